@@ -0,0 +1,88 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/base/vectorization.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include <material.h>
+
+using namespace dealii;
+
+// Overhead of the neo-Hookean material derived by automatic differentiation
+// over the hand-coded one in the quadrature point kernel of the tangent
+// operator, i.e. the Kirchhoff stress and the action of the tangent on the
+// symmetric gradient of the source vector, for a batch of quadrature points
+// with different deformation gradients.
+
+template <int dim>
+void run (const unsigned int n_points,
+          const unsigned int n_repetitions)
+{
+  typedef VectorizedArray<double> NumberType;
+  const unsigned int n_lanes = NumberType::n_array_elements;
+  const unsigned int n_batches = n_points / n_lanes;
+
+  const double mu = 0.4225e6;
+  const double nu = 0.3;
+  Material_Compressible_Neo_Hook_One_Field<dim,NumberType> material(mu,nu);
+  const Material_Hyperelastic_AD<dim,NumberType,Compressible_Neo_Hook_Energy<dim>>
+  material_ad(Compressible_Neo_Hook_Energy<dim>(mu,nu));
+
+  AlignedVector<Tensor<2,dim,NumberType>>          F(n_batches);
+  AlignedVector<SymmetricTensor<2,dim,NumberType>> src(n_batches), dst(n_batches);
+  for (unsigned int b = 0; b < n_batches; ++b)
+    for (unsigned int v = 0; v < n_lanes; ++v)
+      for (unsigned int i = 0; i < dim; ++i)
+        for (unsigned int j = 0; j < dim; ++j)
+          {
+            F[b][i][j][v] = (i == j ? 1. : 0.) + 0.2 * (static_cast<double>(std::rand()) / RAND_MAX - 0.5);
+            src[b][i][j][v] = static_cast<double>(std::rand()) / RAND_MAX;
+          }
+
+  double times[2];
+  for (unsigned int variant = 0; variant < 2; ++variant)
+    {
+      Timer timer;
+      for (unsigned int r = 0; r < n_repetitions; ++r)
+        for (unsigned int b = 0; b < n_batches; ++b)
+          {
+            SymmetricTensor<2,dim,NumberType> tau;
+            if (variant == 0)
+              {
+                const NumberType det_F = determinant(F[b]);
+                const SymmetricTensor<2,dim,NumberType> b_bar = Physics::Elasticity::Kinematics::b(F_iso(F[b]));
+                material.get_tau(tau, det_F, b_bar);
+                dst[b] = material.act_Jc(det_F, b_bar, src[b]) + tau;
+              }
+            else
+              {
+                material_ad.get_tau(tau, F[b]);
+                dst[b] = material_ad.act_Jc(F[b], src[b]) + tau;
+              }
+          }
+      timer.stop();
+      times[variant] = timer.wall_time() / n_repetitions;
+    }
+
+  std::cout << std::setprecision(4)
+            << "dim = " << dim << ", " << n_points << " quadrature points, "
+            << n_lanes << " lanes" << std::endl
+            << "  hand-coded:  " << times[0] << " s, "
+            << n_points / times[0] / 1e6 << " Mpoints/s" << std::endl
+            << "  AD:          " << times[1] << " s, "
+            << n_points / times[1] / 1e6 << " Mpoints/s" << std::endl
+            << "  overhead:    " << times[1] / times[0] << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, 1);
+
+  run<2>(1 << 14, 200);
+  run<3>(1 << 14, 100);
+}
@@ -0,0 +1,139 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/function.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_system.h>
+#include <deal.II/fe/mapping_q_eulerian.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include <mf_nh_operator.h>
+
+using namespace dealii;
+
+// Cost of the anisotropic fiber reinforced material relative to the
+// isotropic neo-Hookean one in the matrix-free tangent operator. Both apply
+// the same operator to the same vector on a stretched and sheared cube, so
+// that the difference in the run time is the extra cost of the fiber terms in
+// the quadrature point kernel.
+
+template <int dim>
+class Displacement : public Function<dim>
+{
+public:
+  Displacement() :
+    Function<dim>(dim)
+  {}
+
+  double value (const Point<dim> &p,
+                const unsigned int component) const
+  {
+    // stretch along the fibers and simple shear
+    if (component==0)
+      return 0.1*p[0] + 0.1*p[1];
+    else
+      return 0.;
+  }
+};
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void run (const unsigned int n_refinements,
+          const unsigned int n_repetitions)
+{
+  typedef double number;
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global (n_refinements);
+
+  FESystem<dim> fe(FE_Q<dim>(fe_degree),dim);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+
+  ConstraintMatrix constraints;
+  constraints.close();
+
+  Vector<number> displacement(dof.n_dofs()), src(dof.n_dofs()), dst(dof.n_dofs());
+  VectorTools::interpolate(dof, Displacement<dim>(), displacement);
+  for (unsigned int i=0; i<src.size(); ++i)
+    src(i) = ((double)std::rand())/RAND_MAX;
+
+  MappingQEulerian<dim,Vector<number>> mapping(/*degree*/1,dof,displacement);
+
+  auto mf_data_current   = std::make_shared<MatrixFree<dim,number>>();
+  auto mf_data_reference = std::make_shared<MatrixFree<dim,number>>();
+
+  const QGauss<1> quad (n_q_points_1d);
+  typename MatrixFree<dim,number>::AdditionalData data;
+  data.tasks_parallel_scheme = MatrixFree<dim,number>::AdditionalData::none;
+
+  mf_data_reference->reinit (        dof, constraints, quad, data);
+  mf_data_current->reinit   (mapping,dof, constraints, quad, data);
+
+  const double nu = 0.3;
+  const double mu = 0.4225e6;
+  auto material = std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<number>>>(mu,nu);
+  auto fiber_material = std::make_shared<Material_HGO_Fibers<dim,VectorizedArray<number>>>(mu,1.0);
+
+  // two fiber families at plus and minus 30 degrees to the x-axis
+  auto fibers = std::make_shared<FiberDirections<dim,number>>();
+  fibers->reinit(*mf_data_reference, 2,
+                 [](const typename DoFHandler<dim>::cell_iterator &,
+                    const unsigned int family)
+  {
+    Tensor<1,dim> a;
+    a[0] = std::cos(numbers::PI/6.);
+    a[1] = (family == 0 ? 1. : -1.) * std::sin(numbers::PI/6.);
+    return a;
+  });
+
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number> op;
+  op.initialize(mf_data_current,mf_data_reference,displacement);
+  op.set_material(material);
+
+  std::cout << "dim = " << dim << ", degree = " << fe_degree
+            << ", cells = " << tria.n_active_cells()
+            << ", dofs = " << dof.n_dofs()
+            << ", fiber storage = " << fibers->memory_consumption() << " bytes"
+            << std::endl;
+
+  double times[2];
+  for (unsigned int variant = 0; variant < 2; ++variant)
+    {
+      if (variant == 1)
+        op.set_fibers(fiber_material, fibers);
+
+      // warm up
+      op.vmult(dst,src);
+
+      Timer timer;
+      for (unsigned int r = 0; r < n_repetitions; ++r)
+        op.vmult(dst,src);
+      timer.stop();
+      times[variant] = timer.wall_time() / n_repetitions;
+    }
+
+  std::cout << std::setprecision(4)
+            << "  neo-Hooke:         " << times[0] << " s per vmult, "
+            << dof.n_dofs() / times[0] / 1e6 << " MDoFs/s" << std::endl
+            << "  HGO (2 families):  " << times[1] << " s per vmult, "
+            << dof.n_dofs() / times[1] / 1e6 << " MDoFs/s" << std::endl
+            << "  relative cost:     " << times[1] / times[0] << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, 1);
+
+  run<2,2,3>(7, 50);
+  run<3,1,2>(5, 50);
+  run<3,2,3>(4, 50);
+}
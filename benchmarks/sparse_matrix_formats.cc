@@ -0,0 +1,156 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_renumbering.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_system.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+
+// Matrix-vector product of the assembled tangent in the formats of the
+// matrix-based solver, i.e. SparseMatrix, its SELL-C-sigma copy, the block
+// CSR format and the upper triangle, on the Cook membrane at several sizes.
+// The matrix is the linear elastic stiffness with the left edge clamped,
+// which has the sparsity and the constrained rows of the tangent. The DoFs
+// are numbered as for the block format, i.e. by Cuthill-McKee with the
+// components of each node next to each other.
+
+template <typename MatrixType>
+double time_vmult (const MatrixType     &matrix,
+                   const Vector<double> &src,
+                   Vector<double>       &dst,
+                   const unsigned int    n_repetitions)
+{
+  Timer timer;
+  for (unsigned int r = 0; r < n_repetitions; ++r)
+    matrix.vmult(dst, src);
+  timer.stop();
+  return timer.wall_time() / n_repetitions;
+}
+
+
+
+template <int dim>
+void run (const unsigned int degree,
+          const unsigned int elements_per_edge,
+          const unsigned int n_repetitions)
+{
+  Triangulation<dim> triangulation;
+  Cook_Membrane::make_cook_membrane_grid(triangulation, elements_per_edge, 1e-3);
+
+  const FESystem<dim> fe(FE_Q<dim>(degree), dim);
+  DoFHandler<dim> dof_handler(triangulation);
+  dof_handler.distribute_dofs(fe);
+  DoFRenumbering::Cuthill_McKee(dof_handler);
+  renumber_nodal_blocks(dof_handler);
+
+  ConstraintMatrix constraints;
+  VectorTools::interpolate_boundary_values(dof_handler, 1,
+                                           ZeroFunction<dim>(dim),
+                                           constraints);
+  constraints.close();
+
+  DynamicSparsityPattern dsp(dof_handler.n_dofs(), dof_handler.n_dofs());
+  DoFTools::make_sparsity_pattern(dof_handler, dsp, constraints, false);
+  SparsityPattern sparsity;
+  sparsity.copy_from(dsp);
+
+  SparseMatrix<double> matrix(sparsity);
+  {
+    const double mu = 0.4225e6, lambda = 1.69e6;
+    const QGauss<dim> quadrature(degree + 1);
+    FEValues<dim> fe_values(fe, quadrature, update_gradients | update_JxW_values);
+    const FEValuesExtractors::Vector u(0);
+    FullMatrix<double> cell_matrix(fe.dofs_per_cell, fe.dofs_per_cell);
+    std::vector<types::global_dof_index> local_dof_indices(fe.dofs_per_cell);
+    for (const auto &cell : dof_handler.active_cell_iterators())
+      {
+        fe_values.reinit(cell);
+        cell_matrix = 0;
+        for (unsigned int q = 0; q < quadrature.size(); ++q)
+          for (unsigned int i = 0; i < fe.dofs_per_cell; ++i)
+            for (unsigned int j = 0; j < fe.dofs_per_cell; ++j)
+              cell_matrix(i, j) += (2. * mu * (fe_values[u].symmetric_gradient(i, q) *
+                                               fe_values[u].symmetric_gradient(j, q)) +
+                                    lambda * fe_values[u].divergence(i, q) *
+                                    fe_values[u].divergence(j, q)) * fe_values.JxW(q);
+        cell->get_dof_indices(local_dof_indices);
+        constraints.distribute_local_to_global(cell_matrix, local_dof_indices, matrix);
+      }
+  }
+
+  SellCSigmaMatrix<double> matrix_sell;
+  matrix_sell.reinit(sparsity);
+  matrix_sell.copy_from(matrix);
+
+  BSRMatrix<dim,double> matrix_bsr;
+  matrix_bsr.reinit(sparsity);
+  SymmetricSparseMatrix<double> matrix_symmetric;
+  matrix_symmetric.reinit(sparsity);
+  for (unsigned int row = 0; row < matrix.m(); ++row)
+    for (SparseMatrix<double>::const_iterator p = matrix.begin(row); p != matrix.end(row); ++p)
+      {
+        matrix_bsr.add(row, p->column(), p->value());
+        matrix_symmetric.add(row, p->column(), p->value());
+      }
+
+  Vector<double> src(dof_handler.n_dofs()), dst(dof_handler.n_dofs()), dst_format(dof_handler.n_dofs());
+  for (unsigned int i = 0; i < src.size(); ++i)
+    src(i) = std::sin(1. + i);
+  constraints.set_zero(src);
+
+  const double time = time_vmult(matrix, src, dst, n_repetitions);
+
+  std::cout << std::setprecision(4)
+            << "dim = " << dim << ", degree = " << degree << ", "
+            << dof_handler.n_dofs() << " DoFs, "
+            << MultithreadInfo::n_threads() << " threads, "
+            << VectorizedArray<double>::n_array_elements << " lanes" << std::endl
+            << "  CSR:          " << time << " s, "
+            << (matrix.memory_consumption() + sparsity.memory_consumption()) / 1048576.
+            << " MB" << std::endl;
+
+  const auto report = [&](const std::string &name,
+                          const double       time_format,
+                          const std::size_t  memory)
+  {
+    dst_format -= dst;
+    std::cout << "  " << name << time_format << " s, "
+              << memory / 1048576. << " MB, speedup " << time / time_format
+              << ", difference " << dst_format.linfty_norm() / dst.linfty_norm() << std::endl;
+  };
+
+  report("SELL-C-sigma: ", time_vmult(matrix_sell, src, dst_format, n_repetitions),
+         matrix_sell.memory_consumption());
+  report("BSR:          ", time_vmult(matrix_bsr, src, dst_format, n_repetitions),
+         matrix_bsr.memory_consumption());
+  report("Symmetric:    ", time_vmult(matrix_symmetric, src, dst_format, n_repetitions),
+         matrix_symmetric.memory_consumption());
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, numbers::invalid_unsigned_int);
+
+  for (const unsigned int elements_per_edge : {32, 128, 512})
+    run<2>(1, elements_per_edge, 100);
+  for (const unsigned int elements_per_edge : {32, 64, 128})
+    run<3>(2, elements_per_edge, 20);
+}
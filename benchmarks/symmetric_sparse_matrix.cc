@@ -0,0 +1,99 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_renumbering.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_system.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include <symmetric_sparse_matrix.h>
+
+using namespace dealii;
+
+// Matrix-vector product of SparseMatrix against the symmetric storage of
+// only the upper triangle for the sparsity pattern of the displacement
+// field on a cube, numbered by Cuthill-McKee as in the solver. The entries
+// are arbitrary but symmetric.
+
+template <int dim>
+void run (const unsigned int degree,
+          const unsigned int n_refinements,
+          const unsigned int n_repetitions)
+{
+  Triangulation<dim> triangulation;
+  GridGenerator::hyper_cube(triangulation);
+  triangulation.refine_global(n_refinements);
+
+  const FESystem<dim> fe(FE_Q<dim>(degree), dim);
+  DoFHandler<dim> dof_handler(triangulation);
+  dof_handler.distribute_dofs(fe);
+  DoFRenumbering::Cuthill_McKee(dof_handler);
+
+  DynamicSparsityPattern dsp(dof_handler.n_dofs(), dof_handler.n_dofs());
+  DoFTools::make_sparsity_pattern(dof_handler, dsp);
+  SparsityPattern sparsity;
+  sparsity.copy_from(dsp);
+
+  SparseMatrix<double> matrix(sparsity);
+  SymmetricSparseMatrix<double> matrix_symmetric;
+  matrix_symmetric.reinit(sparsity);
+  for (unsigned int row = 0; row < sparsity.n_rows(); ++row)
+    for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+      {
+        const unsigned int i = std::min<unsigned int>(row, p->column());
+        const unsigned int j = std::max<unsigned int>(row, p->column());
+        const double value = (i == j ? 100. : -1. + 1e-3 * ((i * 31 + j * 17) % 1000));
+        matrix.set(row, p->column(), value);
+        matrix_symmetric.add(row, p->column(), value);
+      }
+
+  Vector<double> src(dof_handler.n_dofs()), dst(dof_handler.n_dofs()), dst_symmetric(dof_handler.n_dofs());
+  for (unsigned int i = 0; i < src.size(); ++i)
+    src(i) = std::sin(1. + i);
+
+  Timer timer;
+  for (unsigned int r = 0; r < n_repetitions; ++r)
+    matrix.vmult(dst, src);
+  timer.stop();
+  const double time = timer.wall_time() / n_repetitions;
+
+  timer.restart();
+  for (unsigned int r = 0; r < n_repetitions; ++r)
+    matrix_symmetric.vmult(dst_symmetric, src);
+  timer.stop();
+  const double time_symmetric = timer.wall_time() / n_repetitions;
+
+  dst_symmetric -= dst;
+
+  std::cout << std::setprecision(4)
+            << "dim = " << dim << ", degree = " << degree << ", "
+            << dof_handler.n_dofs() << " DoFs, "
+            << MultithreadInfo::n_threads() << " threads" << std::endl
+            << "  SparseMatrix:          " << time << " s, "
+            << (matrix.memory_consumption() + sparsity.memory_consumption()) / 1048576.
+            << " MB" << std::endl
+            << "  SymmetricSparseMatrix: " << time_symmetric << " s, "
+            << matrix_symmetric.memory_consumption() / 1048576. << " MB" << std::endl
+            << "  speedup:               " << time / time_symmetric
+            << ", difference " << dst_symmetric.linfty_norm() / dst.linfty_norm() << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, numbers::invalid_unsigned_int);
+
+  run<2>(1, 9, 100);
+  run<2>(2, 8, 50);
+  run<3>(1, 5, 50);
+  run<3>(2, 4, 20);
+}
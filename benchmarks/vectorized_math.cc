@@ -0,0 +1,96 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/vectorization.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include <vectorized_math.h>
+
+using namespace dealii;
+
+// Throughput of the vectorized exp, log and pow relative to the lane by lane
+// fallback of deal.II, which calls the scalar functions of the standard
+// library. The vector width and thus the instruction set is the one the
+// library was compiled for, so build this benchmark against deal.II
+// configured for SSE2, AVX and AVX-512 to compare the instruction sets.
+
+template <typename Number, typename Function>
+double time_function (const AlignedVector<VectorizedArray<Number>> &input,
+                      AlignedVector<VectorizedArray<Number>>       &output,
+                      const unsigned int                            n_repetitions,
+                      const Function                               &function)
+{
+  // warm up
+  for (unsigned int i = 0; i < input.size(); ++i)
+    output[i] = function(input[i]);
+
+  Timer timer;
+  for (unsigned int r = 0; r < n_repetitions; ++r)
+    for (unsigned int i = 0; i < input.size(); ++i)
+      output[i] = function(input[i]);
+  timer.stop();
+
+  // giga evaluations per second
+  return 1e-9 * input.size() * VectorizedArray<Number>::n_array_elements * n_repetitions / timer.wall_time();
+}
+
+
+
+template <typename Number>
+void run (const unsigned int n_points,
+          const unsigned int n_repetitions)
+{
+  constexpr unsigned int n_lanes = VectorizedArray<Number>::n_array_elements;
+  typedef VectorizedMath::Accuracy Accuracy;
+
+  // stretches around one as for det(F), small enough to stay in the cache
+  AlignedVector<VectorizedArray<Number>> input(n_points / n_lanes), output(n_points / n_lanes);
+  for (unsigned int i = 0; i < input.size(); ++i)
+    for (unsigned int v = 0; v < n_lanes; ++v)
+      input[i][v] = 0.5 + static_cast<Number>(std::rand()) / RAND_MAX;
+
+  std::cout << (sizeof(Number) == 8 ? "double" : "float")
+            << ", " << n_lanes << " lanes (vectorization level "
+            << DEAL_II_COMPILER_VECTORIZATION_LEVEL << "), Geval/s:" << std::endl;
+
+  const Number exponent = -2./3.;
+  const double fallback[3] =
+  {
+    time_function(input, output, n_repetitions, [](const VectorizedArray<Number> &x) { return std::log(x); }),
+    time_function(input, output, n_repetitions, [](const VectorizedArray<Number> &x) { return std::exp(x); }),
+    time_function(input, output, n_repetitions, [&](const VectorizedArray<Number> &x) { return std::pow(x, exponent); })
+  };
+  const double full[3] =
+  {
+    time_function(input, output, n_repetitions, [](const VectorizedArray<Number> &x) { return VectorizedMath::log<Accuracy::full>(x); }),
+    time_function(input, output, n_repetitions, [](const VectorizedArray<Number> &x) { return VectorizedMath::exp<Accuracy::full>(x); }),
+    time_function(input, output, n_repetitions, [&](const VectorizedArray<Number> &x) { return VectorizedMath::pow<Accuracy::full>(x, exponent); })
+  };
+  const double reduced[3] =
+  {
+    time_function(input, output, n_repetitions, [](const VectorizedArray<Number> &x) { return VectorizedMath::log<Accuracy::reduced>(x); }),
+    time_function(input, output, n_repetitions, [](const VectorizedArray<Number> &x) { return VectorizedMath::exp<Accuracy::reduced>(x); }),
+    time_function(input, output, n_repetitions, [&](const VectorizedArray<Number> &x) { return VectorizedMath::pow<Accuracy::reduced>(x, exponent); })
+  };
+
+  const char *names[3] = {"log", "exp", "pow"};
+  std::cout << std::setprecision(3)
+            << "         std::     full              reduced" << std::endl;
+  for (unsigned int f = 0; f < 3; ++f)
+    std::cout << "  " << names[f] << "    "
+              << std::setw(6) << fallback[f] << "   "
+              << std::setw(6) << full[f] << " (x" << std::setw(4) << full[f] / fallback[f] << ")   "
+              << std::setw(6) << reduced[f] << " (x" << std::setw(4) << reduced[f] / fallback[f] << ")"
+              << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, 1);
+
+  run<double>(4096, 20000);
+  run<float> (4096, 20000);
+}
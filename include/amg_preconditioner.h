@@ -0,0 +1,215 @@
+#pragma once
+
+#include <deal.II/base/config.h>
+
+#ifdef DEAL_II_WITH_TRILINOS
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/point.h>
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/fe/fe.h>
+#include <deal.II/fe/mapping_q_generic.h>
+
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/trilinos_precondition.h>
+#include <deal.II/lac/trilinos_sparse_matrix.h>
+#include <deal.II/lac/vector.h>
+
+#include <ml_MultiLevelPreconditioner.h>
+#include <Teuchos_ParameterList.hpp>
+
+#include <vector>
+
+using namespace dealii;
+
+  /**
+   * Smoothed aggregation AMG of Trilinos ML for the assembled tangent, with
+   * the rigid body modes as the near null space. These are the translations
+   * and the infinitesimal rotations about the origin evaluated at the
+   * support points of the DoFs, so that the aggregates represent the
+   * rotations of the coarse levels, which the constant modes of
+   * TrilinosWrappers::PreconditionAMG::AdditionalData cannot.
+   *
+   * initialize() copies the matrix and sets up the hierarchy. The hierarchy
+   * remains a valid preconditioner if the matrix changes afterwards, so that
+   * the setup can be reused as long as the iteration counts stay low.
+   *
+   * The nodes have to be numbered consecutively as for BSRMatrix, since ML
+   * aggregates blocks of consecutive rows of the size of the number of
+   * components.
+   */
+  class AMGPreconditioner : public Subscriptor
+  {
+  public:
+    struct AdditionalData
+    {
+      AdditionalData (const unsigned int smoother_sweeps = 2,
+                      const double       aggregation_threshold = 1e-4)
+        :
+        smoother_sweeps(smoother_sweeps),
+        aggregation_threshold(aggregation_threshold)
+      {}
+
+      unsigned int smoother_sweeps;
+      double       aggregation_threshold;
+    };
+
+    AMGPreconditioner ();
+
+    /**
+     * Evaluate the rigid body modes at the support points of the DoFs of
+     * @p dof_handler, whose element is a system of dim equal scalar elements.
+     */
+    template <int dim>
+    void set_rigid_body_modes (const DoFHandler<dim> &dof_handler);
+
+    void initialize (const SparseMatrix<double> &matrix,
+                     const AdditionalData       &additional_data = AdditionalData());
+
+    bool is_initialized () const;
+
+    void vmult (Vector<double>       &dst,
+                const Vector<double> &src) const;
+
+    void clear ();
+
+  private:
+    // the modes one after the other, as ML expects them
+    std::vector<double> null_space;
+    unsigned int        n_modes;
+    unsigned int        n_components;
+
+    TrilinosWrappers::SparseMatrix   matrix;
+    TrilinosWrappers::PreconditionAMG amg;
+    bool                              initialized;
+  };
+
+
+
+  inline
+  AMGPreconditioner::AMGPreconditioner ()
+    :
+    n_modes(0),
+    n_components(0),
+    initialized(false)
+  {}
+
+
+
+  inline
+  void
+  AMGPreconditioner::clear ()
+  {
+    amg.clear();
+    matrix.clear();
+    null_space.clear();
+    n_modes = 0;
+    initialized = false;
+  }
+
+
+
+  template <int dim>
+  void
+  AMGPreconditioner::set_rigid_body_modes (const DoFHandler<dim> &dof_handler)
+  {
+    const FiniteElement<dim> &fe = dof_handler.get_fe();
+    AssertThrow (fe.n_components() == dim && fe.n_base_elements() == 1,
+                 ExcMessage("The rigid body modes require a system of dim equal scalar elements"));
+
+    const types::global_dof_index n_dofs = dof_handler.n_dofs();
+    n_components = dim;
+    n_modes = (dim == 2 ? 3 : 6);
+
+    std::vector<Point<dim>> support_points(n_dofs);
+    DoFTools::map_dofs_to_support_points(MappingQGeneric<dim>(1), dof_handler, support_points);
+
+    std::vector<unsigned int> dof_component(n_dofs);
+    std::vector<types::global_dof_index> local_dof_indices(fe.dofs_per_cell);
+    for (const auto &cell : dof_handler.active_cell_iterators())
+      {
+        cell->get_dof_indices(local_dof_indices);
+        for (unsigned int i = 0; i < fe.dofs_per_cell; ++i)
+          dof_component[local_dof_indices[i]] = fe.system_to_component_index(i).first;
+      }
+
+    // translations, then the rotations $\boldsymbol{\omega} \times
+    // \mathbf{x}$ about the axes, i.e. only about the z-axis in 2d
+    null_space.assign(n_modes * n_dofs, 0.);
+    for (types::global_dof_index i = 0; i < n_dofs; ++i)
+      {
+        const unsigned int c = dof_component[i];
+        const Point<dim> &x = support_points[i];
+        null_space[c * n_dofs + i] = 1.;
+        if (dim == 2)
+          null_space[2 * n_dofs + i] = (c == 0 ? -x[1] : x[0]);
+        else
+          for (unsigned int axis = 0; axis < 3; ++axis)
+            {
+              // the component c of $\mathbf{e}_{axis} \times \mathbf{x}$
+              const unsigned int next = (axis + 1) % 3, previous = (axis + 2) % 3;
+              if (c == previous)
+                null_space[(dim + axis) * n_dofs + i] = x[next];
+              else if (c == next)
+                null_space[(dim + axis) * n_dofs + i] = -x[previous];
+            }
+      }
+  }
+
+
+
+  inline
+  void
+  AMGPreconditioner::initialize (const SparseMatrix<double> &matrix_,
+                                 const AdditionalData       &additional_data)
+  {
+    Assert (n_modes > 0, ExcMessage("The rigid body modes have to be set first"));
+    AssertDimension (null_space.size(), n_modes * matrix_.m());
+
+    // the hierarchy refers to the matrix, so it is released first
+    amg.clear();
+    matrix.reinit(matrix_);
+
+    Teuchos::ParameterList parameter_list;
+    ML_Epetra::SetDefaults("SA", parameter_list);
+    parameter_list.set("aggregation: type", "Uncoupled");
+    parameter_list.set("aggregation: threshold", additional_data.aggregation_threshold);
+    parameter_list.set("smoother: type", "Chebyshev");
+    parameter_list.set("smoother: sweeps", static_cast<int>(additional_data.smoother_sweeps));
+    parameter_list.set("coarse: type", "Amesos-KLU");
+    parameter_list.set("coarse: max size", 2000);
+    parameter_list.set("ML output", 0);
+
+    parameter_list.set("PDE equations", static_cast<int>(n_components));
+    parameter_list.set("null space: type", "pre-computed");
+    parameter_list.set("null space: dimension", static_cast<int>(n_modes));
+    parameter_list.set("null space: vectors", null_space.data());
+
+    amg.initialize(matrix, parameter_list);
+    initialized = true;
+  }
+
+
+
+  inline
+  bool
+  AMGPreconditioner::is_initialized () const
+  {
+    return initialized;
+  }
+
+
+
+  inline
+  void
+  AMGPreconditioner::vmult (Vector<double>       &dst,
+                            const Vector<double> &src) const
+  {
+    Assert (initialized, ExcNotInitialized());
+    amg.vmult(dst, src);
+  }
+
+#endif
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/vector.h>
+
+#include <deque>
+
+using namespace dealii;
+
+  /**
+   * Anderson acceleration of a fixed-point iteration $\mathbf{x}_{k+1} =
+   * \mathbf{x}_k + \mathbf{f}_k$, e.g. the Newton updates of a load step or
+   * the updates of one field in a staggered scheme, see Walker and Ni (2011).
+   *
+   * The differences $\varDelta \mathbf{x}_i = \mathbf{x}_{i+1} -
+   * \mathbf{x}_i$ and $\varDelta \mathbf{f}_i = \mathbf{f}_{i+1} -
+   * \mathbf{f}_i$ of the last @p history_depth iterations are kept. The
+   * update is replaced by $\mathbf{f}_k - \sum_i \gamma_i (\varDelta
+   * \mathbf{x}_i + \varDelta \mathbf{f}_i)$ with the coefficients
+   * $\boldsymbol{\gamma}$ that minimize $\| \mathbf{f}_k - \sum_i \gamma_i
+   * \varDelta \mathbf{f}_i \|$. The small least squares problem is solved
+   * with its normal equations.
+   *
+   * As the accelerated update is a combination of updates, it satisfies
+   * homogeneous constraints whenever these do. At most
+   * 2 @p history_depth + 2 vectors are stored.
+   */
+  template <typename VectorType>
+  class AndersonAcceleration
+  {
+  public:
+    AndersonAcceleration (const unsigned int history_depth = 0);
+
+    /**
+     * Forget all iterates, e.g. at the beginning of a load step.
+     */
+    void reset ();
+
+    /**
+     * Replace the @p update of the fixed-point iteration at the iterate
+     * @p x by the accelerated one and add both to the history. Without
+     * history, i.e. in the first iteration or for zero depth, the update is
+     * not changed.
+     */
+    void apply (const VectorType &x,
+                VectorType       &update);
+
+    unsigned int depth () const;
+
+    /**
+     * Largest number of vectors of the size of the iterates stored.
+     */
+    unsigned int max_n_vectors () const;
+
+    std::size_t memory_consumption () const;
+
+  private:
+    unsigned int history_depth;
+
+    std::deque<VectorType> delta_x;
+    std::deque<VectorType> delta_f;
+
+    VectorType x_previous;
+    VectorType f_previous;
+    bool       has_previous;
+  };
+
+
+
+  template <typename VectorType>
+  AndersonAcceleration<VectorType>::AndersonAcceleration (const unsigned int history_depth)
+    :
+    history_depth(history_depth),
+    has_previous(false)
+  {}
+
+
+
+  template <typename VectorType>
+  void
+  AndersonAcceleration<VectorType>::reset ()
+  {
+    delta_x.clear();
+    delta_f.clear();
+    has_previous = false;
+  }
+
+
+
+  template <typename VectorType>
+  unsigned int
+  AndersonAcceleration<VectorType>::depth () const
+  {
+    return history_depth;
+  }
+
+
+
+  template <typename VectorType>
+  unsigned int
+  AndersonAcceleration<VectorType>::max_n_vectors () const
+  {
+    return history_depth > 0 ? 2*history_depth + 2 : 0;
+  }
+
+
+
+  template <typename VectorType>
+  void
+  AndersonAcceleration<VectorType>::apply (const VectorType &x,
+                                           VectorType       &update)
+  {
+    if (history_depth == 0)
+      return;
+
+    AssertDimension (x.size(), update.size());
+
+    if (has_previous)
+      {
+        // the oldest differences are dropped to bound the memory
+        if (delta_x.size() == history_depth)
+          {
+            delta_x.pop_front();
+            delta_f.pop_front();
+          }
+
+        delta_x.push_back(x);
+        delta_x.back() -= x_previous;
+        delta_f.push_back(update);
+        delta_f.back() -= f_previous;
+      }
+
+    x_previous = x;
+    f_previous = update;
+    has_previous = true;
+
+    const unsigned int n = delta_f.size();
+    if (n == 0)
+      return;
+
+    // normal equations of the least squares problem, slightly regularized
+    // against nearly linearly dependent differences
+    FullMatrix<double> normal_matrix(n, n);
+    Vector<double>     rhs(n), gamma(n);
+    double max_diagonal = 0.;
+    for (unsigned int i=0; i<n; ++i)
+      {
+        for (unsigned int j=0; j<=i; ++j)
+          normal_matrix(i,j) = normal_matrix(j,i) = delta_f[i] * delta_f[j];
+        rhs(i) = delta_f[i] * update;
+        max_diagonal = std::max(max_diagonal, normal_matrix(i,i));
+      }
+
+    // a stagnating iteration has no information to extrapolate from
+    if (max_diagonal == 0.)
+      return;
+
+    for (unsigned int i=0; i<n; ++i)
+      normal_matrix(i,i) += 1e-12 * max_diagonal;
+
+    normal_matrix.gauss_jordan();
+    normal_matrix.vmult(gamma, rhs);
+
+    for (unsigned int i=0; i<n; ++i)
+      {
+        update.add(-gamma(i), delta_x[i]);
+        update.add(-gamma(i), delta_f[i]);
+      }
+  }
+
+
+
+  template <typename VectorType>
+  std::size_t
+  AndersonAcceleration<VectorType>::memory_consumption () const
+  {
+    std::size_t memory = x_previous.memory_consumption() + f_previous.memory_consumption();
+    for (unsigned int i=0; i<delta_x.size(); ++i)
+      memory += delta_x[i].memory_consumption() + delta_f[i].memory_consumption();
+    return memory;
+  }
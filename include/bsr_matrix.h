@@ -0,0 +1,568 @@
+#pragma once
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe.h>
+
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+// ConstraintMatrix::distribute_local_to_global() is only instantiated for the
+// matrices of the library:
+#include <deal.II/lac/constraint_matrix.templates.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace dealii;
+
+  /**
+   * Sparse matrix in the block compressed sparse row format with dense
+   * blocks of size @p block_size, i.e. the couplings between the dim
+   * displacement components of two nodes. One column index is stored per
+   * block instead of per entry, and the products with the dense blocks have
+   * a fixed trip count that the compiler unrolls and vectorizes.
+   *
+   * The DoFs of node $I$ have to be numbered $I \, b, \dots, I \, b + b - 1$
+   * with the block size $b$, see renumber_nodal_blocks(). The block sparsity
+   * pattern is the one of the nodes, i.e. the union of the scalar pattern
+   * over the components, so that a block holds explicit zeros for the
+   * couplings the scalar pattern misses.
+   *
+   * The interface is the subset of SparseMatrix used by the solver: the
+   * assembly through ConstraintMatrix, vmult() for CG, the relaxation
+   * methods for PreconditionJacobi, PreconditionSSOR and
+   * PreconditionSelector, and copy_to() for the direct solver, which needs a
+   * scalar matrix.
+   */
+  template <int block_size, typename number>
+  class BSRMatrix : public Subscriptor
+  {
+  public:
+    typedef number                  value_type;
+    typedef types::global_dof_index size_type;
+
+    BSRMatrix ();
+
+    /**
+     * Set up the block pattern from the scalar @p sparsity and zero the
+     * entries.
+     */
+    void reinit (const SparsityPattern &sparsity);
+
+    void clear ();
+
+    /**
+     * Only zero can be assigned, as for SparseMatrix.
+     */
+    BSRMatrix &operator = (const double d);
+
+    size_type m () const;
+    size_type n () const;
+
+    /**
+     * Number of stored entries including the explicit zeros of the blocks.
+     */
+    std::size_t n_nonzero_elements () const;
+
+    std::size_t memory_consumption () const;
+
+    void add (const size_type i,
+              const size_type j,
+              const number    value);
+
+    template <typename number2>
+    void add (const size_type  row,
+              const size_type  n_cols,
+              const size_type *col_indices,
+              const number2   *values,
+              const bool       elide_zero_values = true,
+              const bool       col_indices_are_sorted = false);
+
+    number el (const size_type i,
+               const size_type j) const;
+
+    number diag_element (const size_type i) const;
+
+    void vmult (Vector<number>       &dst,
+                const Vector<number> &src) const;
+
+    void precondition_Jacobi (Vector<number>       &dst,
+                              const Vector<number> &src,
+                              const number          omega = 1.) const;
+
+    void precondition_SOR (Vector<number>       &dst,
+                           const Vector<number> &src,
+                           const number          omega = 1.) const;
+
+    /**
+     * Point SSOR in the same form as SparseMatrix::precondition_SSOR(). The
+     * last argument is only there for the interface of PreconditionSSOR and
+     * ignored.
+     */
+    void precondition_SSOR (Vector<number>                 &dst,
+                            const Vector<number>           &src,
+                            const number                    omega = 1.,
+                            const std::vector<std::size_t> &pos_right_of_diagonal = std::vector<std::size_t>()) const;
+
+    /**
+     * Copy into a scalar matrix on the scalar pattern of the blocks, which
+     * is set up in @p sparsity.
+     */
+    void copy_to (SparsityPattern      &sparsity,
+                  SparseMatrix<number> &matrix) const;
+
+  private:
+    /**
+     * Position of the block (@p block_row, @p block_col), or
+     * numbers::invalid_size_type.
+     */
+    std::size_t block_index (const unsigned int block_row,
+                             const unsigned int block_col) const;
+
+    /**
+     * The product of the block rows in [@p begin, @p end).
+     */
+    void vmult_block_rows (Vector<number>       &dst,
+                           const Vector<number> &src,
+                           const unsigned int    begin,
+                           const unsigned int    end) const;
+
+    static const unsigned int entries_per_block = block_size * block_size;
+
+    // block rows per parallel task at least
+    static const unsigned int grain_size = 64;
+
+    unsigned int n_block_rows;
+
+    // the blocks of a row are sorted by their column
+    std::vector<std::size_t>  row_start;
+    std::vector<unsigned int> block_column;
+    std::vector<std::size_t>  diagonal_block;
+
+    // the entries of each block in row-major order
+    AlignedVector<number> values;
+  };
+
+
+
+  /**
+   * Renumber the DoFs of a vector-valued element with one base element so
+   * that the components of each node are numbered consecutively, as needed by
+   * BSRMatrix. The nodes keep the order of their first DoF in the given
+   * numbering, e.g. the one of Cuthill-McKee.
+   */
+  template <int dim>
+  void renumber_nodal_blocks (DoFHandler<dim> &dof_handler)
+  {
+    const FiniteElement<dim> &fe = dof_handler.get_fe();
+    const unsigned int n_components = fe.n_components();
+    AssertThrow (fe.n_base_elements() == 1 && fe.element_multiplicity(0) == n_components,
+                 ExcMessage("Nodal blocks require a system of equal scalar elements"));
+
+    const types::global_dof_index n_dofs = dof_handler.n_dofs();
+
+    // the DoFs of each node in component order
+    std::vector<unsigned int>            node_of_dof(n_dofs, numbers::invalid_unsigned_int);
+    std::vector<types::global_dof_index> node_dofs;
+    node_dofs.reserve(n_dofs);
+    std::vector<types::global_dof_index> local_dof_indices(fe.dofs_per_cell);
+    for (typename DoFHandler<dim>::active_cell_iterator cell = dof_handler.begin_active();
+         cell != dof_handler.end(); ++cell)
+      {
+        cell->get_dof_indices(local_dof_indices);
+        for (unsigned int i = 0; i < fe.dofs_per_cell; ++i)
+          if (fe.system_to_component_index(i).first == 0 &&
+              node_of_dof[local_dof_indices[i]] == numbers::invalid_unsigned_int)
+            {
+              const unsigned int node = node_dofs.size() / n_components;
+              const unsigned int base_index = fe.system_to_component_index(i).second;
+              for (unsigned int c = 0; c < n_components; ++c)
+                {
+                  const types::global_dof_index dof = local_dof_indices[fe.component_to_system_index(c, base_index)];
+                  node_of_dof[dof] = node;
+                  node_dofs.push_back(dof);
+                }
+            }
+      }
+    AssertDimension (node_dofs.size(), n_dofs);
+
+    std::vector<types::global_dof_index> new_numbers(n_dofs, numbers::invalid_dof_index);
+    types::global_dof_index next = 0;
+    for (types::global_dof_index i = 0; i < n_dofs; ++i)
+      if (new_numbers[i] == numbers::invalid_dof_index)
+        for (unsigned int c = 0; c < n_components; ++c)
+          new_numbers[node_dofs[node_of_dof[i] * n_components + c]] = next++;
+
+    dof_handler.renumber_dofs(new_numbers);
+  }
+
+
+
+  template <int block_size, typename number>
+  BSRMatrix<block_size,number>::BSRMatrix ()
+    :
+    n_block_rows(0)
+  {}
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::clear ()
+  {
+    n_block_rows = 0;
+    row_start.clear();
+    block_column.clear();
+    diagonal_block.clear();
+    values.clear();
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::reinit (const SparsityPattern &sparsity)
+  {
+    Assert (sparsity.n_rows() == sparsity.n_cols(), ExcNotQuadratic());
+    AssertThrow (sparsity.n_rows() % block_size == 0,
+                 ExcMessage("The size has to be a multiple of the block size"));
+    n_block_rows = sparsity.n_rows() / block_size;
+
+    DynamicSparsityPattern block_sparsity(n_block_rows, n_block_rows);
+    for (size_type row = 0; row < sparsity.n_rows(); ++row)
+      for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+        block_sparsity.add(row / block_size, p->column() / block_size);
+
+    row_start.resize(n_block_rows + 1);
+    block_column.resize(block_sparsity.n_nonzero_elements());
+    diagonal_block.resize(n_block_rows);
+    row_start[0] = 0;
+    for (unsigned int I = 0; I < n_block_rows; ++I)
+      {
+        std::size_t k = row_start[I];
+        for (DynamicSparsityPattern::iterator p = block_sparsity.begin(I); p != block_sparsity.end(I); ++p, ++k)
+          {
+            block_column[k] = p->column();
+            if (p->column() == I)
+              diagonal_block[I] = k;
+          }
+        row_start[I + 1] = k;
+      }
+
+    values.resize_fast(block_column.size() * entries_per_block);
+    *this = 0.;
+  }
+
+
+
+  template <int block_size, typename number>
+  BSRMatrix<block_size,number> &
+  BSRMatrix<block_size,number>::operator = (const double d)
+  {
+    Assert (d == 0, ExcMessage("Only zero can be assigned to the matrix"));
+    (void)d;
+    values.fill(number());
+    return *this;
+  }
+
+
+
+  template <int block_size, typename number>
+  typename BSRMatrix<block_size,number>::size_type
+  BSRMatrix<block_size,number>::m () const
+  {
+    return static_cast<size_type>(n_block_rows) * block_size;
+  }
+
+
+
+  template <int block_size, typename number>
+  typename BSRMatrix<block_size,number>::size_type
+  BSRMatrix<block_size,number>::n () const
+  {
+    return m();
+  }
+
+
+
+  template <int block_size, typename number>
+  std::size_t
+  BSRMatrix<block_size,number>::n_nonzero_elements () const
+  {
+    return values.size();
+  }
+
+
+
+  template <int block_size, typename number>
+  std::size_t
+  BSRMatrix<block_size,number>::memory_consumption () const
+  {
+    return MemoryConsumption::memory_consumption(row_start) +
+           MemoryConsumption::memory_consumption(block_column) +
+           MemoryConsumption::memory_consumption(diagonal_block) +
+           values.memory_consumption();
+  }
+
+
+
+  template <int block_size, typename number>
+  std::size_t
+  BSRMatrix<block_size,number>::block_index (const unsigned int block_row,
+                                             const unsigned int block_col) const
+  {
+    const std::vector<unsigned int>::const_iterator
+    begin = block_column.begin() + row_start[block_row],
+    end = block_column.begin() + row_start[block_row + 1],
+    p = std::lower_bound(begin, end, block_col);
+    if (p == end || *p != block_col)
+      return numbers::invalid_size_type;
+    return p - block_column.begin();
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::add (const size_type i,
+                                     const size_type j,
+                                     const number    value)
+  {
+    const std::size_t k = block_index(i / block_size, j / block_size);
+    Assert (k != numbers::invalid_size_type,
+            ExcMessage("The entry is not in the sparsity pattern"));
+    values[k * entries_per_block + (i % block_size) * block_size + j % block_size] += value;
+  }
+
+
+
+  template <int block_size, typename number>
+  template <typename number2>
+  void
+  BSRMatrix<block_size,number>::add (const size_type  row,
+                                     const size_type  n_cols,
+                                     const size_type *col_indices,
+                                     const number2   *col_values,
+                                     const bool       elide_zero_values,
+                                     const bool       /*col_indices_are_sorted*/)
+  {
+    const unsigned int I = row / block_size;
+    const unsigned int r = row % block_size;
+
+    // consecutive columns mostly fall into the same block
+    std::size_t k = numbers::invalid_size_type;
+    unsigned int J = numbers::invalid_unsigned_int;
+    for (size_type c = 0; c < n_cols; ++c)
+      {
+        if (elide_zero_values && col_values[c] == number2())
+          continue;
+
+        if (col_indices[c] / block_size != J)
+          {
+            J = col_indices[c] / block_size;
+            k = block_index(I, J);
+            Assert (k != numbers::invalid_size_type,
+                    ExcMessage("The entry is not in the sparsity pattern"));
+          }
+        values[k * entries_per_block + r * block_size + col_indices[c] % block_size] += col_values[c];
+      }
+  }
+
+
+
+  template <int block_size, typename number>
+  number
+  BSRMatrix<block_size,number>::el (const size_type i,
+                                    const size_type j) const
+  {
+    const std::size_t k = block_index(i / block_size, j / block_size);
+    if (k == numbers::invalid_size_type)
+      return number();
+    return values[k * entries_per_block + (i % block_size) * block_size + j % block_size];
+  }
+
+
+
+  template <int block_size, typename number>
+  number
+  BSRMatrix<block_size,number>::diag_element (const size_type i) const
+  {
+    const unsigned int r = i % block_size;
+    return values[diagonal_block[i / block_size] * entries_per_block + r * block_size + r];
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::vmult_block_rows (Vector<number>       &dst,
+                                                  const Vector<number> &src,
+                                                  const unsigned int    begin,
+                                                  const unsigned int    end) const
+  {
+    const number *src_ptr = src.begin();
+    number *dst_ptr = dst.begin();
+    for (unsigned int I = begin; I < end; ++I)
+      {
+        number sum[block_size] = {};
+        for (std::size_t k = row_start[I]; k < row_start[I + 1]; ++k)
+          {
+            const number *block = &values[k * entries_per_block];
+            const number *x = src_ptr + static_cast<std::size_t>(block_column[k]) * block_size;
+            for (unsigned int r = 0; r < block_size; ++r)
+              for (unsigned int c = 0; c < block_size; ++c)
+                sum[r] += block[r * block_size + c] * x[c];
+          }
+        for (unsigned int r = 0; r < block_size; ++r)
+          dst_ptr[static_cast<std::size_t>(I) * block_size + r] = sum[r];
+      }
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::vmult (Vector<number>       &dst,
+                                       const Vector<number> &src) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+    Assert (&src != &dst, ExcMessage("The vectors have to be different"));
+
+    parallel::apply_to_subranges(0u, n_block_rows,
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      vmult_block_rows(dst, src, begin, end);
+    },
+    grain_size);
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::precondition_Jacobi (Vector<number>       &dst,
+                                                     const Vector<number> &src,
+                                                     const number          omega) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+
+    for (size_type i = 0; i < m(); ++i)
+      dst(i) = omega * src(i) / diag_element(i);
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::precondition_SOR (Vector<number>       &dst,
+                                                  const Vector<number> &src,
+                                                  const number          omega) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+
+    for (unsigned int I = 0; I < n_block_rows; ++I)
+      for (unsigned int r = 0; r < block_size; ++r)
+        {
+          const size_type row = static_cast<size_type>(I) * block_size + r;
+          number s = src(row);
+          for (std::size_t k = row_start[I]; k < row_start[I + 1] && block_column[k] <= I; ++k)
+            {
+              const number *block = &values[k * entries_per_block + r * block_size];
+              const size_type col_start = static_cast<size_type>(block_column[k]) * block_size;
+              const unsigned int n_c = (block_column[k] == I ? r : block_size);
+              for (unsigned int c = 0; c < n_c; ++c)
+                s -= block[c] * dst(col_start + c);
+            }
+          dst(row) = s * omega / diag_element(row);
+        }
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::precondition_SSOR (Vector<number>                 &dst,
+                                                   const Vector<number>           &src,
+                                                   const number                    omega,
+                                                   const std::vector<std::size_t> &) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+
+    dst = src;
+
+    // forward sweep over the entries left of the diagonal
+    for (unsigned int I = 0; I < n_block_rows; ++I)
+      for (unsigned int r = 0; r < block_size; ++r)
+        {
+          const size_type row = static_cast<size_type>(I) * block_size + r;
+          number s = 0;
+          for (std::size_t k = row_start[I]; k < row_start[I + 1] && block_column[k] <= I; ++k)
+            {
+              const number *block = &values[k * entries_per_block + r * block_size];
+              const size_type col_start = static_cast<size_type>(block_column[k]) * block_size;
+              const unsigned int n_c = (block_column[k] == I ? r : block_size);
+              for (unsigned int c = 0; c < n_c; ++c)
+                s += block[c] * dst(col_start + c);
+            }
+          dst(row) -= s * omega;
+          dst(row) /= diag_element(row);
+        }
+
+    for (size_type row = 0; row < m(); ++row)
+      dst(row) *= omega * (2. - omega) * diag_element(row);
+
+    // backward sweep over the entries right of the diagonal
+    for (unsigned int I = n_block_rows; I-- > 0; )
+      for (unsigned int r = block_size; r-- > 0; )
+        {
+          const size_type row = static_cast<size_type>(I) * block_size + r;
+          number s = 0;
+          for (std::size_t k = diagonal_block[I]; k < row_start[I + 1]; ++k)
+            {
+              const number *block = &values[k * entries_per_block + r * block_size];
+              const size_type col_start = static_cast<size_type>(block_column[k]) * block_size;
+              for (unsigned int c = (block_column[k] == I ? r + 1 : 0); c < block_size; ++c)
+                s += block[c] * dst(col_start + c);
+            }
+          dst(row) -= s * omega;
+          dst(row) /= diag_element(row);
+        }
+  }
+
+
+
+  template <int block_size, typename number>
+  void
+  BSRMatrix<block_size,number>::copy_to (SparsityPattern      &sparsity,
+                                         SparseMatrix<number> &matrix) const
+  {
+    DynamicSparsityPattern dsp(m(), n());
+    for (unsigned int I = 0; I < n_block_rows; ++I)
+      for (unsigned int r = 0; r < block_size; ++r)
+        for (std::size_t k = row_start[I]; k < row_start[I + 1]; ++k)
+          for (unsigned int c = 0; c < block_size; ++c)
+            dsp.add(static_cast<size_type>(I) * block_size + r,
+                    static_cast<size_type>(block_column[k]) * block_size + c);
+    sparsity.copy_from(dsp);
+    matrix.reinit(sparsity);
+
+    for (unsigned int I = 0; I < n_block_rows; ++I)
+      for (unsigned int r = 0; r < block_size; ++r)
+        for (std::size_t k = row_start[I]; k < row_start[I + 1]; ++k)
+          for (unsigned int c = 0; c < block_size; ++c)
+            matrix.set(static_cast<size_type>(I) * block_size + r,
+                       static_cast<size_type>(block_column[k]) * block_size + c,
+                       values[k * entries_per_block + r * block_size + c]);
+  }
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+
+using namespace dealii;
+
+  /**
+   * Scalar coefficients which are constant on each cell, e.g. a design
+   * density or material parameters that vary from cell to cell.
+   *
+   * Like the FiberDirections, the coefficients are stored once per cell batch
+   * of a MatrixFree object as VectorizedArray, i.e. one value per lane, so
+   * that the matrix-free operator loads them once before the loop over
+   * quadrature points. They are set and read per active cell, in which form
+   * they are used by the matrix-based assembly and the driver.
+   */
+  template <int dim, typename number>
+  class CellCoefficients
+  {
+  public:
+    CellCoefficients ();
+
+    /**
+     * Set up the storage of @p n_components coefficients for the cell
+     * batches of @p data. All coefficients are initialized with
+     * @p initial_value.
+     */
+    void reinit (const MatrixFree<dim,number> &data,
+                 const unsigned int            n_components,
+                 const number                  initial_value = 1.);
+
+    /**
+     * Check that the cell batches of @p data are laid out in the same way as
+     * those the storage was set up with.
+     */
+    bool matches (const MatrixFree<dim,number> &data) const;
+
+    unsigned int n_components () const;
+
+    /**
+     * Set the coefficient @p component of all cells from @p values, which is
+     * indexed by the active cell index. Unfilled lanes of the last cell
+     * batches get the value of the first lane.
+     */
+    void set (const unsigned int    component,
+              const Vector<double> &values);
+
+    /**
+     * Coefficient @p component on all lanes of the cell batch @p cell.
+     */
+    const VectorizedArray<number> &
+    get (const unsigned int cell,
+         const unsigned int component) const;
+
+    /**
+     * Coefficient @p component on the cell with the given active cell index.
+     */
+    number
+    get_active_cell (const unsigned int active_cell_index,
+                     const unsigned int component) const;
+
+    std::size_t memory_consumption () const;
+
+  private:
+    unsigned int n_coefficients;
+    unsigned int n_cell_batches;
+
+    AlignedVector<VectorizedArray<number>> coefficients;
+
+    /**
+     * Cell batch and lane for each active cell.
+     */
+    std::vector<std::pair<unsigned int,unsigned int>> active_cell_to_batch_lane;
+
+    std::vector<unsigned int> n_filled_lanes;
+  };
+
+
+
+  template <int dim, typename number>
+  CellCoefficients<dim,number>::CellCoefficients ()
+    :
+    n_coefficients(0),
+    n_cell_batches(0)
+  {}
+
+
+
+  template <int dim, typename number>
+  void
+  CellCoefficients<dim,number>::reinit (const MatrixFree<dim,number> &data,
+                                        const unsigned int            n_components_,
+                                        const number                  initial_value)
+  {
+    n_coefficients = n_components_;
+    n_cell_batches = data.n_macro_cells();
+
+    coefficients.resize(n_cell_batches*n_coefficients);
+    for (unsigned int i=0; i<coefficients.size(); ++i)
+      coefficients[i] = make_vectorized_array<number>(initial_value);
+
+    active_cell_to_batch_lane.assign(data.get_dof_handler().get_triangulation().n_active_cells(),
+                                     std::make_pair(numbers::invalid_unsigned_int,
+                                                    numbers::invalid_unsigned_int));
+
+    n_filled_lanes.resize(n_cell_batches);
+    for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+      {
+        n_filled_lanes[cell] = data.n_components_filled(cell);
+        for (unsigned int v=0; v<n_filled_lanes[cell]; ++v)
+          active_cell_to_batch_lane[data.get_cell_iterator(cell,v)->active_cell_index()] = std::make_pair(cell,v);
+      }
+  }
+
+
+
+  template <int dim, typename number>
+  bool
+  CellCoefficients<dim,number>::matches (const MatrixFree<dim,number> &data) const
+  {
+    if (data.n_macro_cells() != n_cell_batches)
+      return false;
+
+    for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+      for (unsigned int v=0; v<data.n_components_filled(cell); ++v)
+        if (active_cell_to_batch_lane[data.get_cell_iterator(cell,v)->active_cell_index()] !=
+            std::make_pair(cell,v))
+          return false;
+
+    return true;
+  }
+
+
+
+  template <int dim, typename number>
+  unsigned int
+  CellCoefficients<dim,number>::n_components () const
+  {
+    return n_coefficients;
+  }
+
+
+
+  template <int dim, typename number>
+  void
+  CellCoefficients<dim,number>::set (const unsigned int    component,
+                                     const Vector<double> &values)
+  {
+    Assert (component < n_coefficients, ExcIndexRange(component, 0, n_coefficients));
+    AssertDimension (values.size(), active_cell_to_batch_lane.size());
+
+    for (unsigned int i=0; i<active_cell_to_batch_lane.size(); ++i)
+      {
+        const std::pair<unsigned int,unsigned int> &batch_lane = active_cell_to_batch_lane[i];
+        Assert (batch_lane.first != numbers::invalid_unsigned_int, ExcInternalError());
+        coefficients[batch_lane.first*n_coefficients+component][batch_lane.second] = values(i);
+      }
+
+    for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+      {
+        VectorizedArray<number> &c = coefficients[cell*n_coefficients+component];
+        for (unsigned int v=n_filled_lanes[cell]; v<VectorizedArray<number>::n_array_elements; ++v)
+          c[v] = c[0];
+      }
+  }
+
+
+
+  template <int dim, typename number>
+  inline
+  const VectorizedArray<number> &
+  CellCoefficients<dim,number>::get (const unsigned int cell,
+                                     const unsigned int component) const
+  {
+    Assert (cell < n_cell_batches, ExcIndexRange(cell, 0, n_cell_batches));
+    Assert (component < n_coefficients, ExcIndexRange(component, 0, n_coefficients));
+    return coefficients[cell*n_coefficients+component];
+  }
+
+
+
+  template <int dim, typename number>
+  inline
+  number
+  CellCoefficients<dim,number>::get_active_cell (const unsigned int active_cell_index,
+                                                 const unsigned int component) const
+  {
+    const std::pair<unsigned int,unsigned int> &batch_lane = active_cell_to_batch_lane[active_cell_index];
+    Assert (batch_lane.first != numbers::invalid_unsigned_int, ExcInternalError());
+
+    return get(batch_lane.first,component)[batch_lane.second];
+  }
+
+
+
+  template <int dim, typename number>
+  std::size_t
+  CellCoefficients<dim,number>::memory_consumption () const
+  {
+    return coefficients.memory_consumption() +
+           MemoryConsumption::memory_consumption(active_cell_to_batch_lane) +
+           MemoryConsumption::memory_consumption(n_filled_lanes);
+  }
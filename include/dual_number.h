@@ -0,0 +1,366 @@
+#pragma once
+
+#include <deal.II/base/template_constraints.h>
+#include <deal.II/base/vectorization.h>
+
+#include <vectorized_math.h>
+
+#include <type_traits>
+
+using namespace dealii;
+
+namespace internal
+{
+  // Conversion of a scalar constant to the number type, which broadcasts it
+  // for vectorized and nested dual numbers
+  template <typename Number>
+  struct ScalarConstant
+  {
+    static Number
+    make(const double x)
+    {
+      return Number(x);
+    }
+  };
+
+  template <typename Number>
+  struct ScalarConstant<VectorizedArray<Number>>
+  {
+    static VectorizedArray<Number>
+    make(const double x)
+    {
+      return make_vectorized_array<Number>(x);
+    }
+  };
+}
+
+
+
+/**
+ * Dual number $a + b \varepsilon$ with $\varepsilon^2 = 0$ for the forward
+ * mode automatic differentiation. Evaluating a function on $x + \varepsilon$
+ * gives its value and its derivative at $x$. With Number a VectorizedArray,
+ * all lanes are differentiated at once, and nesting dual numbers gives
+ * directional second derivatives.
+ *
+ * The type can be used as the number type of deal.II tensors. The functions
+ * of VectorizedMath are overloaded for it below, so that strain energy
+ * functions written with those are differentiated as well.
+ */
+template <typename Number>
+class DualNumber
+{
+public:
+  DualNumber ()
+    :
+    value(internal::ScalarConstant<Number>::make(0.)),
+    derivative(internal::ScalarConstant<Number>::make(0.))
+  {}
+
+  DualNumber (const Number &value,
+              const Number &derivative)
+    :
+    value(value),
+    derivative(derivative)
+  {}
+
+  // Constants, i.e. numbers with vanishing derivative:
+  DualNumber (const Number &value)
+    :
+    value(value),
+    derivative(internal::ScalarConstant<Number>::make(0.))
+  {}
+
+  template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+  DualNumber (const T value)
+    :
+    value(internal::ScalarConstant<Number>::make(value)),
+    derivative(internal::ScalarConstant<Number>::make(0.))
+  {}
+
+  DualNumber &
+  operator += (const DualNumber &x)
+  {
+    value += x.value;
+    derivative += x.derivative;
+    return *this;
+  }
+
+  DualNumber &
+  operator -= (const DualNumber &x)
+  {
+    value -= x.value;
+    derivative -= x.derivative;
+    return *this;
+  }
+
+  DualNumber &
+  operator *= (const DualNumber &x)
+  {
+    derivative = derivative * x.value + value * x.derivative;
+    value *= x.value;
+    return *this;
+  }
+
+  DualNumber &
+  operator /= (const DualNumber &x)
+  {
+    value /= x.value;
+    derivative = (derivative - value * x.derivative) / x.value;
+    return *this;
+  }
+
+  template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+  DualNumber &
+  operator *= (const T factor)
+  {
+    value *= static_cast<double>(factor);
+    derivative *= static_cast<double>(factor);
+    return *this;
+  }
+
+  template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+  DualNumber &
+  operator /= (const T factor)
+  {
+    return *this *= (1. / factor);
+  }
+
+  Number value;
+  Number derivative;
+};
+
+
+
+// The arithmetic operations with dual numbers, with the underlying number
+// type and with plain scalars. The latter are passed on as double, for which
+// VectorizedArray provides the operations:
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator - (const DualNumber<Number> &x)
+{
+  return DualNumber<Number>(-x.value, -x.derivative);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator + (DualNumber<Number> x, const DualNumber<Number> &y)
+{
+  return x += y;
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator - (DualNumber<Number> x, const DualNumber<Number> &y)
+{
+  return x -= y;
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator * (const DualNumber<Number> &x, const DualNumber<Number> &y)
+{
+  return DualNumber<Number>(x.value * y.value,
+                            x.derivative * y.value + x.value * y.derivative);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator / (const DualNumber<Number> &x, const DualNumber<Number> &y)
+{
+  const Number quotient = x.value / y.value;
+  return DualNumber<Number>(quotient,
+                            (x.derivative - quotient * y.derivative) / y.value);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator + (const DualNumber<Number> &x, const Number &y)
+{
+  return DualNumber<Number>(x.value + y, x.derivative);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator + (const Number &x, const DualNumber<Number> &y)
+{
+  return DualNumber<Number>(x + y.value, y.derivative);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator - (const DualNumber<Number> &x, const Number &y)
+{
+  return DualNumber<Number>(x.value - y, x.derivative);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator - (const Number &x, const DualNumber<Number> &y)
+{
+  return DualNumber<Number>(x - y.value, -y.derivative);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator * (const DualNumber<Number> &x, const Number &y)
+{
+  return DualNumber<Number>(x.value * y, x.derivative * y);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator * (const Number &x, const DualNumber<Number> &y)
+{
+  return DualNumber<Number>(x * y.value, x * y.derivative);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator / (const DualNumber<Number> &x, const Number &y)
+{
+  return DualNumber<Number>(x.value / y, x.derivative / y);
+}
+
+template <typename Number>
+inline
+DualNumber<Number>
+operator / (const Number &x, const DualNumber<Number> &y)
+{
+  const Number quotient = x / y.value;
+  return DualNumber<Number>(quotient, -quotient * y.derivative / y.value);
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator + (const DualNumber<Number> &x, const T y)
+{
+  return DualNumber<Number>(x.value + static_cast<double>(y), x.derivative);
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator + (const T x, const DualNumber<Number> &y)
+{
+  return DualNumber<Number>(static_cast<double>(x) + y.value, y.derivative);
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator - (const DualNumber<Number> &x, const T y)
+{
+  return DualNumber<Number>(x.value - static_cast<double>(y), x.derivative);
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator - (const T x, const DualNumber<Number> &y)
+{
+  return DualNumber<Number>(static_cast<double>(x) - y.value, -y.derivative);
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator * (const DualNumber<Number> &x, const T y)
+{
+  return DualNumber<Number>(x.value * static_cast<double>(y), x.derivative * static_cast<double>(y));
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator * (const T x, const DualNumber<Number> &y)
+{
+  return DualNumber<Number>(static_cast<double>(x) * y.value, static_cast<double>(x) * y.derivative);
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator / (const DualNumber<Number> &x, const T y)
+{
+  return x * (1. / y);
+}
+
+template <typename Number, typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline
+DualNumber<Number>
+operator / (const T x, const DualNumber<Number> &y)
+{
+  const Number quotient = static_cast<double>(x) / y.value;
+  return DualNumber<Number>(quotient, -quotient * y.derivative / y.value);
+}
+
+
+
+// Dual numbers are scalars for the tensor classes of deal.II:
+namespace dealii
+{
+  template <typename Number>
+  struct EnableIfScalar<DualNumber<Number>>
+  {
+    typedef DualNumber<Number> type;
+  };
+}
+
+
+
+// The chain rule for the functions of the vectorized math layer. They are
+// more specialized than the generic versions there and hence preferred for
+// dual numbers:
+namespace VectorizedMath
+{
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  DualNumber<Number>
+  exp(const DualNumber<Number> &x)
+  {
+    const Number exp_x = exp<accuracy>(x.value);
+    return DualNumber<Number>(exp_x, exp_x * x.derivative);
+  }
+
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  DualNumber<Number>
+  log(const DualNumber<Number> &x)
+  {
+    return DualNumber<Number>(log<accuracy>(x.value), x.derivative / x.value);
+  }
+
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  DualNumber<Number>
+  pow(const DualNumber<Number> &x,
+      const double              y)
+  {
+    const Number pow_x = pow<accuracy>(x.value, y);
+    return DualNumber<Number>(pow_x, (pow_x / x.value) * x.derivative * y);
+  }
+
+  template <typename Number>
+  inline
+  DualNumber<Number>
+  sqrt(const DualNumber<Number> &x)
+  {
+    const Number sqrt_x = sqrt(x.value);
+    return DualNumber<Number>(sqrt_x, x.derivative / sqrt_x * 0.5);
+  }
+}
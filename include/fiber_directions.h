@@ -0,0 +1,196 @@
+#pragma once
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <functional>
+
+using namespace dealii;
+
+  /**
+   * Referential fiber directions of anisotropic materials.
+   *
+   * The directions are constant on each cell, so they are stored once per
+   * cell batch of a MatrixFree object rather than at the quadrature points:
+   * for each fiber family, a cell batch holds a single
+   * Tensor<1,dim,VectorizedArray<number>>, i.e. one direction per lane. The
+   * matrix-free operator loads the fibers of a cell batch once before the
+   * loop over quadrature points. The matrix-based assembly accesses the lanes
+   * through the active cell index.
+   */
+  template <int dim, typename number>
+  class FiberDirections
+  {
+  public:
+    typedef std::function<Tensor<1,dim>(const typename DoFHandler<dim>::cell_iterator &,
+                                        const unsigned int)> DirectionFunction;
+
+    FiberDirections ();
+
+    /**
+     * Evaluate the direction of each of the @p n_fiber_families families on
+     * every cell of @p data. The directions returned by @p direction are
+     * normalized here. Unfilled lanes of the last cell batches are set to the
+     * direction of the first lane.
+     */
+    void reinit (const MatrixFree<dim,number> &data,
+                 const unsigned int            n_fiber_families,
+                 const DirectionFunction      &direction);
+
+    /**
+     * Check that the cell batches of @p data are laid out in the same way as
+     * those the storage was set up with.
+     */
+    bool matches (const MatrixFree<dim,number> &data) const;
+
+    unsigned int n_fiber_families () const;
+
+    /**
+     * Direction of @p family on all lanes of the cell batch @p cell.
+     */
+    const Tensor<1,dim,VectorizedArray<number>> &
+    get (const unsigned int cell,
+         const unsigned int family) const;
+
+    /**
+     * Direction of @p family on the cell with the given active cell index.
+     */
+    Tensor<1,dim,number>
+    get_active_cell (const unsigned int active_cell_index,
+                     const unsigned int family) const;
+
+    std::size_t memory_consumption () const;
+
+  private:
+    unsigned int n_families;
+    unsigned int n_cell_batches;
+
+    AlignedVector<Tensor<1,dim,VectorizedArray<number>>> directions;
+
+    /**
+     * Cell batch and lane for each active cell.
+     */
+    std::vector<std::pair<unsigned int,unsigned int>> active_cell_to_batch_lane;
+  };
+
+
+
+  template <int dim, typename number>
+  FiberDirections<dim,number>::FiberDirections ()
+    :
+    n_families(0),
+    n_cell_batches(0)
+  {}
+
+
+
+  template <int dim, typename number>
+  void
+  FiberDirections<dim,number>::reinit (const MatrixFree<dim,number> &data,
+                                       const unsigned int            n_fiber_families_,
+                                       const DirectionFunction      &direction)
+  {
+    n_families = n_fiber_families_;
+    n_cell_batches = data.n_macro_cells();
+
+    directions.resize(n_cell_batches*n_families);
+    active_cell_to_batch_lane.assign(data.get_dof_handler().get_triangulation().n_active_cells(),
+                                     std::make_pair(numbers::invalid_unsigned_int,
+                                                    numbers::invalid_unsigned_int));
+
+    for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+      {
+        for (unsigned int v=0; v<data.n_components_filled(cell); ++v)
+          {
+            const typename DoFHandler<dim>::cell_iterator cell_it = data.get_cell_iterator(cell,v);
+            active_cell_to_batch_lane[cell_it->active_cell_index()] = std::make_pair(cell,v);
+
+            for (unsigned int f=0; f<n_families; ++f)
+              {
+                const Tensor<1,dim> a = direction(cell_it,f);
+                Assert (a.norm() > 0, ExcMessage("Fiber direction must not vanish"));
+                for (unsigned int d=0; d<dim; ++d)
+                  directions[cell*n_families+f][d][v] = a[d] / a.norm();
+              }
+          }
+
+        for (unsigned int v=data.n_components_filled(cell); v<VectorizedArray<number>::n_array_elements; ++v)
+          for (unsigned int f=0; f<n_families; ++f)
+            for (unsigned int d=0; d<dim; ++d)
+              directions[cell*n_families+f][d][v] = directions[cell*n_families+f][d][0];
+      }
+  }
+
+
+
+  template <int dim, typename number>
+  bool
+  FiberDirections<dim,number>::matches (const MatrixFree<dim,number> &data) const
+  {
+    if (data.n_macro_cells() != n_cell_batches)
+      return false;
+
+    for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+      for (unsigned int v=0; v<data.n_components_filled(cell); ++v)
+        if (active_cell_to_batch_lane[data.get_cell_iterator(cell,v)->active_cell_index()] !=
+            std::make_pair(cell,v))
+          return false;
+
+    return true;
+  }
+
+
+
+  template <int dim, typename number>
+  unsigned int
+  FiberDirections<dim,number>::n_fiber_families () const
+  {
+    return n_families;
+  }
+
+
+
+  template <int dim, typename number>
+  inline
+  const Tensor<1,dim,VectorizedArray<number>> &
+  FiberDirections<dim,number>::get (const unsigned int cell,
+                                    const unsigned int family) const
+  {
+    Assert (cell < n_cell_batches, ExcIndexRange(cell, 0, n_cell_batches));
+    Assert (family < n_families, ExcIndexRange(family, 0, n_families));
+    return directions[cell*n_families+family];
+  }
+
+
+
+  template <int dim, typename number>
+  inline
+  Tensor<1,dim,number>
+  FiberDirections<dim,number>::get_active_cell (const unsigned int active_cell_index,
+                                                const unsigned int family) const
+  {
+    const std::pair<unsigned int,unsigned int> &batch_lane = active_cell_to_batch_lane[active_cell_index];
+    Assert (batch_lane.first != numbers::invalid_unsigned_int, ExcInternalError());
+
+    const Tensor<1,dim,VectorizedArray<number>> &a = get(batch_lane.first,family);
+    Tensor<1,dim,number> result;
+    for (unsigned int d=0; d<dim; ++d)
+      result[d] = a[d][batch_lane.second];
+    return result;
+  }
+
+
+
+  template <int dim, typename number>
+  std::size_t
+  FiberDirections<dim,number>::memory_consumption () const
+  {
+    return directions.memory_consumption() +
+           MemoryConsumption::memory_consumption(active_cell_to_batch_lane);
+  }
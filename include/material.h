@@ -3,6 +3,11 @@
 #include <deal.II/physics/elasticity/kinematics.h>
 #include <deal.II/physics/elasticity/standard_tensors.h>
 
+#include <dual_number.h>
+#include <vectorized_math.h>
+
+#include <array>
+
 using namespace dealii;
 
 /**
@@ -39,6 +44,35 @@ VectorizedArray<number> divide_by_dim(const VectorizedArray<number> &x,
   return res;
 }
 
+// Isochoric part $J^{-1/d} \mathbf{F}$ of the deformation gradient. Unlike
+// Physics::Elasticity::Kinematics::F_iso(), the power is evaluated on all
+// lanes at once for vectorized arguments:
+template <int dim, typename NumberType>
+inline
+Tensor<2, dim, NumberType>
+F_iso(const Tensor<2, dim, NumberType> &F)
+{
+  return VectorizedMath::exp(VectorizedMath::log(determinant(F)) * (-1.0/dim)) * F;
+}
+
+// Indicator of positive values, which is evaluated lane by lane for
+// vectorized arguments:
+template <typename number>
+number positive_indicator(const number &x)
+{
+  return x > 0 ? number(1.) : number(0.);
+}
+
+template <typename number>
+VectorizedArray<number> positive_indicator(const VectorizedArray<number> &x)
+{
+  VectorizedArray<number> res;
+  for (unsigned int i = 0; i < VectorizedArray<number>::n_array_elements; i++)
+    res[i] = x[i] > 0 ? 1. : 0.;
+
+  return res;
+}
+
 // As discussed in the literature and step-44, Neo-Hookean materials are a type
 // of hyperelastic materials.  The entire domain is assumed to be composed of a
 // compressible neo-Hookean material.  This class defines the behaviour of
@@ -71,11 +105,16 @@ VectorizedArray<number> divide_by_dim(const VectorizedArray<number> &x,
   class Material_Compressible_Neo_Hook_One_Field
   {
   public:
+    // The isochoric response can be scaled independently of the bulk
+    // modulus, which gives the instantaneous response of the viscoelastic
+    // material below.
     Material_Compressible_Neo_Hook_One_Field(const double mu,
-                                             const double nu)
+                                             const double nu,
+                                             const double isochoric_scaling = 1.0)
       :
       kappa((2.0 * mu * (1.0 + nu)) / (3.0 * (1.0 - 2.0 * nu))),
-      c_1(mu / 2.0)
+      c_1(isochoric_scaling * mu / 2.0),
+      dkappa_dnu(kappa * 3.0 / ((1.0 + nu) * (1.0 - 2.0 * nu)))
     {
       Assert(kappa > 0, ExcInternalError());
     }
@@ -92,6 +131,27 @@ VectorizedArray<number> divide_by_dim(const VectorizedArray<number> &x,
       return get_Psi_vol(det_F) + get_Psi_iso(b_bar);
     }
 
+    // The energy for the shear and the bulk modulus scaled by @p mu_scaling
+    // and @p kappa_scaling, see the corresponding overload of get_tau.
+    NumberType
+    get_Psi(const NumberType                        &det_F,
+            const SymmetricTensor<2,dim,NumberType> &b_bar,
+            const NumberType                        &mu_scaling,
+            const NumberType                        &kappa_scaling) const
+    {
+      return kappa_scaling * get_Psi_vol(det_F) + mu_scaling * get_Psi_iso(b_bar);
+    }
+
+    // The part of the energy which drives the fracture, i.e. the isochoric
+    // energy and the volumetric energy under tension $J > 1$. The volumetric
+    // energy under compression does not open cracks.
+    NumberType
+    get_Psi_tensile(const NumberType                        &det_F,
+                    const SymmetricTensor<2,dim,NumberType> &b_bar) const
+    {
+      return positive_indicator(det_F - 1.0) * get_Psi_vol(det_F) + get_Psi_iso(b_bar);
+    }
+
     // The second function determines the Kirchhoff stress $\boldsymbol{\tau}
     // = \boldsymbol{\tau}_{\textrm{iso}} + \boldsymbol{\tau}_{\textrm{vol}}$
     void
@@ -136,10 +196,6 @@ VectorizedArray<number> divide_by_dim(const VectorizedArray<number> &x,
       SymmetricTensor<2,dim,NumberType> res;
       const NumberType tr = trace(src);
 
-      SymmetricTensor<2,dim,NumberType> dev_src(src);
-      for (unsigned int i = 0; i < dim; ++i)
-        dev_src[i][i] -= divide_by_dim(tr,dim);
-
       // 1) The volumetric part of the tangent $J
       // \mathfrak{c}_\textrm{vol}$. Again, note the difference in its
       // definition when compared to step-44. The extra terms result from two
@@ -159,6 +215,189 @@ VectorizedArray<number> divide_by_dim(const VectorizedArray<number> &x,
 
       // 2) the isochoric part of the tangent $J
       // \mathfrak{c}_\textrm{iso}$:
+      res += act_Jc_iso(b_bar,src);
+
+      return res;
+    }
+
+    // The Kirchhoff stress and the action of the tangent for moduli that
+    // vary in space, where the shear and the bulk modulus of this material
+    // are scaled by @p mu_scaling and @p kappa_scaling. The isochoric part of
+    // the response is linear in the former, the volumetric part in the
+    // latter.
+    void
+    get_tau(SymmetricTensor<2,dim,NumberType>       &res,
+            const NumberType                        &det_F,
+            const SymmetricTensor<2,dim,NumberType> &b_bar,
+            const NumberType                        &mu_scaling,
+            const NumberType                        &kappa_scaling)
+    {
+      res = NumberType();
+
+      const NumberType tmp = NumberType(kappa_scaling * get_dPsi_vol_dJ(det_F) * det_F);
+
+      SymmetricTensor<2,dim,NumberType> tau_bar = b_bar * (2.0 * c_1);
+      tau_bar *= mu_scaling;
+      NumberType tr = trace(tau_bar);
+      for (unsigned int d = 0; d < dim; ++d)
+        res[d][d] = tmp - divide_by_dim(tr,dim);
+
+      res += tau_bar;
+    }
+
+    SymmetricTensor<2,dim,NumberType>
+    act_Jc(const NumberType                        &det_F,
+           const SymmetricTensor<2,dim,NumberType> &b_bar,
+           const SymmetricTensor<2,dim,NumberType> &src,
+           const NumberType                        &mu_scaling,
+           const NumberType                        &kappa_scaling) const
+    {
+      SymmetricTensor<2,dim,NumberType> res = src;
+      res*= - det_F*(2.0 * get_dPsi_vol_dJ(det_F));
+
+      const NumberType tmp = det_F * (get_dPsi_vol_dJ(det_F) + det_F * get_d2Psi_vol_dJ2(det_F)) * trace(src);
+      for (unsigned int i = 0; i < dim; ++i)
+        res[i][i] += tmp;
+      res *= kappa_scaling;
+
+      SymmetricTensor<2,dim,NumberType> res_iso = act_Jc_iso(b_bar,src);
+      res_iso *= mu_scaling;
+      res += res_iso;
+
+      return res;
+    }
+
+    // The Kirchhoff stress of the mean dilatation formulation, see Simo,
+    // Taylor and Pister (1985). This is the F-bar method with the cell
+    // average $\theta = \frac{1}{V} \int_{\Omega_0^e} J \, dV$ of the
+    // Jacobian, i.e. the ratio of current and reference cell volume, in the
+    // volumetric response. The pressure $p = \Psi_{\textrm{vol}}'(\theta)$
+    // is constant on each cell, the volumetric Kirchhoff stress is
+    // $\boldsymbol{\tau}_{\textrm{vol}} = J p \mathbf{I}$:
+    void
+    get_tau_mean_dilatation(SymmetricTensor<2,dim,NumberType>       &res,
+                            const NumberType                        &det_F,
+                            const SymmetricTensor<2,dim,NumberType> &b_bar,
+                            const NumberType                        &theta)
+    {
+      res = NumberType();
+
+      const NumberType tmp = NumberType(get_dPsi_vol_dJ(theta) * det_F);
+
+      SymmetricTensor<2,dim,NumberType> tau_bar = b_bar * (2.0 * c_1);
+      NumberType tr = trace(tau_bar);
+      for (unsigned int d = 0; d < dim; ++d)
+        res[d][d] = tmp - divide_by_dim(tr,dim);
+
+      res += tau_bar;
+    }
+
+    // The action of the tangent of the mean dilatation formulation at fixed
+    // pressure, $J \mathfrak{c}_{\textrm{vol}} = J p [\mathbf{I} \otimes
+    // \mathbf{I} - 2 \mathcal{I}]$ plus the isochoric part. The change of
+    // the pressure with the cell volume couples all quadrature points of a
+    // cell and has to be added by the caller: it contributes
+    // $\frac{\Psi_{\textrm{vol}}''(\theta)}{V} \int_{\Omega^e}
+    // \nabla \cdot \delta \mathbf{v} \, dv \int_{\Omega^e} \nabla
+    // \cdot \varDelta \mathbf{u} \, dv$ to the bilinear form, which keeps
+    // the tangent symmetric.
+    SymmetricTensor<2,dim,NumberType>
+    act_Jc_mean_dilatation(const NumberType                        &det_F,
+                           const SymmetricTensor<2,dim,NumberType> &b_bar,
+                           const NumberType                        &theta,
+                           const SymmetricTensor<2,dim,NumberType> &src) const
+    {
+      const NumberType Jp = det_F * get_dPsi_vol_dJ(theta);
+
+      SymmetricTensor<2,dim,NumberType> res = src;
+      res *= -2.0 * Jp;
+
+      const NumberType tmp = Jp * trace(src);
+      for (unsigned int i = 0; i < dim; ++i)
+        res[i][i] += tmp;
+
+      res += act_Jc_iso(b_bar,src);
+
+      return res;
+    }
+
+    // Second derivative of the volumetric free energy wrt $J$. We
+    // need the following computation explicitly in the tangent so we make it
+    // public.  We calculate $\frac{\partial^2
+    // \Psi_{\textrm{vol}}(J)}{\partial J \partial
+    // J}$
+    NumberType
+    get_d2Psi_vol_dJ2(const NumberType &det_F) const
+    {
+        return ( (kappa / 2.0) * (1.0 + 1.0 / (det_F * det_F)));
+    }
+
+    // Derivatives of the Kirchhoff stress with respect to the shear modulus
+    // $\mu$ and the Poisson's ratio $\nu$. Both the isochoric and the
+    // volumetric stress are linear in $\mu$ for fixed $\nu$, hence
+    // $\partial \boldsymbol{\tau} / \partial \mu = \boldsymbol{\tau} / \mu$,
+    // whereas $\nu$ only enters the bulk modulus:
+    // $\partial \boldsymbol{\tau} / \partial \nu = \boldsymbol{\tau}_{\textrm{vol}}
+    // \frac{1}{\kappa} \frac{\partial \kappa}{\partial \nu}$.
+    void
+    get_dtau_dparameters(SymmetricTensor<2,dim,NumberType>       &dtau_dmu,
+                         SymmetricTensor<2,dim,NumberType>       &dtau_dnu,
+                         const NumberType                        &det_F,
+                         const SymmetricTensor<2,dim,NumberType> &b_bar)
+    {
+      get_tau(dtau_dmu,det_F,b_bar);
+      dtau_dmu *= 1.0 / (2.0 * c_1);
+
+      dtau_dnu = NumberType();
+      const NumberType tmp = NumberType(get_dPsi_vol_dJ(det_F) * det_F * (dkappa_dnu / kappa));
+      for (unsigned int d = 0; d < dim; ++d)
+        dtau_dnu[d][d] = tmp;
+    }
+
+  private:
+    // Define constitutive model parameters $\kappa$ (bulk modulus) and the
+    // neo-Hookean model parameter $c_1$:
+    const double kappa;
+    const double c_1;
+
+    // Derivative of the bulk modulus with respect to the Poisson's ratio
+    const double dkappa_dnu;
+
+    // Value of the volumetric free energy
+    NumberType
+    get_Psi_vol(const NumberType &det_F) const
+    {
+      return (kappa / 4.0) * (det_F*det_F - 1.0 - 2.0*VectorizedMath::log(det_F));
+    }
+
+    // Value of the isochoric free energy
+    NumberType
+    get_Psi_iso(const SymmetricTensor<2,dim,NumberType> &b_bar) const
+    {
+      return c_1 * (trace(b_bar) - dim);
+    }
+
+    // Derivative of the volumetric free energy with respect to
+    // $J$ return $\frac{\partial
+    // \Psi_{\text{vol}}(J)}{\partial J}$
+    NumberType
+    get_dPsi_vol_dJ(const NumberType &det_F) const
+    {
+        return (kappa / 2.0) * (det_F - 1.0 / det_F);
+    }
+
+    // The isochoric part of the tangent
+    // $J \mathfrak{c}_\textrm{iso}$ acting on a symmetric tensor:
+    SymmetricTensor<2,dim,NumberType>
+    act_Jc_iso(const SymmetricTensor<2,dim,NumberType> &b_bar,
+               const SymmetricTensor<2,dim,NumberType> &src) const
+    {
+      SymmetricTensor<2,dim,NumberType> res;
+      const NumberType tr = trace(src);
+
+      SymmetricTensor<2,dim,NumberType> dev_src(src);
+      for (unsigned int i = 0; i < dim; ++i)
+        dev_src[i][i] -= divide_by_dim(tr,dim);
 
       // trace of fictitious Kirchhoff stress
       // $\overline{\boldsymbol{\tau}}$:
@@ -185,41 +424,236 @@ VectorizedArray<number> divide_by_dim(const VectorizedArray<number> &x,
       // c_bar==0 so we don't have a term with it.
       return res;
     }
+  };
 
-  private:
-    // Define constitutive model parameters $\kappa$ (bulk modulus) and the
-    // neo-Hookean model parameter $c_1$:
-    const double kappa;
-    const double c_1;
 
-    // Value of the volumetric free energy
-    NumberType
-    get_Psi_vol(const NumberType &det_F) const
+
+
+// Finite strain $J_2$ plasticity following Simo (1992), see also Simo and
+// Hughes, Computational Inelasticity, Box 9.1 and 9.2. The elastic response is
+// the same neo-Hookean one as above, written in terms of the elastic left
+// Cauchy-Green tensor $\overline{\mathbf{b}}^e = \overline{\mathbf{F}}
+// \overline{\mathbf{C}}^{p\,-1} \overline{\mathbf{F}}^T$. The history at each
+// quadrature point consists of the isochoric inverse plastic right
+// Cauchy-Green tensor $\overline{\mathbf{C}}^{p\,-1}$, the equivalent
+// plastic strain $\alpha$ with linear isotropic hardening $K$ and the
+// (deviatoric, spatial) back stress $\boldsymbol{\beta}$ with linear
+// kinematic hardening $H$.
+//
+// Given the deformation gradient at the end of the step and the history at the
+// beginning of the step, the radial return mapping gives the stress, the
+// updated history and the coefficients of the consistent tangent. Plastic
+// and elastic quadrature points are not distinguished by branches but by an
+// indicator, so that the same code runs on all lanes of a vectorized cell
+// batch.
+//
+// The back stress is not transported with the plastic flow in the elastic
+// trial step, $\boldsymbol{\beta}^{\textrm{trial}} = \boldsymbol{\beta}_n$,
+// and the tangent neglects its change with the metric. For isotropic
+// hardening the tangent is the consistent one up to the term $\mathbf{n}
+// \otimes \textrm{dev}(\mathbf{n}^2)$, which vanishes for traceless
+// $2 \times 2$ tensors and is not symmetric in 3d. We use its symmetric part,
+// so that the tangent is symmetric and CG can be used.
+  template <int dim,typename NumberType>
+  class Material_J2_Plasticity
+  {
+  public:
+    static const unsigned int n_stress_components = SymmetricTensor<2,dim>::n_independent_components;
+
+    // $\overline{\mathbf{C}}^{p\,-1}$, $\alpha$ and $\boldsymbol{\beta}$:
+    static const unsigned int n_history_variables = 2 * n_stress_components + 1;
+
+    // Index of the equivalent plastic strain among the history variables:
+    static const unsigned int alpha_index = n_stress_components;
+
+    typedef std::array<NumberType,n_history_variables> History;
+
+    // The quantities of the return mapping that are needed to apply the
+    // tangent:
+    struct State
     {
-      return (kappa / 4.0) * (det_F*det_F - 1.0 - 2.0*std::log(det_F));
+      NumberType                        det_F;
+      NumberType                        mu_bar;
+      SymmetricTensor<2,dim,NumberType> tau;
+      SymmetricTensor<2,dim,NumberType> s_trial;
+      SymmetricTensor<2,dim,NumberType> n;
+      SymmetricTensor<2,dim,NumberType> dev_n2;
+      NumberType                        beta_1;
+      NumberType                        beta_3;
+      NumberType                        beta_4;
+    };
+
+    Material_J2_Plasticity(const double mu,
+                           const double nu,
+                           const double yield_stress,
+                           const double isotropic_hardening,
+                           const double kinematic_hardening)
+      :
+      kappa((2.0 * mu * (1.0 + nu)) / (3.0 * (1.0 - 2.0 * nu))),
+      mu(mu),
+      yield_stress(yield_stress),
+      K(isotropic_hardening),
+      H(kinematic_hardening)
+    {
+      Assert(kappa > 0, ExcInternalError());
+      Assert(yield_stress > 0, ExcInternalError());
     }
 
-    // Value of the isochoric free energy
-    NumberType
-    get_Psi_iso(const SymmetricTensor<2,dim,NumberType> &b_bar) const
+    // The undeformed, virgin state: $\overline{\mathbf{C}}^{p\,-1} =
+    // \mathbf{I}$, no plastic strain and no back stress.
+    static std::vector<double>
+    initial_history()
     {
-      return c_1 * (trace(b_bar) - dim);
+      std::vector<double> history(n_history_variables, 0.0);
+      for (unsigned int d = 0; d < dim; ++d)
+        history[SymmetricTensor<2,dim>::component_to_unrolled_index(TableIndices<2>(d,d))] = 1.0;
+      return history;
     }
 
-    // Derivative of the volumetric free energy with respect to
-    // $J$ return $\frac{\partial
-    // \Psi_{\text{vol}}(J)}{\partial J}$
+    void
+    return_mapping(State                            &state,
+                   History                          &history,
+                   const Tensor<2,dim,NumberType>   &F,
+                   const History                    &history_old) const
+    {
+      SymmetricTensor<2,dim,NumberType> C_p_inv_bar_old, beta_old;
+      for (unsigned int i = 0; i < n_stress_components; ++i)
+        {
+          const TableIndices<2> indices = SymmetricTensor<2,dim>::unrolled_to_component_indices(i);
+          C_p_inv_bar_old[indices] = history_old[i];
+          beta_old[indices] = history_old[alpha_index + 1 + i];
+        }
+      const NumberType &alpha_old = history_old[alpha_index];
+
+      // 1) Elastic trial state
+      state.det_F = determinant(F);
+      const Tensor<2,dim,NumberType> F_bar = F_iso(F);
+      const SymmetricTensor<2,dim,NumberType> b_bar_trial =
+        symmetrize(F_bar * Tensor<2,dim,NumberType>(C_p_inv_bar_old) * transpose(F_bar));
+
+      const NumberType I_bar = divide_by_dim(trace(b_bar_trial),dim);
+      state.mu_bar = I_bar * mu;
+      state.s_trial = b_bar_trial * mu;
+      for (unsigned int d = 0; d < dim; ++d)
+        state.s_trial[d][d] -= state.mu_bar;
+
+      // 2) Check the yield condition
+      const SymmetricTensor<2,dim,NumberType> xi_trial = state.s_trial - beta_old;
+      const NumberType norm_xi_trial = VectorizedMath::sqrt(xi_trial * xi_trial);
+      const NumberType f_trial = norm_xi_trial
+                                 - std::sqrt(2.0 / 3.0) * (yield_stress + K * alpha_old);
+      const NumberType plastic = positive_indicator(f_trial);
+
+      // 3) Radial return. In elastic lanes the plastic multiplier vanishes;
+      // the norm is shifted there only to avoid dividing by zero in the
+      // undeformed state.
+      const NumberType two_mu_bar_beta_0 = 2.0 * state.mu_bar + (2.0 / 3.0) * (K + H);
+      const NumberType delta_gamma = plastic * f_trial / two_mu_bar_beta_0;
+      const NumberType norm_xi_safe = norm_xi_trial + (1.0 - plastic);
+      state.n = xi_trial * (1.0 / norm_xi_safe);
+
+      const SymmetricTensor<2,dim,NumberType> s = state.s_trial - state.n * (2.0 * state.mu_bar * delta_gamma);
+      const NumberType alpha = alpha_old + std::sqrt(2.0 / 3.0) * delta_gamma;
+      const SymmetricTensor<2,dim,NumberType> beta = beta_old + state.n * ((2.0 / 3.0) * H * delta_gamma);
+
+      // 4) Kirchhoff stress $\boldsymbol{\tau} = J p \mathbf{I} + \mathbf{s}$
+      state.tau = s;
+      const NumberType tmp = NumberType(get_dPsi_vol_dJ(state.det_F) * state.det_F);
+      for (unsigned int d = 0; d < dim; ++d)
+        state.tau[d][d] += tmp;
+
+      // 5) Update the plastic deformation from $\overline{\mathbf{b}}^e =
+      // \mathbf{s} / \mu + \overline{I}^e \mathbf{I}$
+      SymmetricTensor<2,dim,NumberType> b_bar_e = s * (1.0 / mu);
+      for (unsigned int d = 0; d < dim; ++d)
+        b_bar_e[d][d] += I_bar;
+      const Tensor<2,dim,NumberType> F_bar_inv = invert(F_bar);
+      const SymmetricTensor<2,dim,NumberType> C_p_inv_bar =
+        symmetrize(F_bar_inv * Tensor<2,dim,NumberType>(b_bar_e) * transpose(F_bar_inv));
+
+      for (unsigned int i = 0; i < n_stress_components; ++i)
+        {
+          const TableIndices<2> indices = SymmetricTensor<2,dim>::unrolled_to_component_indices(i);
+          history[i] = C_p_inv_bar[indices];
+          history[alpha_index + 1 + i] = beta[indices];
+        }
+      history[alpha_index] = alpha;
+
+      // 6) Coefficients of the consistent tangent, Box 9.2
+      const NumberType beta_0 = two_mu_bar_beta_0 / (2.0 * state.mu_bar);
+      const NumberType beta_2 = (1.0 - 1.0 / beta_0) * (2.0 / dim) * norm_xi_trial / state.mu_bar * delta_gamma;
+      state.beta_1 = 2.0 * state.mu_bar * delta_gamma / norm_xi_safe;
+      state.beta_3 = plastic * (1.0 / beta_0 - state.beta_1 + beta_2);
+      state.beta_4 = plastic * (1.0 / beta_0 - state.beta_1) * norm_xi_trial / state.mu_bar;
+
+      state.dev_n2 = symmetrize(Tensor<2,dim,NumberType>(state.n) * Tensor<2,dim,NumberType>(state.n));
+      const NumberType tr_n2 = divide_by_dim(trace(state.dev_n2),dim);
+      for (unsigned int d = 0; d < dim; ++d)
+        state.dev_n2[d][d] -= tr_n2;
+    }
+
+    // The action of the algorithmic tangent $J \mathfrak{c}^{ep} =
+    // J \mathfrak{c}^{\textrm{trial}} - \beta_1 \overline{\mathfrak{c}}^{\textrm{trial}}
+    // - 2 \overline{\mu} \beta_3 \mathbf{n} \otimes \mathbf{n}
+    // - 2 \overline{\mu} \beta_4 \, \textrm{sym}[\mathbf{n} \otimes
+    // \textrm{dev}(\mathbf{n}^2)]$ on a symmetric tensor.
+    SymmetricTensor<2,dim,NumberType>
+    act_Jc(const State                             &state,
+           const SymmetricTensor<2,dim,NumberType> &src) const
+    {
+      const NumberType &det_F = state.det_F;
+      const NumberType tr = trace(src);
+
+      SymmetricTensor<2,dim,NumberType> dev_src(src);
+      for (unsigned int i = 0; i < dim; ++i)
+        dev_src[i][i] -= divide_by_dim(tr,dim);
+
+      // 1) the volumetric part, identical to the neo-Hookean material
+      SymmetricTensor<2,dim,NumberType> res = src;
+      res *= - det_F*(2.0 * get_dPsi_vol_dJ(det_F));
+
+      const NumberType tmp = det_F * (get_dPsi_vol_dJ(det_F) + det_F * get_d2Psi_vol_dJ2(det_F)) * tr;
+      for (unsigned int i = 0; i < dim; ++i)
+        res[i][i] += tmp;
+
+      // 2) the deviatoric trial tangent $\overline{\mathfrak{c}}^{\textrm{trial}} =
+      // 2 \overline{\mu} \mathcal{I}_{\textrm{dev}} - \frac{2}{d} [\mathbf{s}^{\textrm{trial}}
+      // \otimes \mathbf{I} + \mathbf{I} \otimes \mathbf{s}^{\textrm{trial}}]$,
+      // scaled by $1 - \beta_1$
+      SymmetricTensor<2,dim,NumberType> c_bar_src = dev_src * (2.0 * state.mu_bar);
+      c_bar_src -= state.s_trial * ((2.0 / dim) * tr);
+      const NumberType s_src = state.s_trial * src;
+      for (unsigned int i = 0; i < dim; ++i)
+        c_bar_src[i][i] -= (2.0 / dim) * s_src;
+
+      res += c_bar_src * (1.0 - state.beta_1);
+
+      // 3) the plastic corrections, which vanish at elastic points
+      const NumberType n_src = state.n * src;
+      const NumberType dev_n2_src = state.dev_n2 * src;
+      res -= state.n * (2.0 * state.mu_bar * state.beta_3 * n_src);
+      res -= (state.n * dev_n2_src + state.dev_n2 * n_src) * (state.mu_bar * state.beta_4);
+
+      return res;
+    }
+
+  private:
+    // The bulk modulus $\kappa$, the shear modulus $\mu$, the initial yield
+    // stress and the isotropic and kinematic hardening moduli:
+    const double kappa;
+    const double mu;
+    const double yield_stress;
+    const double K;
+    const double H;
+
+    // Derivatives of the volumetric free energy $\Psi_{\textrm{vol}}(J) =
+    // \kappa \frac{1}{4} [ J^2 - 1 - 2\textrm{ln}\; J ]$, see above:
     NumberType
     get_dPsi_vol_dJ(const NumberType &det_F) const
     {
         return (kappa / 2.0) * (det_F - 1.0 / det_F);
     }
 
-    // Second derivative of the volumetric free energy wrt $J$. We
-    // need the following computation explicitly in the tangent so we make it
-    // public.  We calculate $\frac{\partial^2
-    // \Psi_{\textrm{vol}}(J)}{\partial J \partial
-    // J}$
     NumberType
     get_d2Psi_vol_dJ2(const NumberType &det_F) const
     {
@@ -227,3 +661,497 @@ VectorizedArray<number> divide_by_dim(const VectorizedArray<number> &x,
     }
   };
 
+  template <int dim,typename NumberType>
+  const unsigned int Material_J2_Plasticity<dim,NumberType>::n_stress_components;
+
+  template <int dim,typename NumberType>
+  const unsigned int Material_J2_Plasticity<dim,NumberType>::n_history_variables;
+
+  template <int dim,typename NumberType>
+  const unsigned int Material_J2_Plasticity<dim,NumberType>::alpha_index;
+
+
+
+// Finite strain viscoelasticity with a Prony series, see Holzapfel, Nonlinear
+// Solid Mechanics, Section 6.10 and Simo (1987). The isochoric neo-Hookean
+// response from above is augmented by $m$ Maxwell elements with relative
+// stiffnesses $\beta_\alpha$ and relaxation times $\tau_\alpha$, whose
+// non-equilibrium stresses $\mathbf{Q}_\alpha$ are the internal variables. The
+// second Piola-Kirchhoff stress is $\mathbf{S} = \mathbf{S}_{\textrm{vol}} +
+// \mathbf{S}_{\textrm{iso}} + \sum_\alpha \mathbf{Q}_\alpha$ and the
+// recurrence
+// $\mathbf{Q}_\alpha^{n+1} = \mathbf{H}_\alpha^n + \beta_\alpha e^{\xi_\alpha}
+// \mathbf{S}_{\textrm{iso}}^{n+1}$, $\mathbf{H}_\alpha^n = e^{\xi_\alpha}
+// (e^{\xi_\alpha} \mathbf{Q}_\alpha^n - \beta_\alpha \mathbf{S}_{\textrm{iso}}^n)$,
+// $\xi_\alpha = -\varDelta t / (2 \tau_\alpha)$,
+// turns the stress within a time step into the one of a neo-Hookean material
+// whose isochoric part is scaled by $1 + \sum_\alpha \beta_\alpha
+// e^{\xi_\alpha}$ plus the fixed stress $\mathbf{H}^n = \sum_\alpha
+// \mathbf{H}_\alpha^n$. Its push forward $\boldsymbol{\tau}_H = \mathbf{F}
+// \mathbf{H}^n \mathbf{F}^T$ has a vanishing Lie derivative, so it only
+// enters the geometric part of the tangent.
+//
+// The internal variables are therefore updated only once per time step. At
+// each quadrature point we store $\mathbf{H}^{n}$, $\mathbf{S}_{\textrm{iso}}^n$
+// and $\mathbf{Q}_\alpha^n$, in this order.
+  template <int dim,typename NumberType>
+  class Viscoelastic_Prony_Series
+  {
+  public:
+    static const unsigned int n_stress_components = SymmetricTensor<2,dim>::n_independent_components;
+
+    Viscoelastic_Prony_Series(const double               mu,
+                              const std::vector<double> &relative_stiffnesses,
+                              const std::vector<double> &relaxation_times,
+                              const double               delta_t)
+      :
+      mu(mu),
+      beta(relative_stiffnesses),
+      exp_xi(relaxation_times.size())
+    {
+      AssertDimension(relative_stiffnesses.size(), relaxation_times.size());
+      for (unsigned int a = 0; a < exp_xi.size(); ++a)
+        {
+          Assert(relaxation_times[a] > 0, ExcMessage("Relaxation times must be positive"));
+          exp_xi[a] = std::exp(-delta_t / (2.0 * relaxation_times[a]));
+        }
+    }
+
+    // Scaling $1 + \sum_\alpha \beta_\alpha e^{\xi_\alpha}$ of the isochoric
+    // stress within a time step:
+    static double
+    isochoric_scaling(const std::vector<double> &relative_stiffnesses,
+                      const std::vector<double> &relaxation_times,
+                      const double               delta_t)
+    {
+      AssertDimension(relative_stiffnesses.size(), relaxation_times.size());
+      double scaling = 1.0;
+      for (unsigned int a = 0; a < relative_stiffnesses.size(); ++a)
+        scaling += relative_stiffnesses[a] * std::exp(-delta_t / (2.0 * relaxation_times[a]));
+      return scaling;
+    }
+
+    unsigned int
+    n_history_variables() const
+    {
+      return (beta.size() + 2) * n_stress_components;
+    }
+
+    // The viscous Kirchhoff stress $\boldsymbol{\tau}_H$ of the current time
+    // step from the first $n_{\textrm{stress}}$ history variables:
+    static SymmetricTensor<2,dim,NumberType>
+    get_tau_viscous(const Tensor<2,dim,NumberType> &F,
+                    const NumberType               *history)
+    {
+      return symmetrize(F * Tensor<2,dim,NumberType>(unpack(history)) * transpose(F));
+    }
+
+    // Advance the internal variables from $t_n$ to $t_{n+1}$ given the
+    // converged deformation gradient at $t_{n+1}$, and evaluate
+    // $\mathbf{H}^{n+1}$ for the next time step.
+    void
+    update_internal_variables(const Tensor<2,dim,NumberType> &F,
+                              const NumberType               *history_old,
+                              NumberType                     *history) const
+    {
+      // $\mathbf{S}_{\textrm{iso}} = \mathbf{F}^{-1} \mu \, \textrm{dev}(\overline{\mathbf{b}}) \mathbf{F}^{-T}$
+      const SymmetricTensor<2,dim,NumberType> b_bar =
+        Physics::Elasticity::Kinematics::b(F_iso(F));
+      SymmetricTensor<2,dim,NumberType> tau_iso = b_bar * mu;
+      const NumberType tr = divide_by_dim(trace(tau_iso),dim);
+      for (unsigned int d = 0; d < dim; ++d)
+        tau_iso[d][d] -= tr;
+      const Tensor<2,dim,NumberType> F_inv = invert(F);
+      const SymmetricTensor<2,dim,NumberType> S_iso =
+        symmetrize(F_inv * Tensor<2,dim,NumberType>(tau_iso) * transpose(F_inv));
+
+      const SymmetricTensor<2,dim,NumberType> S_iso_old = unpack(history_old + n_stress_components);
+
+      SymmetricTensor<2,dim,NumberType> H;
+      for (unsigned int a = 0; a < beta.size(); ++a)
+        {
+          const unsigned int offset = (a + 2) * n_stress_components;
+          const SymmetricTensor<2,dim,NumberType> Q_old = unpack(history_old + offset);
+
+          const SymmetricTensor<2,dim,NumberType> H_old = (Q_old * exp_xi[a] - S_iso_old * beta[a]) * exp_xi[a];
+          const SymmetricTensor<2,dim,NumberType> Q = H_old + S_iso * (beta[a] * exp_xi[a]);
+          H += (Q * exp_xi[a] - S_iso * beta[a]) * exp_xi[a];
+
+          pack(Q, history + offset);
+        }
+
+      pack(H, history);
+      pack(S_iso, history + n_stress_components);
+    }
+
+  private:
+    const double              mu;
+    const std::vector<double> beta;
+    std::vector<double>       exp_xi;
+
+    static SymmetricTensor<2,dim,NumberType>
+    unpack(const NumberType *values)
+    {
+      SymmetricTensor<2,dim,NumberType> t;
+      for (unsigned int i = 0; i < n_stress_components; ++i)
+        t[SymmetricTensor<2,dim>::unrolled_to_component_indices(i)] = values[i];
+      return t;
+    }
+
+    static void
+    pack(const SymmetricTensor<2,dim,NumberType> &t,
+         NumberType                              *values)
+    {
+      for (unsigned int i = 0; i < n_stress_components; ++i)
+        values[i] = t[SymmetricTensor<2,dim>::unrolled_to_component_indices(i)];
+    }
+  };
+
+  template <int dim,typename NumberType>
+  const unsigned int Viscoelastic_Prony_Series<dim,NumberType>::n_stress_components;
+
+
+
+// The anisotropic part of the Holzapfel-Gasser-Ogden model for fiber
+// reinforced materials, see Holzapfel, Gasser and Ogden (2000) and Holzapfel,
+// Nonlinear Solid Mechanics, Section 6.7. It is added to the neo-Hookean
+// ground matrix above. Each of up to two fiber families with referential
+// direction $\mathbf{a}_0$ contributes the isochoric strain energy
+// $\Psi_f = \frac{k_1}{2 k_2} [ e^{k_2 (\overline{I}_4 - 1)^2} - 1 ]$ with
+// $\overline{I}_4 = \overline{\mathbf{a}} \cdot \overline{\mathbf{a}}$,
+// $\overline{\mathbf{a}} = \overline{\mathbf{F}} \mathbf{a}_0$. Fibers do not
+// support compression, so the contribution of a family vanishes for
+// $\overline{I}_4 \leq 1$; as in the plasticity model this is handled by an
+// indicator rather than a branch.
+//
+// With $\mathbf{m} = \overline{\mathbf{a}} \otimes \overline{\mathbf{a}}$ the
+// fictitious Kirchhoff stress is $\overline{\boldsymbol{\tau}} = 2 \Psi_f'
+// \mathbf{m}$ and the fictitious tangent $J \overline{\mathfrak{c}} = 4
+// \Psi_f'' \mathbf{m} \otimes \mathbf{m}$. The isochoric projection of the
+// latter acts on a symmetric tensor through the contraction with
+// $\textrm{dev}(\mathbf{m})$ only, so that no fourth order tensors are
+// needed.
+  template <int dim,typename NumberType>
+  class Material_HGO_Fibers
+  {
+  public:
+    static const unsigned int max_fiber_families = 2;
+
+    // The quantities of the fiber families at a quadrature point that are
+    // needed to apply the tangent:
+    struct State
+    {
+      SymmetricTensor<2,dim,NumberType> tau;
+      NumberType                        tr_tau_bar;
+      SymmetricTensor<2,dim,NumberType> dev_m[max_fiber_families];
+      NumberType                        d2_psi[max_fiber_families];
+      unsigned int                      n_families;
+    };
+
+    Material_HGO_Fibers(const double k1,
+                        const double k2)
+      :
+      k1(k1),
+      k2(k2)
+    {
+      Assert(k1 >= 0, ExcMessage("Fiber stiffness must not be negative"));
+      Assert(k2 > 0, ExcMessage("Fiber exponent must be positive"));
+    }
+
+    // Evaluate the isochoric Kirchhoff stress
+    // $\boldsymbol{\tau}_f = \mathcal{P} : \overline{\boldsymbol{\tau}}$ of
+    // the @p n_families fiber families with referential directions @p a_0
+    // for the isochoric deformation gradient $\overline{\mathbf{F}}$:
+    void
+    evaluate(State                                &state,
+             const Tensor<2,dim,NumberType>       &F_bar,
+             const Tensor<1,dim,NumberType> *const a_0,
+             const unsigned int                    n_families) const
+    {
+      Assert(n_families <= max_fiber_families,
+             ExcIndexRange(n_families, 0, max_fiber_families+1));
+      state.n_families = n_families;
+
+      SymmetricTensor<2,dim,NumberType> tau_bar;
+      for (unsigned int f = 0; f < n_families; ++f)
+        {
+          const Tensor<1,dim,NumberType> a = F_bar * a_0[f];
+          const SymmetricTensor<2,dim,NumberType> m = symmetrize(outer_product(a,a));
+          const NumberType I4_minus_1 = a * a - 1.0;
+          const NumberType exp_term = VectorizedMath::exp(k2 * I4_minus_1 * I4_minus_1) * positive_indicator(I4_minus_1);
+
+          // $\Psi_f'$ and $4 \Psi_f''$:
+          const NumberType d_psi = k1 * I4_minus_1 * exp_term;
+          state.d2_psi[f] = 4.0 * k1 * (1.0 + 2.0 * k2 * I4_minus_1 * I4_minus_1) * exp_term;
+
+          tau_bar += m * (2.0 * d_psi);
+
+          state.dev_m[f] = m;
+          const NumberType tr_m = divide_by_dim(trace(m),dim);
+          for (unsigned int d = 0; d < dim; ++d)
+            state.dev_m[f][d][d] -= tr_m;
+        }
+
+      state.tr_tau_bar = trace(tau_bar);
+      state.tau = tau_bar;
+      const NumberType tr = divide_by_dim(state.tr_tau_bar,dim);
+      for (unsigned int d = 0; d < dim; ++d)
+        state.tau[d][d] -= tr;
+    }
+
+    // The action of the isochoric fiber tangent
+    // $J \mathfrak{c}_f = \mathcal{P} : J \overline{\mathfrak{c}} : \mathcal{P}
+    // + \frac{2}{d} \textrm{tr}(\overline{\boldsymbol{\tau}}) \mathcal{P}
+    // - \frac{2}{d} [\boldsymbol{\tau}_f \otimes \mathbf{I} + \mathbf{I}
+    // \otimes \boldsymbol{\tau}_f]$ on a symmetric tensor:
+    SymmetricTensor<2,dim,NumberType>
+    act_Jc(const State                             &state,
+           const SymmetricTensor<2,dim,NumberType> &src) const
+    {
+      const NumberType tr = trace(src);
+
+      SymmetricTensor<2,dim,NumberType> dev_src(src);
+      for (unsigned int i = 0; i < dim; ++i)
+        dev_src[i][i] -= divide_by_dim(tr,dim);
+
+      SymmetricTensor<2,dim,NumberType> res = dev_src * (2.0 / dim * state.tr_tau_bar);
+      for (unsigned int f = 0; f < state.n_families; ++f)
+        res += state.dev_m[f] * (state.d2_psi[f] * (state.dev_m[f] * dev_src));
+
+      res -= state.tau * (2.0 / dim * tr);
+      const NumberType tau_src = 2.0 / dim * (state.tau * src);
+      for (unsigned int i = 0; i < dim; ++i)
+        res[i][i] -= tau_src;
+
+      return res;
+    }
+
+  private:
+    const double k1;
+    const double k2;
+  };
+
+  template <int dim,typename NumberType>
+  const unsigned int Material_HGO_Fibers<dim,NumberType>::max_fiber_families;
+
+
+
+// Isotropic thermal expansion through the multiplicative split $\mathbf{F} =
+// \mathbf{F}_M \mathbf{F}_\theta$ of the deformation gradient into a
+// mechanical part and the thermal stretch $\mathbf{F}_\theta = \vartheta
+// \mathbf{I}$, $\vartheta = 1 + \alpha (T - T_0)$. The strain energy is
+// evaluated with $\mathbf{F}_M$. As $\mathbf{F}_\theta$ is spherical, the
+// isochoric part $\overline{\mathbf{F}}_M = \overline{\mathbf{F}}$ is not
+// affected and only the volume change $J_M = J / \vartheta^{dim}$ enters the
+// volumetric response. Since $J \, \partial J_M / \partial J = J_M$, the
+// Kirchhoff stress and its tangent of the materials above are obtained by
+// simply passing $J_M$ instead of $J$.
+  template <int dim,typename NumberType>
+  class Thermal_Expansion
+  {
+  public:
+    Thermal_Expansion(const double alpha,
+                      const double reference_temperature)
+      :
+      alpha(alpha),
+      reference_temperature(reference_temperature)
+    {}
+
+    // The mechanical volume change $J_M$ for the temperature $T$:
+    NumberType
+    get_det_F_mechanical(const NumberType &det_F,
+                         const NumberType &temperature) const
+    {
+      const NumberType stretch = 1.0 + alpha * (temperature - reference_temperature);
+      NumberType det_F_theta = stretch;
+      for (unsigned int d = 1; d < dim; ++d)
+        det_F_theta *= stretch;
+      return det_F / det_F_theta;
+    }
+
+  private:
+    const double alpha;
+    const double reference_temperature;
+  };
+
+
+
+// Degradation of the strain energy by the phase-field damage $d \in [0,1]$
+// with $g(d) = (1 - d)^2 (1 - k) + k$ and a small residual stiffness $k$ of
+// the fully broken material. Only the tensile part of the energy, see
+// Material_Compressible_Neo_Hook_One_Field::get_Psi_tensile(), is degraded,
+// so that a crack cannot be closed by interpenetration. Since the isochoric
+// part is linear in the shear modulus and the volumetric part in the bulk
+// modulus, the degradation amounts to scaling both moduli, for which the
+// neo-Hookean material already provides overloads of get_tau and act_Jc. The
+// switch between tension and compression is held fixed in the tangent.
+  template <int dim,typename NumberType>
+  class Phase_Field_Degradation
+  {
+  public:
+    Phase_Field_Degradation(const double residual_stiffness)
+      :
+      residual_stiffness(residual_stiffness)
+    {}
+
+    NumberType
+    get_degradation(const NumberType &damage) const
+    {
+      return (1.0 - damage) * (1.0 - damage) * (1.0 - residual_stiffness) + residual_stiffness;
+    }
+
+    // Multiply the scalings of the shear and the bulk modulus by the
+    // degradation for the volume change $J$:
+    void
+    degrade(const NumberType &det_F,
+            const NumberType &damage,
+            NumberType       &mu_scaling,
+            NumberType       &kappa_scaling) const
+    {
+      const NumberType degradation = get_degradation(damage);
+      mu_scaling *= degradation;
+      kappa_scaling *= 1.0 + positive_indicator(det_F - 1.0) * (degradation - 1.0);
+    }
+
+  private:
+    const double residual_stiffness;
+  };
+
+
+
+// Hyperelastic materials defined by their strain energy $\Psi(\mathbf{C})$
+// alone. The second Piola-Kirchhoff stress $\mathbf{S} = 2 \partial \Psi /
+// \partial \mathbf{C}$ is obtained by forward mode automatic
+// differentiation, one evaluation of the energy with dual numbers per
+// independent component of $\mathbf{C}$, and $\boldsymbol{\tau} =
+// \mathbf{F} \mathbf{S} \mathbf{F}^T$. The action of the tangent on a
+// symmetric tensor $\mathbf{d}$ is the directional derivative of the stress
+// itself, which nests a second level of dual numbers: for the variation
+// $\delta \mathbf{F} = \mathbf{d} \mathbf{F}$, the Lie derivative gives
+// $J \mathfrak{c} : \mathbf{d} = D \boldsymbol{\tau} [\delta \mathbf{F}]
+// - \mathbf{d} \boldsymbol{\tau} - \boldsymbol{\tau} \mathbf{d}$.
+//
+// The @p StrainEnergy is a function object with a templated
+//   NumberType operator()(const Tensor<2,dim,NumberType> &C) const
+// which only uses arithmetic operations, the tensor functions of deal.II and
+// the functions of VectorizedMath. A new material is thus a single function,
+// and with NumberType a VectorizedArray it is evaluated on all lanes at once.
+  template <int dim,typename NumberType,typename StrainEnergy>
+  class Material_Hyperelastic_AD
+  {
+  public:
+    Material_Hyperelastic_AD(const StrainEnergy &energy)
+      :
+      energy(energy)
+    {}
+
+    NumberType
+    get_Psi(const Tensor<2,dim,NumberType> &F) const
+    {
+      return energy(Tensor<2,dim,NumberType>(transpose(F) * F));
+    }
+
+    void
+    get_tau(SymmetricTensor<2,dim,NumberType> &res,
+            const Tensor<2,dim,NumberType>    &F) const
+    {
+      const Tensor<2,dim,NumberType> tau = F * get_S(Tensor<2,dim,NumberType>(transpose(F) * F)) * transpose(F);
+      res = symmetrize(tau);
+    }
+
+    SymmetricTensor<2,dim,NumberType>
+    act_Jc(const Tensor<2,dim,NumberType>          &F,
+           const SymmetricTensor<2,dim,NumberType> &src) const
+    {
+      typedef DualNumber<NumberType> Dual;
+
+      // the deformation gradient perturbed in the direction $\mathbf{d} \mathbf{F}$
+      const Tensor<2,dim,NumberType> d(src);
+      const Tensor<2,dim,NumberType> dF = d * F;
+      Tensor<2,dim,Dual> F_dual;
+      for (unsigned int i = 0; i < dim; ++i)
+        for (unsigned int j = 0; j < dim; ++j)
+          F_dual[i][j] = Dual(F[i][j], dF[i][j]);
+
+      const Tensor<2,dim,Dual> tau_dual = F_dual * get_S(Tensor<2,dim,Dual>(transpose(F_dual) * F_dual)) * transpose(F_dual);
+
+      Tensor<2,dim,NumberType> tau, d_tau;
+      for (unsigned int i = 0; i < dim; ++i)
+        for (unsigned int j = 0; j < dim; ++j)
+          {
+            const Dual &tau_ij = tau_dual[i][j];
+            tau[i][j] = tau_ij.value;
+            d_tau[i][j] = tau_ij.derivative;
+          }
+
+      return symmetrize(d_tau - d * tau - tau * d);
+    }
+
+  private:
+    const StrainEnergy energy;
+
+    // $\mathbf{S} = 2 \partial \Psi / \partial \mathbf{C}$, where the
+    // derivative in the direction of the symmetric unit tensor of an
+    // off-diagonal component counts both $C_{ij}$ and $C_{ji}$
+    template <typename Number>
+    Tensor<2,dim,Number>
+    get_S(const Tensor<2,dim,Number> &C) const
+    {
+      typedef DualNumber<Number> Dual;
+
+      Tensor<2,dim,Dual> C_dual;
+      for (unsigned int i = 0; i < dim; ++i)
+        for (unsigned int j = 0; j < dim; ++j)
+          C_dual[i][j] = Dual(C[i][j]);
+
+      const Number zero = internal::ScalarConstant<Number>::make(0.);
+      const Number one  = internal::ScalarConstant<Number>::make(1.);
+
+      Tensor<2,dim,Number> S;
+      for (unsigned int i = 0; i < dim; ++i)
+        for (unsigned int j = i; j < dim; ++j)
+          {
+            C_dual[i][j] = Dual(C[i][j], one);
+            C_dual[j][i] = Dual(C[j][i], one);
+
+            const Dual psi = energy(C_dual);
+            S[i][j] = psi.derivative * (i == j ? 2.0 : 1.0);
+            S[j][i] = S[i][j];
+
+            C_dual[i][j] = Dual(C[i][j], zero);
+            C_dual[j][i] = Dual(C[j][i], zero);
+          }
+      return S;
+    }
+  };
+
+
+
+// The strain energy of Material_Compressible_Neo_Hook_One_Field in terms of
+// $\mathbf{C}$, i.e. $\Psi = c_1 [ (\det \mathbf{C})^{-1/d} \textrm{tr}
+// \mathbf{C} - d ] + \frac{\kappa}{4} [ \det \mathbf{C} - 1 - \ln \det
+// \mathbf{C} ]$, for Material_Hyperelastic_AD.
+  template <int dim>
+  class Compressible_Neo_Hook_Energy
+  {
+  public:
+    Compressible_Neo_Hook_Energy(const double mu,
+                                 const double nu)
+      :
+      kappa((2.0 * mu * (1.0 + nu)) / (3.0 * (1.0 - 2.0 * nu))),
+      c_1(mu / 2.0)
+    {}
+
+    template <typename NumberType>
+    NumberType
+    operator()(const Tensor<2,dim,NumberType> &C) const
+    {
+      const NumberType det_C = determinant(C);
+      return c_1 * (VectorizedMath::pow(det_C, -1.0/dim) * trace(C) - double(dim))
+             + (kappa / 4.0) * (det_C - 1.0 - VectorizedMath::log(det_C));
+    }
+
+  private:
+    const double kappa;
+    const double c_1;
+  };
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <array>
+
+using namespace dealii;
+
+  /**
+   * History variables at the quadrature points of all cells.
+   *
+   * The variables are stored in a structure-of-arrays layout: every scalar
+   * history variable has its own array of VectorizedArray objects which is
+   * indexed by the cell batch of a MatrixFree object and the quadrature point.
+   * The matrix-free operator therefore loads the history of all lanes of a
+   * cell batch with contiguous vector loads. The matrix-based assembly, which
+   * works on single cells, accesses the lanes through the active cell index.
+   *
+   * Each variable is kept twice, at the last accepted load step (old) and at
+   * the current Newton iterate (current). The constitutive update always
+   * starts from the old values, so that the current values can be recomputed
+   * in every iteration. An accepted step is committed, a rejected step is
+   * rolled back to the old values.
+   */
+  template <int dim, typename number>
+  class MaterialHistory
+  {
+  public:
+    MaterialHistory ();
+
+    /**
+     * Allocate the storage for the cell batches of @p data with
+     * @p n_q_points quadrature points per cell. The number of history
+     * variables is given by the size of @p initial_values, which are used to
+     * initialize both the old and the current values.
+     */
+    void reinit (const MatrixFree<dim,number> &data,
+                 const unsigned int            n_q_points,
+                 const std::vector<number>    &initial_values);
+
+    /**
+     * Check that the cell batches of @p data are laid out in the same way as
+     * those the storage was set up with.
+     */
+    bool matches (const MatrixFree<dim,number> &data) const;
+
+    unsigned int n_variables () const;
+
+    /**
+     * Old value of @p variable at quadrature point @p q of the cell batch
+     * @p cell.
+     */
+    const VectorizedArray<number> &
+    old_value (const unsigned int variable,
+               const unsigned int cell,
+               const unsigned int q) const;
+
+    /**
+     * Current value of @p variable at quadrature point @p q of the cell batch
+     * @p cell.
+     */
+    VectorizedArray<number> &
+    current_value (const unsigned int variable,
+                   const unsigned int cell,
+                   const unsigned int q);
+
+    /**
+     * Old values of the first @p n variables at quadrature point @p q of the
+     * cell batch @p cell.
+     */
+    template <std::size_t n>
+    void read_old (const unsigned int                      cell,
+                   const unsigned int                      q,
+                   std::array<VectorizedArray<number>,n>  &values) const;
+
+    /**
+     * Old values of the first @p n variables at quadrature point @p q of the
+     * cell with the given active cell index.
+     */
+    template <std::size_t n>
+    void read_old_active_cell (const unsigned int     active_cell_index,
+                               const unsigned int     q,
+                               std::array<number,n>  &values) const;
+
+    /**
+     * Set the current values of all variables at quadrature point @p q of the
+     * cell with the given active cell index.
+     */
+    template <std::size_t n>
+    void write_current_active_cell (const unsigned int           active_cell_index,
+                                    const unsigned int           q,
+                                    const std::array<number,n>  &values);
+
+    /**
+     * Average of the old values of @p variable over the quadrature points of
+     * each active cell.
+     */
+    void get_cell_averages (const unsigned int variable,
+                            Vector<double>    &values) const;
+
+    /**
+     * Accept the current values as the state of the converged step.
+     */
+    void commit ();
+
+    /**
+     * Reset the current values to the state of the last converged step.
+     */
+    void rollback ();
+
+    std::size_t memory_consumption () const;
+
+    /**
+     * Memory of the old and current values at a single quadrature point.
+     */
+    std::size_t memory_consumption_per_quadrature_point () const;
+
+  private:
+    unsigned int index (const unsigned int variable,
+                        const unsigned int cell,
+                        const unsigned int q) const;
+
+    unsigned int n_history_variables;
+    unsigned int n_cell_batches;
+    unsigned int n_q_points;
+
+    AlignedVector<VectorizedArray<number>> old_values;
+    AlignedVector<VectorizedArray<number>> current_values;
+
+    /**
+     * Cell batch and lane for each active cell.
+     */
+    std::vector<std::pair<unsigned int,unsigned int>> active_cell_to_batch_lane;
+  };
+
+
+
+  template <int dim, typename number>
+  MaterialHistory<dim,number>::MaterialHistory ()
+    :
+    n_history_variables(0),
+    n_cell_batches(0),
+    n_q_points(0)
+  {}
+
+
+
+  template <int dim, typename number>
+  void
+  MaterialHistory<dim,number>::reinit (const MatrixFree<dim,number> &data,
+                                       const unsigned int            n_q_points_,
+                                       const std::vector<number>    &initial_values)
+  {
+    n_history_variables = initial_values.size();
+    n_cell_batches = data.n_macro_cells();
+    n_q_points = n_q_points_;
+
+    old_values.resize(n_history_variables*n_cell_batches*n_q_points);
+    for (unsigned int variable=0; variable<n_history_variables; ++variable)
+      for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+        for (unsigned int q=0; q<n_q_points; ++q)
+          old_values[index(variable,cell,q)] = make_vectorized_array<number>(initial_values[variable]);
+    current_values = old_values;
+
+    active_cell_to_batch_lane.assign(data.get_dof_handler().get_triangulation().n_active_cells(),
+                                     std::make_pair(numbers::invalid_unsigned_int,
+                                                    numbers::invalid_unsigned_int));
+    for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+      for (unsigned int v=0; v<data.n_components_filled(cell); ++v)
+        active_cell_to_batch_lane[data.get_cell_iterator(cell,v)->active_cell_index()] =
+          std::make_pair(cell,v);
+  }
+
+
+
+  template <int dim, typename number>
+  bool
+  MaterialHistory<dim,number>::matches (const MatrixFree<dim,number> &data) const
+  {
+    if (data.n_macro_cells() != n_cell_batches)
+      return false;
+
+    for (unsigned int cell=0; cell<n_cell_batches; ++cell)
+      for (unsigned int v=0; v<data.n_components_filled(cell); ++v)
+        if (active_cell_to_batch_lane[data.get_cell_iterator(cell,v)->active_cell_index()] !=
+            std::make_pair(cell,v))
+          return false;
+
+    return true;
+  }
+
+
+
+  template <int dim, typename number>
+  unsigned int
+  MaterialHistory<dim,number>::n_variables () const
+  {
+    return n_history_variables;
+  }
+
+
+
+  template <int dim, typename number>
+  inline
+  unsigned int
+  MaterialHistory<dim,number>::index (const unsigned int variable,
+                                      const unsigned int cell,
+                                      const unsigned int q) const
+  {
+    Assert (variable < n_history_variables, ExcIndexRange(variable, 0, n_history_variables));
+    Assert (cell < n_cell_batches, ExcIndexRange(cell, 0, n_cell_batches));
+    Assert (q < n_q_points, ExcIndexRange(q, 0, n_q_points));
+    return (variable*n_cell_batches + cell)*n_q_points + q;
+  }
+
+
+
+  template <int dim, typename number>
+  inline
+  const VectorizedArray<number> &
+  MaterialHistory<dim,number>::old_value (const unsigned int variable,
+                                          const unsigned int cell,
+                                          const unsigned int q) const
+  {
+    return old_values[index(variable,cell,q)];
+  }
+
+
+
+  template <int dim, typename number>
+  inline
+  VectorizedArray<number> &
+  MaterialHistory<dim,number>::current_value (const unsigned int variable,
+                                              const unsigned int cell,
+                                              const unsigned int q)
+  {
+    return current_values[index(variable,cell,q)];
+  }
+
+
+
+  template <int dim, typename number>
+  template <std::size_t n>
+  inline
+  void
+  MaterialHistory<dim,number>::read_old (const unsigned int                      cell,
+                                         const unsigned int                      q,
+                                         std::array<VectorizedArray<number>,n>  &values) const
+  {
+    Assert (n <= n_history_variables, ExcIndexRange(n, 0, n_history_variables+1));
+    for (unsigned int variable=0; variable<n; ++variable)
+      values[variable] = old_values[index(variable,cell,q)];
+  }
+
+
+
+  template <int dim, typename number>
+  template <std::size_t n>
+  inline
+  void
+  MaterialHistory<dim,number>::read_old_active_cell (const unsigned int     active_cell_index,
+                                                     const unsigned int     q,
+                                                     std::array<number,n>  &values) const
+  {
+    Assert (n <= n_history_variables, ExcIndexRange(n, 0, n_history_variables+1));
+    const std::pair<unsigned int,unsigned int> &batch_lane = active_cell_to_batch_lane[active_cell_index];
+    Assert (batch_lane.first != numbers::invalid_unsigned_int, ExcInternalError());
+
+    for (unsigned int variable=0; variable<n; ++variable)
+      values[variable] = old_values[index(variable,batch_lane.first,q)][batch_lane.second];
+  }
+
+
+
+  template <int dim, typename number>
+  template <std::size_t n>
+  inline
+  void
+  MaterialHistory<dim,number>::write_current_active_cell (const unsigned int           active_cell_index,
+                                                          const unsigned int           q,
+                                                          const std::array<number,n>  &values)
+  {
+    Assert (n == n_history_variables, ExcDimensionMismatch(n, n_history_variables));
+    const std::pair<unsigned int,unsigned int> &batch_lane = active_cell_to_batch_lane[active_cell_index];
+    Assert (batch_lane.first != numbers::invalid_unsigned_int, ExcInternalError());
+
+    for (unsigned int variable=0; variable<n; ++variable)
+      current_values[index(variable,batch_lane.first,q)][batch_lane.second] = values[variable];
+  }
+
+
+
+  template <int dim, typename number>
+  void
+  MaterialHistory<dim,number>::get_cell_averages (const unsigned int variable,
+                                                  Vector<double>    &values) const
+  {
+    values.reinit(active_cell_to_batch_lane.size());
+    for (unsigned int c=0; c<active_cell_to_batch_lane.size(); ++c)
+      {
+        const std::pair<unsigned int,unsigned int> &batch_lane = active_cell_to_batch_lane[c];
+        double sum = 0.;
+        for (unsigned int q=0; q<n_q_points; ++q)
+          sum += old_values[index(variable,batch_lane.first,q)][batch_lane.second];
+        values(c) = sum / n_q_points;
+      }
+  }
+
+
+
+  template <int dim, typename number>
+  void
+  MaterialHistory<dim,number>::commit ()
+  {
+    old_values = current_values;
+  }
+
+
+
+  template <int dim, typename number>
+  void
+  MaterialHistory<dim,number>::rollback ()
+  {
+    current_values = old_values;
+  }
+
+
+
+  template <int dim, typename number>
+  std::size_t
+  MaterialHistory<dim,number>::memory_consumption () const
+  {
+    return old_values.memory_consumption() +
+           current_values.memory_consumption() +
+           MemoryConsumption::memory_consumption(active_cell_to_batch_lane);
+  }
+
+
+
+  template <int dim, typename number>
+  std::size_t
+  MaterialHistory<dim,number>::memory_consumption_per_quadrature_point () const
+  {
+    return 2 * n_history_variables * sizeof(number);
+  }
@@ -0,0 +1,477 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/point.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <material.h>
+
+using namespace dealii;
+
+  /**
+   * A rigid obstacle given by the signed distance of a spatial point to its
+   * surface. The distance, called gap, is negative for points that
+   * penetrate the obstacle. The normal points from the obstacle towards the
+   * body.
+   */
+  template <int dim, typename NumberType>
+  class RigidObstacle
+  {
+  public:
+    virtual ~RigidObstacle() = default;
+
+    /**
+     * Gap of the spatial point @p x and the outward normal of the obstacle at
+     * its closest point.
+     */
+    virtual NumberType
+    gap (const Point<dim,NumberType> &x,
+         Tensor<1,dim,NumberType>    &normal) const = 0;
+
+    /**
+     * Change of the normal at @p x in the direction @p v.
+     */
+    virtual Tensor<1,dim,NumberType>
+    normal_derivative (const Point<dim,NumberType>    &x,
+                       const Tensor<1,dim,NumberType> &v) const = 0;
+  };
+
+
+
+  /**
+   * The half space behind the plane through @p point with the normal
+   * @p normal.
+   */
+  template <int dim, typename NumberType>
+  class RigidPlane : public RigidObstacle<dim,NumberType>
+  {
+  public:
+    RigidPlane (const Point<dim>     &point,
+                const Tensor<1,dim>  &normal)
+      :
+      point(point),
+      normal(normal / normal.norm())
+    {}
+
+    virtual NumberType
+    gap (const Point<dim,NumberType> &x,
+         Tensor<1,dim,NumberType>    &n) const override
+    {
+      NumberType g = NumberType();
+      for (unsigned int d=0; d<dim; ++d)
+        {
+          n[d] = normal[d];
+          g += (x[d] - point[d]) * normal[d];
+        }
+      return g;
+    }
+
+    virtual Tensor<1,dim,NumberType>
+    normal_derivative (const Point<dim,NumberType>    &,
+                       const Tensor<1,dim,NumberType> &) const override
+    {
+      return Tensor<1,dim,NumberType>();
+    }
+
+  private:
+    const Point<dim>    point;
+    const Tensor<1,dim> normal;
+  };
+
+
+
+  /**
+   * A cylinder with the axis parallel to the z-axis through @p center, i.e.
+   * a disk in 2d.
+   */
+  template <int dim, typename NumberType>
+  class RigidCylinder : public RigidObstacle<dim,NumberType>
+  {
+  public:
+    RigidCylinder (const Point<dim> &center,
+                   const double      radius)
+      :
+      center(center),
+      radius(radius)
+    {
+      Assert (radius > 0, ExcMessage("The radius must be positive"));
+    }
+
+    virtual NumberType
+    gap (const Point<dim,NumberType> &x,
+         Tensor<1,dim,NumberType>    &n) const override
+    {
+      const Tensor<1,dim,NumberType> d = radial_vector(x);
+      const NumberType distance = d.norm();
+      n = d / distance;
+      return distance - radius;
+    }
+
+    // $\frac{1}{|\mathbf{d}|} [\mathbf{I} - \mathbf{n} \otimes \mathbf{n}]
+    // \mathbf{v}$ restricted to the plane orthogonal to the axis:
+    virtual Tensor<1,dim,NumberType>
+    normal_derivative (const Point<dim,NumberType>    &x,
+                       const Tensor<1,dim,NumberType> &v) const override
+    {
+      const Tensor<1,dim,NumberType> d = radial_vector(x);
+      const NumberType distance = d.norm();
+      const Tensor<1,dim,NumberType> n = d / distance;
+
+      Tensor<1,dim,NumberType> result = v;
+      if (dim == 3)
+        result[dim-1] = NumberType();
+      result -= n * (n * v);
+      return result / distance;
+    }
+
+  private:
+    Tensor<1,dim,NumberType>
+    radial_vector (const Point<dim,NumberType> &x) const
+    {
+      Tensor<1,dim,NumberType> d;
+      for (unsigned int i=0; i<std::min(dim,2); ++i)
+        d[i] = x[i] - center[i];
+      return d;
+    }
+
+    const Point<dim> center;
+    const double     radius;
+  };
+
+
+
+  /**
+   * Penalty contact of a boundary of the body with a rigid obstacle.
+   *
+   * The penalty energy $\Pi_c = \int_{\Gamma_0} \frac{\epsilon}{2}
+   * \langle -g \rangle^2 dA$ of the gap $g$ of the spatial position of the
+   * boundary gives the contact forces
+   * $\int_{\Gamma_0} \epsilon \langle -g \rangle \mathbf{n} \cdot \delta
+   * \mathbf{v} \, dA$ and the tangent
+   * $\int_{\Gamma_0} \epsilon H(-g) (\mathbf{n} \cdot \varDelta \mathbf{u})
+   * (\mathbf{n} \cdot \delta \mathbf{v}) - \epsilon \langle -g \rangle
+   * \delta \mathbf{v} \cdot \nabla \mathbf{n} \varDelta \mathbf{u} \, dA$.
+   *
+   * The boundary faces are evaluated matrix-free with FEFaceEvaluation on the
+   * reference configuration, the gap at all quadrature points of a face batch
+   * is computed with vector instructions. Faces which are not in contact do
+   * not contribute, so the face batches on the contact boundary in which at
+   * least one quadrature point penetrates the obstacle are tracked as the
+   * active set. Only the active face batches are visited when the forces and
+   * the tangent are applied.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  class PenaltyContact
+  {
+  public:
+    typedef RigidObstacle<dim,VectorizedArray<number>> Obstacle;
+
+    PenaltyContact ();
+
+    /**
+     * Request the boundary face data that is needed for the contact from a
+     * MatrixFree object.
+     */
+    static void
+    add_data_flags (typename MatrixFree<dim,number>::AdditionalData &data);
+
+    /**
+     * Set up the contact of the faces with @p boundary_id of @p data with
+     * the obstacle. The MatrixFree object has to be set up for the reference
+     * configuration with the flags of add_data_flags().
+     */
+    void initialize (std::shared_ptr<const MatrixFree<dim,number>> data,
+                     const types::boundary_id                      boundary_id,
+                     std::shared_ptr<const Obstacle>                obstacle,
+                     const double                                   penalty,
+                     const Vector<number>                          &displacement);
+
+    void clear ();
+
+    /**
+     * Find the face batches in contact for the current displacement. Returns
+     * their number.
+     */
+    unsigned int update_active_set ();
+
+    unsigned int n_active_face_batches () const;
+
+    /**
+     * Add the contact forces to @p dst.
+     */
+    void add_forces (Vector<number> &dst) const;
+
+    /**
+     * Add the action of the contact tangent to @p dst.
+     */
+    void vmult_add (Vector<number>       &dst,
+                    const Vector<number> &src) const;
+
+    /**
+     * Add the diagonal of the contact tangent to @p diagonal.
+     */
+    void add_diagonal (Vector<number> &diagonal) const;
+
+  private:
+    typedef FEFaceEvaluation<dim,fe_degree,n_q_points_1d,dim,number> FaceEvaluation;
+
+    /**
+     * Gap and normal at quadrature point @p q of the face evaluation
+     * @p phi_u of the displacement.
+     */
+    VectorizedArray<number>
+    get_gap (const FaceEvaluation                   &phi_u,
+             const unsigned int                      q,
+             Point<dim,VectorizedArray<number>>     &x,
+             Tensor<1,dim,VectorizedArray<number>>  &normal) const;
+
+    /**
+     * Submit the tangent applied to the values of @p phi at the quadrature
+     * points.
+     */
+    void do_tangent_on_face (const FaceEvaluation &phi_u,
+                             FaceEvaluation       &phi) const;
+
+    std::shared_ptr<const MatrixFree<dim,number>> data;
+    std::shared_ptr<const Obstacle>                obstacle;
+    double                                         penalty;
+    const Vector<number>                          *displacement;
+
+    std::vector<unsigned int> contact_face_batches;
+    std::vector<unsigned int> active_face_batches;
+  };
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::PenaltyContact ()
+    :
+    penalty(0.),
+    displacement(nullptr)
+  {}
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::add_data_flags (
+    typename MatrixFree<dim,number>::AdditionalData &additional_data)
+  {
+    additional_data.mapping_update_flags_boundary_faces =
+      update_values | update_quadrature_points | update_JxW_values;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::initialize (
+    std::shared_ptr<const MatrixFree<dim,number>> data_,
+    const types::boundary_id                      boundary_id,
+    std::shared_ptr<const Obstacle>                obstacle_,
+    const double                                   penalty_,
+    const Vector<number>                          &displacement_)
+  {
+    data = data_;
+    obstacle = obstacle_;
+    penalty = penalty_;
+    displacement = &displacement_;
+
+    contact_face_batches.clear();
+    for (unsigned int face=data->n_inner_face_batches();
+         face<data->n_inner_face_batches()+data->n_boundary_face_batches(); ++face)
+      if (data->get_boundary_id(face) == boundary_id)
+        contact_face_batches.push_back(face);
+
+    active_face_batches.clear();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::clear ()
+  {
+    data.reset();
+    contact_face_batches.clear();
+    active_face_batches.clear();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  inline
+  VectorizedArray<number>
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::get_gap (
+    const FaceEvaluation                   &phi_u,
+    const unsigned int                      q,
+    Point<dim,VectorizedArray<number>>     &x,
+    Tensor<1,dim,VectorizedArray<number>>  &normal) const
+  {
+    x = phi_u.quadrature_point(q);
+    const Tensor<1,dim,VectorizedArray<number>> u = phi_u.get_value(q);
+    for (unsigned int d=0; d<dim; ++d)
+      x[d] += u[d];
+    return obstacle->gap(x,normal);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::update_active_set ()
+  {
+    FaceEvaluation phi_u(*data);
+
+    active_face_batches.clear();
+    for (const unsigned int face : contact_face_batches)
+      {
+        phi_u.reinit(face);
+        phi_u.read_dof_values_plain(*displacement);
+        phi_u.evaluate(true,false);
+
+        const unsigned int n_filled = data->n_active_entries_per_face_batch(face);
+        bool active = false;
+        for (unsigned int q=0; q<phi_u.n_q_points && !active; ++q)
+          {
+            Point<dim,VectorizedArray<number>>    x;
+            Tensor<1,dim,VectorizedArray<number>> normal;
+            const VectorizedArray<number> g = get_gap(phi_u,q,x,normal);
+            for (unsigned int v=0; v<n_filled; ++v)
+              if (g[v] < 0)
+                active = true;
+          }
+
+        if (active)
+          active_face_batches.push_back(face);
+      }
+
+    return active_face_batches.size();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::n_active_face_batches () const
+  {
+    return active_face_batches.size();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::add_forces (Vector<number> &dst) const
+  {
+    FaceEvaluation phi_u(*data);
+
+    for (const unsigned int face : active_face_batches)
+      {
+        phi_u.reinit(face);
+        phi_u.read_dof_values_plain(*displacement);
+        phi_u.evaluate(true,false);
+
+        for (unsigned int q=0; q<phi_u.n_q_points; ++q)
+          {
+            Point<dim,VectorizedArray<number>>    x;
+            Tensor<1,dim,VectorizedArray<number>> normal;
+            const VectorizedArray<number> g = get_gap(phi_u,q,x,normal);
+
+            // $\epsilon \langle -g \rangle \mathbf{n}$
+            phi_u.submit_value(normal * (penalty * positive_indicator(-g) * (-g)), q);
+          }
+
+        phi_u.integrate(true,false);
+        phi_u.distribute_local_to_global(dst);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  inline
+  void
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::do_tangent_on_face (
+    const FaceEvaluation &phi_u,
+    FaceEvaluation       &phi) const
+  {
+    phi.evaluate(true,false);
+
+    for (unsigned int q=0; q<phi.n_q_points; ++q)
+      {
+        Point<dim,VectorizedArray<number>>    x;
+        Tensor<1,dim,VectorizedArray<number>> normal;
+        const VectorizedArray<number> g = get_gap(phi_u,q,x,normal);
+        const VectorizedArray<number> active = positive_indicator(-g);
+
+        const Tensor<1,dim,VectorizedArray<number>> v = phi.get_value(q);
+        phi.submit_value(normal * (penalty * active * (normal * v)) -
+                         obstacle->normal_derivative(x,v) * (penalty * active * (-g)),
+                         q);
+      }
+
+    phi.integrate(true,false);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::vmult_add (Vector<number>       &dst,
+                                                                 const Vector<number> &src) const
+  {
+    FaceEvaluation phi_u(*data);
+    FaceEvaluation phi(*data);
+
+    for (const unsigned int face : active_face_batches)
+      {
+        phi_u.reinit(face);
+        phi_u.read_dof_values_plain(*displacement);
+        phi_u.evaluate(true,false);
+
+        phi.reinit(face);
+        phi.read_dof_values(src);
+        do_tangent_on_face(phi_u,phi);
+        phi.distribute_local_to_global(dst);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  PenaltyContact<dim,fe_degree,n_q_points_1d,number>::add_diagonal (Vector<number> &diagonal) const
+  {
+    FaceEvaluation phi_u(*data);
+    FaceEvaluation phi(*data);
+
+    AlignedVector<VectorizedArray<number>> local_diagonal(phi.dofs_per_cell);
+
+    for (const unsigned int face : active_face_batches)
+      {
+        phi_u.reinit(face);
+        phi_u.read_dof_values_plain(*displacement);
+        phi_u.evaluate(true,false);
+
+        phi.reinit(face);
+        for (unsigned int i=0; i<phi.dofs_per_cell; ++i)
+          {
+            for (unsigned int j=0; j<phi.dofs_per_cell; ++j)
+              phi.begin_dof_values()[j] = VectorizedArray<number>();
+            phi.begin_dof_values()[i] = 1.;
+
+            do_tangent_on_face(phi_u,phi);
+            local_diagonal[i] = phi.begin_dof_values()[i];
+          }
+
+        for (unsigned int i=0; i<phi.dofs_per_cell; ++i)
+          phi.begin_dof_values()[i] = local_diagonal[i];
+        phi.distribute_local_to_global(diagonal);
+      }
+  }
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <deal.II/physics/elasticity/kinematics.h>
+
+#include <material.h>
+#include <material_history.h>
+
+using namespace dealii;
+
+  /**
+   * Matrix-free operator of the phase-field damage problem of the
+   * second order (AT2) model in the reference configuration,
+   * $\int (\frac{G_c}{l} + 2 \mathcal{H}) d \, \delta d + G_c l \nabla_0 d
+   * \cdot \nabla_0 \delta d \, dV$, with the fracture toughness $G_c$ and
+   * the length scale $l$. For a fixed crack driving force $\mathcal{H}$ the
+   * problem is linear in the damage $d$, whose right hand side is
+   * $\int 2 \mathcal{H} \delta d \, dV$.
+   *
+   * The crack driving force $\mathcal{H} = \max_{s \leq t}
+   * \Psi^+(\mathbf{F}(s))$ is the largest tensile energy of the neo-Hookean
+   * material so far, which makes the damage irreversible. It is the only
+   * variable of a MaterialHistory at the quadrature points: the old value
+   * holds the maximum up to the last converged step and the current one is
+   * recomputed from it for the current displacement.
+   *
+   * As for the HeatOperator, the damage is a further field of the MatrixFree
+   * object of the reference configuration, which shares the cell batches with
+   * the displacement. Constrained DoFs get identity rows.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  class DamageOperator : public Subscriptor
+  {
+  public:
+    DamageOperator ();
+
+    void clear();
+
+    void initialize(std::shared_ptr<const MatrixFree<dim,number>> data_reference,
+                    const unsigned int    displacement_dof_index,
+                    const unsigned int    damage_dof_index,
+                    const Vector<number> &displacement,
+                    std::shared_ptr<MaterialHistory<dim,number>> crack_driving_force);
+
+    void set_parameters(const double fracture_toughness,
+                        const double length_scale);
+
+    /**
+     * Update the current values of the crack driving force for the current
+     * displacement, starting from the old values.
+     */
+    void update_crack_driving_force(const Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<number>> &material);
+
+    void compute_diagonal();
+
+    unsigned int m () const;
+    unsigned int n () const;
+
+    void vmult (Vector<double> &dst,
+                const Vector<double> &src) const;
+    void Tvmult (Vector<double> &dst,
+                 const Vector<double> &src) const;
+
+    void precondition_Jacobi(Vector<number> &dst,
+                             const Vector<number> &src,
+                             const number omega) const;
+
+    /**
+     * Right hand side $\int 2 \mathcal{H} \delta d \, dV$ for the current
+     * crack driving force. Constrained entries are zero.
+     */
+    void compute_rhs(Vector<double> &rhs) const;
+
+  private:
+
+    /**
+     * Apply operator on a range of cells.
+     */
+    void local_apply_cell (const MatrixFree<dim,number>               &data,
+                           Vector<double>                             &dst,
+                           const Vector<double>                       &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const;
+
+    void do_quadrature_point_operation(FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> &phi_damage,
+                                       const unsigned int                                  cell) const;
+
+    std::shared_ptr<const MatrixFree<dim,number>> data_reference;
+
+    unsigned int displacement_dof_index;
+    unsigned int damage_dof_index;
+
+    const Vector<number> *displacement;
+
+    std::shared_ptr<MaterialHistory<dim,number>> crack_driving_force;
+
+    double fracture_toughness;
+    double length_scale;
+
+    Vector<number> inverse_diagonal;
+  };
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::DamageOperator ()
+    :
+    Subscriptor(),
+    displacement_dof_index(0),
+    damage_dof_index(1),
+    displacement(nullptr),
+    fracture_toughness(1.),
+    length_scale(1.)
+  {}
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::clear ()
+  {
+    data_reference.reset();
+    crack_driving_force.reset();
+    displacement = nullptr;
+    inverse_diagonal.reinit(0);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::initialize(
+                    std::shared_ptr<const MatrixFree<dim,number>> data_reference_,
+                    const unsigned int    displacement_dof_index_,
+                    const unsigned int    damage_dof_index_,
+                    const Vector<number> &displacement_,
+                    std::shared_ptr<MaterialHistory<dim,number>> crack_driving_force_)
+  {
+    Assert (crack_driving_force_->n_variables() == 1,
+            ExcDimensionMismatch(crack_driving_force_->n_variables(), 1));
+    Assert (crack_driving_force_->matches(*data_reference_), ExcInternalError());
+
+    data_reference = data_reference_;
+    displacement_dof_index = displacement_dof_index_;
+    damage_dof_index = damage_dof_index_;
+    displacement = &displacement_;
+    crack_driving_force = crack_driving_force_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::set_parameters(const double fracture_toughness_,
+                                                                    const double length_scale_)
+  {
+    Assert (fracture_toughness_ > 0, ExcMessage("The fracture toughness has to be positive"));
+    Assert (length_scale_ > 0, ExcMessage("The length scale has to be positive"));
+    fracture_toughness = fracture_toughness_;
+    length_scale = length_scale_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::m () const
+  {
+    return data_reference->get_dof_handler(damage_dof_index).n_dofs();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::n () const
+  {
+    return data_reference->get_dof_handler(damage_dof_index).n_dofs();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::precondition_Jacobi(Vector<number> &dst,
+                                                                         const Vector<number> &src,
+                                                                         const number omega) const
+  {
+    Assert (inverse_diagonal.size() == src.size(), ExcNotInitialized());
+    dst.equ(omega, src);
+    dst.scale(inverse_diagonal);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::update_crack_driving_force(
+                    const Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<number>> &material)
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_displacement(*data_reference, displacement_dof_index);
+
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_displacement.reinit(cell);
+        phi_displacement.read_dof_values_plain(*displacement);
+        phi_displacement.evaluate (false,true,false);
+
+        for (unsigned int q=0; q<phi_displacement.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<number>>          F      = Physics::Elasticity::Kinematics::F(phi_displacement.get_gradient(q));
+            const VectorizedArray<number>                        det_F  = determinant(F);
+            const SymmetricTensor<2,dim,VectorizedArray<number>> b_bar  =
+              Physics::Elasticity::Kinematics::b(F_iso(F));
+
+            crack_driving_force->current_value(0,cell,q) =
+              std::max(crack_driving_force->old_value(0,cell,q), material.get_Psi_tensile(det_F,b_bar));
+          }
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::vmult (Vector<double>       &dst,
+                                                            const Vector<double> &src) const
+  {
+    dst = 0;
+    local_apply_cell(*data_reference, dst, src,
+                     std::make_pair<unsigned int,unsigned int>(0,data_reference->n_macro_cells()));
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs(damage_dof_index);
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      dst(constrained_dofs[i]) = src(constrained_dofs[i]);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::Tvmult (Vector<double>       &dst,
+                                                             const Vector<double> &src) const
+  {
+    vmult(dst, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::local_apply_cell (
+                           const MatrixFree<dim,number>               &data,
+                           Vector<double>                             &dst,
+                           const Vector<double>                       &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> phi_damage (data, damage_dof_index);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi_damage.reinit(cell);
+        phi_damage.read_dof_values(src);
+        phi_damage.evaluate (true,true,false);
+
+        do_quadrature_point_operation(phi_damage, cell);
+
+        phi_damage.integrate (true,true);
+        phi_damage.distribute_local_to_global(dst);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::do_quadrature_point_operation(
+                             FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> &phi_damage,
+                             const unsigned int                                  cell) const
+  {
+    for (unsigned int q=0; q<phi_damage.n_q_points; ++q)
+      {
+        const VectorizedArray<number> JxW = phi_damage.JxW(q);
+        const VectorizedArray<number> reaction = fracture_toughness / length_scale +
+                                                 2. * crack_driving_force->current_value(0,cell,q);
+
+        phi_damage.submit_value(phi_damage.get_value(q) * reaction * JxW, q);
+        phi_damage.submit_gradient(phi_damage.get_gradient(q) * (fracture_toughness * length_scale) * JxW, q);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::compute_rhs(Vector<double> &rhs) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> phi_damage (*data_reference, damage_dof_index);
+
+    rhs = 0;
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_damage.reinit(cell);
+        for (unsigned int q=0; q<phi_damage.n_q_points; ++q)
+          phi_damage.submit_value(2. * crack_driving_force->current_value(0,cell,q) * phi_damage.JxW(q), q);
+
+        phi_damage.integrate (true,false);
+        phi_damage.distribute_local_to_global(rhs);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  DamageOperator<dim,fe_degree,n_q_points_1d,number>::compute_diagonal()
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> phi_damage (*data_reference, damage_dof_index);
+
+    data_reference->initialize_dof_vector(inverse_diagonal, damage_dof_index);
+
+    AlignedVector<VectorizedArray<number>> local_diagonal(phi_damage.dofs_per_cell);
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_damage.reinit(cell);
+
+        for (unsigned int i=0; i<phi_damage.dofs_per_cell; ++i)
+          {
+            for (unsigned int j=0; j<phi_damage.dofs_per_cell; ++j)
+              phi_damage.begin_dof_values()[j] = VectorizedArray<number>();
+            phi_damage.begin_dof_values()[i] = 1.;
+
+            phi_damage.evaluate (true,true,false);
+            do_quadrature_point_operation(phi_damage, cell);
+            phi_damage.integrate (true,true);
+
+            local_diagonal[i] = phi_damage.begin_dof_values()[i];
+          }
+
+        for (unsigned int i=0; i<phi_damage.dofs_per_cell; ++i)
+          phi_damage.begin_dof_values()[i] = local_diagonal[i];
+        phi_damage.distribute_local_to_global(inverse_diagonal);
+      }
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs(damage_dof_index);
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      inverse_diagonal(constrained_dofs[i]) = 1.;
+
+    for (unsigned int i=0; i<inverse_diagonal.size(); ++i)
+      {
+        Assert (inverse_diagonal(i) > 0., ExcMessage("Diagonal of the damage operator has to be positive"));
+        inverse_diagonal(i) = 1./inverse_diagonal(i);
+      }
+  }
@@ -0,0 +1,469 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/identity_matrix.h>
+#include <deal.II/lac/vector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace dealii;
+
+  /**
+   * Locally optimal block preconditioned conjugate gradient (LOBPCG) method
+   * for the smallest eigenvalues of the generalized problem $A x = \lambda B x$
+   * with symmetric $A$ and symmetric positive definite $B$.
+   *
+   * Only the action of the operators on a block of vectors is required, so
+   * that $A$ can be the matrix-free NeoHookOperator and $B$ the MassOperator
+   * or the identity. The preconditioner approximates $A^{-1}$, e.g. the Jacobi
+   * preconditioner of the tangent operator. All iterates are kept zero on the
+   * constrained DoFs, so that the identity rows of the operators do not give
+   * spurious eigenvalues.
+   *
+   * See Knyazev 2001, Toward the optimal preconditioned eigensolver: locally
+   * optimal block preconditioned conjugate gradient method,
+   * doi: 10.1137/S1064827500366124
+   */
+  class LOBPCGEigensolver
+  {
+  public:
+    struct AdditionalData
+    {
+      AdditionalData(const unsigned int max_iterations = 200,
+                     const double       tolerance = 1e-6)
+        :
+        max_iterations(max_iterations),
+        tolerance(tolerance)
+      {}
+
+      unsigned int max_iterations;
+      double       tolerance;
+    };
+
+    LOBPCGEigensolver(const AdditionalData &data = AdditionalData());
+
+    /**
+     * Compute as many eigenpairs as @p eigenvectors has elements. The vectors
+     * have to be initialized to the correct size, their content is used as
+     * start vectors unless it is zero in which case random vectors are used.
+     * Returns the number of iterations. The eigenvectors are $B$-orthonormal.
+     */
+    template <typename MatrixType, typename MassMatrixType, typename PreconditionerType>
+    unsigned int
+    solve(const MatrixType            &A,
+          const MassMatrixType        &B,
+          const PreconditionerType    &preconditioner,
+          const ConstraintMatrix      &constraints,
+          std::vector<double>         &eigenvalues,
+          std::vector<Vector<double>> &eigenvectors,
+          std::vector<double>         &residuals) const;
+
+  private:
+    const AdditionalData additional_data;
+
+    /**
+     * Apply an operator to a block of vectors.
+     */
+    template <typename MatrixType>
+    static void
+    apply(const MatrixType                  &A,
+          std::vector<Vector<double>>       &dst,
+          const std::vector<Vector<double>> &src);
+
+    static void
+    apply(const IdentityMatrix              &,
+          std::vector<Vector<double>>       &dst,
+          const std::vector<Vector<double>> &src);
+
+    /**
+     * Solve the dense generalized eigenvalue problem $G_A c = \theta G_B c$ via
+     * Cholesky factorization of $G_B$ and Jacobi rotations. Return false if
+     * $G_B$ is numerically singular.
+     */
+    static bool
+    rayleigh_ritz(const FullMatrix<double> &G_A,
+                  const FullMatrix<double> &G_B,
+                  std::vector<double>      &theta,
+                  FullMatrix<double>       &C);
+
+    /**
+     * Eigenvalues and eigenvectors (columns of @p V) of a symmetric matrix,
+     * sorted by increasing eigenvalue.
+     */
+    static void
+    symmetric_eigenvalues(FullMatrix<double>  &M,
+                          std::vector<double> &lambda,
+                          FullMatrix<double>  &V);
+
+    /**
+     * dst[j] = sum_k src[k] C(offset+k, j)
+     */
+    static void
+    combine(const std::vector<const Vector<double>*> &src,
+            const FullMatrix<double>                 &C,
+            const unsigned int                        offset,
+            std::vector<Vector<double>>              &dst);
+  };
+
+
+
+  inline
+  LOBPCGEigensolver::LOBPCGEigensolver(const AdditionalData &data)
+    :
+    additional_data(data)
+  {}
+
+
+
+  template <typename MatrixType>
+  inline
+  void
+  LOBPCGEigensolver::apply(const MatrixType                  &A,
+                           std::vector<Vector<double>>       &dst,
+                           const std::vector<Vector<double>> &src)
+  {
+    A.vmult(dst, src);
+  }
+
+
+
+  inline
+  void
+  LOBPCGEigensolver::apply(const IdentityMatrix              &,
+                           std::vector<Vector<double>>       &dst,
+                           const std::vector<Vector<double>> &src)
+  {
+    dst = src;
+  }
+
+
+
+  inline
+  void
+  LOBPCGEigensolver::combine(const std::vector<const Vector<double>*> &src,
+                             const FullMatrix<double>                 &C,
+                             const unsigned int                        offset,
+                             std::vector<Vector<double>>              &dst)
+  {
+    for (unsigned int j=0; j<dst.size(); ++j)
+      {
+        dst[j] = 0;
+        for (unsigned int k=0; k<src.size(); ++k)
+          dst[j].add(C(offset+k,j), *src[k]);
+      }
+  }
+
+
+
+  inline
+  void
+  LOBPCGEigensolver::symmetric_eigenvalues(FullMatrix<double>  &M,
+                                           std::vector<double> &lambda,
+                                           FullMatrix<double>  &V)
+  {
+    const unsigned int n = M.m();
+    V.reinit(n,n);
+    for (unsigned int i=0; i<n; ++i)
+      V(i,i) = 1.;
+
+    // cyclic Jacobi rotations, the matrices are small (three times the block size)
+    for (unsigned int sweep=0; sweep<100; ++sweep)
+      {
+        double off_diagonal = 0., diagonal = 0.;
+        for (unsigned int i=0; i<n; ++i)
+          {
+            diagonal += M(i,i)*M(i,i);
+            for (unsigned int j=i+1; j<n; ++j)
+              off_diagonal += M(i,j)*M(i,j);
+          }
+        if (off_diagonal <= 1e-30 * diagonal)
+          break;
+
+        for (unsigned int p=0; p<n; ++p)
+          for (unsigned int q=p+1; q<n; ++q)
+            {
+              if (std::abs(M(p,q)) <= std::numeric_limits<double>::min())
+                continue;
+
+              const double tau = (M(q,q) - M(p,p)) / (2. * M(p,q));
+              const double t = (tau >= 0. ? 1. : -1.) / (std::abs(tau) + std::sqrt(1. + tau*tau));
+              const double c = 1. / std::sqrt(1. + t*t);
+              const double s = t * c;
+
+              for (unsigned int k=0; k<n; ++k)
+                {
+                  const double m_kp = M(k,p), m_kq = M(k,q);
+                  M(k,p) = c*m_kp - s*m_kq;
+                  M(k,q) = s*m_kp + c*m_kq;
+                }
+              for (unsigned int k=0; k<n; ++k)
+                {
+                  const double m_pk = M(p,k), m_qk = M(q,k);
+                  M(p,k) = c*m_pk - s*m_qk;
+                  M(q,k) = s*m_pk + c*m_qk;
+                }
+              for (unsigned int k=0; k<n; ++k)
+                {
+                  const double v_kp = V(k,p), v_kq = V(k,q);
+                  V(k,p) = c*v_kp - s*v_kq;
+                  V(k,q) = s*v_kp + c*v_kq;
+                }
+            }
+      }
+
+    // sort by increasing eigenvalues
+    std::vector<unsigned int> permutation(n);
+    for (unsigned int i=0; i<n; ++i)
+      permutation[i] = i;
+    std::sort(permutation.begin(), permutation.end(),
+              [&M](const unsigned int a, const unsigned int b)
+    {
+      return M(a,a) < M(b,b);
+    });
+
+    FullMatrix<double> V_sorted(n,n);
+    lambda.resize(n);
+    for (unsigned int j=0; j<n; ++j)
+      {
+        lambda[j] = M(permutation[j],permutation[j]);
+        for (unsigned int i=0; i<n; ++i)
+          V_sorted(i,j) = V(i,permutation[j]);
+      }
+    V = V_sorted;
+  }
+
+
+
+  inline
+  bool
+  LOBPCGEigensolver::rayleigh_ritz(const FullMatrix<double> &G_A,
+                                   const FullMatrix<double> &G_B,
+                                   std::vector<double>      &theta,
+                                   FullMatrix<double>       &C)
+  {
+    const unsigned int n = G_A.m();
+
+    // Cholesky factorization G_B = L L^T
+    double max_diagonal = 0.;
+    for (unsigned int i=0; i<n; ++i)
+      max_diagonal = std::max(max_diagonal, std::abs(G_B(i,i)));
+
+    FullMatrix<double> L(n,n);
+    for (unsigned int j=0; j<n; ++j)
+      {
+        double d = G_B(j,j);
+        for (unsigned int k=0; k<j; ++k)
+          d -= L(j,k)*L(j,k);
+        if (d <= 1e-12 * max_diagonal)
+          return false;
+        L(j,j) = std::sqrt(d);
+        for (unsigned int i=j+1; i<n; ++i)
+          {
+            double v = G_B(i,j);
+            for (unsigned int k=0; k<j; ++k)
+              v -= L(i,k)*L(j,k);
+            L(i,j) = v / L(j,j);
+          }
+      }
+
+    FullMatrix<double> L_inv(n,n);
+    L_inv.invert(L);
+
+    // M = L^{-1} G_A L^{-T}
+    FullMatrix<double> tmp(n,n), M(n,n);
+    L_inv.mmult(tmp, G_A);
+    tmp.mTmult(M, L_inv);
+    M.symmetrize();
+
+    FullMatrix<double> Y;
+    symmetric_eigenvalues(M, theta, Y);
+
+    // back-transformation c = L^{-T} y
+    C.reinit(n,n);
+    L_inv.Tmmult(C, Y);
+
+    return true;
+  }
+
+
+
+  template <typename MatrixType, typename MassMatrixType, typename PreconditionerType>
+  unsigned int
+  LOBPCGEigensolver::solve(const MatrixType            &A,
+                           const MassMatrixType        &B,
+                           const PreconditionerType    &preconditioner,
+                           const ConstraintMatrix      &constraints,
+                           std::vector<double>         &eigenvalues,
+                           std::vector<Vector<double>> &X,
+                           std::vector<double>         &residuals) const
+  {
+    const unsigned int m = X.size();
+    Assert (m > 0, ExcInternalError());
+    const unsigned int size = X[0].size();
+
+    // start vectors
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(-1.,1.);
+    for (unsigned int j=0; j<m; ++j)
+      {
+        if (X[j].l2_norm() == 0.)
+          for (unsigned int i=0; i<size; ++i)
+            X[j](i) = distribution(generator);
+        constraints.set_zero(X[j]);
+      }
+
+    std::vector<Vector<double>> AX(m, Vector<double>(size)), BX(m, Vector<double>(size));
+    std::vector<Vector<double>> W (m, Vector<double>(size)), AW(m, Vector<double>(size)),
+        BW(m, Vector<double>(size));
+    std::vector<Vector<double>> P, AP, BP;
+    std::vector<Vector<double>> X_new(m, Vector<double>(size)), P_new(m, Vector<double>(size));
+
+    apply(A, AX, X);
+    apply(B, BX, X);
+
+    // initial Rayleigh-Ritz step on the start vectors
+    {
+      FullMatrix<double> G_A(m,m), G_B(m,m), C;
+      for (unsigned int i=0; i<m; ++i)
+        for (unsigned int j=0; j<m; ++j)
+          {
+            G_A(i,j) = X[i] * AX[j];
+            G_B(i,j) = X[i] * BX[j];
+          }
+      G_A.symmetrize();
+      G_B.symmetrize();
+      AssertThrow(rayleigh_ritz(G_A, G_B, eigenvalues, C),
+                  ExcMessage("Start vectors of LOBPCG are linearly dependent"));
+      eigenvalues.resize(m);
+
+      std::vector<const Vector<double>*> S(m), AS(m), BS(m);
+      for (unsigned int j=0; j<m; ++j)
+        {
+          S[j] = &X[j];
+          AS[j] = &AX[j];
+          BS[j] = &BX[j];
+        }
+      combine(S,  C, 0, X_new);
+      X.swap(X_new);
+      combine(AS, C, 0, X_new);
+      AX.swap(X_new);
+      combine(BS, C, 0, X_new);
+      BX.swap(X_new);
+    }
+
+    residuals.resize(m);
+    unsigned int it = 0;
+    for (; it < additional_data.max_iterations; ++it)
+      {
+        // residuals and convergence check
+        bool converged = true;
+        for (unsigned int j=0; j<m; ++j)
+          {
+            W[j] = AX[j];
+            W[j].add(-eigenvalues[j], BX[j]);
+            residuals[j] = W[j].l2_norm() /
+                           std::max(std::abs(eigenvalues[j]) * BX[j].l2_norm(),
+                                    std::numeric_limits<double>::min());
+            if (residuals[j] > additional_data.tolerance)
+              converged = false;
+          }
+        if (converged)
+          break;
+
+        // preconditioned residuals
+        for (unsigned int j=0; j<m; ++j)
+          {
+            Vector<double> r(W[j]);
+            preconditioner.vmult(W[j], r);
+            constraints.set_zero(W[j]);
+          }
+        apply(A, AW, W);
+        apply(B, BW, W);
+
+        // Rayleigh-Ritz on the subspace spanned by [X, W, P]. If the basis is
+        // numerically singular, the search directions P are dropped.
+        bool use_P = (P.size() == m);
+        FullMatrix<double> C;
+        std::vector<double> theta;
+        std::vector<const Vector<double>*> S, AS, BS;
+        for (unsigned int attempt=0; attempt<2; ++attempt)
+          {
+            S.clear();
+            AS.clear();
+            BS.clear();
+            for (unsigned int j=0; j<m; ++j)
+              {
+                S.push_back(&X[j]);
+                AS.push_back(&AX[j]);
+                BS.push_back(&BX[j]);
+              }
+            for (unsigned int j=0; j<m; ++j)
+              {
+                S.push_back(&W[j]);
+                AS.push_back(&AW[j]);
+                BS.push_back(&BW[j]);
+              }
+            if (use_P)
+              for (unsigned int j=0; j<m; ++j)
+                {
+                  S.push_back(&P[j]);
+                  AS.push_back(&AP[j]);
+                  BS.push_back(&BP[j]);
+                }
+
+            const unsigned int n = S.size();
+            FullMatrix<double> G_A(n,n), G_B(n,n);
+            for (unsigned int i=0; i<n; ++i)
+              for (unsigned int j=i; j<n; ++j)
+                {
+                  G_A(i,j) = G_A(j,i) = *S[i] * *AS[j];
+                  G_B(i,j) = G_B(j,i) = *S[i] * *BS[j];
+                }
+
+            if (rayleigh_ritz(G_A, G_B, theta, C))
+              break;
+
+            AssertThrow(use_P == true,
+                        ExcMessage("LOBPCG basis became linearly dependent"));
+            use_P = false;
+          }
+
+        for (unsigned int j=0; j<m; ++j)
+          eigenvalues[j] = theta[j];
+
+        // The new search directions are the parts of the Ritz vectors that are
+        // not in the span of the old X:
+        const std::vector<const Vector<double>*> S_P (S.begin()+m, S.end());
+        const std::vector<const Vector<double>*> AS_P(AS.begin()+m, AS.end());
+        const std::vector<const Vector<double>*> BS_P(BS.begin()+m, BS.end());
+        if (P.size() != m)
+          {
+            P.resize(m, Vector<double>(size));
+            AP.resize(m, Vector<double>(size));
+            BP.resize(m, Vector<double>(size));
+          }
+
+        combine(S_P, C, m, P_new);
+        combine(S, C, 0, X_new);
+        P.swap(P_new);
+        X.swap(X_new);
+
+        combine(AS_P, C, m, P_new);
+        combine(AS, C, 0, X_new);
+        AP.swap(P_new);
+        AX.swap(X_new);
+
+        combine(BS_P, C, m, P_new);
+        combine(BS, C, 0, X_new);
+        BP.swap(P_new);
+        BX.swap(X_new);
+      }
+
+    return it;
+  }
@@ -52,11 +52,27 @@
 #include <deal.II/physics/elasticity/kinematics.h>
 #include <deal.II/physics/elasticity/standard_tensors.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
 #include <mf_nh_operator.h>
+#include <mf_contact.h>
+#include <mf_heat_operator.h>
+#include <mf_linear_elastic_operator.h>
+#include <multicolor_ssor.h>
+#include <bsr_matrix.h>
+#include <symmetric_sparse_matrix.h>
+#include <sell_c_sigma_matrix.h>
+#include <amg_preconditioner.h>
+#include <mf_damage_operator.h>
+#include <anderson_acceleration.h>
+#include <mf_mass_operator.h>
+#include <mf_eigensolver.h>
 #include <material.h>
+#include <material_history.h>
+#include <fiber_directions.h>
+#include <cell_coefficients.h>
 
 using namespace dealii;
 
@@ -82,6 +98,7 @@ namespace Cook_Membrane
     {
       unsigned int poly_degree;
       unsigned int quad_order;
+      std::string  volumetric_formulation;
 
       static void
       declare_parameters(ParameterHandler &prm);
@@ -102,6 +119,12 @@ namespace Cook_Membrane
         prm.declare_entry("Quadrature order", "3",
                           Patterns::Integer(0),
                           "Gauss quadrature order");
+
+        prm.declare_entry("Volumetric formulation", "Standard",
+                          Patterns::Selection("Standard|F-bar"),
+                          "Evaluate the volumetric response at the quadrature "
+                          "points or with the mean dilatation of each cell "
+                          "against volumetric locking");
       }
       prm.leave_subsection();
     }
@@ -112,6 +135,7 @@ namespace Cook_Membrane
       {
         poly_degree = prm.get_integer("Polynomial degree");
         quad_order = prm.get_integer("Quadrature order");
+        volumetric_formulation = prm.get("Volumetric formulation");
       }
       prm.leave_subsection();
     }
@@ -159,11 +183,25 @@ namespace Cook_Membrane
 // @sect4{Materials}
 
 // We also need the shear modulus $ \mu $ and Poisson ration $ \nu $ for the
-// neo-Hookean material.
+// neo-Hookean material. The elastoplastic material additionally needs the
+// initial yield stress and the linear isotropic and kinematic hardening
+// moduli, the viscoelastic one the relative stiffnesses and relaxation times
+// of its Maxwell elements. The fiber reinforced material adds one or two
+// fiber families at $\pm$ the fiber angle to the beam axis.
     struct Materials
     {
-      double nu;
-      double mu;
+      double              nu;
+      double              mu;
+      std::string         material_model;
+      double              yield_stress;
+      double              isotropic_hardening;
+      double              kinematic_hardening;
+      std::vector<double> prony_stiffnesses;
+      std::vector<double> prony_relaxation_times;
+      double              fiber_stiffness;
+      double              fiber_exponent;
+      double              fiber_angle;
+      unsigned int        n_fiber_families;
 
       static void
       declare_parameters(ParameterHandler &prm);
@@ -183,6 +221,50 @@ namespace Cook_Membrane
         prm.declare_entry("Shear modulus", "0.4225e6",
                           Patterns::Double(),
                           "Shear modulus");
+
+        prm.declare_entry("Material model", "Neo-Hooke",
+                          Patterns::Selection("Neo-Hooke|J2 plasticity|Viscoelastic|HGO"),
+                          "Hyperelastic, finite strain elastoplastic, "
+                          "viscoelastic or fiber reinforced (Holzapfel-Gasser-Ogden) "
+                          "material");
+
+        prm.declare_entry("Yield stress", "2.0e4",
+                          Patterns::Double(0.0),
+                          "Initial yield stress");
+
+        prm.declare_entry("Isotropic hardening modulus", "1.0e5",
+                          Patterns::Double(0.0),
+                          "Linear isotropic hardening modulus");
+
+        prm.declare_entry("Kinematic hardening modulus", "0.0",
+                          Patterns::Double(0.0),
+                          "Linear kinematic hardening modulus");
+
+        prm.declare_entry("Prony series stiffnesses", "0.5",
+                          Patterns::List(Patterns::Double(0.0)),
+                          "Stiffnesses of the Maxwell elements relative to the "
+                          "isochoric equilibrium stiffness");
+
+        prm.declare_entry("Prony series relaxation times", "0.1",
+                          Patterns::List(Patterns::Double(0.0)),
+                          "Relaxation times of the Maxwell elements");
+
+        prm.declare_entry("Fiber stiffness", "1.0e5",
+                          Patterns::Double(0.0),
+                          "Stress-like fiber parameter k1");
+
+        prm.declare_entry("Fiber exponent", "1.0",
+                          Patterns::Double(0.0),
+                          "Dimensionless fiber parameter k2");
+
+        prm.declare_entry("Fiber angle", "30",
+                          Patterns::Double(-90.0,90.0),
+                          "Angle of the fibers to the beam axis in degrees");
+
+        prm.declare_entry("Fiber families", "2",
+                          Patterns::Integer(1,2),
+                          "One family at the fiber angle or two at plus and "
+                          "minus the fiber angle");
       }
       prm.leave_subsection();
     }
@@ -193,6 +275,23 @@ namespace Cook_Membrane
       {
         nu = prm.get_double("Poisson's ratio");
         mu = prm.get_double("Shear modulus");
+        material_model = prm.get("Material model");
+        yield_stress = prm.get_double("Yield stress");
+        isotropic_hardening = prm.get_double("Isotropic hardening modulus");
+        kinematic_hardening = prm.get_double("Kinematic hardening modulus");
+        prony_stiffnesses = Utilities::string_to_double(
+          Utilities::split_string_list(prm.get("Prony series stiffnesses")));
+        prony_relaxation_times = Utilities::string_to_double(
+          Utilities::split_string_list(prm.get("Prony series relaxation times")));
+        AssertThrow(prony_stiffnesses.size() == prony_relaxation_times.size(),
+                    ExcMessage("Number of Prony series stiffnesses and relaxation times differ"));
+        for (const double tau_i : prony_relaxation_times)
+          AssertThrow(tau_i > 0,
+                      ExcMessage("The Prony series relaxation times have to be positive"));
+        fiber_stiffness = prm.get_double("Fiber stiffness");
+        fiber_exponent = prm.get_double("Fiber exponent");
+        fiber_angle = prm.get_double("Fiber angle");
+        n_fiber_families = prm.get_integer("Fiber families");
       }
       prm.leave_subsection();
     }
@@ -201,7 +300,23 @@ namespace Cook_Membrane
 
 // Next, we choose both solver and preconditioner settings.  The use of an
 // effective preconditioner is critical to ensure convergence when a large
-// nonlinear motion occurs within a Newton increment.
+// nonlinear motion occurs within a Newton increment. The matrix-free
+// operator either tabulates the Jacobians of the current configuration after
+// every Newton iteration or computes them on the fly from the deformation
+// gradient. Instead of the Jacobi preconditioner, the matrix-free solver can
+// be preconditioned by a Chebyshev iteration on the linear elastic operator
+// of the undeformed state, which is set up once per run. For the assembled
+// tangent, "mc_ssor" is a multithreaded SSOR on a coloring of the sparsity
+// pattern. The assembled tangent is stored either in the scalar CSR format,
+// in the block CSR format with the dim x dim blocks of the nodes, which
+// stores one column index per block and vectorizes the product with it, or
+// in the symmetric format with only the upper triangle, which halves the
+// memory traffic of the product for the symmetric tangent. "SELL" assembles
+// the CSR matrix and copies it into the SELL-C-sigma format for a vectorized
+// product in CG, while the preconditioner works on the CSR matrix. With
+// Trilinos, "amg" is the smoothed aggregation AMG of ML with the rigid body
+// modes, whose setup is kept until the CG iterations grow by more than the
+// rebuild ratio beyond those right after the setup.
     struct LinearSolver
     {
       std::string type_lin;
@@ -209,6 +324,12 @@ namespace Cook_Membrane
       double      max_iterations_lin;
       std::string preconditioner_type;
       double      preconditioner_relaxation;
+      unsigned int preconditioner_degree;
+      double      preconditioner_smoothing_range;
+      unsigned int preconditioner_eigenvalue_iterations;
+      std::string mf_geometry;
+      std::string matrix_format;
+      double      amg_rebuild_ratio;
 
       static void
       declare_parameters(ParameterHandler &prm);
@@ -234,12 +355,40 @@ namespace Cook_Membrane
                           "Linear solver iterations (multiples of the system matrix size)");
 
         prm.declare_entry("Preconditioner type", "jacobi",
-                          Patterns::Selection("jacobi|ssor"),
+                          Patterns::Selection("jacobi|ssor|mc_ssor|linear_elastic|amg"),
                           "Type of preconditioner");
 
         prm.declare_entry("Preconditioner relaxation", "0.65",
                           Patterns::Double(0.0),
                           "Preconditioner relaxation value");
+
+        prm.declare_entry("Preconditioner degree", "4",
+                          Patterns::Integer(1),
+                          "Degree of the Chebyshev iteration of the linear elastic preconditioner");
+
+        prm.declare_entry("Preconditioner smoothing range", "0",
+                          Patterns::Double(0.0),
+                          "Ratio of the largest to the smallest eigenvalue treated by the Chebyshev "
+                          "iteration, where 0 selects the square of the degree, but at least 4");
+
+        prm.declare_entry("Preconditioner eigenvalue iterations", "20",
+                          Patterns::Integer(1),
+                          "CG iterations to estimate the largest eigenvalue for the Chebyshev iteration");
+
+        prm.declare_entry("Current configuration geometry", "Tabulated",
+                          Patterns::Selection("Tabulated|On the fly"),
+                          "Whether the matrix-free operator stores the Jacobians of the "
+                          "current configuration or computes them in the cell kernel");
+
+        prm.declare_entry("Matrix format", "CSR",
+                          Patterns::Selection("CSR|BSR|Symmetric|SELL"),
+                          "Storage of the assembled tangent, scalar, with the blocks of the nodes, "
+                          "only its upper triangle or scalar with a SELL-C-sigma copy for the product");
+
+        prm.declare_entry("AMG rebuild ratio", "1.5",
+                          Patterns::Double(1.0),
+                          "Set up the AMG preconditioner again once the CG iterations exceed "
+                          "this multiple of those right after the last setup");
       }
       prm.leave_subsection();
     }
@@ -253,20 +402,48 @@ namespace Cook_Membrane
         max_iterations_lin = prm.get_double("Max iteration multiplier");
         preconditioner_type = prm.get("Preconditioner type");
         preconditioner_relaxation = prm.get_double("Preconditioner relaxation");
+        preconditioner_degree = prm.get_integer("Preconditioner degree");
+        preconditioner_smoothing_range = prm.get_double("Preconditioner smoothing range");
+        preconditioner_eigenvalue_iterations = prm.get_integer("Preconditioner eigenvalue iterations");
+        mf_geometry = prm.get("Current configuration geometry");
+        matrix_format = prm.get("Matrix format");
+        amg_rebuild_ratio = prm.get_double("AMG rebuild ratio");
       }
       prm.leave_subsection();
+
+      AssertThrow(preconditioner_type != "linear_elastic" || type_lin == "MF_CG",
+                  ExcMessage("The linear elastic preconditioner requires the matrix-free solver"));
+      AssertThrow(preconditioner_type != "mc_ssor" || type_lin == "CG",
+                  ExcMessage("The multicolor SSOR preconditioner requires the assembled tangent"));
+      AssertThrow(matrix_format != "SELL" || type_lin == "CG",
+                  ExcMessage("The SELL-C-sigma copy is only used by the CG solver on the assembled tangent"));
+      AssertThrow(preconditioner_type != "mc_ssor" || matrix_format == "CSR" || matrix_format == "SELL",
+                  ExcMessage("The multicolor SSOR preconditioner requires the CSR format"));
+      AssertThrow(preconditioner_type != "amg" ||
+                  (type_lin == "CG" && (matrix_format == "CSR" || matrix_format == "SELL")),
+                  ExcMessage("The AMG preconditioner requires the assembled tangent in the CSR format"));
+#ifndef DEAL_II_WITH_TRILINOS
+      AssertThrow(preconditioner_type != "amg",
+                  ExcMessage("The AMG preconditioner requires deal.II with Trilinos"));
+#endif
     }
 
 // @sect4{Nonlinear solver}
 
 // A Newton-Raphson scheme is used to solve the nonlinear system of governing
 // equations.  We now define the tolerances and the maximum number of
-// iterations for the Newton-Raphson nonlinear solver.
+// iterations for the Newton-Raphson nonlinear solver. The Newton updates as
+// well as the updates of the staggered coupling with the temperature or the
+// damage can be combined with those of previous iterations by Anderson
+// acceleration. Alternatively, the full approximation scheme solves the
+// nonlinear problem by multigrid directly.
     struct NonlinearSolver
     {
+      std::string  type_nonlin;
       unsigned int max_iterations_NR;
       double       tol_f;
       double       tol_u;
+      unsigned int anderson_depth;
 
       static void
       declare_parameters(ParameterHandler &prm);
@@ -279,6 +456,10 @@ namespace Cook_Membrane
     {
       prm.enter_subsection("Nonlinear solver");
       {
+        prm.declare_entry("Solver type", "Newton",
+                          Patterns::Selection("Newton|FAS"),
+                          "Type of solver used to solve the nonlinear system");
+
         prm.declare_entry("Max iterations Newton-Raphson", "10",
                           Patterns::Integer(0),
                           "Number of Newton-Raphson iterations allowed");
@@ -290,6 +471,11 @@ namespace Cook_Membrane
         prm.declare_entry("Tolerance displacement", "1.0e-6",
                           Patterns::Double(0.0),
                           "Displacement error tolerance");
+
+        prm.declare_entry("Anderson acceleration depth", "0",
+                          Patterns::Integer(0),
+                          "Number of previous updates used by the Anderson acceleration "
+                          "(0 to disable)");
       }
       prm.leave_subsection();
     }
@@ -298,20 +484,97 @@ namespace Cook_Membrane
     {
       prm.enter_subsection("Nonlinear solver");
       {
+        type_nonlin = prm.get("Solver type");
         max_iterations_NR = prm.get_integer("Max iterations Newton-Raphson");
         tol_f = prm.get_double("Tolerance force");
         tol_u = prm.get_double("Tolerance displacement");
+        anderson_depth = prm.get_integer("Anderson acceleration depth");
+      }
+      prm.leave_subsection();
+    }
+
+// @sect4{Nonlinear multigrid}
+
+// The full approximation scheme works on a hierarchy of globally refined Cook
+// meshes whose finest level is the mesh of the Newton scheme. Each level is
+// smoothed by damped nonlinear Jacobi sweeps, the coarsest level is solved by
+// Newton's method. The time to solution can be compared to the one of the
+// matrix-free Newton-CG scheme on the finest level.
+    struct NonlinearMultigrid
+    {
+      unsigned int fas_levels;
+      unsigned int fas_smoothing_sweeps;
+      double       fas_smoothing_relaxation;
+      unsigned int fas_max_cycles;
+      double       fas_coarse_tolerance;
+      bool         fas_compare_newton;
+
+      static void
+      declare_parameters(ParameterHandler &prm);
+
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    void NonlinearMultigrid::declare_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Nonlinear multigrid");
+      {
+        prm.declare_entry("Levels", "3",
+                          Patterns::Integer(1),
+                          "Number of levels, the elements per edge have to be "
+                          "divisible by the refinement of the finest level");
+
+        prm.declare_entry("Smoothing sweeps", "3",
+                          Patterns::Integer(1),
+                          "Number of nonlinear Jacobi sweeps before and after "
+                          "each coarse correction");
+
+        prm.declare_entry("Smoothing relaxation", "0.5",
+                          Patterns::Double(0.0),
+                          "Damping of the nonlinear Jacobi sweeps");
+
+        prm.declare_entry("Max cycles", "50",
+                          Patterns::Integer(1),
+                          "Number of V-cycles allowed per load step");
+
+        prm.declare_entry("Coarse tolerance", "1.0e-3",
+                          Patterns::Double(0.0),
+                          "Residual reduction of the Newton scheme on the coarsest level");
+
+        prm.declare_entry("Compare with Newton-CG", "false",
+                          Patterns::Bool(),
+                          "Solve the load steps again by the Newton-CG scheme "
+                          "and compare the times to solution");
+      }
+      prm.leave_subsection();
+    }
+
+    void NonlinearMultigrid::parse_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Nonlinear multigrid");
+      {
+        fas_levels = prm.get_integer("Levels");
+        fas_smoothing_sweeps = prm.get_integer("Smoothing sweeps");
+        fas_smoothing_relaxation = prm.get_double("Smoothing relaxation");
+        fas_max_cycles = prm.get_integer("Max cycles");
+        fas_coarse_tolerance = prm.get_double("Coarse tolerance");
+        fas_compare_newton = prm.get_bool("Compare with Newton-CG");
       }
       prm.leave_subsection();
     }
 
 // @sect4{Time}
 
-// Set the timestep size $ \varDelta t $ and the simulation end-time.
+// Set the timestep size $ \varDelta t $ and the simulation end-time. The
+// load is ramped up linearly until the load ramp time and then held, which
+// is relevant for rate dependent materials. By default it is ramped over the
+// whole simulation.
     struct Time
     {
       double delta_t;
       double end_time;
+      double load_ramp_time;
 
       static void
       declare_parameters(ParameterHandler &prm);
@@ -331,6 +594,11 @@ namespace Cook_Membrane
         prm.declare_entry("Time step size", "0.1",
                           Patterns::Double(),
                           "Time step size");
+
+        prm.declare_entry("Load ramp time", "0",
+                          Patterns::Double(0.0),
+                          "Time at which the full load is reached "
+                          "(0 for the end time)");
       }
       prm.leave_subsection();
     }
@@ -341,24 +609,28 @@ namespace Cook_Membrane
       {
         end_time = prm.get_double("End time");
         delta_t = prm.get_double("Time step size");
+        load_ramp_time = prm.get_double("Load ramp time");
       }
       prm.leave_subsection();
     }
 
-// @sect4{All parameters}
-
-// Finally we consolidate all of the above structures into a single container
-// that holds all of our run-time selections.
-    struct AllParameters :
-      public FESystem,
-      public Geometry,
-      public Materials,
-      public LinearSolver,
-      public NonlinearSolver,
-      public Time
+// @sect4{Continuation}
 
+// By default the load factor is a linear function of time. Alternatively the
+// load factor is treated as an additional unknown and the equilibrium path is
+// followed with an arc-length (Riks) method, which allows to pass limit
+// points. The arc length is adapted to the number of Newton iterations and
+// is initially chosen such that the first load increment equals
+// $\varDelta t / t_{\textrm{end}}$.
+    struct Continuation
     {
-      AllParameters(const std::string &input_file);
+      std::string  type_continuation;
+      double       load_scaling;
+      unsigned int desired_iterations;
+      double       min_arc_length_factor;
+      double       max_arc_length_factor;
+      unsigned int max_steps;
+      double       final_load_factor;
 
       static void
       declare_parameters(ParameterHandler &prm);
@@ -367,157 +639,909 @@ namespace Cook_Membrane
       parse_parameters(ParameterHandler &prm);
     };
 
-    AllParameters::AllParameters(const std::string &input_file)
+    void Continuation::declare_parameters(ParameterHandler &prm)
     {
-      ParameterHandler prm;
-      declare_parameters(prm);
-      prm.parse_input(input_file);
-      parse_parameters(prm);
-    }
+      prm.enter_subsection("Continuation");
+      {
+        prm.declare_entry("Continuation type", "Load",
+                          Patterns::Selection("Load|Arc-length"),
+                          "Load control or arc-length continuation");
 
-    void AllParameters::declare_parameters(ParameterHandler &prm)
-    {
-      FESystem::declare_parameters(prm);
-      Geometry::declare_parameters(prm);
-      Materials::declare_parameters(prm);
-      LinearSolver::declare_parameters(prm);
-      NonlinearSolver::declare_parameters(prm);
-      Time::declare_parameters(prm);
+        prm.declare_entry("Load scaling", "1.0",
+                          Patterns::Double(0.0),
+                          "Weight of the load factor in the arc-length constraint");
+
+        prm.declare_entry("Desired iterations", "5",
+                          Patterns::Integer(1),
+                          "Number of Newton iterations the arc length is adapted to");
+
+        prm.declare_entry("Minimum arc length factor", "1e-3",
+                          Patterns::Double(0.0),
+                          "Smallest arc length relative to the initial one");
+
+        prm.declare_entry("Maximum arc length factor", "4",
+                          Patterns::Double(0.0),
+                          "Largest arc length relative to the initial one");
+
+        prm.declare_entry("Maximum steps", "100",
+                          Patterns::Integer(1),
+                          "Maximum number of arc-length steps");
+
+        prm.declare_entry("Final load factor", "1",
+                          Patterns::Double(),
+                          "Load factor at which the arc-length continuation stops");
+      }
+      prm.leave_subsection();
     }
 
-    void AllParameters::parse_parameters(ParameterHandler &prm)
+    void Continuation::parse_parameters(ParameterHandler &prm)
     {
-      FESystem::parse_parameters(prm);
-      Geometry::parse_parameters(prm);
-      Materials::parse_parameters(prm);
-      LinearSolver::parse_parameters(prm);
-      NonlinearSolver::parse_parameters(prm);
-      Time::parse_parameters(prm);
+      prm.enter_subsection("Continuation");
+      {
+        type_continuation = prm.get("Continuation type");
+        load_scaling = prm.get_double("Load scaling");
+        desired_iterations = prm.get_integer("Desired iterations");
+        min_arc_length_factor = prm.get_double("Minimum arc length factor");
+        max_arc_length_factor = prm.get_double("Maximum arc length factor");
+        max_steps = prm.get_integer("Maximum steps");
+        final_load_factor = prm.get_double("Final load factor");
+      }
+      prm.leave_subsection();
     }
-  }
 
-// @sect3{Time class}
+// @sect4{Eigensolver}
 
-// A simple class to store time data. Its functioning is transparent so no
-// discussion is necessary. For simplicity we assume a constant time step
-// size.
-  class Time
-  {
-  public:
-    Time (const double time_end,
-          const double delta_t)
-      :
-      timestep(0),
-      time_current(0.0),
-      time_end(time_end),
-      delta_t(delta_t)
-    {}
+// At selected load steps the lowest eigenvalues of the tangent operator
+// (stability) or of the tangent operator with respect to the mass operator
+// (modal analysis) can be computed with a matrix-free block eigensolver.
+    struct Eigensolver
+    {
+      std::string               eigenvalue_problem;
+      unsigned int              n_eigenvalues;
+      std::vector<unsigned int> eigenvalue_steps;
+      double                    tol_eigen;
+      unsigned int              max_iterations_eigen;
+      double                    density;
 
-    virtual ~Time()
-    {}
+      static void
+      declare_parameters(ParameterHandler &prm);
 
-    double current() const
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    void Eigensolver::declare_parameters(ParameterHandler &prm)
     {
-      return time_current;
+      prm.enter_subsection("Eigensolver");
+      {
+        prm.declare_entry("Eigenvalue problem", "None",
+                          Patterns::Selection("None|Stability|Modal"),
+                          "Eigenvalues of the tangent (Stability) or of the "
+                          "tangent with respect to the mass operator (Modal)");
+
+        prm.declare_entry("Number of eigenvalues", "4",
+                          Patterns::Integer(1),
+                          "Number of lowest eigenvalues to compute");
+
+        prm.declare_entry("Load steps", "",
+                          Patterns::List(Patterns::Integer(0)),
+                          "Load steps after which the eigenvalues are computed");
+
+        prm.declare_entry("Tolerance", "1e-6",
+                          Patterns::Double(0.0),
+                          "Relative residual of the eigenpairs");
+
+        prm.declare_entry("Max iterations", "200",
+                          Patterns::Integer(1),
+                          "Maximum number of eigensolver iterations");
+
+        prm.declare_entry("Density", "1000",
+                          Patterns::Double(0.0),
+                          "Mass density in the reference configuration");
+      }
+      prm.leave_subsection();
     }
-    double end() const
+
+    void Eigensolver::parse_parameters(ParameterHandler &prm)
     {
-      return time_end;
+      prm.enter_subsection("Eigensolver");
+      {
+        eigenvalue_problem = prm.get("Eigenvalue problem");
+        n_eigenvalues = prm.get_integer("Number of eigenvalues");
+        const std::vector<int> steps =
+          Utilities::string_to_int(Utilities::split_string_list(prm.get("Load steps")));
+        eigenvalue_steps.assign(steps.begin(), steps.end());
+        tol_eigen = prm.get_double("Tolerance");
+        max_iterations_eigen = prm.get_integer("Max iterations");
+        density = prm.get_double("Density");
+      }
+      prm.leave_subsection();
     }
-    double get_delta_t() const
+
+// @sect4{Sensitivities}
+
+// After each converged load step the derivatives of the vertical tip
+// displacement with respect to the material parameters can be computed with
+// an adjoint solve.
+    struct Sensitivity
     {
-      return delta_t;
-    }
-    unsigned int get_timestep() const
+      bool adjoint_sensitivities;
+
+      static void
+      declare_parameters(ParameterHandler &prm);
+
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    void Sensitivity::declare_parameters(ParameterHandler &prm)
     {
-      return timestep;
+      prm.enter_subsection("Sensitivity");
+      {
+        prm.declare_entry("Adjoint sensitivities", "false",
+                          Patterns::Bool(),
+                          "Compute the derivatives of the tip displacement "
+                          "with respect to the shear modulus and Poisson's ratio");
+      }
+      prm.leave_subsection();
     }
-    void increment()
+
+    void Sensitivity::parse_parameters(ParameterHandler &prm)
     {
-      time_current += delta_t;
-      ++timestep;
+      prm.enter_subsection("Sensitivity");
+      {
+        adjoint_sensitivities = prm.get_bool("Adjoint sensitivities");
+      }
+      prm.leave_subsection();
     }
 
-  private:
-    unsigned int timestep;
-    double       time_current;
-    const double time_end;
-    const double delta_t;
-  };
+// @sect4{Contact}
 
-// @sect3{Compressible neo-Hookean material within a one-field formulation}
+// A boundary of the body can be pressed against a rigid obstacle, either a
+// plane or a cylinder with the axis along z. The contact is enforced with a
+// penalty.
+    struct Contact
+    {
+      std::string         obstacle;
+      unsigned int        contact_boundary_id;
+      std::vector<double> obstacle_point;
+      std::vector<double> obstacle_normal;
+      double              obstacle_radius;
+      double              contact_penalty;
 
-// @sect3{Quasi-static compressible finite-strain solid}
+      static void
+      declare_parameters(ParameterHandler &prm);
 
-// The Solid class is the central class in that it represents the problem at
-// hand. It follows the usual scheme in that all it really has is a
-// constructor, destructor and a <code>run()</code> function that dispatches
-// all the work to private functions of this class:
-  template <int dim,typename NumberType>
-  class Solid
-  {
-  public:
-    // matrix free polynomial degree
-    static constexpr int degree = 1;
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
 
-    // matrix free quadrature order
-    static constexpr int n_q_points_1d = 2;
+    void Contact::declare_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Contact");
+      {
+        prm.declare_entry("Obstacle", "None",
+                          Patterns::Selection("None|Plane|Cylinder"),
+                          "Rigid obstacle the contact boundary is pressed against");
 
-    Solid(const Parameters::AllParameters &parameters);
+        prm.declare_entry("Contact boundary id", "0",
+                          Patterns::Integer(0),
+                          "Boundary that may come into contact with the obstacle");
 
-    virtual
-    ~Solid();
+        prm.declare_entry("Obstacle point", "0.0, 0.065, 0.0",
+                          Patterns::List(Patterns::Double()),
+                          "A point on the plane or the center of the cylinder");
 
-    void
-    run();
+        prm.declare_entry("Obstacle normal", "0.0, -1.0, 0.0",
+                          Patterns::List(Patterns::Double()),
+                          "Normal of the plane pointing towards the body");
 
-  private:
+        prm.declare_entry("Obstacle radius", "0.01",
+                          Patterns::Double(0.0),
+                          "Radius of the cylinder");
 
-    // We start the collection of member functions with one that builds the
-    // grid:
-    void
-    make_grid();
+        prm.declare_entry("Penalty parameter", "1.0e10",
+                          Patterns::Double(0.0),
+                          "Penalty parameter of the contact constraint");
+      }
+      prm.leave_subsection();
+    }
 
-    // Set up the finite element system to be solved:
-    void
-    system_setup();
+    void Contact::parse_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Contact");
+      {
+        obstacle = prm.get("Obstacle");
+        contact_boundary_id = prm.get_integer("Contact boundary id");
+        obstacle_point = Utilities::string_to_double(
+          Utilities::split_string_list(prm.get("Obstacle point")));
+        obstacle_normal = Utilities::string_to_double(
+          Utilities::split_string_list(prm.get("Obstacle normal")));
+        obstacle_radius = prm.get_double("Obstacle radius");
+        contact_penalty = prm.get_double("Penalty parameter");
+      }
+      prm.leave_subsection();
+    }
 
-    // Set up matrix-free
-    void
-    setup_matrix_free(const int &it_nr);
+// @sect4{Thermal coupling}
 
-    // Function to assemble the system matrix and right hand side vecotr.
-    void
-    assemble_system();
+// Thermal expansion couples the deformation to a temperature field which is
+// governed by transient heat conduction. The temperature of the clamped
+// boundary is ramped up with the load, all other boundaries are insulated.
+// Both fields are solved for one after the other within a time step.
+    struct Thermal
+    {
+      bool         thermal_coupling;
+      double       thermal_expansion;
+      double       reference_temperature;
+      double       boundary_temperature;
+      double       heat_capacity;
+      double       thermal_conductivity;
+      unsigned int staggered_iterations;
 
-    // Apply Dirichlet boundary conditions on the displacement field
-    void
-    make_constraints(const int &it_nr);
+      static void
+      declare_parameters(ParameterHandler &prm);
 
-    // Solve for the displacement using a Newton-Raphson method. We break this
-    // function into the nonlinear loop and the function that solves the
-    // linearized Newton-Raphson step:
-    void
-    solve_nonlinear_timestep();
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
 
-    std::pair<unsigned int, double>
-    solve_linear_system(Vector<double> &newton_update);
+    void Thermal::declare_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Thermal");
+      {
+        prm.declare_entry("Thermal coupling", "false",
+                          Patterns::Bool(),
+                          "Solve for the temperature and include thermal expansion");
 
-    // Set total solution based on the current values of solution_n and solution_delta:
-    void set_total_solution();
+        prm.declare_entry("Thermal expansion coefficient", "1.0e-5",
+                          Patterns::Double(),
+                          "Linear thermal expansion coefficient");
 
-    void
-    output_results() const;
+        prm.declare_entry("Reference temperature", "293.0",
+                          Patterns::Double(0.0),
+                          "Initial temperature at which there is no thermal strain");
 
-    // Finally, some member variables that describe the current state: A
-    // collection of the parameters used to describe the problem setup...
-    const Parameters::AllParameters &parameters;
+        prm.declare_entry("Boundary temperature", "393.0",
+                          Patterns::Double(0.0),
+                          "Temperature of the clamped boundary at the full load");
 
-    // ...the volume of the reference and current configurations...
-    double                           vol_reference;
-    double                           vol_current;
+        prm.declare_entry("Heat capacity", "3.6e6",
+                          Patterns::Double(0.0),
+                          "Volumetric heat capacity");
 
-    // ...and description of the geometry on which the problem is solved:
+        prm.declare_entry("Thermal conductivity", "50.0",
+                          Patterns::Double(0.0),
+                          "Thermal conductivity in the current configuration");
+
+        prm.declare_entry("Staggered iterations", "1",
+                          Patterns::Integer(1),
+                          "Number of solves of the heat equation per time step, "
+                          "each followed by a mechanical solve except for the last one");
+      }
+      prm.leave_subsection();
+    }
+
+    void Thermal::parse_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Thermal");
+      {
+        thermal_coupling = prm.get_bool("Thermal coupling");
+        thermal_expansion = prm.get_double("Thermal expansion coefficient");
+        reference_temperature = prm.get_double("Reference temperature");
+        boundary_temperature = prm.get_double("Boundary temperature");
+        heat_capacity = prm.get_double("Heat capacity");
+        thermal_conductivity = prm.get_double("Thermal conductivity");
+        staggered_iterations = prm.get_integer("Staggered iterations");
+      }
+      prm.leave_subsection();
+    }
+
+// @sect4{Homogenization}
+
+// Instead of the Cook membrane, a periodic representative volume element
+// (RVE) on the unit cube can be subjected to a sequence of macroscopic
+// deformation gradients. Each state lists the $dim \times dim$ entries of
+// $\overline{\mathbf{F}}$ row by row, and the states are separated by
+// semicolons. For the fiber reinforced material the RVE is a cross-ply
+// laminate of two layers.
+    struct Homogenization
+    {
+      bool                             rve_homogenization;
+      unsigned int                     rve_refinements;
+      std::vector<std::vector<double>> macroscopic_deformations;
+
+      static void
+      declare_parameters(ParameterHandler &prm);
+
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    void Homogenization::declare_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Homogenization");
+      {
+        prm.declare_entry("RVE homogenization", "false",
+                          Patterns::Bool(),
+                          "Compute the homogenized response of a periodic RVE "
+                          "instead of the Cook membrane");
+
+        prm.declare_entry("RVE refinements", "4",
+                          Patterns::Integer(1),
+                          "Number of global refinements of the unit cube");
+
+        prm.declare_entry("Macroscopic deformation gradients",
+                          "1.05, 0.0, 0.0, 1.0; 1.1, 0.0, 0.0, 1.0; 1.1, 0.1, 0.0, 1.0",
+                          Patterns::Anything(),
+                          "Macroscopic deformation gradients row by row, "
+                          "separated by semicolons");
+      }
+      prm.leave_subsection();
+    }
+
+    void Homogenization::parse_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Homogenization");
+      {
+        rve_homogenization = prm.get_bool("RVE homogenization");
+        rve_refinements = prm.get_integer("RVE refinements");
+
+        macroscopic_deformations.clear();
+        for (const auto &state : Utilities::split_string_list(prm.get("Macroscopic deformation gradients"), ';'))
+          macroscopic_deformations.push_back(
+            Utilities::string_to_double(Utilities::split_string_list(state)));
+      }
+      prm.leave_subsection();
+    }
+
+// @sect4{Topology optimization}
+
+// The material of the Cook membrane can be distributed by a density based
+// topology optimization which minimizes the compliance for a given volume
+// fraction. The stiffness of each cell is interpolated from its density with
+// the SIMP law $s(\rho) = s_{\min} + (1 - s_{\min}) \rho^p$ and the design
+// is updated with the optimality criteria method.
+    struct TopologyOptimization
+    {
+      bool         topology_optimization;
+      double       volume_fraction;
+      double       penalization_exponent;
+      double       minimum_stiffness;
+      double       filter_radius;
+      unsigned int optimization_iterations;
+      double       move_limit;
+      double       design_tolerance;
+
+      static void
+      declare_parameters(ParameterHandler &prm);
+
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    void TopologyOptimization::declare_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Topology optimization");
+      {
+        prm.declare_entry("Topology optimization", "false",
+                          Patterns::Bool(),
+                          "Optimize the distribution of the material instead "
+                          "of a single analysis");
+
+        prm.declare_entry("Volume fraction", "0.5",
+                          Patterns::Double(0.0,1.0),
+                          "Fraction of the volume filled with material");
+
+        prm.declare_entry("Penalization exponent", "3.0",
+                          Patterns::Double(1.0),
+                          "Exponent of the SIMP interpolation of the stiffness");
+
+        prm.declare_entry("Minimum stiffness", "1.0e-3",
+                          Patterns::Double(0.0,1.0),
+                          "Relative stiffness of the void");
+
+        prm.declare_entry("Filter radius", "1.5",
+                          Patterns::Double(0.0),
+                          "Radius of the sensitivity filter in multiples "
+                          "of the element size along the beam");
+
+        prm.declare_entry("Optimization iterations", "30",
+                          Patterns::Integer(1),
+                          "Maximum number of design updates");
+
+        prm.declare_entry("Move limit", "0.2",
+                          Patterns::Double(0.0,1.0),
+                          "Maximum change of the density per design update");
+
+        prm.declare_entry("Design tolerance", "1.0e-2",
+                          Patterns::Double(0.0),
+                          "Maximum change of the density at convergence");
+      }
+      prm.leave_subsection();
+    }
+
+    void TopologyOptimization::parse_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Topology optimization");
+      {
+        topology_optimization = prm.get_bool("Topology optimization");
+        volume_fraction = prm.get_double("Volume fraction");
+        penalization_exponent = prm.get_double("Penalization exponent");
+        minimum_stiffness = prm.get_double("Minimum stiffness");
+        filter_radius = prm.get_double("Filter radius");
+        optimization_iterations = prm.get_integer("Optimization iterations");
+        move_limit = prm.get_double("Move limit");
+        design_tolerance = prm.get_double("Design tolerance");
+      }
+      prm.leave_subsection();
+    }
+
+// @sect4{Uncertainty quantification}
+
+// The response of the Cook membrane to spatially varying material parameters
+// can be estimated by Monte-Carlo sampling. The shear modulus is a lognormal
+// and the Poisson's ratio a normal random field with the given mean values
+// and coefficients of variation, both constant on each cell and correlated
+// over the correlation length.
+    struct UncertaintyQuantification
+    {
+      unsigned int monte_carlo_samples;
+      double       shear_modulus_variation;
+      double       poissons_ratio_variation;
+      double       correlation_length;
+      unsigned int random_seed;
+      unsigned int sampling_threads;
+
+      static void
+      declare_parameters(ParameterHandler &prm);
+
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    void UncertaintyQuantification::declare_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Uncertainty quantification");
+      {
+        prm.declare_entry("Monte-Carlo samples", "0",
+                          Patterns::Integer(0),
+                          "Number of samples of the random material fields, "
+                          "none for a deterministic analysis");
+
+        prm.declare_entry("Shear modulus variation", "0.1",
+                          Patterns::Double(0.0),
+                          "Coefficient of variation of the shear modulus");
+
+        prm.declare_entry("Poisson's ratio variation", "0.05",
+                          Patterns::Double(0.0),
+                          "Coefficient of variation of the Poisson's ratio");
+
+        prm.declare_entry("Correlation length", "8.0",
+                          Patterns::Double(0.0),
+                          "Correlation length of the random fields in the "
+                          "unscaled coordinates of the beam");
+
+        prm.declare_entry("Random seed", "1",
+                          Patterns::Integer(0),
+                          "Seed of the random number generator");
+
+        prm.declare_entry("Sampling threads", "0",
+                          Patterns::Integer(0),
+                          "Number of samples solved concurrently, "
+                          "0 for the number of available threads");
+      }
+      prm.leave_subsection();
+    }
+
+    void UncertaintyQuantification::parse_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Uncertainty quantification");
+      {
+        monte_carlo_samples = prm.get_integer("Monte-Carlo samples");
+        shear_modulus_variation = prm.get_double("Shear modulus variation");
+        poissons_ratio_variation = prm.get_double("Poisson's ratio variation");
+        correlation_length = prm.get_double("Correlation length");
+        random_seed = prm.get_integer("Random seed");
+        sampling_threads = prm.get_integer("Sampling threads");
+      }
+      prm.leave_subsection();
+    }
+
+// @sect4{Phase-field fracture}
+
+// Cracks are described by a phase-field damage variable which degrades the
+// tensile energy of the neo-Hookean material. The damage follows from the
+// largest tensile energy so far and the fracture toughness, regularized over
+// the length scale, which is given for the unscaled geometry. The damage and
+// the displacement are solved for one after the other within a load step.
+    struct PhaseField
+    {
+      bool         phase_field_fracture;
+      double       fracture_toughness;
+      double       phase_field_length_scale;
+      double       residual_stiffness;
+      unsigned int phase_field_staggered_iterations;
+
+      static void
+      declare_parameters(ParameterHandler &prm);
+
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    void PhaseField::declare_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Phase field");
+      {
+        prm.declare_entry("Phase-field fracture", "false",
+                          Patterns::Bool(),
+                          "Solve for a damage field which degrades the tensile energy");
+
+        prm.declare_entry("Fracture toughness", "1.0",
+                          Patterns::Double(0.0),
+                          "Critical energy release rate G_c");
+
+        prm.declare_entry("Length scale", "1.0",
+                          Patterns::Double(0.0),
+                          "Regularization length of the crack");
+
+        prm.declare_entry("Residual stiffness", "1.0e-6",
+                          Patterns::Double(0.0,1.0),
+                          "Relative stiffness of the fully damaged material");
+
+        prm.declare_entry("Staggered iterations", "1",
+                          Patterns::Integer(1),
+                          "Number of solves of the damage problem per load step, "
+                          "each followed by a mechanical solve except for the last one");
+      }
+      prm.leave_subsection();
+    }
+
+    void PhaseField::parse_parameters(ParameterHandler &prm)
+    {
+      prm.enter_subsection("Phase field");
+      {
+        phase_field_fracture = prm.get_bool("Phase-field fracture");
+        fracture_toughness = prm.get_double("Fracture toughness");
+        phase_field_length_scale = prm.get_double("Length scale");
+        residual_stiffness = prm.get_double("Residual stiffness");
+        phase_field_staggered_iterations = prm.get_integer("Staggered iterations");
+      }
+      prm.leave_subsection();
+    }
+
+// @sect4{All parameters}
+
+// Finally we consolidate all of the above structures into a single container
+// that holds all of our run-time selections.
+    struct AllParameters :
+      public FESystem,
+      public Geometry,
+      public Materials,
+      public LinearSolver,
+      public NonlinearSolver,
+      public NonlinearMultigrid,
+      public Time,
+      public Continuation,
+      public Eigensolver,
+      public Sensitivity,
+      public Contact,
+      public Thermal,
+      public Homogenization,
+      public TopologyOptimization,
+      public UncertaintyQuantification,
+      public PhaseField
+
+    {
+      AllParameters(const std::string &input_file);
+
+      static void
+      declare_parameters(ParameterHandler &prm);
+
+      void
+      parse_parameters(ParameterHandler &prm);
+    };
+
+    AllParameters::AllParameters(const std::string &input_file)
+    {
+      ParameterHandler prm;
+      declare_parameters(prm);
+      prm.parse_input(input_file);
+      parse_parameters(prm);
+    }
+
+    void AllParameters::declare_parameters(ParameterHandler &prm)
+    {
+      FESystem::declare_parameters(prm);
+      Geometry::declare_parameters(prm);
+      Materials::declare_parameters(prm);
+      LinearSolver::declare_parameters(prm);
+      NonlinearSolver::declare_parameters(prm);
+      NonlinearMultigrid::declare_parameters(prm);
+      Time::declare_parameters(prm);
+      Continuation::declare_parameters(prm);
+      Eigensolver::declare_parameters(prm);
+      Sensitivity::declare_parameters(prm);
+      Contact::declare_parameters(prm);
+      Thermal::declare_parameters(prm);
+      Homogenization::declare_parameters(prm);
+      TopologyOptimization::declare_parameters(prm);
+      UncertaintyQuantification::declare_parameters(prm);
+      PhaseField::declare_parameters(prm);
+    }
+
+    void AllParameters::parse_parameters(ParameterHandler &prm)
+    {
+      FESystem::parse_parameters(prm);
+      Geometry::parse_parameters(prm);
+      Materials::parse_parameters(prm);
+      LinearSolver::parse_parameters(prm);
+      NonlinearSolver::parse_parameters(prm);
+      NonlinearMultigrid::parse_parameters(prm);
+      Time::parse_parameters(prm);
+      Continuation::parse_parameters(prm);
+      Eigensolver::parse_parameters(prm);
+      Sensitivity::parse_parameters(prm);
+      Contact::parse_parameters(prm);
+      Thermal::parse_parameters(prm);
+      Homogenization::parse_parameters(prm);
+      TopologyOptimization::parse_parameters(prm);
+      UncertaintyQuantification::parse_parameters(prm);
+      PhaseField::parse_parameters(prm);
+    }
+  }
+
+// @sect3{Time class}
+
+// A simple class to store time data. Its functioning is transparent so no
+// discussion is necessary. For simplicity we assume a constant time step
+// size. The load factor grows linearly until the load ramp time and stays
+// at one afterwards.
+  class Time
+  {
+  public:
+    Time (const double time_end,
+          const double delta_t,
+          const double load_ramp_time = 0.0)
+      :
+      timestep(0),
+      time_current(0.0),
+      time_end(time_end),
+      delta_t(delta_t),
+      load_ramp_time(load_ramp_time > 0.0 ? load_ramp_time : time_end)
+    {}
+
+    virtual ~Time()
+    {}
+
+    double current() const
+    {
+      return time_current;
+    }
+    double end() const
+    {
+      return time_end;
+    }
+    double get_delta_t() const
+    {
+      return delta_t;
+    }
+    unsigned int get_timestep() const
+    {
+      return timestep;
+    }
+    double load_factor() const
+    {
+      return std::min(time_current / load_ramp_time, 1.0);
+    }
+    void increment()
+    {
+      time_current += delta_t;
+      ++timestep;
+    }
+
+  private:
+    unsigned int timestep;
+    double       time_current;
+    const double time_end;
+    const double delta_t;
+    const double load_ramp_time;
+  };
+
+// @sect3{Compressible neo-Hookean material within a one-field formulation}
+
+// @sect3{Quasi-static compressible finite-strain solid}
+
+// The Solid class is the central class in that it represents the problem at
+// hand. It follows the usual scheme in that all it really has is a
+// constructor, destructor and a <code>run()</code> function that dispatches
+// all the work to private functions of this class:
+  template <int dim,typename NumberType>
+  class Solid
+  {
+  public:
+    // matrix free polynomial degree
+    static constexpr int degree = 1;
+
+    // matrix free quadrature order
+    static constexpr int n_q_points_1d = 2;
+
+    Solid(const Parameters::AllParameters &parameters);
+
+    virtual
+    ~Solid();
+
+    void
+    run();
+
+    // The results of the last converged step, by which the tests compare
+    // the solvers and formulations with each other:
+    double
+    get_vertical_tip_displacement() const;
+
+    double
+    get_load_factor() const;
+
+    // The work $\lambda \mathbf{f}_{\textrm{ext}}^T \mathbf{u}$ of the
+    // external load, which the topology optimization minimizes:
+    double
+    get_compliance() const;
+
+    // The derivatives of the vertical tip displacement with respect to
+    // $\mu$ and $\nu$ of the last adjoint solve:
+    std::pair<double,double>
+    get_parameter_sensitivities() const;
+
+  private:
+
+    // We start the collection of member functions with one that builds the
+    // grid:
+    void
+    make_grid();
+
+    // Set up the finite element system to be solved:
+    void
+    system_setup();
+
+    // Set up matrix-free
+    void
+    setup_matrix_free(const int &it_nr);
+
+    // Function to assemble the system matrix and right hand side vecotr.
+    void
+    assemble_system();
+
+    // The assembly itself, which does not print the status, so that it can
+    // also serve as the reference of the matrix-free residual in debug mode:
+    void
+    assemble_system_matrix_based();
+
+    // For the matrix-free solver, only the right hand side vector is needed,
+    // which is evaluated in the same sweep over the cells as the diagonal of
+    // the tangent and the global quantities:
+    void
+    assemble_residual_matrix_free();
+
+    void
+    assemble_external_force();
+
+    // Apply Dirichlet boundary conditions on the displacement field
+    void
+    make_constraints(const int &it_nr);
+
+    // Solve for the displacement using a Newton-Raphson method. We break this
+    // function into the nonlinear loop and the function that solves the
+    // linearized Newton-Raphson step:
+    void
+    solve_nonlinear_timestep();
+
+    // Alternatively, the load factor is an additional unknown which is
+    // controlled by an arc-length constraint. The step returns whether the
+    // Newton scheme converged, so that the driver can reduce the arc length
+    // and repeat the step:
+    void
+    run_arc_length();
+
+    bool
+    solve_nonlinear_timestep_arc_length(double &arc_length,
+                                        unsigned int &n_iterations);
+
+    std::pair<unsigned int, double>
+    solve_linear_system(const Vector<double> &rhs,
+                        Vector<double> &newton_update);
+
+    // Set total solution based on the current values of solution_n and solution_delta:
+    void set_total_solution();
+
+    void
+    output_results() const;
+
+    // Postprocessing of a converged load step which requires the
+    // linearization around the converged solution:
+    void
+    postprocess_converged_step();
+
+    // Accept the history variables of the converged step. The internal
+    // variables of the viscoelastic material are advanced to the end of the
+    // time step here:
+    void
+    commit_history();
+
+    void
+    update_internal_variables();
+
+    // Referential direction of fiber family @p family on @p cell:
+    Tensor<1,dim>
+    get_fiber_direction(const typename DoFHandler<dim>::cell_iterator &cell,
+                        const unsigned int                             family) const;
+
+    // Compute the lowest eigenvalues of the tangent operator linearized
+    // around the converged solution and write them together with the modes:
+    void
+    compute_eigenvalues();
+
+    // Compute the sensitivities of the vertical tip displacement with
+    // respect to the material parameters with one adjoint solve:
+    void
+    compute_adjoint_sensitivities();
+
+    // Minimize the compliance of the membrane with a density based topology
+    // optimization. Every design needs the equilibrium state, which is
+    // computed starting from the displacement of the previous design:
+    void
+    run_topology_optimization();
+
+    // The compliance of the current design, whose derivatives with respect
+    // to the cell densities are stored in cell_sensitivity_density:
+    double
+    compute_compliance_sensitivities();
+
+    // Find the neighbours of each cell and their weights for the
+    // sensitivity filter:
+    void
+    setup_density_filter();
+
+    // Update the densities with the optimality criteria method and return
+    // the maximum change:
+    double
+    update_density();
+
+    // Pass the stiffness interpolated from the densities to the operator:
+    void
+    update_material_scaling();
+
+    // Solve the heat equation of the current time step on the body deformed
+    // by the current displacement:
+    void
+    solve_heat_equation();
+
+    // Solve the damage problem for the crack driving force of the current
+    // displacement:
+    void
+    solve_phase_field();
+
+    // Replace the change of a field from @p previous to @p current in a
+    // staggered iteration by the accelerated one:
+    void
+    accelerate_staggered_update(const Vector<double> &previous,
+                                Vector<double>       &current);
+
+    // Finally, some member variables that describe the current state: A
+    // collection of the parameters used to describe the problem setup...
+    const Parameters::AllParameters &parameters;
+
+    // ...the volume of the reference and current configurations, the strain
+    // energy and the reaction force on the clamped boundary...
+    double                           vol_reference;
+    double                           vol_current;
+    double                           strain_energy;
+    Tensor<1,dim>                    reaction_force;
+
+    // ...the load factor that scales the applied traction...
+    double                           load_factor;
+
+    // ...and description of the geometry on which the problem is solved:
     Triangulation<dim>               triangulation;
 
     // Also, keep track of the current time and the time spent evaluating
@@ -538,6 +1562,62 @@ namespace Cook_Membrane
     std::shared_ptr<Material_Compressible_Neo_Hook_One_Field<dim,NumberType>> material;
     std::shared_ptr<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>> material_vec;
 
+    // the elastoplastic material, if selected, together with its history
+    // variables at the quadrature points
+    std::shared_ptr<Material_J2_Plasticity<dim,NumberType>> plastic_material;
+    std::shared_ptr<Material_J2_Plasticity<dim,VectorizedArray<NumberType>>> plastic_material_vec;
+    std::shared_ptr<MaterialHistory<dim,double>> material_history;
+
+    // the internal variables of the viscoelastic material, if selected,
+    // which are stored in the material history as well
+    std::shared_ptr<Viscoelastic_Prony_Series<dim,VectorizedArray<NumberType>>> viscous_material_vec;
+
+    // the fiber families of the anisotropic material, if selected, which are
+    // added to the neo-Hookean ground matrix, and their directions per cell
+    std::shared_ptr<Material_HGO_Fibers<dim,NumberType>> fiber_material;
+    std::shared_ptr<Material_HGO_Fibers<dim,VectorizedArray<NumberType>>> fiber_material_vec;
+    std::shared_ptr<FiberDirections<dim,double>> fiber_directions;
+
+    // the rigid obstacle, if any, and the penalty contact of the boundary
+    // with it, which is evaluated matrix-free on the boundary faces
+    std::shared_ptr<RigidObstacle<dim,NumberType>> obstacle;
+    std::shared_ptr<RigidObstacle<dim,VectorizedArray<NumberType>>> obstacle_vec;
+    std::shared_ptr<PenaltyContact<dim,degree,n_q_points_1d,double>> contact;
+
+    // the temperature field of the thermal coupling, if selected, with the
+    // same interpolation on the same mesh as the displacement. It is the
+    // second field of the matrix-free data.
+    const FE_Q<dim>                  fe_temperature;
+    DoFHandler<dim>                  dof_handler_temperature;
+    ConstraintMatrix                 constraints_temperature;
+    Vector<double>                   temperature;
+    Vector<double>                   temperature_n;
+    std::shared_ptr<Thermal_Expansion<dim,NumberType>> thermal_expansion;
+    std::shared_ptr<Thermal_Expansion<dim,VectorizedArray<NumberType>>> thermal_expansion_vec;
+
+    static const unsigned int        temperature_dof_index = 1;
+
+    // the damage field of the phase-field fracture, if selected, with the
+    // same interpolation on the same mesh as the displacement, and the crack
+    // driving force at the quadrature points. Like the temperature, the
+    // damage is the second field of the matrix-free data. The damage of the
+    // last load step bounds the accelerated staggered updates from below.
+    const FE_Q<dim>                  fe_damage;
+    DoFHandler<dim>                  dof_handler_damage;
+    ConstraintMatrix                 constraints_damage;
+    Vector<double>                   damage;
+    Vector<double>                   damage_n;
+    std::shared_ptr<Phase_Field_Degradation<dim,NumberType>> degradation;
+    std::shared_ptr<Phase_Field_Degradation<dim,VectorizedArray<NumberType>>> degradation_vec;
+    std::shared_ptr<MaterialHistory<dim,double>> crack_driving_force;
+
+    static const unsigned int        damage_dof_index = 1;
+
+    // The instantaneous isochoric stiffness of the viscoelastic material
+    // within a time step relative to the equilibrium one:
+    static double
+    get_isochoric_scaling(const Parameters::AllParameters &parameters);
+
     static const unsigned int        n_components = dim;
     static const unsigned int        first_u_component = 0;
 
@@ -562,6 +1642,46 @@ namespace Cook_Membrane
     SparseMatrix<double>             tangent_matrix;
     Vector<double>                   system_rhs;
 
+    // The coloring of the sparsity pattern for the multithreaded SSOR
+    // preconditioner, computed along with the pattern:
+    MulticolorSSOR<double>           mc_ssor;
+
+    // The tangent in the block CSR format, which replaces tangent_matrix
+    // and the scalar sparsity pattern if selected:
+    BSRMatrix<dim,double>            tangent_matrix_bsr;
+
+    // The upper triangle of the tangent, which replaces tangent_matrix
+    // and the scalar sparsity pattern if selected:
+    SymmetricSparseMatrix<double>    tangent_matrix_symmetric;
+
+    // The copy of tangent_matrix for the product in CG if the SELL-C-sigma
+    // format is selected:
+    SellCSigmaMatrix<double>         tangent_matrix_sell;
+
+#ifdef DEAL_II_WITH_TRILINOS
+    // The AMG preconditioner of tangent_matrix and the CG iterations right
+    // after its setup and in the last solve, which decide on its reuse:
+    AMGPreconditioner                amg_preconditioner;
+    unsigned int                     amg_setup_lin_it;
+    unsigned int                     amg_last_lin_it;
+#endif
+
+    // The external force for a unit load factor. Together with the load
+    // factor it makes up the external part of the right hand side vector:
+    Vector<double>                   external_force;
+
+    // The factorization of the tangent matrix for the direct solver. It is
+    // reused as long as the tangent matrix does not change, for example when
+    // the arc-length method needs to solve for two right hand sides.
+    SparseDirectUMFPACK              tangent_matrix_direct;
+    bool                             tangent_matrix_factorized;
+
+    // Whether the residual is evaluated by assemble_residual_matrix_free()
+    // instead of assemble_system(), and the indicator of the DoFs on the
+    // clamped boundary for the reaction force:
+    const bool                       matrix_free_residual;
+    Vector<double>                   reaction_dofs;
+
     // solution at the previous time-step
     Vector<double>                   solution_n;
 
@@ -571,6 +1691,31 @@ namespace Cook_Membrane
     // current total solution:  solution_tota = solution_n + solution_delta
     Vector<double>                   solution_total;
 
+    // the converged increments of the previous arc-length step, which
+    // determine the direction of the predictor, and the displacement norm
+    // that scales the load factor in the arc-length constraint
+    Vector<double>                   solution_delta_previous;
+    double                           load_factor_delta_previous;
+    double                           arc_length_displacement_scale;
+
+    // the Anderson acceleration of the Newton updates within a load step and
+    // of the temperature or damage updates of the staggered scheme
+    AndersonAcceleration<Vector<double>> anderson_newton;
+    AndersonAcceleration<Vector<double>> anderson_staggered;
+
+    // per cell contributions to the derivatives of the tip displacement
+    // with respect to the shear modulus and Poisson's ratio
+    Vector<double>                   cell_sensitivity_mu;
+    Vector<double>                   cell_sensitivity_nu;
+
+    // the cell densities of the topology optimization together with the
+    // derivatives of the compliance, the interpolated stiffness per cell
+    // batch and the neighbours with their weights for the filter
+    Vector<double>                   density;
+    Vector<double>                   cell_sensitivity_density;
+    std::shared_ptr<CellCoefficients<dim,double>> material_scaling;
+    std::vector<std::vector<std::pair<unsigned int,double>>> density_filter;
+
     // Then define a number of variables to store norms and update norms and
     // normalisation factors.
     struct Errors
@@ -618,11 +1763,22 @@ namespace Cook_Membrane
     void
     print_vertical_tip_displacement();
 
+    types::global_dof_index
+    get_vertical_tip_dof() const;
+
     std::shared_ptr<MappingQEulerian<dim,Vector<double>>> eulerian_mapping;
     std::shared_ptr<MatrixFree<dim,double>> mf_data_current;
     std::shared_ptr<MatrixFree<dim,double>> mf_data_reference;
 
     NeoHookOperator<dim,degree,n_q_points_1d,double> mf_nh_operator;
+    MassOperator<dim,degree,n_q_points_1d,double>    mf_mass_operator;
+    HeatOperator<dim,degree,n_q_points_1d,double>    mf_heat_operator;
+    DamageOperator<dim,degree,n_q_points_1d,double>  mf_damage_operator;
+
+    // The linear elastic preconditioner and its Chebyshev iteration are set
+    // up along with the MatrixFree data of the reference configuration:
+    LinearElasticOperator<dim,degree,n_q_points_1d,double> mf_le_operator;
+    PreconditionChebyshev<LinearElasticOperator<dim,degree,n_q_points_1d,double>,Vector<double>> le_preconditioner;
   };
 
 // @sect3{Implementation of the <code>Solid</code> class}
@@ -636,8 +1792,10 @@ namespace Cook_Membrane
     parameters(parameters),
     vol_reference (0.0),
     vol_current (0.0),
+    strain_energy (0.0),
+    load_factor (0.0),
     triangulation(Triangulation<dim>::maximum_smoothing),
-    time(parameters.end_time, parameters.delta_t),
+    time(parameters.end_time, parameters.delta_t, parameters.load_ramp_time),
     timer(std::cout,
           TimerOutput::never/*TimerOutput::summary*/,
           TimerOutput::wall_times),
@@ -648,15 +1806,145 @@ namespace Cook_Membrane
     dofs_per_cell (fe.dofs_per_cell),
     u_fe(first_u_component),
     material(std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,NumberType>>(
-      parameters.mu,parameters.nu)),
+      parameters.mu,parameters.nu,get_isochoric_scaling(parameters))),
     material_vec(std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>>(
-      parameters.mu,parameters.nu)),
+      parameters.mu,parameters.nu,get_isochoric_scaling(parameters))),
+    fe_temperature(degree),
+    dof_handler_temperature(triangulation),
+    fe_damage(degree),
+    dof_handler_damage(triangulation),
     qf_cell(n_q_points_1d),
     qf_face(n_q_points_1d),
     n_q_points (qf_cell.size()),
-    n_q_points_f (qf_face.size())
+    n_q_points_f (qf_face.size()),
+    tangent_matrix_factorized(false),
+    matrix_free_residual(parameters.type_lin == "MF_CG" &&
+                         parameters.material_model != "J2 plasticity" &&
+                         parameters.volumetric_formulation == "Standard" &&
+                         parameters.obstacle == "None"),
+    load_factor_delta_previous(0.0),
+    arc_length_displacement_scale(0.0),
+    anderson_newton(parameters.anderson_depth),
+    anderson_staggered(parameters.anderson_depth)
   {
     mf_nh_operator.set_material(material_vec);
+
+    if (parameters.volumetric_formulation == "F-bar")
+      {
+        AssertThrow(parameters.material_model != "J2 plasticity" &&
+                    parameters.adjoint_sensitivities == false,
+                    ExcNotImplemented());
+        mf_nh_operator.set_mean_dilatation(true);
+      }
+
+    if (parameters.material_model == "J2 plasticity")
+      {
+        AssertThrow(parameters.adjoint_sensitivities == false,
+                    ExcNotImplemented());
+
+        plastic_material = std::make_shared<Material_J2_Plasticity<dim,NumberType>>(
+          parameters.mu,parameters.nu,parameters.yield_stress,
+          parameters.isotropic_hardening,parameters.kinematic_hardening);
+        plastic_material_vec = std::make_shared<Material_J2_Plasticity<dim,VectorizedArray<NumberType>>>(
+          parameters.mu,parameters.nu,parameters.yield_stress,
+          parameters.isotropic_hardening,parameters.kinematic_hardening);
+        material_history = std::make_shared<MaterialHistory<dim,double>>();
+      }
+    else if (parameters.material_model == "Viscoelastic")
+      {
+        AssertThrow(parameters.adjoint_sensitivities == false,
+                    ExcNotImplemented());
+
+        viscous_material_vec = std::make_shared<Viscoelastic_Prony_Series<dim,VectorizedArray<NumberType>>>(
+          parameters.mu,parameters.prony_stiffnesses,parameters.prony_relaxation_times,
+          parameters.delta_t);
+        material_history = std::make_shared<MaterialHistory<dim,double>>();
+      }
+    else if (parameters.material_model == "HGO")
+      {
+        AssertThrow(parameters.adjoint_sensitivities == false,
+                    ExcNotImplemented());
+
+        fiber_material = std::make_shared<Material_HGO_Fibers<dim,NumberType>>(
+          parameters.fiber_stiffness,parameters.fiber_exponent);
+        fiber_material_vec = std::make_shared<Material_HGO_Fibers<dim,VectorizedArray<NumberType>>>(
+          parameters.fiber_stiffness,parameters.fiber_exponent);
+        fiber_directions = std::make_shared<FiberDirections<dim,double>>();
+      }
+
+    if (parameters.obstacle != "None")
+      {
+        AssertThrow(parameters.obstacle_point.size() >= dim,
+                    ExcMessage("The obstacle point needs dim coordinates"));
+        Point<dim> point;
+        for (unsigned int d = 0; d < dim; ++d)
+          point[d] = parameters.obstacle_point[d];
+
+        if (parameters.obstacle == "Plane")
+          {
+            AssertThrow(parameters.obstacle_normal.size() >= dim,
+                        ExcMessage("The obstacle normal needs dim coordinates"));
+            Tensor<1,dim> normal;
+            for (unsigned int d = 0; d < dim; ++d)
+              normal[d] = parameters.obstacle_normal[d];
+            AssertThrow(normal.norm() > 0, ExcMessage("The obstacle normal must not vanish"));
+
+            obstacle = std::make_shared<RigidPlane<dim,NumberType>>(point,normal);
+            obstacle_vec = std::make_shared<RigidPlane<dim,VectorizedArray<NumberType>>>(point,normal);
+          }
+        else
+          {
+            obstacle = std::make_shared<RigidCylinder<dim,NumberType>>(point,parameters.obstacle_radius);
+            obstacle_vec = std::make_shared<RigidCylinder<dim,VectorizedArray<NumberType>>>(point,parameters.obstacle_radius);
+          }
+
+        contact = std::make_shared<PenaltyContact<dim,degree,n_q_points_1d,double>>();
+      }
+
+    if (parameters.thermal_coupling)
+      {
+        AssertThrow(parameters.material_model != "J2 plasticity" &&
+                    parameters.volumetric_formulation == "Standard" &&
+                    parameters.type_continuation != "Arc-length" &&
+                    parameters.adjoint_sensitivities == false,
+                    ExcNotImplemented());
+
+        thermal_expansion = std::make_shared<Thermal_Expansion<dim,NumberType>>(
+          parameters.thermal_expansion,parameters.reference_temperature);
+        thermal_expansion_vec = std::make_shared<Thermal_Expansion<dim,VectorizedArray<NumberType>>>(
+          parameters.thermal_expansion,parameters.reference_temperature);
+      }
+
+    if (parameters.topology_optimization)
+      {
+        AssertThrow((parameters.material_model == "Neo-Hooke" ||
+                     parameters.material_model == "HGO") &&
+                    parameters.volumetric_formulation == "Standard" &&
+                    parameters.type_continuation != "Arc-length" &&
+                    parameters.obstacle == "None" &&
+                    parameters.thermal_coupling == false &&
+                    parameters.adjoint_sensitivities == false,
+                    ExcNotImplemented());
+
+        material_scaling = std::make_shared<CellCoefficients<dim,double>>();
+      }
+
+    if (parameters.phase_field_fracture)
+      {
+        AssertThrow(parameters.material_model == "Neo-Hooke" &&
+                    parameters.volumetric_formulation == "Standard" &&
+                    parameters.type_continuation != "Arc-length" &&
+                    parameters.thermal_coupling == false &&
+                    parameters.topology_optimization == false &&
+                    parameters.adjoint_sensitivities == false,
+                    ExcNotImplemented());
+
+        degradation = std::make_shared<Phase_Field_Degradation<dim,NumberType>>(
+          parameters.residual_stiffness);
+        degradation_vec = std::make_shared<Phase_Field_Degradation<dim,VectorizedArray<NumberType>>>(
+          parameters.residual_stiffness);
+        crack_driving_force = std::make_shared<MaterialHistory<dim,double>>();
+      }
   }
 
 // The class destructor simply clears the data held by the DOFHandler
@@ -664,56 +1952,251 @@ namespace Cook_Membrane
   Solid<dim,NumberType>::~Solid()
   {
     mf_nh_operator.clear();
+    mf_mass_operator.clear();
+    mf_heat_operator.clear();
+    mf_damage_operator.clear();
+    mf_le_operator.clear();
+    mc_ssor.clear();
+    tangent_matrix_bsr.clear();
+    tangent_matrix_symmetric.clear();
+    tangent_matrix_sell.clear();
+#ifdef DEAL_II_WITH_TRILINOS
+    amg_preconditioner.clear();
+#endif
+    if (contact)
+      contact->clear();
 
     mf_data_current.reset();
     mf_data_reference.reset();
     eulerian_mapping.reset();
 
-    dof_handler_ref.clear();
+    dof_handler_ref.clear();
+    dof_handler_temperature.clear();
+    dof_handler_damage.clear();
+  }
+
+
+// In solving the quasi-static problem, the time becomes a loading parameter,
+// i.e. we increasing the loading linearly with time, making the two concepts
+// interchangeable. We choose to increment time linearly using a constant time
+// step size.
+//
+// We start the function with preprocessing, and then output the initial grid
+// before starting the simulation proper with the first time (and loading)
+// increment.
+//
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::run()
+  {
+    make_grid();
+    system_setup();
+    output_results();
+    time.increment();
+
+    // With arc-length continuation the load factor is no longer prescribed
+    // by the time, so a different driver is used:
+    if (parameters.type_continuation == "Arc-length")
+      {
+        run_arc_length();
+        print_vertical_tip_displacement();
+        return;
+      }
+
+    // Likewise, the topology optimization solves for the equilibrium of
+    // each design:
+    if (material_scaling)
+      {
+        run_topology_optimization();
+        print_vertical_tip_displacement();
+        return;
+      }
+
+    // We then declare the incremental solution update $\varDelta
+    // \mathbf{\Xi}:= \{\varDelta \mathbf{u}\}$ and start the loop over the
+    // time domain.
+    //
+    // At the beginning, we reset the solution update for this time step...
+    while (time.current() <= time.end())
+      {
+        solution_delta = 0.0;
+        load_factor = time.load_factor();
+
+        // ...solve the current time step and update total solution vector
+        // $\mathbf{\Xi}_{\textrm{n}} = \mathbf{\Xi}_{\textrm{n-1}} +
+        // \varDelta \mathbf{\Xi}$...
+        solve_nonlinear_timestep();
+
+        // With the thermal coupling, the heat equation is then solved on the
+        // deformed body and, for more than one staggered iteration, the
+        // mechanical problem again with the new temperature...
+        anderson_staggered.reset();
+        if (thermal_expansion)
+          for (unsigned int k = 0; k < parameters.staggered_iterations; ++k)
+            {
+              if (k > 0)
+                solve_nonlinear_timestep();
+              set_total_solution();
+              const Vector<double> temperature_previous(temperature);
+              solve_heat_equation();
+              accelerate_staggered_update(temperature_previous, temperature);
+            }
+
+        // Likewise, the damage follows from the deformed body...
+        if (degradation)
+          for (unsigned int k = 0; k < parameters.phase_field_staggered_iterations; ++k)
+            {
+              if (k > 0)
+                solve_nonlinear_timestep();
+              set_total_solution();
+              const Vector<double> damage_previous(damage);
+              solve_phase_field();
+              accelerate_staggered_update(damage_previous, damage);
+
+              // The accelerated damage is a combination of the past iterates,
+              // which may heal the crack or exceed the fully broken state.
+              // It is projected back onto $d_n \leq d \leq 1$, which the
+              // history field guarantees for the plain staggered update:
+              for (types::global_dof_index i = 0; i < damage.size(); ++i)
+                damage(i) = std::min(1.0, std::max(damage_n(i), damage(i)));
+            }
+
+        solution_n += solution_delta;
+        if (thermal_expansion)
+          temperature_n = temperature;
+        if (degradation)
+          damage_n = damage;
+
+        // ...evaluate stability and sensitivities of the converged state,
+        // which are linearized around the history of the last step, before
+        // the history is advanced...
+        postprocess_converged_step();
+        commit_history();
+
+        // ...and plot the results before moving on happily to the next time
+        // step:
+        output_results();
+        time.increment();
+      }
+
+    // Lastly, we print the vertical tip displacement of the Cook cantilever
+    // after the full load is applied
+    print_vertical_tip_displacement();
+  }
+
+
+  template <int dim,typename NumberType>
+  double Solid<dim,NumberType>::get_vertical_tip_displacement() const
+  {
+    return solution_n(get_vertical_tip_dof());
+  }
+
+
+  template <int dim,typename NumberType>
+  double Solid<dim,NumberType>::get_load_factor() const
+  {
+    return load_factor;
+  }
+
+
+  template <int dim,typename NumberType>
+  double Solid<dim,NumberType>::get_compliance() const
+  {
+    return load_factor * (external_force * solution_n);
+  }
+
+
+  template <int dim,typename NumberType>
+  std::pair<double,double> Solid<dim,NumberType>::get_parameter_sensitivities() const
+  {
+    Assert (parameters.adjoint_sensitivities, ExcNotInitialized());
+
+    double sensitivity_mu = 0.0, sensitivity_nu = 0.0;
+    for (unsigned int i = 0; i < cell_sensitivity_mu.size(); ++i)
+      {
+        sensitivity_mu += cell_sensitivity_mu(i);
+        sensitivity_nu += cell_sensitivity_nu(i);
+      }
+    return std::make_pair(sensitivity_mu, sensitivity_nu);
   }
 
 
-// In solving the quasi-static problem, the time becomes a loading parameter,
-// i.e. we increasing the loading linearly with time, making the two concepts
-// interchangeable. We choose to increment time linearly using a constant time
-// step size.
-//
-// We start the function with preprocessing, and then output the initial grid
-// before starting the simulation proper with the first time (and loading)
-// increment.
-//
+// The arc-length driver follows the equilibrium path in the space of the
+// displacements and the load factor. Each step has a prescribed arc length
+// $\varDelta s$ which is adapted to the number of Newton iterations the
+// previous step needed: if it converged quickly, the arc length grows, if it
+// did not converge at all, it is halved and the step is repeated from the last
+// converged state. This lets us pass limit points (snap-through) within a
+// single run.
   template <int dim,typename NumberType>
-  void Solid<dim,NumberType>::run()
+  void Solid<dim,NumberType>::run_arc_length()
   {
-    make_grid();
-    system_setup();
-    output_results();
-    time.increment();
+    // A negative arc length indicates that it is to be determined from the
+    // first predictor:
+    double arc_length = -1.0;
+    double arc_length_min = 0.0;
+    double arc_length_max = std::numeric_limits<double>::max();
 
-    // We then declare the incremental solution update $\varDelta
-    // \mathbf{\Xi}:= \{\varDelta \mathbf{u}\}$ and start the loop over the
-    // time domain.
-    //
-    // At the beginning, we reset the solution update for this time step...
-    while (time.current() <= time.end())
+    solution_delta_previous.reinit(dof_handler_ref.n_dofs());
+    load_factor_delta_previous = 0.0;
+
+    while (load_factor < parameters.final_load_factor)
       {
+        AssertThrow(time.get_timestep() <= parameters.max_steps,
+                    ExcMessage("Maximum number of arc-length steps reached "
+                               "before the final load factor."));
+
         solution_delta = 0.0;
+        const double load_factor_n = load_factor;
+        const bool   first_step = (arc_length < 0.0);
+
+        unsigned int n_iterations = 0;
+        const bool converged = solve_nonlinear_timestep_arc_length(arc_length,
+                                                                   n_iterations);
+
+        if (first_step)
+          {
+            arc_length_min = parameters.min_arc_length_factor * arc_length;
+            arc_length_max = parameters.max_arc_length_factor * arc_length;
+          }
+
+        if (converged == false)
+          {
+            // Restart the step from the last converged state with a smaller
+            // arc length:
+            solution_delta = 0.0;
+            load_factor = load_factor_n;
+            if (material_history)
+              material_history->rollback();
+            arc_length *= 0.5;
+            std::cout << " Arc length reduced to " << arc_length << std::endl;
+
+            AssertThrow(arc_length >= arc_length_min,
+                        ExcMessage("Arc length fell below its minimum value!"));
+            continue;
+          }
 
-        // ...solve the current time step and update total solution vector
-        // $\mathbf{\Xi}_{\textrm{n}} = \mathbf{\Xi}_{\textrm{n-1}} +
-        // \varDelta \mathbf{\Xi}$...
-        solve_nonlinear_timestep();
         solution_n += solution_delta;
+        solution_delta_previous = solution_delta;
+        load_factor_delta_previous = load_factor - load_factor_n;
+
+        std::cout << "Load factor: " << load_factor
+                  << "\t Vertical tip displacement: "
+                  << solution_n(get_vertical_tip_dof())
+                  << std::endl;
+
+        postprocess_converged_step();
+        commit_history();
 
-        // ...and plot the results before moving on happily to the next time
-        // step:
         output_results();
         time.increment();
-      }
 
-    // Lastly, we print the vertical tip displacement of the Cook cantilever
-    // after the full load is applied
-    print_vertical_tip_displacement();
+        // Adapt the arc length to the desired number of iterations, but do
+        // not change it by more than a factor of two in one step:
+        const double ratio = std::sqrt(double(parameters.desired_iterations) /
+                                       std::max(n_iterations,1u));
+        arc_length *= std::min(2.0, std::max(0.5, ratio));
+        arc_length = std::min(arc_length_max, std::max(arc_length_min, arc_length));
+      }
   }
 
 
@@ -747,51 +2230,198 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
   return pt_out;
 }
 
+// The grid of the beam is shared by all drivers on the Cook membrane:
+template <int dim>
+void make_cook_membrane_grid (Triangulation<dim> &triangulation,
+                              const unsigned int  elements_per_edge,
+                              const double        scale)
+{
+  // Divide the beam, but only along the x- and y-coordinate directions
+  std::vector< unsigned int > repetitions(dim, elements_per_edge);
+  // Only allow one element through the thickness
+  // (modelling a plane strain condition)
+  if (dim == 3)
+    repetitions[dim-1] = 1;
+
+  const Point<dim> bottom_left = (dim == 3 ? Point<dim>(0.0, 0.0, -0.5) : Point<dim>(0.0, 0.0));
+  const Point<dim> top_right = (dim == 3 ? Point<dim>(48.0, 44.0, 0.5) : Point<dim>(48.0, 44.0));
+
+  GridGenerator::subdivided_hyper_rectangle(triangulation,
+                                            repetitions,
+                                            bottom_left,
+                                            top_right);
+
+  // Since we wish to apply a Neumann BC to the right-hand surface, we
+  // must find the cell faces in this part of the domain and mark them with
+  // a distinct boundary ID number.  The faces we are looking for are on the
+  // +x surface and will get boundary ID 11.
+  // Dirichlet boundaries exist on the left-hand face of the beam (this fixed
+  // boundary will get ID 1) and on the +Z and -Z faces (which correspond to
+  // ID 2 and we will use to impose the plane strain condition)
+  const double tol_boundary = 1e-6;
+  typename Triangulation<dim>::active_cell_iterator cell =
+    triangulation.begin_active(), endc = triangulation.end();
+  for (; cell != endc; ++cell)
+    for (unsigned int face = 0;
+         face < GeometryInfo<dim>::faces_per_cell; ++face)
+      if (cell->face(face)->at_boundary() == true)
+      {
+        if (std::abs(cell->face(face)->center()[0] - 0.0) < tol_boundary)
+          cell->face(face)->set_boundary_id(1); // -X faces
+        else if (std::abs(cell->face(face)->center()[0] - 48.0) < tol_boundary)
+          cell->face(face)->set_boundary_id(11); // +X faces
+        else if (std::abs(std::abs(cell->face(face)->center()[0]) - 0.5) < tol_boundary)
+          cell->face(face)->set_boundary_id(2); // +Z and -Z faces
+      }
+
+  // Transform the hyper-rectangle into the beam shape
+  GridTools::transform(&grid_y_transform<dim>, triangulation);
+
+  GridTools::scale(scale, triangulation);
+}
+
+// Likewise the boundary conditions: The left hand side of the beam is
+// clamped and, in 3d, the Z-displacement is fixed on the +Z and -Z faces for
+// the plane strain condition. The constraints are added to @p constraints,
+// which is closed by the caller.
+template <int dim>
+void make_cook_membrane_constraints (const DoFHandler<dim> &dof_handler,
+                                     ConstraintMatrix      &constraints)
+{
+  const FiniteElement<dim> &fe = dof_handler.get_fe();
+
+  VectorTools::interpolate_boundary_values(dof_handler,
+                                           1,
+                                           ZeroFunction<dim>(fe.n_components()),
+                                           constraints,
+                                           fe.component_mask(FEValuesExtractors::Vector(0)));
+  if (dim == 3)
+    VectorTools::interpolate_boundary_values(dof_handler,
+                                             2,
+                                             ZeroFunction<dim>(fe.n_components()),
+                                             constraints,
+                                             fe.component_mask(FEValuesExtractors::Scalar(2)));
+}
+
+// The vertical traction on the right hand side of the beam for a unit load
+// factor. It is specified in the reference configuration as the total force
+// over the area of the right hand side, and its direction does not evolve
+// with the deformation of the domain.
+template <int dim>
+void assemble_cook_membrane_traction (const DoFHandler<dim>    &dof_handler,
+                                      const ConstraintMatrix   &constraints,
+                                      const Quadrature<dim-1>  &qf_face,
+                                      const double              scale,
+                                      Vector<double>           &external_force)
+{
+  const FiniteElement<dim> &fe = dof_handler.get_fe();
+  FEFaceValues<dim> fe_face_values(fe, qf_face, update_values | update_JxW_values);
+
+  Vector<double> cell_external_force(fe.dofs_per_cell);
+  std::vector<types::global_dof_index> local_dof_indices(fe.dofs_per_cell);
+
+  // (Total force) / (RHS surface area)
+  const double magnitude = 1.0 / (16.0 * scale * 1.0 * scale);
+
+  external_force.reinit(dof_handler.n_dofs());
+  for (const auto &cell : dof_handler.active_cell_iterators())
+    for (unsigned int face = 0; face < GeometryInfo<dim>::faces_per_cell; ++face)
+      if (cell->face(face)->at_boundary() == true && cell->face(face)->boundary_id() == 11)
+        {
+          fe_face_values.reinit(cell, face);
+          cell_external_force = 0.;
+          for (unsigned int f_q_point = 0; f_q_point < qf_face.size(); ++f_q_point)
+            for (unsigned int i = 0; i < fe.dofs_per_cell; ++i)
+              if (fe.system_to_component_index(i).first == 1)
+                cell_external_force(i) += magnitude * fe_face_values.shape_value(i,f_q_point)
+                                          * fe_face_values.JxW(f_q_point);
+
+          cell->get_dof_indices(local_dof_indices);
+          constraints.distribute_local_to_global(cell_external_force,
+                                                 local_dof_indices,
+                                                 external_force);
+        }
+}
+
+// The DoF of the vertical displacement at the upper right corner of the
+// beam, where the result is compared to the literature. This point is
+// coincident with a vertex, so that FE_Q elements have a DoF there.
+template <int dim>
+types::global_dof_index
+get_cook_membrane_tip_dof (const DoFHandler<dim> &dof_handler,
+                           const double           scale)
+{
+  Point<dim> tip (48.0*scale,60.0*scale);
+  if (dim == 3)
+    tip[2] = 0.5*scale;
+
+  for (const auto &cell : dof_handler.active_cell_iterators())
+    for (unsigned int v=0; v<GeometryInfo<dim>::vertices_per_cell; ++v)
+      if (cell->vertex(v).distance(tip) < 1e-6)
+        return cell->vertex_dof_index(v,1);
+
+  AssertThrow(false, ExcMessage("Found no vertex at the tip!"));
+  return numbers::invalid_dof_index;
+}
+
+// For each active cell, the active cells whose centers lie within @p radius
+// of its center together with the distance, sorted by the cell index. The
+// search grows in layers of cells sharing a vertex from the cell itself and
+// continues through the cells that are closer than the radius plus their
+// diameter, i.e. through all cells which the ball of the radius intersects,
+// so that its cost grows with the number of neighbours rather than with the
+// number of cells.
+template <int dim>
+std::vector<std::vector<std::pair<unsigned int,double>>>
+find_cells_within_radius (const Triangulation<dim> &triangulation,
+                          const double              radius)
+{
+  typedef typename Triangulation<dim>::active_cell_iterator cell_iterator;
+  const std::vector<std::set<cell_iterator>> vertex_to_cells =
+    GridTools::vertex_to_cell_map(triangulation);
+
+  std::vector<std::vector<std::pair<unsigned int,double>>> neighbors(triangulation.n_active_cells());
+  std::vector<unsigned int> visited(triangulation.n_active_cells(), numbers::invalid_unsigned_int);
+  std::vector<cell_iterator> layer, next_layer;
+  for (const auto &cell : triangulation.active_cell_iterators())
+    {
+      const unsigned int e = cell->active_cell_index();
+      const Point<dim> center = cell->center();
+
+      visited[e] = e;
+      layer.assign(1, cell);
+      while (!layer.empty())
+        {
+          next_layer.clear();
+          for (const auto &neighbor : layer)
+            {
+              const double distance = center.distance(neighbor->center());
+              if (distance < radius)
+                neighbors[e].push_back(std::make_pair(neighbor->active_cell_index(), distance));
+              if (distance >= radius + neighbor->diameter())
+                continue;
+
+              for (unsigned int v=0; v<GeometryInfo<dim>::vertices_per_cell; ++v)
+                for (const auto &candidate : vertex_to_cells[neighbor->vertex_index(v)])
+                  if (visited[candidate->active_cell_index()] != e)
+                    {
+                      visited[candidate->active_cell_index()] = e;
+                      next_layer.push_back(candidate);
+                    }
+            }
+          layer.swap(next_layer);
+        }
+
+      std::sort(neighbors[e].begin(), neighbors[e].end());
+    }
+
+  return neighbors;
+}
+
   template <int dim,typename NumberType>
   void Solid<dim,NumberType>::make_grid()
   {
-    // Divide the beam, but only along the x- and y-coordinate directions
-    std::vector< unsigned int > repetitions(dim, parameters.elements_per_edge);
-    // Only allow one element through the thickness
-    // (modelling a plane strain condition)
-    if (dim == 3)
-      repetitions[dim-1] = 1;
-
-    const Point<dim> bottom_left = (dim == 3 ? Point<dim>(0.0, 0.0, -0.5) : Point<dim>(0.0, 0.0));
-    const Point<dim> top_right = (dim == 3 ? Point<dim>(48.0, 44.0, 0.5) : Point<dim>(48.0, 44.0));
-
-    GridGenerator::subdivided_hyper_rectangle(triangulation,
-                                              repetitions,
-                                              bottom_left,
-                                              top_right);
-
-   // Since we wish to apply a Neumann BC to the right-hand surface, we
-   // must find the cell faces in this part of the domain and mark them with
-   // a distinct boundary ID number.  The faces we are looking for are on the
-   // +x surface and will get boundary ID 11.
-   // Dirichlet boundaries exist on the left-hand face of the beam (this fixed
-   // boundary will get ID 1) and on the +Z and -Z faces (which correspond to
-   // ID 2 and we will use to impose the plane strain condition)
-   const double tol_boundary = 1e-6;
-   typename Triangulation<dim>::active_cell_iterator cell =
-     triangulation.begin_active(), endc = triangulation.end();
-   for (; cell != endc; ++cell)
-     for (unsigned int face = 0;
-          face < GeometryInfo<dim>::faces_per_cell; ++face)
-       if (cell->face(face)->at_boundary() == true)
-       {
-         if (std::abs(cell->face(face)->center()[0] - 0.0) < tol_boundary)
-           cell->face(face)->set_boundary_id(1); // -X faces
-         else if (std::abs(cell->face(face)->center()[0] - 48.0) < tol_boundary)
-           cell->face(face)->set_boundary_id(11); // +X faces
-         else if (std::abs(std::abs(cell->face(face)->center()[0]) - 0.5) < tol_boundary)
-           cell->face(face)->set_boundary_id(2); // +Z and -Z faces
-       }
-
-    // Transform the hyper-rectangle into the beam shape
-    GridTools::transform(&grid_y_transform<dim>, triangulation);
-
-    GridTools::scale(parameters.scale, triangulation);
+    make_cook_membrane_grid(triangulation, parameters.elements_per_edge, parameters.scale);
 
     vol_reference = GridTools::volume(triangulation);
     vol_current = vol_reference;
@@ -813,6 +2443,8 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
     // efficient manner. We also record the number of DOFs per block.
     dof_handler_ref.distribute_dofs(fe);
     DoFRenumbering::Cuthill_McKee(dof_handler_ref);
+    if (parameters.matrix_format == "BSR" || parameters.preconditioner_type == "amg")
+      renumber_nodal_blocks(dof_handler_ref);
 
     std::cout << "Triangulation:"
               << "\n\t Number of active cells: " << triangulation.n_active_cells()
@@ -830,14 +2462,127 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
       sparsity_pattern.copy_from(dsp);
     }
 
-    tangent_matrix.reinit(sparsity_pattern);
+    // The block and the symmetric matrix have their own pattern, so that
+    // the scalar one is not kept.
+    if (parameters.matrix_format == "BSR")
+      {
+        tangent_matrix_bsr.reinit(sparsity_pattern);
+        sparsity_pattern.reinit(0, 0, 0);
+        std::cout << "\t Tangent matrix: "
+                  << tangent_matrix_bsr.memory_consumption() / 1048576. << " MB" << std::endl;
+      }
+    else if (parameters.matrix_format == "Symmetric")
+      {
+        tangent_matrix_symmetric.reinit(sparsity_pattern);
+        sparsity_pattern.reinit(0, 0, 0);
+        std::cout << "\t Tangent matrix: "
+                  << tangent_matrix_symmetric.memory_consumption() / 1048576. << " MB" << std::endl;
+      }
+    else
+      tangent_matrix.reinit(sparsity_pattern);
+
+    if (parameters.matrix_format == "SELL")
+      {
+        tangent_matrix_sell.reinit(sparsity_pattern);
+        std::cout << "\t Tangent matrix: "
+                  << (tangent_matrix.memory_consumption() + sparsity_pattern.memory_consumption()) / 1048576.
+                  << " MB, SELL-C-sigma copy: "
+                  << tangent_matrix_sell.memory_consumption() / 1048576. << " MB" << std::endl;
+      }
+
+    if (parameters.preconditioner_type == "mc_ssor")
+      {
+        mc_ssor.color(sparsity_pattern);
+        std::cout << "\t Colors of the sparsity pattern: " << mc_ssor.n_colors()
+                  << std::endl;
+      }
+
+#ifdef DEAL_II_WITH_TRILINOS
+    if (parameters.preconditioner_type == "amg")
+      {
+        amg_preconditioner.clear();
+        amg_preconditioner.set_rigid_body_modes(dof_handler_ref);
+        amg_setup_lin_it = 0;
+        amg_last_lin_it = 0;
+      }
+#endif
 
     // We then set up storage vectors
     system_rhs.reinit(dof_handler_ref.n_dofs());
+    external_force.reinit(dof_handler_ref.n_dofs());
     solution_n.reinit(dof_handler_ref.n_dofs());
     solution_delta.reinit(dof_handler_ref.n_dofs());
     solution_total.reinit(dof_handler_ref.n_dofs());
 
+    cell_sensitivity_mu.reinit(triangulation.n_active_cells());
+    cell_sensitivity_nu.reinit(triangulation.n_active_cells());
+
+    // The topology optimization starts from a uniform density:
+    if (material_scaling)
+      {
+        density.reinit(triangulation.n_active_cells());
+        density = parameters.volume_fraction;
+        cell_sensitivity_density.reinit(triangulation.n_active_cells());
+        setup_density_filter();
+      }
+
+    // The temperature starts at the reference temperature and is prescribed
+    // on the clamped boundary:
+    if (thermal_expansion)
+      {
+        dof_handler_temperature.distribute_dofs(fe_temperature);
+        DoFRenumbering::Cuthill_McKee(dof_handler_temperature);
+
+        constraints_temperature.clear();
+        DoFTools::make_hanging_node_constraints(dof_handler_temperature, constraints_temperature);
+        VectorTools::interpolate_boundary_values(dof_handler_temperature,
+                                                 1,
+                                                 ZeroFunction<dim>(),
+                                                 constraints_temperature);
+        constraints_temperature.close();
+
+        temperature.reinit(dof_handler_temperature.n_dofs());
+        temperature = parameters.reference_temperature;
+        temperature_n = temperature;
+
+        std::cout << "\t Number of temperature degrees of freedom: "
+                  << dof_handler_temperature.n_dofs() << std::endl;
+      }
+
+    // The body is intact at the beginning. There are no Dirichlet conditions
+    // on the damage:
+    if (degradation)
+      {
+        dof_handler_damage.distribute_dofs(fe_damage);
+        DoFRenumbering::Cuthill_McKee(dof_handler_damage);
+
+        constraints_damage.clear();
+        DoFTools::make_hanging_node_constraints(dof_handler_damage, constraints_damage);
+        constraints_damage.close();
+
+        damage.reinit(dof_handler_damage.n_dofs());
+        damage_n.reinit(dof_handler_damage.n_dofs());
+
+        std::cout << "\t Number of damage degrees of freedom: "
+                  << dof_handler_damage.n_dofs() << std::endl;
+      }
+
+    // The history of the Anderson acceleration is bounded by its depth:
+    if (parameters.anderson_depth > 0)
+      {
+        const types::global_dof_index n_staggered_dofs = thermal_expansion ?
+                                                         dof_handler_temperature.n_dofs() :
+                                                         degradation ?
+                                                         dof_handler_damage.n_dofs() :
+                                                         0;
+        std::cout << "Anderson acceleration: depth " << parameters.anderson_depth
+                  << ", at most "
+                  << (anderson_newton.max_n_vectors() * dof_handler_ref.n_dofs() +
+                      anderson_staggered.max_n_vectors() * n_staggered_dofs) * sizeof(double)
+                  / (1024. * 1024.)
+                  << " MB" << std::endl;
+      }
+
     timer.leave_subsection();
   }
 
@@ -848,34 +2593,204 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
     timer.enter_subsection("Setup matrix-free");
 
     // The constraints in Newton-Raphson are different for it_nr=0 and 1,
-    // and then they are the same so we only need to re-init the data
-    // according to the updated displacement/mapping
+    // but only in their inhomogeneities, which the operator does not see.
+    // The index data thus only depends on the mesh and is set up once for
+    // all Newton iterations, load steps and, in the topology optimization,
+    // designs. Afterwards we only need to re-init the data according to the
+    // updated displacement/mapping
     const QGauss<1> quad (n_q_points_1d);
     typename MatrixFree<dim,double>::AdditionalData data;
     data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
 
-    if (it_nr <= 1)
+    // The temperature or the damage is added as a second field, so that it
+    // shares the cell batches with the displacement:
+    std::vector<const DoFHandler<dim> *>  dof_handlers(1, &dof_handler_ref);
+    std::vector<const ConstraintMatrix *> constraint_matrices(1, &constraints);
+    if (thermal_expansion)
       {
-        // solution_total is the point around which we linearize
-        eulerian_mapping = std::make_shared<MappingQEulerian<dim,Vector<double>>>(/*mapping degree*/1,dof_handler_ref,solution_total);
+        dof_handlers.push_back(&dof_handler_temperature);
+        constraint_matrices.push_back(&constraints_temperature);
+      }
+    if (degradation)
+      {
+        dof_handlers.push_back(&dof_handler_damage);
+        constraint_matrices.push_back(&constraints_damage);
+      }
+    const std::vector<QGauss<1>> quads(1, quad);
 
-        mf_data_current = std::make_shared<MatrixFree<dim,double>>();
+    Assert (mf_data_reference || it_nr == 0, ExcInternalError());
+    (void)it_nr;
+    if (!mf_data_reference)
+      {
         mf_data_reference = std::make_shared<MatrixFree<dim,double>>();
 
-        mf_data_reference->reinit (                  dof_handler_ref, constraints, quad, data);
-        mf_data_current->reinit   (*eulerian_mapping,dof_handler_ref, constraints, quad, data);
+        // The contact is evaluated on the boundary faces of the reference
+        // configuration:
+        typename MatrixFree<dim,double>::AdditionalData data_reference(data);
+        if (contact)
+          PenaltyContact<dim,degree,n_q_points_1d,double>::add_data_flags(data_reference);
+
+        mf_data_reference->reinit (                  dof_handlers, constraint_matrices, quads, data_reference);
+
+        // solution_total is the point around which we linearize
+        if (parameters.mf_geometry == "On the fly")
+          mf_nh_operator.initialize(mf_data_reference,solution_total);
+        else
+          {
+            eulerian_mapping = std::make_shared<MappingQEulerian<dim,Vector<double>>>(/*mapping degree*/1,dof_handler_ref,solution_total);
+            mf_data_current = std::make_shared<MatrixFree<dim,double>>();
+            mf_data_current->reinit   (*eulerian_mapping,dof_handlers, constraint_matrices, quads, data);
+
+            mf_nh_operator.initialize(mf_data_current,mf_data_reference,solution_total);
+          }
+
+        // The memory saved by computing the geometry on the fly. It depends on
+        // the SIMD width and the deal.II build, so that it is not printed for
+        // the default mode, i.e. in the regression tests.
+        if (parameters.mf_geometry == "On the fly")
+          std::cout << "Matrix-free data: "
+                    << mf_data_reference->memory_consumption() / (1024. * 1024.)
+                    << " MB" << std::endl;
+
+        // The reaction force is the sum of the internal forces on the
+        // clamped boundary:
+        if (matrix_free_residual)
+          {
+            std::vector<bool> clamped_dofs(dof_handler_ref.n_dofs());
+            DoFTools::extract_boundary_dofs(dof_handler_ref, fe.component_mask(u_fe), clamped_dofs,
+                                            std::set<types::boundary_id>{1});
+            reaction_dofs.reinit(dof_handler_ref.n_dofs());
+            for (types::global_dof_index i = 0; i < dof_handler_ref.n_dofs(); ++i)
+              if (clamped_dofs[i])
+                reaction_dofs(i) = 1.0;
+            mf_nh_operator.set_reaction_dofs(reaction_dofs);
+          }
+
+        // The linear elastic preconditioner does not depend on the
+        // deformation, so that its diagonal and the eigenvalue estimate of
+        // the Chebyshev iteration are computed only here. The range of the
+        // latter is by default chosen as the square of the degree, on which
+        // the error is reduced by about $e^{-2}$.
+        if (parameters.preconditioner_type == "linear_elastic")
+          {
+            mf_le_operator.initialize(mf_data_reference, parameters.mu, parameters.nu);
+            mf_le_operator.compute_diagonal();
+
+            typename PreconditionChebyshev<LinearElasticOperator<dim,degree,n_q_points_1d,double>,Vector<double>>::AdditionalData
+            chebyshev_data;
+            chebyshev_data.degree = parameters.preconditioner_degree;
+            chebyshev_data.smoothing_range = parameters.preconditioner_smoothing_range > 0. ?
+                                             parameters.preconditioner_smoothing_range :
+                                             std::max(4., double(parameters.preconditioner_degree * parameters.preconditioner_degree));
+            chebyshev_data.eig_cg_n_iterations = parameters.preconditioner_eigenvalue_iterations;
+            chebyshev_data.preconditioner = mf_le_operator.get_matrix_diagonal_inverse();
+            le_preconditioner.initialize(mf_le_operator, chebyshev_data);
+          }
+
+        if (thermal_expansion)
+          {
+            mf_nh_operator.set_thermal_expansion(thermal_expansion_vec, temperature, temperature_dof_index);
+            mf_heat_operator.initialize(mf_data_reference, 0, temperature_dof_index, solution_total);
+            mf_heat_operator.set_parameters(parameters.heat_capacity, parameters.thermal_conductivity,
+                                            parameters.delta_t);
+          }
+
+        // The crack driving force is a history variable at the quadrature
+        // points of the cell batches of the reference configuration:
+        if (degradation)
+          {
+            crack_driving_force->reinit(*mf_data_reference, n_q_points, std::vector<double>(1, 0.0));
+            mf_nh_operator.set_phase_field(degradation_vec, damage, damage_dof_index);
+            mf_damage_operator.initialize(mf_data_reference, 0, damage_dof_index, solution_total,
+                                          crack_driving_force);
+            mf_damage_operator.set_parameters(parameters.fracture_toughness,
+                                              parameters.phase_field_length_scale * parameters.scale);
+          }
+
+        if (contact)
+          {
+            contact->initialize(mf_data_reference, parameters.contact_boundary_id,
+                                obstacle_vec, parameters.contact_penalty, solution_total);
+            mf_nh_operator.set_contact(contact);
+          }
+
+        // The history variables are laid out according to the cell batches
+        // of the reference configuration, which do not change as long as the
+        // mesh stays the same:
+        if (material_history)
+          {
+            if (material_history->n_variables() == 0)
+              {
+                if (plastic_material)
+                  {
+                    material_history->reinit(*mf_data_reference, n_q_points,
+                                             Material_J2_Plasticity<dim,NumberType>::initial_history());
+                    mf_nh_operator.set_material(plastic_material_vec, material_history);
+                  }
+                else
+                  {
+                    material_history->reinit(*mf_data_reference, n_q_points,
+                                             std::vector<double>(viscous_material_vec->n_history_variables(), 0.0));
+                    mf_nh_operator.set_viscous_history(material_history);
+                  }
+
+                // The history typically dominates the memory of the
+                // matrix-free solver:
+                std::cout << "Material history: "
+                          << material_history->memory_consumption() / (1024. * 1024.)
+                          << " MB, "
+                          << material_history->memory_consumption_per_quadrature_point()
+                          << " bytes per quadrature point" << std::endl;
+              }
+            Assert(material_history->matches(*mf_data_reference), ExcInternalError());
+          }
+
+        // Likewise, the fiber directions are evaluated once per cell:
+        if (fiber_directions)
+          {
+            if (fiber_directions->n_fiber_families() == 0)
+              {
+                fiber_directions->reinit(*mf_data_reference, parameters.n_fiber_families,
+                                         [this](const typename DoFHandler<dim>::cell_iterator &cell,
+                                                const unsigned int                             family)
+                {
+                  return get_fiber_direction(cell,family);
+                });
+                mf_nh_operator.set_fibers(fiber_material_vec, fiber_directions);
+
+                std::cout << "Fiber directions: "
+                          << fiber_directions->memory_consumption() / (1024. * 1024.)
+                          << " MB" << std::endl;
+              }
+            Assert(fiber_directions->matches(*mf_data_reference), ExcInternalError());
+          }
 
-        mf_nh_operator.initialize(mf_data_current,mf_data_reference,solution_total);
+        // The stiffness of the topology optimization is stored per cell
+        // batch as well:
+        if (material_scaling)
+          {
+            material_scaling->reinit(*mf_data_reference, 1);
+            update_material_scaling();
+            mf_nh_operator.set_material_scaling(material_scaling);
+          }
       }
-    else
+    else if (mf_data_current)
       {
         // here reinitialize MatrixFree with initialize_indices=false
         // as the mapping has to be recomputed but the topology of cells is the same
         data.initialize_indices = false;
-        mf_data_current->reinit   (*eulerian_mapping,dof_handler_ref, constraints, quad, data);
+        mf_data_current->reinit   (*eulerian_mapping,dof_handlers, constraint_matrices, quads, data);
       }
 
-    mf_nh_operator.compute_diagonal();
+    // The active set of the contact follows the current displacement:
+    if (contact)
+      contact->update_active_set();
+
+    mf_nh_operator.compute_cell_dilatation();
+
+    // The matrix-free residual comes with the diagonal:
+    if (!matrix_free_residual)
+      mf_nh_operator.compute_diagonal();
 
     timer.leave_subsection();
   }
@@ -901,6 +2816,8 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
     error_update_0.reset();
     error_update_norm.reset();
 
+    anderson_newton.reset();
+
     print_conv_header();
 
     // We now perform a number of Newton iterations to iteratively solve the
@@ -932,9 +2849,28 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
         setup_matrix_free(newton_iteration);
 
         // now ready to go-on and assmble linearized problem around solution_n + solution_delta for this iteration.
-        assemble_system();
+        if (matrix_free_residual)
+          assemble_residual_matrix_free();
+        else
+          assemble_system();
 
 #ifdef DEBUG
+        // the matrix-based reference for the checks below:
+        if (matrix_free_residual)
+          {
+            const Vector<double> system_rhs_mf(system_rhs);
+            assemble_system_matrix_based();
+
+            Vector<double> diff(system_rhs);
+            diff.add(-1, system_rhs_mf);
+            Assert (diff.l2_norm() <= 1e-10 * std::max(1.0, system_rhs.l2_norm()),
+                    ExcMessage("MF and MB residual are different " +
+                               std::to_string(diff.l2_norm()) +
+                               " at Newton iteration " +
+                               std::to_string(newton_iteration)
+                              ));
+          }
+
         // check vmult of matrix-based and matrix-free for a random vector:
         {
           Vector<double> src(dof_handler_ref.n_dofs()), dst_mb(dof_handler_ref.n_dofs()), dst_mf(dof_handler_ref.n_dofs()), diff(dof_handler_ref.n_dofs());
@@ -943,7 +2879,14 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
 
           constraints.set_zero(src);
 
-          tangent_matrix.vmult(dst_mb, src);
+          if (parameters.matrix_format == "BSR")
+            tangent_matrix_bsr.vmult(dst_mb, src);
+          else if (parameters.matrix_format == "Symmetric")
+            tangent_matrix_symmetric.vmult(dst_mb, src);
+          else if (parameters.matrix_format == "SELL")
+            tangent_matrix_sell.vmult(dst_mb, src);
+          else
+            tangent_matrix.vmult(dst_mb, src);
           mf_nh_operator.vmult(dst_mf, src);
 
           diff = dst_mb;
@@ -956,7 +2899,12 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
                             ));
 
           // now check Jacobi preconditioner
-          tangent_matrix.precondition_Jacobi(dst_mb,src,0.8);
+          if (parameters.matrix_format == "BSR")
+            tangent_matrix_bsr.precondition_Jacobi(dst_mb,src,0.8);
+          else if (parameters.matrix_format == "Symmetric")
+            tangent_matrix_symmetric.precondition_Jacobi(dst_mb,src,0.8);
+          else
+            tangent_matrix.precondition_Jacobi(dst_mb,src,0.8);
           mf_nh_operator.precondition_Jacobi(dst_mf,src,0.8);
 
           diff = dst_mb;
@@ -992,7 +2940,7 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
           }
 
         const std::pair<unsigned int, double>
-        lin_solver_output = solve_linear_system(newton_update);
+        lin_solver_output = solve_linear_system(system_rhs, newton_update);
 
         get_error_update(newton_update, error_update);
         if (newton_iteration == 0)
@@ -1005,6 +2953,9 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
         error_update_norm = error_update;
         error_update_norm.normalise(error_update_0);
 
+        // The convergence is judged by the plain Newton update, the
+        // accelerated one is applied:
+        anderson_newton.apply(solution_delta, newton_update);
         solution_delta += newton_update;
 
         std::cout << " | " << std::fixed << std::setprecision(3) << std::setw(7)
@@ -1028,6 +2979,155 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
   }
 
 
+// @sect4{Solid::solve_nonlinear_timestep_arc_length}
+
+// The Newton scheme for the arc-length method solves the extended system
+// $\mathbf{K} \delta \mathbf{u} - \delta \lambda \mathbf{f} = \mathbf{r}$,
+// $g(\varDelta \mathbf{u}, \varDelta \lambda) = 0$, where the constraint
+// $g = \varDelta \mathbf{u} \cdot \varDelta \mathbf{u} + \psi^2 u_0^2
+// \varDelta \lambda^2 - \varDelta s^2$ fixes the length of the step. Instead
+// of assembling the bordered matrix we eliminate the load factor increment
+// (Sherman-Morrison) which requires two solves with the tangent per
+// iteration, $\delta \mathbf{u}_r = \mathbf{K}^{-1} \mathbf{r}$ and
+// $\delta \mathbf{u}_f = \mathbf{K}^{-1} \mathbf{f}$. Both are done with
+// the usual linear solver, i.e. with the matrix-free operator in the case of
+// <code>MF_CG</code>.
+  template <int dim,typename NumberType>
+  bool
+  Solid<dim,NumberType>::solve_nonlinear_timestep_arc_length(double &arc_length,
+                                                             unsigned int &n_iterations)
+  {
+    std::cout << std::endl << "Arc-length step " << time.get_timestep()
+              << " @ load factor " << load_factor << std::endl;
+
+    Vector<double> newton_update(dof_handler_ref.n_dofs());
+    Vector<double> update_residual(dof_handler_ref.n_dofs());
+    Vector<double> update_load(dof_handler_ref.n_dofs());
+
+    error_residual.reset();
+    error_residual_0.reset();
+    error_residual_norm.reset();
+    error_update.reset();
+    error_update_0.reset();
+    error_update_norm.reset();
+
+    print_conv_header();
+
+    double load_factor_delta = 0.0;
+
+    unsigned int newton_iteration = 0;
+    for (; newton_iteration < parameters.max_iterations_NR;
+         ++newton_iteration)
+      {
+        std::cout << " " << std::setw(2) << newton_iteration << " " << std::flush;
+
+        make_constraints(newton_iteration);
+        set_total_solution();
+        setup_matrix_free(newton_iteration);
+        if (matrix_free_residual)
+          assemble_residual_matrix_free();
+        else
+          assemble_system();
+
+        // The tangent of the load path is needed in every iteration:
+        const std::pair<unsigned int, double>
+        lin_solver_output_load = solve_linear_system(external_force, update_load);
+
+        if (arc_length_displacement_scale == 0.0)
+          arc_length_displacement_scale = update_load * update_load;
+        const double psi_2 = parameters.load_scaling * parameters.load_scaling
+                             * arc_length_displacement_scale;
+
+        if (newton_iteration == 0)
+          {
+            // The predictor goes along the tangent of the load path. Its
+            // orientation is chosen such that we continue in the direction of
+            // the previous step, which lets us follow the path through limit
+            // points where the load factor decreases:
+            const double tangent_norm = std::sqrt(update_load * update_load + psi_2);
+            if (arc_length < 0.0)
+              arc_length = tangent_norm * time.get_delta_t() / time.end();
+
+            const double orientation = solution_delta_previous * update_load
+                                       + psi_2 * load_factor_delta_previous;
+            load_factor_delta = (orientation < 0.0 ? -1.0 : 1.0) * arc_length / tangent_norm;
+
+            newton_update.equ(load_factor_delta, update_load);
+            solution_delta += newton_update;
+            load_factor += load_factor_delta;
+
+            get_error_update(newton_update, error_update);
+            error_update_0 = error_update;
+
+            std::cout << " PRD | " << std::fixed << std::setprecision(3) << std::setw(7)
+                      << std::scientific << lin_solver_output_load.first << "  "
+                      << lin_solver_output_load.second << "  " << load_factor
+                      << std::endl;
+            continue;
+          }
+
+        // The residual is measured relative to the current external load:
+        get_error_residual(error_residual);
+        Errors error_load;
+        error_load.norm = std::abs(load_factor) * external_force.l2_norm();
+        error_load.u = error_load.norm;
+        error_residual_norm = error_residual;
+        error_residual_norm.normalise(error_load);
+
+        if (!numbers::is_finite(error_residual.norm))
+          break;
+
+        if (newton_iteration > 1 && error_update_norm.u <= parameters.tol_u
+            && error_residual_norm.u <= parameters.tol_f)
+          {
+            std::cout << " CONVERGED! " << std::endl;
+            print_conv_footer();
+
+            break;
+          }
+
+        const std::pair<unsigned int, double>
+        lin_solver_output = solve_linear_system(system_rhs, update_residual);
+
+        // Linearize the arc-length constraint to find the change of the load
+        // factor:
+        const double constraint = solution_delta * solution_delta
+                                  + psi_2 * load_factor_delta * load_factor_delta
+                                  - arc_length * arc_length;
+        const double denominator = 2.0 * (solution_delta * update_load)
+                                   + 2.0 * psi_2 * load_factor_delta;
+        if (std::abs(denominator) < std::numeric_limits<double>::min())
+          break;
+
+        const double delta_load_factor = -(constraint + 2.0 * (solution_delta * update_residual))
+                                         / denominator;
+
+        newton_update = update_residual;
+        newton_update.add(delta_load_factor, update_load);
+
+        get_error_update(newton_update, error_update);
+        error_update_norm = error_update;
+        error_update_norm.normalise(error_update_0);
+
+        solution_delta += newton_update;
+        load_factor_delta += delta_load_factor;
+        load_factor += delta_load_factor;
+
+        std::cout << " | " << std::fixed << std::setprecision(3) << std::setw(7)
+                  << std::scientific << lin_solver_output.first << "  "
+                  << lin_solver_output.second << "  " << error_residual_norm.norm
+                  << "  " << error_residual_norm.u << "  "
+                  << "  " << error_update_norm.norm << "  " << error_update_norm.u
+                  << "  " << load_factor << std::endl;
+      }
+
+    n_iterations = newton_iteration;
+    return (newton_iteration < parameters.max_iterations_NR &&
+            numbers::is_finite(error_residual.norm) &&
+            error_residual_norm.u <= parameters.tol_f);
+  }
+
+
 // @sect4{Solid::print_conv_header, Solid::print_conv_footer and Solid::print_vertical_tip_displacement}
 
 // This program prints out data in a nice table that is updated
@@ -1068,6 +3168,20 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
               << "Force: \t\t" << error_residual.u / error_residual_0.u << std::endl
               << "v / V_0:\t" << vol_current << " / " << vol_reference
               << std::endl;
+
+    if (matrix_free_residual)
+      {
+        // Components of the reaction force in which the body is not loaded
+        // only contain the residual of the equilibrium, i.e. the round-off of
+        // the linear solver, so that they are printed as zero:
+        Tensor<1,dim> reaction_force_printed = reaction_force;
+        for (unsigned int d = 0; d < dim; ++d)
+          if (std::abs(reaction_force_printed[d]) < 1e-6 * reaction_force.norm())
+            reaction_force_printed[d] = 0.0;
+
+        std::cout << "Strain energy:\t" << strain_energy << std::endl
+                  << "Reaction force:\t" << reaction_force_printed << std::endl;
+      }
   }
 
 // At the end we also output the result that can be compared to that found in
@@ -1082,46 +3196,31 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
       std::cout << "_";
     std::cout << std::endl;
 
+    // Extract y-component of solution at the upper right corner. This point
+    // is coindicent with a vertex, so we can extract it directly as we're
+    // using FE_Q finite elements that have support at the vertices
+    const double vertical_tip_displacement = solution_n(get_vertical_tip_dof());
+
+    // Sanity check using alternate method to extract the solution
+    // at the given point. To do this, we must create an FEValues instance
+    // to help us extract the solution value at the desired point
     Point<dim> soln_pt (48.0*parameters.scale,60.0*parameters.scale);
     if (dim == 3)
       soln_pt[2] = 0.5*parameters.scale;
-    double vertical_tip_displacement = 0.0;
-    double vertical_tip_displacement_check = 0.0;
-
-    typename DoFHandler<dim>::active_cell_iterator cell =
-      dof_handler_ref.begin_active(), endc = dof_handler_ref.end();
-    for (; cell != endc; ++cell)
-    {
-      // if (cell->point_inside(soln_pt) == true)
-      for (unsigned int v=0; v<GeometryInfo<dim>::vertices_per_cell; ++v)
-        if (cell->vertex(v).distance(soln_pt) < 1e-6)
-      {
-        // Extract y-component of solution at the given point
-        // This point is coindicent with a vertex, so we can
-        // extract it directly as we're using FE_Q finite elements
-        // that have support at the vertices
-        vertical_tip_displacement = solution_n(cell->vertex_dof_index(v,u_dof+1));
-
-        // Sanity check using alternate method to extract the solution
-        // at the given point. To do this, we must create an FEValues instance
-        // to help us extract the solution value at the desired point
-        const MappingQ<dim> mapping (degree);
-        const Point<dim> qp_unit = mapping.transform_real_to_unit_cell(cell,soln_pt);
-        const Quadrature<dim> soln_qrule (qp_unit);
-        AssertThrow(soln_qrule.size() == 1, ExcInternalError());
-        FEValues<dim> fe_values_soln (fe, soln_qrule, update_values);
-        fe_values_soln.reinit(cell);
-
-        // Extract y-component of solution at given point
-        std::vector< Tensor<1,dim> > soln_values (soln_qrule.size());
-        fe_values_soln[u_fe].get_function_values(solution_n,
-                                                 soln_values);
-        vertical_tip_displacement_check = soln_values[0][u_dof+1];
-
-        break;
-      }
-    }
-    AssertThrow(vertical_tip_displacement > 0.0, ExcMessage("Found no cell with point inside!"))
+
+    const MappingQ<dim> mapping (degree);
+    const std::pair<typename DoFHandler<dim>::active_cell_iterator, Point<dim> > cell_point =
+      GridTools::find_active_cell_around_point(mapping, dof_handler_ref, soln_pt);
+    const Quadrature<dim> soln_qrule (GeometryInfo<dim>::project_to_unit_cell(cell_point.second));
+    AssertThrow(soln_qrule.size() == 1, ExcInternalError());
+    FEValues<dim> fe_values_soln (fe, soln_qrule, update_values);
+    fe_values_soln.reinit(cell_point.first);
+
+    // Extract y-component of solution at given point
+    std::vector< Tensor<1,dim> > soln_values (soln_qrule.size());
+    fe_values_soln[u_fe].get_function_values(solution_n,
+                                             soln_values);
+    const double vertical_tip_displacement_check = soln_values[0][u_dof+1];
 
     std::cout << "Vertical tip displacement: " << vertical_tip_displacement
               << "\t Check: " << vertical_tip_displacement_check
@@ -1129,6 +3228,16 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
   }
 
 
+// The DoF of the vertical displacement at the upper right corner of the beam
+// is used to monitor the load path, e.g. during arc-length continuation.
+  template <int dim,typename NumberType>
+  types::global_dof_index
+  Solid<dim,NumberType>::get_vertical_tip_dof() const
+  {
+    return get_cook_membrane_tip_dof(dof_handler_ref, parameters.scale);
+  }
+
+
 // @sect4{Solid::get_error_residual}
 
 // Determine the true residual error for the problem.  That is, determine the
@@ -1183,11 +3292,27 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
   template <int dim,typename NumberType>
   void Solid<dim,NumberType>::assemble_system()
   {
-    TimerOutput::Scope t (timer, "Assemble linear system");
     std::cout << " ASM " << std::flush;
 
-    tangent_matrix = 0.0;
+    assemble_system_matrix_based();
+  }
+
+
+
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::assemble_system_matrix_based()
+  {
+    TimerOutput::Scope t (timer, "Assemble linear system");
+
+    if (parameters.matrix_format == "BSR")
+      tangent_matrix_bsr = 0.0;
+    else if (parameters.matrix_format == "Symmetric")
+      tangent_matrix_symmetric = 0.0;
+    else
+      tangent_matrix = 0.0;
     system_rhs = 0.0;
+    vol_current = 0.0;
+    tangent_matrix_factorized = false;
 
     FullMatrix<double> cell_matrix(dofs_per_cell,dofs_per_cell);
     Vector<double> cell_rhs(dofs_per_cell);
@@ -1200,7 +3325,21 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
     std::vector<SymmetricTensor<2,dim,NumberType>> symm_grad_Nx(dofs_per_cell);
 
     FEValues<dim>      fe_values_ref(fe, qf_cell, update_gradients | update_JxW_values);
-    FEFaceValues<dim>  fe_face_values_ref(fe, qf_face, update_values | update_JxW_values);
+    FEFaceValues<dim>  fe_face_values_ref(fe, qf_face, update_values | update_quadrature_points | update_JxW_values);
+    std::vector<Tensor<1,dim,NumberType>> solution_values_u_face(qf_face.size());
+
+    // the temperature for the thermal expansion
+    FEValues<dim>      fe_values_temperature(fe_temperature, qf_cell, update_values);
+    std::vector<NumberType> temperature_values(qf_cell.size());
+
+    // the damage of the phase-field fracture
+    FEValues<dim>      fe_values_damage(fe_damage, qf_cell, update_values);
+    std::vector<NumberType> damage_values(qf_cell.size());
+
+    // For the mean dilatation formulation, the change of the current cell
+    // volume with each shape function:
+    const bool mean_dilatation = (parameters.volumetric_formulation == "F-bar");
+    Vector<double> cell_volume_change(dofs_per_cell);
 
     for (const auto &cell: dof_handler_ref.active_cell_iterators())
       if (cell->is_locally_owned())
@@ -1215,6 +3354,48 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
           // displacement gradient:
           fe_values_ref[u_fe].get_function_gradients(solution_total, solution_grads_u_total);
 
+          if (thermal_expansion)
+            {
+              const typename DoFHandler<dim>::active_cell_iterator
+              cell_temperature(&triangulation, cell->level(), cell->index(), &dof_handler_temperature);
+              fe_values_temperature.reinit(cell_temperature);
+              fe_values_temperature.get_function_values(temperature, temperature_values);
+            }
+
+          if (degradation)
+            {
+              const typename DoFHandler<dim>::active_cell_iterator
+              cell_damage(&triangulation, cell->level(), cell->index(), &dof_handler_damage);
+              fe_values_damage.reinit(cell_damage);
+              fe_values_damage.get_function_values(damage, damage_values);
+            }
+
+          // the ratio of current and reference cell volume
+          NumberType cell_volume = 0.0;
+          NumberType theta = 1.0;
+          if (mean_dilatation)
+            {
+              theta = 0.0;
+              for (unsigned int q_point = 0; q_point < n_q_points; ++q_point)
+                {
+                  cell_volume += fe_values_ref.JxW(q_point);
+                  theta += determinant(Physics::Elasticity::Kinematics::F(solution_grads_u_total[q_point]))
+                           * fe_values_ref.JxW(q_point);
+                }
+              theta /= cell_volume;
+              cell_volume_change = 0.;
+            }
+
+          Tensor<1,dim,NumberType> a_0[Material_HGO_Fibers<dim,NumberType>::max_fiber_families];
+          if (fiber_material)
+            for (unsigned int f = 0; f < fiber_directions->n_fiber_families(); ++f)
+              a_0[f] = fiber_directions->get_active_cell(cell->active_cell_index(), f);
+
+          // the stiffness of the cell in the topology optimization
+          const NumberType scaling = material_scaling ?
+                                     material_scaling->get_active_cell(cell->active_cell_index(), 0) :
+                                     NumberType(1.0);
+
           // Now we build the local cell stiffness matrix. Since the global and
           // local system matrices are symmetric, we can exploit this property by
           // building only the lower half of the local matrix and copying the values
@@ -1232,14 +3413,64 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
               const Tensor<2,dim,NumberType> F_inv = invert(F);
               Assert(det_F > NumberType(0.0), ExcInternalError());
 
+              vol_current += det_F * fe_values_ref.JxW(q_point);
+
+              // the volumetric response only sees the mechanical volume change
+              const NumberType det_F_M = thermal_expansion ?
+                                         thermal_expansion->get_det_F_mechanical(det_F,temperature_values[q_point]) :
+                                         det_F;
+
+              // the damage degrades the tensile part of the energy
+              NumberType mu_degraded = 1.0;
+              NumberType kappa_degraded = 1.0;
+              if (degradation)
+                degradation->degrade(det_F,damage_values[q_point],mu_degraded,kappa_degraded);
+
               for (unsigned int k = 0; k < dofs_per_cell; ++k)
                 {
                   grad_Nx[k] = fe_values_ref[u_fe].gradient(k, q_point) * F_inv;
                   symm_grad_Nx[k] = symmetrize(grad_Nx[k]);
                 }
 
+              // For the elastoplastic material the return mapping starts from
+              // the history of the last converged step and stores the updated
+              // history of the current iterate:
+              typename Material_J2_Plasticity<dim,NumberType>::State plastic_state;
+              typename Material_HGO_Fibers<dim,NumberType>::State    fiber_state;
               SymmetricTensor<2,dim,NumberType> tau;
-              material->get_tau(tau,det_F,b_bar);
+              if (plastic_material)
+                {
+                  typename Material_J2_Plasticity<dim,NumberType>::History history_old, history_new;
+                  material_history->read_old_active_cell(cell->active_cell_index(), q_point, history_old);
+                  plastic_material->return_mapping(plastic_state, history_new, F, history_old);
+                  material_history->write_current_active_cell(cell->active_cell_index(), q_point, history_new);
+                  tau = plastic_state.tau;
+                }
+              else
+                {
+                  if (mean_dilatation)
+                    material->get_tau_mean_dilatation(tau,det_F,b_bar,theta);
+                  else if (degradation)
+                    material->get_tau(tau,det_F_M,b_bar,mu_degraded,kappa_degraded);
+                  else
+                    material->get_tau(tau,det_F_M,b_bar);
+
+                  if (fiber_material)
+                    {
+                      fiber_material->evaluate(fiber_state,F_bar,a_0,fiber_directions->n_fiber_families());
+                      tau += fiber_state.tau;
+                    }
+
+                  tau *= scaling;
+
+                  // the viscous stress of the current time step
+                  if (material_history)
+                    {
+                      std::array<NumberType,Viscoelastic_Prony_Series<dim,NumberType>::n_stress_components> H;
+                      material_history->read_old_active_cell(cell->active_cell_index(), q_point, H);
+                      tau += Viscoelastic_Prony_Series<dim,NumberType>::get_tau_viscous(F,H.data());
+                    }
+                }
               const Tensor<2,dim,NumberType> tau_ns (tau);
               const double JxW = fe_values_ref.JxW(q_point);
 
@@ -1247,14 +3478,26 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
                 {
                   cell_rhs(i) -= (symm_grad_Nx[i] * tau) * JxW;
 
+                  if (mean_dilatation)
+                    cell_volume_change(i) += trace(symm_grad_Nx[i]) * det_F * JxW;
+
                   for (unsigned int j = 0; j <= i; ++j)
                     {
                       // This is the $\mathsf{\mathbf{k}}_{\mathbf{u} \mathbf{u}}$
                       // contribution. It comprises a material contribution, and a
                       // geometrical stress contribution which is only added along
                       // the local matrix diagonals:
-                      cell_matrix(i, j) += (symm_grad_Nx[i] * material->act_Jc(det_F,b_bar,symm_grad_Nx[j])) // The material contribution:
-                                            * JxW;
+                      cell_matrix(i, j) += scaling * (symm_grad_Nx[i] * (plastic_material ? // The material contribution:
+                                                                       plastic_material->act_Jc(plastic_state,symm_grad_Nx[j]) :
+                                                                       mean_dilatation ?
+                                                                       material->act_Jc_mean_dilatation(det_F,b_bar,theta,symm_grad_Nx[j]) :
+                                                                       degradation ?
+                                                                       material->act_Jc(det_F_M,b_bar,symm_grad_Nx[j],mu_degraded,kappa_degraded) :
+                                                                       material->act_Jc(det_F_M,b_bar,symm_grad_Nx[j])))
+                                                    * JxW;
+                      if (fiber_material)
+                        cell_matrix(i, j) += scaling * (symm_grad_Nx[i] * fiber_material->act_Jc(fiber_state,symm_grad_Nx[j]))
+                                                     * JxW;
                       // geometrical stress contribution
                       const Tensor<2, dim> geo = egeo_grad(grad_Nx[j],tau_ns);
                       cell_matrix(i, j) += double_contract<0,0,1,1>(grad_Nx[i],geo) * JxW;
@@ -1262,50 +3505,118 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
                 }
             }
 
+          // The pressure of the mean dilatation formulation changes with the
+          // cell volume, which couples all quadrature points of the cell:
+          if (mean_dilatation)
+            {
+              const NumberType pressure_modulus = material->get_d2Psi_vol_dJ2(theta) / cell_volume;
+              for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                for (unsigned int j = 0; j <= i; ++j)
+                  cell_matrix(i, j) += pressure_modulus * cell_volume_change(i) * cell_volume_change(j);
+            }
+
           // Finally, we need to copy the lower half of the local matrix into the
           // upper half:
           for (unsigned int i = 0; i < dofs_per_cell; ++i)
             for (unsigned int j = i + 1; j < dofs_per_cell; ++j)
               cell_matrix(i, j) = cell_matrix(j, i);
 
-          // Next we assemble the Neumann contribution. We first check to see it the
-          // cell face exists on a boundary on which a traction is applied and add
-          // the contribution if this is the case.
-          for (unsigned int face = 0; face < GeometryInfo<dim>::faces_per_cell; ++face)
-            if (cell->face(face)->at_boundary() == true && cell->face(face)->boundary_id() == 11)
-              {
-                fe_face_values_ref.reinit(cell, face);
-                for (unsigned int f_q_point = 0; f_q_point < n_q_points_f; ++f_q_point)
-                  {
-                    // We specify the traction in reference configuration.
-                    // For this problem, a defined total vertical force is applied
-                    // in the reference configuration.
-                    // The direction of the applied traction is assumed not to
-                    // evolve with the deformation of the domain.
-
-                    // Note that the contributions to the right hand side vector we
-                    // compute here only exist in the displacement components of the
-                    // vector.
-                    const double time_ramp = (time.current() / time.end());
-                    const double magnitude  = (1.0/(16.0*parameters.scale*1.0*parameters.scale))*time_ramp; // (Total force) / (RHS surface area)
-                    Tensor<1,dim> dir;
-                    dir[1] = 1.0;
-                    const Tensor<1, dim> traction  = magnitude*dir;
-
-                    for (unsigned int i = 0; i < dofs_per_cell; ++i)
-                      {
-                        const unsigned int component_i = fe.system_to_component_index(i).first;
-                        const double Ni = fe_face_values_ref.shape_value(i,f_q_point);
-                        const double JxW = fe_face_values_ref.JxW(f_q_point);
-                        cell_rhs(i) += (Ni * traction[component_i]) * JxW;
-                      }
-                  }
-              }
+          // The tangent of the penalty contact with the obstacle. The
+          // corresponding forces are added matrix-free below.
+          if (contact)
+            for (unsigned int face = 0; face < GeometryInfo<dim>::faces_per_cell; ++face)
+              if (cell->face(face)->at_boundary() == true &&
+                  cell->face(face)->boundary_id() == parameters.contact_boundary_id)
+                {
+                  fe_face_values_ref.reinit(cell, face);
+                  fe_face_values_ref[u_fe].get_function_values(solution_total, solution_values_u_face);
 
-          constraints.distribute_local_to_global(cell_matrix, cell_rhs,
-                                                 local_dof_indices,
-                                                 tangent_matrix, system_rhs);
+                  for (unsigned int f_q_point = 0; f_q_point < n_q_points_f; ++f_q_point)
+                    {
+                      const Point<dim,NumberType> x = fe_face_values_ref.quadrature_point(f_q_point)
+                                                      + solution_values_u_face[f_q_point];
+                      Tensor<1,dim,NumberType> normal;
+                      const NumberType g = obstacle->gap(x,normal);
+                      if (g >= 0)
+                        continue;
+
+                      const double JxW = fe_face_values_ref.JxW(f_q_point);
+                      for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                        {
+                          const Tensor<1,dim> N_i = fe_face_values_ref[u_fe].value(i,f_q_point);
+                          for (unsigned int j = 0; j < dofs_per_cell; ++j)
+                            {
+                              const Tensor<1,dim> N_j = fe_face_values_ref[u_fe].value(j,f_q_point);
+                              cell_matrix(i, j) += parameters.contact_penalty *
+                                                   ((normal * N_i) * (normal * N_j) +
+                                                    g * (N_i * obstacle->normal_derivative(x,N_j)))
+                                                   * JxW;
+                            }
+                        }
+                    }
+                }
+
+          if (parameters.matrix_format == "BSR")
+            constraints.distribute_local_to_global(cell_matrix, cell_rhs,
+                                                   local_dof_indices,
+                                                   tangent_matrix_bsr, system_rhs);
+          else if (parameters.matrix_format == "Symmetric")
+            constraints.distribute_local_to_global(cell_matrix, cell_rhs,
+                                                   local_dof_indices,
+                                                   tangent_matrix_symmetric, system_rhs);
+          else
+            constraints.distribute_local_to_global(cell_matrix, cell_rhs,
+                                                   local_dof_indices,
+                                                   tangent_matrix, system_rhs);
         }
+
+    // The contact forces are evaluated matrix-free on the face batches that
+    // are in contact:
+    if (contact)
+      contact->add_forces(system_rhs);
+
+    assemble_external_force();
+    system_rhs.add(load_factor, external_force);
+
+    if (parameters.matrix_format == "SELL")
+      tangent_matrix_sell.copy_from(tangent_matrix);
+  }
+
+
+// The right hand side vector of the matrix-free solver consists of the same
+// internal and external forces as in assemble_system(). The internal forces
+// are integrated in one sweep over the cell batches together with the
+// diagonal of the tangent for the Jacobi preconditioner, the current volume,
+// the strain energy and the reaction force, so that the deformation is read
+// from memory only once per Newton iteration.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::assemble_residual_matrix_free()
+  {
+    TimerOutput::Scope t (timer, "Assemble residual matrix-free");
+    std::cout << " ASM " << std::flush;
+
+    Assert (matrix_free_residual, ExcInternalError());
+
+    system_rhs = 0.0;
+    const typename NeoHookOperator<dim,degree,n_q_points_1d,double>::GlobalQuantities
+    global_quantities = mf_nh_operator.compute_diagonal_and_internal_forces(system_rhs);
+
+    vol_current = global_quantities.current_volume;
+    strain_energy = global_quantities.strain_energy;
+    reaction_force = global_quantities.reaction_force;
+
+    system_rhs *= -1.0;
+    assemble_external_force();
+    system_rhs.add(load_factor, external_force);
+  }
+
+
+// The traction on the right hand side of the beam, for a unit load factor.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::assemble_external_force()
+  {
+    assemble_cook_membrane_traction(dof_handler_ref, constraints, qf_face,
+                                    parameters.scale, external_force);
   }
 
 
@@ -1328,63 +3639,12 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
     if (it_nr > 1)
       return;
     constraints.clear();
-    const bool apply_dirichlet_bc = (it_nr == 0);
-
-    // The boundary conditions for the indentation problem are as follows: On
-    // the -x, -y and -z faces (ID's 0,2,4) we set up a symmetry condition to
-    // allow only planar movement while the +x and +y faces (ID's 1,3) are
-    // traction free. In this contrived problem, part of the +z face (ID 5) is
-    // set to have no motion in the x- and y-component. Finally, as described
-    // earlier, the other part of the +z face has an the applied pressure but
-    // is also constrained in the x- and y-directions.
-    //
-    // In the following, we will have to tell the function interpolation
-    // boundary values which components of the solution vector should be
-    // constrained (i.e., whether it's the x-, y-, z-displacements or
-    // combinations thereof). This is done using ComponentMask objects (see
-    // @ref GlossComponentMask) which we can get from the finite element if we
-    // provide it with an extractor object for the component we wish to
-    // select. To this end we first set up such extractor objects and later
-    // use it when generating the relevant component masks:
-
-    // Fixed left hand side of the beam
-    {
-      const int boundary_id = 1;
-
-      if (apply_dirichlet_bc == true)
-        VectorTools::interpolate_boundary_values(dof_handler_ref,
-                                                 boundary_id,
-                                                 ZeroFunction<dim>(n_components),
-                                                 constraints,
-                                                 fe.component_mask(u_fe));
-      else
-        VectorTools::interpolate_boundary_values(dof_handler_ref,
-                                                 boundary_id,
-                                                 ZeroFunction<dim>(n_components),
-                                                 constraints,
-                                                 fe.component_mask(u_fe));
-    }
-
-    // Zero Z-displacement through thickness direction
-    // This corresponds to a plane strain condition being imposed on the beam
-    if (dim == 3)
-    {
-      const int boundary_id = 2;
-      const FEValuesExtractors::Scalar z_displacement(2);
 
-      if (apply_dirichlet_bc == true)
-        VectorTools::interpolate_boundary_values(dof_handler_ref,
-                                                 boundary_id,
-                                                 ZeroFunction<dim>(n_components),
-                                                 constraints,
-                                                 fe.component_mask(z_displacement));
-      else
-        VectorTools::interpolate_boundary_values(dof_handler_ref,
-                                                 boundary_id,
-                                                 ZeroFunction<dim>(n_components),
-                                                 constraints,
-                                                 fe.component_mask(z_displacement));
-    }
+    // The boundary conditions are shared with the other drivers on the Cook
+    // membrane, see make_cook_membrane_constraints(). As the displacement is
+    // homogeneous on the Dirichlet boundary, the constraints of the first
+    // iteration and those of the updates are the same.
+    make_cook_membrane_constraints(dof_handler_ref, constraints);
 
     constraints.close();
   }
@@ -1394,7 +3654,8 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
 // for the linear problem is straight-forward.
   template <int dim,typename NumberType>
   std::pair<unsigned int, double>
-  Solid<dim,NumberType>::solve_linear_system(Vector<double> &newton_update)
+  Solid<dim,NumberType>::solve_linear_system(const Vector<double> &rhs,
+                                             Vector<double> &newton_update)
   {
     Vector<double> A(dof_handler_ref.n_dofs());
     Vector<double> B(dof_handler_ref.n_dofs());
@@ -1408,10 +3669,10 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
       std::cout << " SLV " << std::flush;
       if (parameters.type_lin == "CG" || parameters.type_lin == "MF_CG")
         {
-          const int solver_its = tangent_matrix.m()
+          const int solver_its = dof_handler_ref.n_dofs()
                                  * parameters.max_iterations_lin;
           const double tol_sol = parameters.tol_lin
-                                 * system_rhs.l2_norm();
+                                 * rhs.l2_norm();
 
           SolverControl solver_control(solver_its, tol_sol);
 
@@ -1424,17 +3685,103 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
               // provide the fastest solver convergence characteristics for this
               // problem on a single-thread machine.  However, for multicore
               // computing, the Jacobi preconditioner which is multithreaded may
-              // converge quicker for larger linear systems.
-              PreconditionSelector<SparseMatrix<double>, Vector<double> >
-              preconditioner (parameters.preconditioner_type,
-                              parameters.preconditioner_relaxation);
-              preconditioner.use_matrix(tangent_matrix);
-
-              solver_CG.solve(tangent_matrix,
-                              newton_update,
-                              system_rhs,
-                              preconditioner);
+              // converge quicker for larger linear systems, and the multicolor
+              // SSOR keeps most of the convergence of SSOR while sweeping the
+              // rows of each color in parallel.
+              if (parameters.preconditioner_type == "mc_ssor")
+                {
+                  mc_ssor.initialize(tangent_matrix,
+                                     parameters.preconditioner_relaxation);
+
+                  if (parameters.matrix_format == "SELL")
+                    solver_CG.solve(tangent_matrix_sell,
+                                    newton_update,
+                                    rhs,
+                                    mc_ssor);
+                  else
+                    solver_CG.solve(tangent_matrix,
+                                    newton_update,
+                                    rhs,
+                                    mc_ssor);
+                }
+#ifdef DEAL_II_WITH_TRILINOS
+              else if (parameters.preconditioner_type == "amg")
+                {
+                  const bool setup = !amg_preconditioner.is_initialized() ||
+                                     amg_last_lin_it > parameters.amg_rebuild_ratio * amg_setup_lin_it;
+                  if (setup)
+                    amg_preconditioner.initialize(tangent_matrix);
+
+                  if (parameters.matrix_format == "SELL")
+                    solver_CG.solve(tangent_matrix_sell,
+                                    newton_update,
+                                    rhs,
+                                    amg_preconditioner);
+                  else
+                    solver_CG.solve(tangent_matrix,
+                                    newton_update,
+                                    rhs,
+                                    amg_preconditioner);
+
+                  amg_last_lin_it = solver_control.last_step();
+                  if (setup)
+                    amg_setup_lin_it = amg_last_lin_it;
+                }
+#endif
+              else if (parameters.matrix_format == "BSR")
+                {
+                  PreconditionSelector<BSRMatrix<dim,double>, Vector<double> >
+                  preconditioner (parameters.preconditioner_type,
+                                  parameters.preconditioner_relaxation);
+                  preconditioner.use_matrix(tangent_matrix_bsr);
+
+                  solver_CG.solve(tangent_matrix_bsr,
+                                  newton_update,
+                                  rhs,
+                                  preconditioner);
+                }
+              else if (parameters.matrix_format == "Symmetric")
+                {
+                  PreconditionSelector<SymmetricSparseMatrix<double>, Vector<double> >
+                  preconditioner (parameters.preconditioner_type,
+                                  parameters.preconditioner_relaxation);
+                  preconditioner.use_matrix(tangent_matrix_symmetric);
+
+                  solver_CG.solve(tangent_matrix_symmetric,
+                                  newton_update,
+                                  rhs,
+                                  preconditioner);
+                }
+              else if (parameters.matrix_format == "SELL")
+                {
+                  PreconditionSelector<SparseMatrix<double>, Vector<double> >
+                  preconditioner (parameters.preconditioner_type,
+                                  parameters.preconditioner_relaxation);
+                  preconditioner.use_matrix(tangent_matrix);
+
+                  solver_CG.solve(tangent_matrix_sell,
+                                  newton_update,
+                                  rhs,
+                                  preconditioner);
+                }
+              else
+                {
+                  PreconditionSelector<SparseMatrix<double>, Vector<double> >
+                  preconditioner (parameters.preconditioner_type,
+                                  parameters.preconditioner_relaxation);
+                  preconditioner.use_matrix(tangent_matrix);
+
+                  solver_CG.solve(tangent_matrix,
+                                  newton_update,
+                                  rhs,
+                                  preconditioner);
+                }
             }
+          else if (parameters.preconditioner_type == "linear_elastic")
+            solver_CG.solve(mf_nh_operator,
+                            newton_update,
+                            rhs,
+                            le_preconditioner);
           else
             {
               AssertThrow(parameters.preconditioner_type == "jacobi",
@@ -1444,7 +3791,7 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
 
               solver_CG.solve(mf_nh_operator,
                 newton_update,
-                system_rhs,
+                rhs,
                 preconditioner);
             }
 
@@ -1455,10 +3802,29 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
         {
           // Otherwise if the problem is small
           // enough, a direct solver can be
-          // utilised.
-          SparseDirectUMFPACK A_direct;
-          A_direct.initialize(tangent_matrix);
-          A_direct.vmult(newton_update, system_rhs);
+          // utilised. The factorization is kept
+          // until the tangent matrix is assembled
+          // again.
+          if (tangent_matrix_factorized == false)
+            {
+              // UMFPACK needs a full scalar matrix, which is a temporary copy
+              // for the block and the symmetric format
+              if (parameters.matrix_format == "BSR" ||
+                  parameters.matrix_format == "Symmetric")
+                {
+                  SparsityPattern      sparsity_scalar;
+                  SparseMatrix<double> tangent_matrix_scalar;
+                  if (parameters.matrix_format == "BSR")
+                    tangent_matrix_bsr.copy_to(sparsity_scalar, tangent_matrix_scalar);
+                  else
+                    tangent_matrix_symmetric.copy_to(sparsity_scalar, tangent_matrix_scalar);
+                  tangent_matrix_direct.initialize(tangent_matrix_scalar);
+                }
+              else
+                tangent_matrix_direct.initialize(tangent_matrix);
+              tangent_matrix_factorized = true;
+            }
+          tangent_matrix_direct.vmult(newton_update, rhs);
 
           lin_it = 1;
           lin_res = 0.0;
@@ -1476,6 +3842,491 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
     return std::make_pair(lin_it, lin_res);
   }
 
+// @sect4{Solid::solve_heat_equation}
+// The heat equation is linear in the temperature for a given deformation, so
+// a single CG solve per call is sufficient. The Dirichlet values are imposed
+// on the temperature first and the residual of this guess is then corrected
+// with homogeneous constraints. The matrix-free data of the last Newton
+// iteration, whose second field is the temperature, is reused.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::solve_heat_equation()
+  {
+    TimerOutput::Scope t (timer, "Solve heat equation");
+    std::cout << " Heat equation: " << std::flush;
+
+    const double boundary_temperature = parameters.reference_temperature +
+                                        load_factor * (parameters.boundary_temperature -
+                                                       parameters.reference_temperature);
+    std::map<types::global_dof_index,double> boundary_values;
+    VectorTools::interpolate_boundary_values(dof_handler_temperature,
+                                             1,
+                                             ConstantFunction<dim>(boundary_temperature),
+                                             boundary_values);
+    for (const auto &boundary_value : boundary_values)
+      temperature(boundary_value.first) = boundary_value.second;
+
+    Vector<double> rhs(dof_handler_temperature.n_dofs());
+    Vector<double> temperature_update(dof_handler_temperature.n_dofs());
+    mf_heat_operator.compute_rhs(rhs, temperature_n, temperature);
+    mf_heat_operator.compute_diagonal();
+
+    const int solver_its = dof_handler_temperature.n_dofs()
+                           * parameters.max_iterations_lin;
+    SolverControl solver_control(solver_its, parameters.tol_lin * rhs.l2_norm());
+    SolverCG<Vector<double> > solver_CG(solver_control);
+
+    PreconditionJacobi<HeatOperator<dim,degree,n_q_points_1d,double>> preconditioner;
+    preconditioner.initialize (mf_heat_operator);
+
+    solver_CG.solve(mf_heat_operator, temperature_update, rhs, preconditioner);
+    constraints_temperature.distribute(temperature_update);
+    temperature += temperature_update;
+
+    std::cout << solver_control.last_step() << " CG iterations, temperature in ["
+              << *std::min_element(temperature.begin(), temperature.end()) << ", "
+              << *std::max_element(temperature.begin(), temperature.end()) << "]"
+              << std::endl;
+  }
+
+// @sect4{Solid::solve_phase_field}
+// The crack driving force is first updated for the current displacement
+// from its value at the last load step, which keeps the damage from healing.
+// For the fixed crack driving force the damage problem is linear and
+// symmetric positive definite, so a single CG solve starting from the last
+// damage suffices. As for the heat equation, the matrix-free data of the last
+// Newton iteration is reused.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::solve_phase_field()
+  {
+    TimerOutput::Scope t (timer, "Solve phase field");
+    std::cout << " Phase field: " << std::flush;
+
+    mf_damage_operator.update_crack_driving_force(*material_vec);
+
+    Vector<double> rhs(dof_handler_damage.n_dofs());
+    mf_damage_operator.compute_rhs(rhs);
+    mf_damage_operator.compute_diagonal();
+
+    const int solver_its = dof_handler_damage.n_dofs()
+                           * parameters.max_iterations_lin;
+    SolverControl solver_control(solver_its, parameters.tol_lin * rhs.l2_norm());
+    SolverCG<Vector<double> > solver_CG(solver_control);
+
+    PreconditionJacobi<DamageOperator<dim,degree,n_q_points_1d,double>> preconditioner;
+    preconditioner.initialize (mf_damage_operator);
+
+    // Without any tensile energy the body stays intact:
+    if (rhs.l2_norm() > 0.0)
+      solver_CG.solve(mf_damage_operator, damage, rhs, preconditioner);
+    constraints_damage.distribute(damage);
+
+    std::cout << solver_control.last_step() << " CG iterations, maximum damage "
+              << damage.linfty_norm() << std::endl;
+  }
+
+// @sect4{Solid::accelerate_staggered_update}
+// The staggered scheme is a fixed-point iteration for the temperature or the
+// damage, whose updates are accelerated like the Newton updates. The
+// accelerated field still satisfies the Dirichlet values of the time step,
+// which all updates but the first keep unchanged.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::accelerate_staggered_update(const Vector<double> &previous,
+                                                          Vector<double>       &current)
+  {
+    Vector<double> update(current);
+    update -= previous;
+    anderson_staggered.apply(previous, update);
+
+    current = previous;
+    current += update;
+  }
+
+// @sect4{Solid::postprocess_converged_step}
+// At convergence the last Newton iteration has assembled the tangent and set
+// up the matrix-free operator around the converged solution, which is reused
+// by the following postprocessing steps.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::postprocess_converged_step()
+  {
+    if (parameters.eigenvalue_problem != "None" &&
+        std::find(parameters.eigenvalue_steps.begin(),
+                  parameters.eigenvalue_steps.end(),
+                  time.get_timestep()) != parameters.eigenvalue_steps.end())
+      compute_eigenvalues();
+
+    if (parameters.adjoint_sensitivities)
+      compute_adjoint_sensitivities();
+  }
+
+// @sect4{Solid::commit_history}
+// History variables are only accepted once a step has converged, and after
+// the postprocessing which needs the linearization around the last step.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::commit_history()
+  {
+    // the crack driving force only grows
+    if (crack_driving_force)
+      crack_driving_force->commit();
+
+    if (!material_history)
+      return;
+
+    if (viscous_material_vec)
+      update_internal_variables();
+
+    material_history->commit();
+  }
+
+// @sect4{Solid::update_internal_variables}
+// The internal variables of the viscoelastic material are advanced in a
+// matrix-free loop over the cell batches using the converged displacement,
+// so that all lanes of a batch are updated at once.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::update_internal_variables()
+  {
+    TimerOutput::Scope t (timer, "Update internal variables");
+
+    FEEvaluation<dim,degree,n_q_points_1d,dim,double> phi(*mf_data_reference);
+
+    const unsigned int n_variables = material_history->n_variables();
+    AlignedVector<VectorizedArray<double>> history_old(n_variables), history_new(n_variables);
+
+    for (unsigned int cell=0; cell<mf_data_reference->n_macro_cells(); ++cell)
+      {
+        phi.reinit(cell);
+        phi.read_dof_values_plain(solution_n);
+        phi.evaluate (false,true,false);
+
+        for (unsigned int q=0; q<phi.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<double>> F =
+              Physics::Elasticity::Kinematics::F(phi.get_gradient(q));
+
+            for (unsigned int v=0; v<n_variables; ++v)
+              history_old[v] = material_history->old_value(v,cell,q);
+
+            viscous_material_vec->update_internal_variables(F, history_old.begin(), history_new.begin());
+
+            for (unsigned int v=0; v<n_variables; ++v)
+              material_history->current_value(v,cell,q) = history_new[v];
+          }
+      }
+  }
+
+// @sect4{Solid::get_fiber_direction}
+// The fibers follow the local axis of the beam, which we take as the first
+// edge of each cell since the mesh is a mapped rectangle whose x-direction
+// runs along the beam. The families are rotated in the x-y plane by plus and
+// minus the fiber angle.
+  template <int dim,typename NumberType>
+  Tensor<1,dim>
+  Solid<dim,NumberType>::get_fiber_direction(const typename DoFHandler<dim>::cell_iterator &cell,
+                                             const unsigned int                             family) const
+  {
+    const Tensor<1,dim> axis = cell->vertex(1) - cell->vertex(0);
+    const double angle = (family == 0 ? 1.0 : -1.0) * parameters.fiber_angle * numbers::PI / 180.0;
+
+    Tensor<1,dim> a = axis;
+    a[0] = std::cos(angle) * axis[0] - std::sin(angle) * axis[1];
+    a[1] = std::sin(angle) * axis[0] + std::cos(angle) * axis[1];
+    return a / a.norm();
+  }
+
+// @sect4{Solid::get_isochoric_scaling}
+  template <int dim,typename NumberType>
+  double Solid<dim,NumberType>::get_isochoric_scaling(const Parameters::AllParameters &parameters)
+  {
+    if (parameters.material_model != "Viscoelastic")
+      return 1.0;
+
+    return Viscoelastic_Prony_Series<dim,NumberType>::isochoric_scaling(parameters.prony_stiffnesses,
+                                                                         parameters.prony_relaxation_times,
+                                                                         parameters.delta_t);
+  }
+
+// @sect4{Solid::compute_adjoint_sensitivities}
+// Equilibrium $\mathbf{f}_{\textrm{int}}(\mathbf{u}, p) =
+// \mathbf{f}_{\textrm{ext}}$ gives $\frac{d \mathbf{u}}{d p} =
+// -\mathbf{K}^{-1} \frac{\partial \mathbf{f}_{\textrm{int}}}{\partial p}$.
+// For the tip displacement $u_{\textrm{tip}} = \mathbf{e}^T \mathbf{u}$ we
+// therefore solve the adjoint problem $\mathbf{K}^T \boldsymbol{\lambda} =
+// \mathbf{e}$ once, which is the same linear system as in the Newton scheme
+// since the tangent is symmetric, and obtain $\frac{d u_{\textrm{tip}}}{d p}
+// = -\boldsymbol{\lambda}^T \frac{\partial \mathbf{f}_{\textrm{int}}}{\partial p}$
+// for any number of parameters. The last term is integrated matrix-free cell
+// by cell, which also gives the contribution of every cell to the total
+// sensitivity.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::compute_adjoint_sensitivities()
+  {
+    TimerOutput::Scope t (timer, "Adjoint sensitivities");
+
+    Vector<double> adjoint_rhs(dof_handler_ref.n_dofs());
+    Vector<double> adjoint(dof_handler_ref.n_dofs());
+    adjoint_rhs(get_vertical_tip_dof()) = 1.0;
+
+    std::cout << "Adjoint:" << std::flush;
+    const std::pair<unsigned int, double>
+    lin_solver_output = solve_linear_system(adjoint_rhs, adjoint);
+
+    mf_nh_operator.compute_parameter_sensitivities(adjoint,
+                                                   cell_sensitivity_mu,
+                                                   cell_sensitivity_nu);
+
+    const std::pair<double,double> sensitivities = get_parameter_sensitivities();
+    std::cout << " | " << lin_solver_output.first << " iterations" << std::endl
+              << "d(tip displacement)/d(mu): " << sensitivities.first << std::endl
+              << "d(tip displacement)/d(nu): " << sensitivities.second << std::endl;
+  }
+
+// @sect4{Solid::run_topology_optimization}
+// The first design is loaded incrementally as in the usual analysis. Since a
+// design changes little from one update to the next, every further design is
+// loaded in a single step that starts from the converged displacement of the
+// previous one. The index data of the matrix-free operator is reused
+// throughout, only the stiffness per cell batch changes.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::run_topology_optimization()
+  {
+    while (time.current() <= time.end())
+      {
+        solution_delta = 0.0;
+        load_factor = time.load_factor();
+        solve_nonlinear_timestep();
+        solution_n += solution_delta;
+        time.increment();
+      }
+
+    for (unsigned int design_iteration = 0;
+         design_iteration < parameters.optimization_iterations;
+         ++design_iteration)
+      {
+        if (design_iteration > 0)
+          {
+            solution_delta = 0.0;
+            solve_nonlinear_timestep();
+            solution_n += solution_delta;
+          }
+
+        const double compliance = compute_compliance_sensitivities();
+        output_results();
+        time.increment();
+
+        const double change = update_density();
+        update_material_scaling();
+
+        std::cout << "Design iteration " << design_iteration
+                  << ": compliance " << compliance
+                  << ", maximum density change " << change << std::endl;
+
+        if (change < parameters.design_tolerance)
+          break;
+      }
+  }
+
+// @sect4{Solid::compute_compliance_sensitivities}
+// The compliance $c = \mathbf{f}_{\textrm{ext}}^T \mathbf{u}$ of the
+// nonlinear problem needs the adjoint solution $\mathbf{K}^T
+// \boldsymbol{\lambda} = \mathbf{f}_{\textrm{ext}}$, which is the
+// displacement itself only in the linear case. As the internal forces of a
+// cell are linear in its stiffness $s_e$, we get $\frac{dc}{d\rho_e} =
+// -s'(\rho_e) \boldsymbol{\lambda}^T \frac{\partial
+// \mathbf{f}_{\textrm{int}}}{\partial s_e}$. The last term is integrated
+// matrix-free for all lanes of a cell batch at once.
+  template <int dim,typename NumberType>
+  double Solid<dim,NumberType>::compute_compliance_sensitivities()
+  {
+    TimerOutput::Scope t (timer, "Compliance sensitivities");
+
+    Vector<double> adjoint_rhs(external_force);
+    Vector<double> adjoint(dof_handler_ref.n_dofs());
+    adjoint_rhs *= load_factor;
+
+    const double compliance = get_compliance();
+
+    std::cout << "Adjoint:" << std::flush;
+    const std::pair<unsigned int, double>
+    lin_solver_output = solve_linear_system(adjoint_rhs, adjoint);
+    std::cout << " | " << lin_solver_output.first << " iterations" << std::endl;
+
+    mf_nh_operator.compute_scaling_sensitivities(adjoint, cell_sensitivity_density);
+
+    const double p = parameters.penalization_exponent;
+    for (unsigned int i = 0; i < density.size(); ++i)
+      cell_sensitivity_density(i) *= (1.0 - parameters.minimum_stiffness) * p
+                                     * std::pow(density(i), p - 1.0);
+
+    return compliance;
+  }
+
+// @sect4{Solid::setup_density_filter}
+// The sensitivities are smoothed with the filter of Sigmund (1997) against
+// checkerboards and mesh dependence. It weights the cells $f$ within the
+// filter radius $r$ of cell $e$ with $w_{ef} = r - |\mathbf{x}_e -
+// \mathbf{x}_f|$. The neighbours are found once, see
+// find_cells_within_radius().
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::setup_density_filter()
+  {
+    const double radius = parameters.filter_radius * 48.0 * parameters.scale
+                          / parameters.elements_per_edge;
+
+    density_filter = find_cells_within_radius(triangulation, radius);
+    for (auto &neighbors : density_filter)
+      for (auto &neighbor : neighbors)
+        neighbor.second = radius - neighbor.second;
+  }
+
+// @sect4{Solid::update_density}
+// The filtered sensitivities $\widehat{\frac{dc}{d\rho_e}} = \frac{\sum_f
+// w_{ef} \rho_f \frac{dc}{d\rho_f}}{\rho_e \sum_f w_{ef}}$ give the
+// optimality criteria update $\rho_e^{\textrm{new}} = \rho_e \sqrt{-
+// \widehat{\frac{dc}{d\rho_e}} / (\Lambda V_e)}$, which is restricted by the
+// move limit and the bounds $0 \leq \rho_e \leq 1$. The Lagrange multiplier
+// $\Lambda$ of the volume constraint is found by bisection.
+  template <int dim,typename NumberType>
+  double Solid<dim,NumberType>::update_density()
+  {
+    const unsigned int n_cells = density.size();
+
+    Vector<double> cell_volume(n_cells);
+    for (const auto &cell : triangulation.active_cell_iterators())
+      cell_volume(cell->active_cell_index()) = cell->measure();
+    const double target_volume = parameters.volume_fraction * cell_volume.l1_norm();
+
+    Vector<double> filtered_sensitivity(n_cells);
+    double lambda_max = 0.0;
+    for (unsigned int e = 0; e < n_cells; ++e)
+      {
+        double weighted_sensitivity = 0.0, weight = 0.0;
+        for (const auto &neighbor : density_filter[e])
+          {
+            weighted_sensitivity += neighbor.second * density(neighbor.first)
+                                    * cell_sensitivity_density(neighbor.first);
+            weight += neighbor.second;
+          }
+        filtered_sensitivity(e) = weighted_sensitivity / (std::max(density(e), 1e-3) * weight);
+        lambda_max = std::max(lambda_max, -filtered_sensitivity(e) / cell_volume(e));
+      }
+    AssertThrow(lambda_max > 0.0,
+                ExcMessage("Adding material does not decrease the compliance anywhere"));
+
+    // For this multiplier all densities decrease to at most a hundredth,
+    // which brackets the volume constraint for any volume fraction above
+    // that:
+    lambda_max *= 1e4;
+    double lambda_min = 0.0;
+
+    Vector<double> density_new(n_cells);
+    while (lambda_max - lambda_min > 1e-4 * (lambda_max + lambda_min))
+      {
+        const double lambda = 0.5 * (lambda_min + lambda_max);
+        for (unsigned int e = 0; e < n_cells; ++e)
+          {
+            const double B = std::max(0.0, -filtered_sensitivity(e) / (lambda * cell_volume(e)));
+            density_new(e) = std::max(std::max(0.0, density(e) - parameters.move_limit),
+                                      std::min(std::min(1.0, density(e) + parameters.move_limit),
+                                               density(e) * std::sqrt(B)));
+          }
+
+        if (density_new * cell_volume > target_volume)
+          lambda_min = lambda;
+        else
+          lambda_max = lambda;
+      }
+
+    double change = 0.0;
+    for (unsigned int e = 0; e < n_cells; ++e)
+      change = std::max(change, std::abs(density_new(e) - density(e)));
+    density = density_new;
+
+    return change;
+  }
+
+// @sect4{Solid::update_material_scaling}
+// The stiffness follows from the density by the SIMP interpolation.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::update_material_scaling()
+  {
+    Vector<double> stiffness(density.size());
+    for (unsigned int i = 0; i < density.size(); ++i)
+      stiffness(i) = parameters.minimum_stiffness + (1.0 - parameters.minimum_stiffness)
+                     * std::pow(density(i), parameters.penalization_exponent);
+
+    material_scaling->set(0, stiffness);
+  }
+
+// @sect4{Solid::compute_eigenvalues}
+// After convergence of a load step, the matrix-free operator is still
+// linearized around the converged solution, so that we can directly compute
+// its lowest eigenvalues. A negative eigenvalue of the tangent indicates that
+// the equilibrium is unstable. The eigenvalues and the modes are written to
+// files for the current load step.
+  template <int dim,typename NumberType>
+  void Solid<dim,NumberType>::compute_eigenvalues()
+  {
+    TimerOutput::Scope t (timer, "Eigensolver");
+
+    std::vector<double> eigenvalues, residuals;
+    std::vector<Vector<double>> modes(parameters.n_eigenvalues,
+                                      Vector<double>(dof_handler_ref.n_dofs()));
+
+    LOBPCGEigensolver::AdditionalData data(parameters.max_iterations_eigen,
+                                           parameters.tol_eigen);
+    LOBPCGEigensolver eigensolver(data);
+
+    PreconditionJacobi<NeoHookOperator<dim,degree,n_q_points_1d,double>> preconditioner;
+    preconditioner.initialize (mf_nh_operator, 1.0);
+
+    unsigned int n_iterations = 0;
+    if (parameters.eigenvalue_problem == "Modal")
+      {
+        mf_mass_operator.initialize(mf_data_reference, parameters.density);
+        n_iterations = eigensolver.solve(mf_nh_operator, mf_mass_operator, preconditioner,
+                                         constraints, eigenvalues, modes, residuals);
+      }
+    else
+      n_iterations = eigensolver.solve(mf_nh_operator, IdentityMatrix(dof_handler_ref.n_dofs()),
+                                       preconditioner, constraints, eigenvalues, modes, residuals);
+
+    std::cout << "Eigenvalues (" << n_iterations << " iterations):";
+    for (unsigned int i = 0; i < eigenvalues.size(); ++i)
+      std::cout << " " << eigenvalues[i];
+    std::cout << std::endl;
+
+    {
+      std::ostringstream filename;
+      filename << "eigenvalues-" << time.get_timestep() << ".txt";
+      std::ofstream output(filename.str().c_str());
+      output << "# eigenvalue residual" << std::endl
+             << std::scientific << std::setprecision(10);
+      for (unsigned int i = 0; i < eigenvalues.size(); ++i)
+        output << eigenvalues[i] << " " << residuals[i] << std::endl;
+    }
+
+    {
+      DataOut<dim> data_out;
+      std::vector<DataComponentInterpretation::DataComponentInterpretation>
+      data_component_interpretation(dim,
+                                    DataComponentInterpretation::component_is_part_of_vector);
+
+      data_out.attach_dof_handler(dof_handler_ref);
+      for (unsigned int i = 0; i < modes.size(); ++i)
+        data_out.add_data_vector(modes[i],
+                                 std::vector<std::string>(dim, "mode_" + Utilities::int_to_string(i)),
+                                 DataOut<dim>::type_dof_data,
+                                 data_component_interpretation);
+
+      MappingQEulerian<dim> q_mapping(degree, dof_handler_ref, solution_n);
+      data_out.build_patches(q_mapping, degree);
+
+      std::ostringstream filename;
+      filename << "eigenmodes-" << time.get_timestep() << ".vtk";
+      std::ofstream output(filename.str().c_str());
+      data_out.write_vtk(output);
+    }
+  }
+
 // @sect4{Solid::output_results}
 // Here we present how the results are written to file to be viewed
 // using ParaView or Visit. The method is similar to that shown in the
@@ -1496,6 +4347,39 @@ Point<dim> grid_y_transform (const Point<dim> &pt_in)
                              DataOut<dim>::type_dof_data,
                              data_component_interpretation);
 
+    if (thermal_expansion)
+      data_out.add_data_vector(dof_handler_temperature, temperature_n, "temperature");
+
+    if (degradation)
+      data_out.add_data_vector(dof_handler_damage, damage, "damage");
+
+    if (material_scaling)
+      {
+        data_out.add_data_vector(density, "density",
+                                 DataOut<dim>::type_cell_data);
+        data_out.add_data_vector(cell_sensitivity_density, "sensitivity_density",
+                                 DataOut<dim>::type_cell_data);
+      }
+
+    if (parameters.adjoint_sensitivities)
+      {
+        data_out.add_data_vector(cell_sensitivity_mu, "sensitivity_mu",
+                                 DataOut<dim>::type_cell_data);
+        data_out.add_data_vector(cell_sensitivity_nu, "sensitivity_nu",
+                                 DataOut<dim>::type_cell_data);
+      }
+
+    // The history is only set up together with the matrix-free data in the
+    // first Newton iteration:
+    Vector<double> equivalent_plastic_strain;
+    if (plastic_material && material_history->n_variables() > 0)
+      {
+        material_history->get_cell_averages(Material_J2_Plasticity<dim,NumberType>::alpha_index,
+                                            equivalent_plastic_strain);
+        data_out.add_data_vector(equivalent_plastic_strain, "equivalent_plastic_strain",
+                                 DataOut<dim>::type_cell_data);
+      }
+
     // Since we are dealing with a large deformation problem, it would be nice
     // to display the result on a displaced grid!  The MappingQEulerian class
     // linked with the DataOut class provides an interface through which this
@@ -0,0 +1,573 @@
+#pragma once
+
+#include <deal.II/base/timer.h>
+
+#include <deal.II/grid/intergrid_map.h>
+
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+
+#include <mf_elasticity.h>
+
+#include <iomanip>
+#include <memory>
+
+namespace Cook_Membrane
+{
+  using namespace dealii;
+
+// @sect3{The <code>FullApproximationScheme</code> class}
+
+// Nonlinear multigrid for the Cook membrane with the full approximation
+// scheme (FAS). Instead of linearizing the problem on the finest level and
+// solving the linear systems by an iterative solver, the nonlinear residual
+// $\mathbf{f}_\ell - \mathbf{A}_\ell(\mathbf{u}_\ell)$ is smoothed on every
+// level by damped Newton-Jacobi sweeps
+// $\mathbf{u}_\ell \leftarrow \mathbf{u}_\ell + \omega
+// \mathbf{D}_\ell^{-1}(\mathbf{u}_\ell) (\mathbf{f}_\ell -
+// \mathbf{A}_\ell(\mathbf{u}_\ell))$ with the diagonal $\mathbf{D}_\ell$ of
+// the tangent. The coarse problem of a V-cycle is
+// $\mathbf{A}_{\ell-1}(\mathbf{u}_{\ell-1}) = \mathbf{A}_{\ell-1}(\hat
+// \mathbf{u}_{\ell-1}) + \mathbf{P}^T (\mathbf{f}_\ell -
+// \mathbf{A}_\ell(\mathbf{u}_\ell))$ for the injected state $\hat
+// \mathbf{u}_{\ell-1}$, and its change $\mathbf{u}_{\ell-1} - \hat
+// \mathbf{u}_{\ell-1}$ is prolongated as the correction. The coarsest level
+// is solved by the matrix-free Newton-CG scheme.
+//
+// The levels are separate triangulations of the Cook membrane, refined
+// globally from the same coarse mesh, so that the prolongation follows from
+// the embedding matrices of the finite element. The internal forces, the
+// diagonal and the tangent of each level are evaluated by its own
+// NeoHookOperator, so that no matrix except for the prolongation is stored.
+  template <int dim,typename NumberType>
+  class FullApproximationScheme
+  {
+  public:
+    static constexpr int degree = 1;
+    static constexpr int n_q_points_1d = 2;
+
+    FullApproximationScheme(const Parameters::AllParameters &parameters);
+
+    virtual
+    ~FullApproximationScheme();
+
+    void
+    run();
+
+    // The vertical tip displacement of the finest level after the last
+    // solve, by which the tests compare the scheme with Newton's method:
+    double
+    get_vertical_tip_displacement() const;
+
+  private:
+
+    // The mesh, the displacement and the operator of one level. The
+    // prolongation maps from the next coarser level:
+    struct Level
+    {
+      Level();
+
+      ~Level();
+
+      Triangulation<dim>                                    triangulation;
+      DoFHandler<dim>                                       dof_handler;
+      ConstraintMatrix                                      constraints;
+      Vector<double>                                        displacement;
+      std::shared_ptr<MappingQEulerian<dim,Vector<double>>> eulerian_mapping;
+      std::shared_ptr<MatrixFree<dim,double>>               mf_data_current;
+      std::shared_ptr<MatrixFree<dim,double>>               mf_data_reference;
+      NeoHookOperator<dim,degree,n_q_points_1d,double>      mf_nh_operator;
+
+      SparsityPattern                                       prolongation_sparsity;
+      SparseMatrix<double>                                  prolongation;
+    };
+
+    void
+    make_grid();
+
+    void
+    system_setup();
+
+    void
+    setup_prolongation(const unsigned int level);
+
+    // V-cycles until the residual of the finest level drops below the
+    // tolerance. Returns the number of cycles:
+    unsigned int
+    solve_fas(const double load_factor);
+
+    void
+    v_cycle(const unsigned int    level,
+            const Vector<double> &rhs);
+
+    void
+    smooth(const unsigned int    level,
+           const Vector<double> &rhs);
+
+    // Newton's method for $\mathbf{A}_\ell(\mathbf{u}_\ell) = \mathbf{f}$ on
+    // the given level until the residual drops below @p tolerance. Returns
+    // the number of Newton iterations:
+    unsigned int
+    solve_newton(const unsigned int    level,
+                 const Vector<double> &rhs,
+                 const double          tolerance);
+
+    double
+    compute_residual(const unsigned int    level,
+                     const Vector<double> &rhs,
+                     Vector<double>       &residual) const;
+
+    void
+    update_current_configuration(const unsigned int level);
+
+    const Parameters::AllParameters &parameters;
+
+    const FESystem<dim>                 fe;
+    std::vector<std::unique_ptr<Level>> levels;
+
+    // The external force of the finest level for a unit load factor and the
+    // DoF of the vertical displacement at the tip:
+    Vector<double>                      external_force;
+    types::global_dof_index             tip_dof;
+
+    std::shared_ptr<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>> material_vec;
+  };
+
+// @sect3{Implementation of the <code>FullApproximationScheme</code> class}
+
+  template <int dim,typename NumberType>
+  FullApproximationScheme<dim,NumberType>::Level::Level()
+    :
+    dof_handler(triangulation)
+  {}
+
+  template <int dim,typename NumberType>
+  FullApproximationScheme<dim,NumberType>::Level::~Level()
+  {
+    mf_nh_operator.clear();
+    mf_data_current.reset();
+    mf_data_reference.reset();
+    eulerian_mapping.reset();
+    dof_handler.clear();
+  }
+
+  template <int dim,typename NumberType>
+  FullApproximationScheme<dim,NumberType>::FullApproximationScheme(const Parameters::AllParameters &parameters)
+    :
+    parameters(parameters),
+    fe(FE_Q<dim>(degree), dim),
+    tip_dof(numbers::invalid_dof_index),
+    material_vec(std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>>(
+      parameters.mu,parameters.nu))
+  {
+    AssertThrow(parameters.material_model == "Neo-Hooke" &&
+                parameters.volumetric_formulation == "Standard" &&
+                parameters.type_continuation != "Arc-length" &&
+                parameters.obstacle == "None" &&
+                parameters.thermal_coupling == false &&
+                parameters.phase_field_fracture == false,
+                ExcNotImplemented());
+
+    const unsigned int coarsening = 1u << (parameters.fas_levels - 1);
+    AssertThrow(parameters.elements_per_edge % coarsening == 0,
+                ExcMessage("The elements per edge are not divisible by " +
+                           std::to_string(coarsening) +
+                           " for the coarsest level."));
+  }
+
+  template <int dim,typename NumberType>
+  FullApproximationScheme<dim,NumberType>::~FullApproximationScheme()
+  {
+    levels.clear();
+  }
+
+// @sect4{FullApproximationScheme::run}
+
+// The load steps are solved by the full approximation scheme and, if
+// requested, once more from the undeformed state by Newton-CG on the finest
+// level to compare the times to solution. Both use the same convergence criterion, the force
+// residual relative to the external force.
+  template <int dim,typename NumberType>
+  void FullApproximationScheme<dim,NumberType>::run()
+  {
+    make_grid();
+    system_setup();
+
+    Level &finest = *levels.back();
+
+    Timer timer;
+    unsigned int n_cycles = 0;
+    {
+      Time time(parameters.end_time, parameters.delta_t, parameters.load_ramp_time);
+      time.increment();
+      while (time.current() <= time.end())
+        {
+          const unsigned int cycles = solve_fas(time.load_factor());
+          std::cout << "Timestep " << time.get_timestep() << " @ " << time.current()
+                    << "s: " << cycles << " FAS cycles" << std::endl;
+          n_cycles += cycles;
+          time.increment();
+        }
+    }
+    timer.stop();
+    const double fas_time = timer.wall_time();
+    const double fas_tip_displacement = finest.displacement(tip_dof);
+
+    std::cout << "Full approximation scheme:"
+              << "\n\t V-cycles: " << n_cycles
+              << "\n\t Time to solution: " << fas_time << "s"
+              << "\n\t Vertical tip displacement: " << fas_tip_displacement
+              << std::endl;
+
+    if (parameters.fas_compare_newton == false)
+      return;
+
+    finest.displacement = 0.0;
+    timer.restart();
+    unsigned int n_newton_iterations = 0;
+    {
+      Time time(parameters.end_time, parameters.delta_t, parameters.load_ramp_time);
+      time.increment();
+      while (time.current() <= time.end())
+        {
+          Vector<double> rhs(external_force);
+          rhs *= time.load_factor();
+          n_newton_iterations += solve_newton(levels.size() - 1, rhs,
+                                              parameters.tol_f * rhs.l2_norm());
+          time.increment();
+        }
+    }
+    timer.stop();
+
+    std::cout << "Newton-CG:"
+              << "\n\t Newton iterations: " << n_newton_iterations
+              << "\n\t Time to solution: " << timer.wall_time() << "s"
+              << "\n\t Vertical tip displacement: " << finest.displacement(tip_dof)
+              << "\n\t Speedup of the full approximation scheme: "
+              << timer.wall_time() / fas_time
+              << std::endl;
+  }
+
+  template <int dim,typename NumberType>
+  double FullApproximationScheme<dim,NumberType>::get_vertical_tip_displacement() const
+  {
+    Assert (levels.empty() == false, ExcNotInitialized());
+    return levels.back()->displacement(tip_dof);
+  }
+
+// @sect4{FullApproximationScheme::make_grid}
+
+// Every level is refined globally from the Cook mesh of the coarsest level,
+// whose elements per edge are those of the finest level divided by the
+// refinement. As the map onto the beam is bilinear, the finest level is the
+// same mesh as the one of the Newton scheme in Solid::make_grid().
+  template <int dim,typename NumberType>
+  void FullApproximationScheme<dim,NumberType>::make_grid()
+  {
+    const unsigned int n_levels = parameters.fas_levels;
+    const unsigned int coarse_elements_per_edge = parameters.elements_per_edge >> (n_levels - 1);
+
+    levels.clear();
+    for (unsigned int level = 0; level < n_levels; ++level)
+      {
+        levels.emplace_back(new Level());
+        make_cook_membrane_grid(levels.back()->triangulation,
+                                coarse_elements_per_edge, parameters.scale);
+        levels.back()->triangulation.refine_global(level);
+      }
+  }
+
+// @sect4{FullApproximationScheme::system_setup}
+
+// The constraints on every level and the external force on the finest one
+// are those of Solid, see make_cook_membrane_constraints() and
+// assemble_cook_membrane_traction(). The matrix-free data of the reference
+// configuration is set up once per level, the one of the current
+// configuration follows the displacement of the level.
+  template <int dim,typename NumberType>
+  void FullApproximationScheme<dim,NumberType>::system_setup()
+  {
+    const QGauss<1> quad (n_q_points_1d);
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+
+    std::cout << "Levels:" << std::endl;
+    for (unsigned int l = 0; l < levels.size(); ++l)
+      {
+        Level &level = *levels[l];
+
+        level.dof_handler.distribute_dofs(fe);
+        DoFRenumbering::Cuthill_McKee(level.dof_handler);
+
+        std::cout << "\t " << l << ": "
+                  << level.triangulation.n_active_cells() << " cells, "
+                  << level.dof_handler.n_dofs() << " degrees of freedom"
+                  << std::endl;
+
+        level.constraints.clear();
+        make_cook_membrane_constraints(level.dof_handler, level.constraints);
+        level.constraints.close();
+
+        level.displacement.reinit(level.dof_handler.n_dofs());
+
+        level.mf_data_reference = std::make_shared<MatrixFree<dim,double>>();
+        level.mf_data_reference->reinit(level.dof_handler, level.constraints, quad, data);
+
+        level.eulerian_mapping = std::make_shared<MappingQEulerian<dim,Vector<double>>>(/*mapping degree*/1,level.dof_handler,level.displacement);
+        level.mf_data_current = std::make_shared<MatrixFree<dim,double>>();
+        level.mf_data_current->reinit(*level.eulerian_mapping, level.dof_handler, level.constraints, quad, data);
+
+        level.mf_nh_operator.set_material(material_vec);
+        level.mf_nh_operator.initialize(level.mf_data_current,level.mf_data_reference,level.displacement);
+
+        if (l > 0)
+          setup_prolongation(l);
+      }
+
+    const Level &finest = *levels.back();
+
+    assemble_cook_membrane_traction(finest.dof_handler, finest.constraints, QGauss<dim-1>(n_q_points_1d),
+                                    parameters.scale, external_force);
+
+    tip_dof = get_cook_membrane_tip_dof(finest.dof_handler, parameters.scale);
+  }
+
+// @sect4{FullApproximationScheme::setup_prolongation}
+
+// Each active cell of the coarser level is refined once on the given level.
+// The InterGridMap finds the refined cell, whose children get the coarse
+// cell values through the embedding matrices. Entries shared by neighboring
+// cells are the same for a conforming element, so they are simply set.
+  template <int dim,typename NumberType>
+  void FullApproximationScheme<dim,NumberType>::setup_prolongation(const unsigned int level)
+  {
+    Assert(level > 0 && level < levels.size(), ExcIndexRange(level, 1, levels.size()));
+
+    const DoFHandler<dim> &coarse_dof_handler = levels[level-1]->dof_handler;
+    Level                 &fine               = *levels[level];
+
+    InterGridMap<DoFHandler<dim>> coarse_to_fine;
+    coarse_to_fine.make_mapping(coarse_dof_handler, fine.dof_handler);
+
+    std::vector<types::global_dof_index> coarse_indices(fe.dofs_per_cell);
+    std::vector<types::global_dof_index> fine_indices(fe.dofs_per_cell);
+
+    // The first pass builds the sparsity pattern, the second one sets the
+    // entries:
+    DynamicSparsityPattern dsp(fine.dof_handler.n_dofs(), coarse_dof_handler.n_dofs());
+    for (unsigned int pass = 0; pass < 2; ++pass)
+      {
+        for (const auto &cell : coarse_dof_handler.active_cell_iterators())
+          {
+            const typename DoFHandler<dim>::cell_iterator fine_cell = coarse_to_fine[cell];
+            Assert(fine_cell->has_children(), ExcInternalError());
+
+            cell->get_dof_indices(coarse_indices);
+            for (unsigned int child = 0; child < fine_cell->n_children(); ++child)
+              {
+                fine_cell->child(child)->get_dof_indices(fine_indices);
+                const FullMatrix<double> &embedding = fe.get_prolongation_matrix(child);
+                for (unsigned int i = 0; i < fe.dofs_per_cell; ++i)
+                  for (unsigned int j = 0; j < fe.dofs_per_cell; ++j)
+                    if (embedding(i,j) != 0.0)
+                      {
+                        if (pass == 0)
+                          dsp.add(fine_indices[i], coarse_indices[j]);
+                        else
+                          fine.prolongation.set(fine_indices[i], coarse_indices[j], embedding(i,j));
+                      }
+              }
+          }
+
+        if (pass == 0)
+          {
+            fine.prolongation_sparsity.copy_from(dsp);
+            fine.prolongation.reinit(fine.prolongation_sparsity);
+          }
+      }
+  }
+
+// @sect4{FullApproximationScheme::solve_fas}
+  template <int dim,typename NumberType>
+  unsigned int
+  FullApproximationScheme<dim,NumberType>::solve_fas(const double load_factor)
+  {
+    const unsigned int finest = levels.size() - 1;
+
+    Vector<double> rhs(external_force);
+    rhs *= load_factor;
+    Vector<double> residual(rhs.size());
+
+    const double tolerance = parameters.tol_f * rhs.l2_norm();
+
+    for (unsigned int cycle = 0; cycle < parameters.fas_max_cycles; ++cycle)
+      {
+        const double residual_norm = compute_residual(finest, rhs, residual);
+        AssertThrow(numbers::is_finite(residual_norm),
+                    ExcMessage("The full approximation scheme diverged!"));
+        if (residual_norm <= tolerance)
+          return cycle;
+
+        v_cycle(finest, rhs);
+      }
+
+    AssertThrow(compute_residual(finest, rhs, residual) <= tolerance,
+                ExcMessage("No convergence in nonlinear multigrid!"));
+    return parameters.fas_max_cycles;
+  }
+
+// @sect4{FullApproximationScheme::v_cycle}
+
+// One V-cycle for $\mathbf{A}_\ell(\mathbf{u}_\ell) = \mathbf{f}_\ell$ that
+// updates the displacement of the level. The state is restricted by
+// injection, which is exact at the vertices of the coarser level, the
+// residual by the transpose of the prolongation. The coarse right hand side
+// vanishes on the constrained DoFs, so that the coarse correction does too.
+  template <int dim,typename NumberType>
+  void
+  FullApproximationScheme<dim,NumberType>::v_cycle(const unsigned int    level,
+                                                   const Vector<double> &rhs)
+  {
+    Level &fine = *levels[level];
+
+    if (level == 0)
+      {
+        Vector<double> residual(rhs.size());
+        const double residual_norm = compute_residual(level, rhs, residual);
+        solve_newton(level, rhs, parameters.fas_coarse_tolerance * residual_norm);
+        return;
+      }
+
+    smooth(level, rhs);
+
+    Vector<double> residual(rhs.size());
+    compute_residual(level, rhs, residual);
+
+    Level &coarse = *levels[level-1];
+    VectorTools::interpolate_to_different_mesh(fine.dof_handler, fine.displacement,
+                                               coarse.dof_handler, coarse.constraints,
+                                               coarse.displacement);
+    const Vector<double> coarse_displacement_initial(coarse.displacement);
+
+    Vector<double> coarse_rhs(coarse.displacement.size());
+    Vector<double> restricted_residual(coarse.displacement.size());
+    coarse.mf_nh_operator.add_internal_forces(coarse_rhs);
+    fine.prolongation.Tvmult(restricted_residual, residual);
+    coarse.constraints.set_zero(restricted_residual);
+    coarse_rhs += restricted_residual;
+
+    v_cycle(level - 1, coarse_rhs);
+
+    Vector<double> coarse_correction(coarse.displacement);
+    coarse_correction -= coarse_displacement_initial;
+    fine.prolongation.vmult_add(fine.displacement, coarse_correction);
+
+    smooth(level, rhs);
+  }
+
+// @sect4{FullApproximationScheme::smooth}
+
+// The Newton-Jacobi sweeps need the diagonal of the tangent at the current
+// displacement and thus the mapping of the current configuration.
+  template <int dim,typename NumberType>
+  void
+  FullApproximationScheme<dim,NumberType>::smooth(const unsigned int    level,
+                                                  const Vector<double> &rhs)
+  {
+    Level &smoothed = *levels[level];
+
+    Vector<double> residual(rhs.size());
+    Vector<double> update(rhs.size());
+    for (unsigned int sweep = 0; sweep < parameters.fas_smoothing_sweeps; ++sweep)
+      {
+        update_current_configuration(level);
+        compute_residual(level, rhs, residual);
+        smoothed.mf_nh_operator.precondition_Jacobi(update, residual,
+                                                    parameters.fas_smoothing_relaxation);
+        smoothed.displacement += update;
+      }
+  }
+
+// @sect4{FullApproximationScheme::solve_newton}
+
+// The matrix-free Newton-CG scheme of MonteCarlo::solve_equilibrium() on one
+// level. It serves as the coarse solver of the V-cycle and as the reference
+// on the finest level.
+  template <int dim,typename NumberType>
+  unsigned int
+  FullApproximationScheme<dim,NumberType>::solve_newton(const unsigned int    level,
+                                                        const Vector<double> &rhs,
+                                                        const double          tolerance)
+  {
+    Level &solved = *levels[level];
+
+    Vector<double> residual(rhs.size());
+    Vector<double> update(rhs.size());
+
+    for (unsigned int newton_iteration = 0;
+         newton_iteration < parameters.max_iterations_NR;
+         ++newton_iteration)
+      {
+        const double residual_norm = compute_residual(level, rhs, residual);
+        AssertThrow(numbers::is_finite(residual_norm),
+                    ExcMessage("Newton's method diverged!"));
+        if (residual_norm <= tolerance)
+          return newton_iteration;
+
+        update_current_configuration(level);
+
+        SolverControl solver_control(solved.dof_handler.n_dofs() * parameters.max_iterations_lin,
+                                     parameters.tol_lin * residual_norm);
+        SolverCG<Vector<double> > solver_CG(solver_control);
+
+        PreconditionJacobi<NeoHookOperator<dim,degree,n_q_points_1d,double>> preconditioner;
+        preconditioner.initialize (solved.mf_nh_operator,parameters.preconditioner_relaxation);
+
+        update = 0.0;
+        solver_CG.solve(solved.mf_nh_operator, update, residual, preconditioner);
+        solved.constraints.distribute(update);
+
+        solved.displacement += update;
+      }
+
+    AssertThrow(compute_residual(level, rhs, residual) <= tolerance,
+                ExcMessage("No convergence in nonlinear solver!"));
+    return parameters.max_iterations_NR;
+  }
+
+// @sect4{FullApproximationScheme::compute_residual}
+
+// The internal forces only need the reference configuration. The residual
+// vanishes on the constrained DoFs.
+  template <int dim,typename NumberType>
+  double
+  FullApproximationScheme<dim,NumberType>::compute_residual(const unsigned int    level,
+                                                            const Vector<double> &rhs,
+                                                            Vector<double>       &residual) const
+  {
+    residual = 0.0;
+    levels[level]->mf_nh_operator.add_internal_forces(residual);
+    residual.sadd(-1.0, 1.0, rhs);
+    return residual.l2_norm();
+  }
+
+// @sect4{FullApproximationScheme::update_current_configuration}
+  template <int dim,typename NumberType>
+  void
+  FullApproximationScheme<dim,NumberType>::update_current_configuration(const unsigned int level)
+  {
+    Level &updated = *levels[level];
+
+    const QGauss<1> quad (n_q_points_1d);
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+
+    // only the mapping changes with the displacement
+    data.initialize_indices = false;
+    updated.mf_data_current->reinit(*updated.eulerian_mapping, updated.dof_handler,
+                                    updated.constraints, quad, data);
+
+    updated.mf_nh_operator.compute_diagonal();
+  }
+
+}
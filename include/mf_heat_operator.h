@@ -0,0 +1,364 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <deal.II/physics/elasticity/kinematics.h>
+
+using namespace dealii;
+
+  /**
+   * Matrix-free operator of the backward Euler step of transient heat
+   * conduction in the reference configuration,
+   * $\int \frac{c}{\varDelta t} T \, \delta T + \nabla_0 T \cdot \mathbf{K}
+   * \nabla_0 \delta T \, dV$, with the pull back $\mathbf{K} = k J
+   * \mathbf{C}^{-1}$ of the isotropic spatial conductivity $k$.
+   *
+   * The temperature is the second field of the MatrixFree object of the
+   * reference configuration, so that the index data and the cell batches of
+   * the mechanical problem are reused. As $\mathbf{K}$ depends on the
+   * deformation, the displacement is gathered in the same cell loop as the
+   * temperature rather than being stored at the quadrature points.
+   *
+   * As in NeoHookOperator, constrained DoFs get identity rows. Inhomogeneous
+   * Dirichlet values are lifted into the right hand side by compute_rhs().
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  class HeatOperator : public Subscriptor
+  {
+  public:
+    HeatOperator ();
+
+    void clear();
+
+    void initialize(std::shared_ptr<const MatrixFree<dim,number>> data_reference,
+                    const unsigned int    displacement_dof_index,
+                    const unsigned int    temperature_dof_index,
+                    const Vector<number> &displacement);
+
+    void set_parameters(const double heat_capacity,
+                        const double conductivity,
+                        const double delta_t);
+
+    void compute_diagonal();
+
+    unsigned int m () const;
+    unsigned int n () const;
+
+    void vmult (Vector<double> &dst,
+                const Vector<double> &src) const;
+    void Tvmult (Vector<double> &dst,
+                 const Vector<double> &src) const;
+
+    void precondition_Jacobi(Vector<number> &dst,
+                             const Vector<number> &src,
+                             const number omega) const;
+
+    /**
+     * Residual $\int \frac{c}{\varDelta t} (T_n - T) \, \delta T - \nabla_0 T
+     * \cdot \mathbf{K} \nabla_0 \delta T \, dV$ of the time step for the
+     * current guess @p temperature, which has to satisfy the Dirichlet
+     * values. Constrained entries are zero.
+     */
+    void compute_rhs(Vector<double>       &rhs,
+                     const Vector<double> &temperature_old,
+                     const Vector<double> &temperature) const;
+
+  private:
+
+    /**
+     * Apply operator on a range of cells.
+     */
+    void local_apply_cell (const MatrixFree<dim,number>               &data,
+                           Vector<double>                             &dst,
+                           const Vector<double>                       &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const;
+
+    /**
+     * Conductivity $\mathbf{K} \, JxW$ and capacity $c / \varDelta t \, JxW$
+     * at the quadrature points of a cell from the gathered displacement.
+     */
+    void do_quadrature_point_operation(FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>   &phi_temperature,
+                                       FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_displacement,
+                                       const bool                                            negate) const;
+
+    std::shared_ptr<const MatrixFree<dim,number>> data_reference;
+
+    unsigned int displacement_dof_index;
+    unsigned int temperature_dof_index;
+
+    const Vector<number> *displacement;
+
+    double heat_capacity;
+    double conductivity;
+    double delta_t;
+
+    Vector<number> inverse_diagonal;
+  };
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::HeatOperator ()
+    :
+    Subscriptor(),
+    displacement_dof_index(0),
+    temperature_dof_index(1),
+    displacement(nullptr),
+    heat_capacity(1.),
+    conductivity(1.),
+    delta_t(1.)
+  {}
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::clear ()
+  {
+    data_reference.reset();
+    displacement = nullptr;
+    inverse_diagonal.reinit(0);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::initialize(
+                    std::shared_ptr<const MatrixFree<dim,number>> data_reference_,
+                    const unsigned int    displacement_dof_index_,
+                    const unsigned int    temperature_dof_index_,
+                    const Vector<number> &displacement_)
+  {
+    data_reference = data_reference_;
+    displacement_dof_index = displacement_dof_index_;
+    temperature_dof_index = temperature_dof_index_;
+    displacement = &displacement_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::set_parameters(const double heat_capacity_,
+                                                                  const double conductivity_,
+                                                                  const double delta_t_)
+  {
+    Assert (delta_t_ > 0, ExcMessage("The time step has to be positive"));
+    heat_capacity = heat_capacity_;
+    conductivity = conductivity_;
+    delta_t = delta_t_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::m () const
+  {
+    return data_reference->get_dof_handler(temperature_dof_index).n_dofs();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::n () const
+  {
+    return data_reference->get_dof_handler(temperature_dof_index).n_dofs();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::precondition_Jacobi(Vector<number> &dst,
+                                                                       const Vector<number> &src,
+                                                                       const number omega) const
+  {
+    Assert (inverse_diagonal.size() == src.size(), ExcNotInitialized());
+    dst.equ(omega, src);
+    dst.scale(inverse_diagonal);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::vmult (Vector<double>       &dst,
+                                                          const Vector<double> &src) const
+  {
+    dst = 0;
+    local_apply_cell(*data_reference, dst, src,
+                     std::make_pair<unsigned int,unsigned int>(0,data_reference->n_macro_cells()));
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs(temperature_dof_index);
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      dst(constrained_dofs[i]) = src(constrained_dofs[i]);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::Tvmult (Vector<double>       &dst,
+                                                           const Vector<double> &src) const
+  {
+    vmult(dst, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::local_apply_cell (
+                           const MatrixFree<dim,number>               &data,
+                           Vector<double>                             &dst,
+                           const Vector<double>                       &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>   phi_temperature (data, temperature_dof_index);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_displacement(data, displacement_dof_index);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi_temperature.reinit(cell);
+        phi_displacement.reinit(cell);
+
+        phi_displacement.read_dof_values_plain(*displacement);
+        phi_displacement.evaluate (false,true,false);
+        phi_temperature.read_dof_values(src);
+        phi_temperature.evaluate (true,true,false);
+
+        do_quadrature_point_operation(phi_temperature, phi_displacement, false);
+
+        phi_temperature.integrate (true,true);
+        phi_temperature.distribute_local_to_global(dst);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::do_quadrature_point_operation(
+                             FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>   &phi_temperature,
+                             FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_displacement,
+                             const bool                                            negate) const
+  {
+    const double sign = negate ? -1. : 1.;
+    for (unsigned int q=0; q<phi_temperature.n_q_points; ++q)
+      {
+        const Tensor<2,dim,VectorizedArray<number>> F =
+          Physics::Elasticity::Kinematics::F(phi_displacement.get_gradient(q));
+        const Tensor<2,dim,VectorizedArray<number>> F_inv = invert(F);
+        const VectorizedArray<number> JxW = phi_temperature.JxW(q);
+
+        // $\mathbf{K} \nabla_0 T = k J \mathbf{F}^{-1} \mathbf{F}^{-T} \nabla_0 T$
+        const Tensor<1,dim,VectorizedArray<number>> flux =
+          F_inv * (phi_temperature.get_gradient(q) * F_inv) * (sign * conductivity * determinant(F));
+
+        phi_temperature.submit_value(phi_temperature.get_value(q) * (sign * heat_capacity / delta_t) * JxW, q);
+        phi_temperature.submit_gradient(flux * JxW, q);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::compute_rhs(Vector<double>       &rhs,
+                                                               const Vector<double> &temperature_old,
+                                                               const Vector<double> &temperature) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>   phi_temperature    (*data_reference, temperature_dof_index);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>   phi_temperature_old(*data_reference, temperature_dof_index);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_displacement   (*data_reference, displacement_dof_index);
+
+    rhs = 0;
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_temperature.reinit(cell);
+        phi_temperature_old.reinit(cell);
+        phi_displacement.reinit(cell);
+
+        phi_displacement.read_dof_values_plain(*displacement);
+        phi_displacement.evaluate (false,true,false);
+
+        // the Dirichlet values are part of the current guess
+        phi_temperature.read_dof_values_plain(temperature);
+        phi_temperature.evaluate (true,true,false);
+        phi_temperature_old.read_dof_values_plain(temperature_old);
+        phi_temperature_old.evaluate (true,false,false);
+
+        do_quadrature_point_operation(phi_temperature, phi_displacement, true);
+
+        // get_value() now returns the submitted value, to which the
+        // contribution of the last time step is added
+        for (unsigned int q=0; q<phi_temperature.n_q_points; ++q)
+          phi_temperature.submit_value(phi_temperature.get_value(q) +
+                                       phi_temperature_old.get_value(q) *
+                                       (heat_capacity / delta_t) * phi_temperature.JxW(q),
+                                       q);
+
+        phi_temperature.integrate (true,true);
+        phi_temperature.distribute_local_to_global(rhs);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  HeatOperator<dim,fe_degree,n_q_points_1d,number>::compute_diagonal()
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>   phi_temperature (*data_reference, temperature_dof_index);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_displacement(*data_reference, displacement_dof_index);
+
+    data_reference->initialize_dof_vector(inverse_diagonal, temperature_dof_index);
+
+    AlignedVector<VectorizedArray<number>> local_diagonal(phi_temperature.dofs_per_cell);
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_temperature.reinit(cell);
+        phi_displacement.reinit(cell);
+
+        phi_displacement.read_dof_values_plain(*displacement);
+        phi_displacement.evaluate (false,true,false);
+
+        for (unsigned int i=0; i<phi_temperature.dofs_per_cell; ++i)
+          {
+            for (unsigned int j=0; j<phi_temperature.dofs_per_cell; ++j)
+              phi_temperature.begin_dof_values()[j] = VectorizedArray<number>();
+            phi_temperature.begin_dof_values()[i] = 1.;
+
+            phi_temperature.evaluate (true,true,false);
+            do_quadrature_point_operation(phi_temperature, phi_displacement, false);
+            phi_temperature.integrate (true,true);
+
+            local_diagonal[i] = phi_temperature.begin_dof_values()[i];
+          }
+
+        for (unsigned int i=0; i<phi_temperature.dofs_per_cell; ++i)
+          phi_temperature.begin_dof_values()[i] = local_diagonal[i];
+        phi_temperature.distribute_local_to_global(inverse_diagonal);
+      }
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs(temperature_dof_index);
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      inverse_diagonal(constrained_dofs[i]) = 1.;
+
+    for (unsigned int i=0; i<inverse_diagonal.size(); ++i)
+      {
+        Assert (inverse_diagonal(i) > 0., ExcMessage("Diagonal of the heat operator has to be positive"));
+        inverse_diagonal(i) = 1./inverse_diagonal(i);
+      }
+  }
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/lac/diagonal_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+using namespace dealii;
+
+  /**
+   * Small strain, constant coefficient linear elastic operator
+   * $\int \boldsymbol{\varepsilon}(\delta \mathbf{v}) : [2 \mu \,
+   * \textrm{dev} \, \boldsymbol{\varepsilon}(\mathbf{u}) + \kappa \,
+   * \textrm{tr} \, \boldsymbol{\varepsilon}(\mathbf{u}) \mathbf{I}] \, dV$ in
+   * the reference configuration. This is the tangent of the neo-Hookean
+   * material in the undeformed state, with the deviator taken in @p dim
+   * dimensions as there.
+   *
+   * It serves as a preconditioner for the tangent of the nonlinear problem.
+   * It neither evaluates a material nor needs the mapping of the current
+   * configuration, so it is set up once per run, including its diagonal and
+   * e.g. the eigenvalue estimate of a Chebyshev iteration, and its
+   * application costs about as much as a Laplacian.
+   *
+   * As in NeoHookOperator, constrained DoFs get identity rows.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  class LinearElasticOperator : public Subscriptor
+  {
+  public:
+    typedef number value_type;
+
+    LinearElasticOperator ();
+
+    void clear();
+
+    void initialize(std::shared_ptr<const MatrixFree<dim,number>> data_reference,
+                    const double mu,
+                    const double nu);
+
+    void compute_diagonal();
+
+    /**
+     * The inverse of the diagonal as needed by PreconditionChebyshev.
+     */
+    std::shared_ptr<DiagonalMatrix<Vector<number>>> get_matrix_diagonal_inverse() const;
+
+    unsigned int m () const;
+    unsigned int n () const;
+
+    void vmult (Vector<double> &dst,
+                const Vector<double> &src) const;
+    void Tvmult (Vector<double> &dst,
+                 const Vector<double> &src) const;
+
+    number el (const unsigned int row,
+               const unsigned int col) const;
+
+    void precondition_Jacobi(Vector<number> &dst,
+                             const Vector<number> &src,
+                             const number omega) const;
+
+  private:
+
+    /**
+     * Apply operator on a range of cells.
+     */
+    void local_apply_cell (const MatrixFree<dim,number>               &data,
+                           Vector<double>                             &dst,
+                           const Vector<double>                       &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const;
+
+    /**
+     * Submit the stress of the evaluated symmetric gradient.
+     */
+    void do_quadrature_point_operation(FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi) const;
+
+    std::shared_ptr<const MatrixFree<dim,number>> data_reference;
+
+    double two_mu;
+    double kappa;
+
+    Vector<number> diagonal;
+    std::shared_ptr<DiagonalMatrix<Vector<number>>> inverse_diagonal_entries;
+  };
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::LinearElasticOperator ()
+    :
+    Subscriptor(),
+    two_mu(1.),
+    kappa(1.)
+  {}
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::clear ()
+  {
+    data_reference.reset();
+    diagonal.reinit(0);
+    inverse_diagonal_entries.reset();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::initialize(
+                    std::shared_ptr<const MatrixFree<dim,number>> data_reference_,
+                    const double mu,
+                    const double nu)
+  {
+    Assert (mu > 0 && nu < 0.5, ExcMessage("The elastic moduli have to be positive"));
+    data_reference = data_reference_;
+    two_mu = 2.0 * mu;
+    kappa = (2.0 * mu * (1.0 + nu)) / (3.0 * (1.0 - 2.0 * nu));
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::m () const
+  {
+    return data_reference->get_vector_partitioner()->size();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  unsigned int
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::n () const
+  {
+    return data_reference->get_vector_partitioner()->size();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::vmult (Vector<double>       &dst,
+                                                                   const Vector<double> &src) const
+  {
+    dst = 0;
+    local_apply_cell(*data_reference, dst, src,
+                     std::make_pair<unsigned int,unsigned int>(0,data_reference->n_macro_cells()));
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs();
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      dst(constrained_dofs[i]) = src(constrained_dofs[i]);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::Tvmult (Vector<double>       &dst,
+                                                                    const Vector<double> &src) const
+  {
+    vmult(dst, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::local_apply_cell (
+                           const MatrixFree<dim,number>               &data,
+                           Vector<double>                             &dst,
+                           const Vector<double>                       &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi(data);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit(cell);
+        phi.read_dof_values(src);
+        phi.evaluate (false,true,false);
+        do_quadrature_point_operation(phi);
+        phi.integrate (false,true);
+        phi.distribute_local_to_global(dst);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::do_quadrature_point_operation(
+                             FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi) const
+  {
+    for (unsigned int q=0; q<phi.n_q_points; ++q)
+      {
+        SymmetricTensor<2,dim,VectorizedArray<number>> sigma = phi.get_symmetric_gradient(q);
+        const VectorizedArray<number> tr = trace(sigma);
+
+        // $2 \mu \, \textrm{dev} \, \boldsymbol{\varepsilon} + \kappa \,
+        // \textrm{tr} \, \boldsymbol{\varepsilon} \mathbf{I}$
+        sigma *= make_vectorized_array<number>(two_mu);
+        for (unsigned int d=0; d<dim; ++d)
+          sigma[d][d] += tr * (kappa - two_mu / dim);
+
+        phi.submit_symmetric_gradient(sigma * phi.JxW(q), q);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::compute_diagonal()
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi(*data_reference);
+
+    data_reference->initialize_dof_vector(diagonal);
+
+    AlignedVector<VectorizedArray<number>> local_diagonal(phi.dofs_per_cell);
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi.reinit(cell);
+
+        for (unsigned int i=0; i<phi.dofs_per_cell; ++i)
+          {
+            for (unsigned int j=0; j<phi.dofs_per_cell; ++j)
+              phi.begin_dof_values()[j] = VectorizedArray<number>();
+            phi.begin_dof_values()[i] = 1.;
+
+            phi.evaluate (false,true,false);
+            do_quadrature_point_operation(phi);
+            phi.integrate (false,true);
+
+            local_diagonal[i] = phi.begin_dof_values()[i];
+          }
+
+        for (unsigned int i=0; i<phi.dofs_per_cell; ++i)
+          phi.begin_dof_values()[i] = local_diagonal[i];
+        phi.distribute_local_to_global(diagonal);
+      }
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs();
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      diagonal(constrained_dofs[i]) = 1.;
+
+    inverse_diagonal_entries = std::make_shared<DiagonalMatrix<Vector<number>>>();
+    Vector<number> &inverse_diagonal = inverse_diagonal_entries->get_vector();
+    inverse_diagonal = diagonal;
+    for (unsigned int i=0; i<inverse_diagonal.size(); ++i)
+      {
+        Assert (inverse_diagonal(i) > 0., ExcMessage("Diagonal of the elastic operator has to be positive"));
+        inverse_diagonal(i) = 1./inverse_diagonal(i);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  std::shared_ptr<DiagonalMatrix<Vector<number>>>
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::get_matrix_diagonal_inverse() const
+  {
+    Assert (inverse_diagonal_entries, ExcNotInitialized());
+    return inverse_diagonal_entries;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  number
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::el (const unsigned int row,
+                                                                const unsigned int col) const
+  {
+    Assert (row == col, ExcNotImplemented());
+    (void)col;
+    Assert (diagonal.size() > 0, ExcNotInitialized());
+    return diagonal(row);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  LinearElasticOperator<dim,fe_degree,n_q_points_1d,number>::precondition_Jacobi(Vector<number> &dst,
+                                                                                const Vector<number> &src,
+                                                                                const number omega) const
+  {
+    Assert (inverse_diagonal_entries, ExcNotInitialized());
+    dst.equ(omega, src);
+    dst.scale(inverse_diagonal_entries->get_vector());
+  }
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+using namespace dealii;
+
+  /**
+   * Mass operator $\int \rho \, \mathbf{N}_i \cdot \mathbf{N}_j \, dV$ for the
+   * vector-valued displacement field in the reference configuration.
+   *
+   * As in NeoHookOperator, constrained DoFs get identity rows. It is used as the
+   * right hand side operator of the modal eigenvalue problem.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  class MassOperator : public Subscriptor
+  {
+  public:
+    MassOperator ();
+
+    void clear();
+
+    void initialize(std::shared_ptr<const MatrixFree<dim,number>> data_reference,
+                    const double density);
+
+    void vmult (Vector<double> &dst,
+                const Vector<double> &src) const;
+
+    void vmult (std::vector<Vector<double>> &dst,
+                const std::vector<Vector<double>> &src) const;
+
+  private:
+
+    /**
+     * Apply operator on a range of cells for a block of vectors.
+     */
+    void local_apply_cell (const MatrixFree<dim,number>               &data,
+                           std::vector<Vector<double>*>               &dst,
+                           const std::vector<const Vector<double>*>   &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const;
+
+    std::shared_ptr<const MatrixFree<dim,number>> data_reference;
+
+    double density;
+  };
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  MassOperator<dim,fe_degree,n_q_points_1d,number>::MassOperator ()
+    :
+    Subscriptor(),
+    density(1.)
+  {}
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  MassOperator<dim,fe_degree,n_q_points_1d,number>::clear ()
+  {
+    data_reference.reset();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  MassOperator<dim,fe_degree,n_q_points_1d,number>::initialize(
+                    std::shared_ptr<const MatrixFree<dim,number>> data_reference_,
+                    const double density_)
+  {
+    data_reference = data_reference_;
+    density = density_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  MassOperator<dim,fe_degree,n_q_points_1d,number>::vmult (Vector<double>       &dst,
+                                                           const Vector<double> &src) const
+  {
+    std::vector<Vector<double>*>       dst_ptr(1, &dst);
+    std::vector<const Vector<double>*> src_ptr(1, &src);
+
+    dst = 0;
+    local_apply_cell(*data_reference, dst_ptr, src_ptr,
+                     std::make_pair<unsigned int,unsigned int>(0,data_reference->n_macro_cells()));
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs();
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      dst(constrained_dofs[i]) += src(constrained_dofs[i]);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  MassOperator<dim,fe_degree,n_q_points_1d,number>::vmult (std::vector<Vector<double>>       &dst,
+                                                           const std::vector<Vector<double>> &src) const
+  {
+    Assert (dst.size() == src.size(), ExcDimensionMismatch(dst.size(), src.size()));
+
+    std::vector<Vector<double>*>       dst_ptr(dst.size());
+    std::vector<const Vector<double>*> src_ptr(src.size());
+    for (unsigned int b=0; b<dst.size(); ++b)
+      {
+        dst[b] = 0;
+        dst_ptr[b] = &dst[b];
+        src_ptr[b] = &src[b];
+      }
+
+    local_apply_cell(*data_reference, dst_ptr, src_ptr,
+                     std::make_pair<unsigned int,unsigned int>(0,data_reference->n_macro_cells()));
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_reference->get_constrained_dofs();
+    for (unsigned int b=0; b<dst.size(); ++b)
+      for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+        dst[b](constrained_dofs[i]) += src[b](constrained_dofs[i]);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  MassOperator<dim,fe_degree,n_q_points_1d,number>::local_apply_cell (
+                           const MatrixFree<dim,number>               &data,
+                           std::vector<Vector<double>*>               &dst,
+                           const std::vector<const Vector<double>*>   &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi(data);
+
+    const VectorizedArray<number> rho = make_vectorized_array<number>(density);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit(cell);
+        for (unsigned int b=0; b<src.size(); ++b)
+          {
+            phi.read_dof_values(*src[b]);
+            phi.evaluate (true,false,false);
+            for (unsigned int q=0; q<phi.n_q_points; ++q)
+              phi.submit_value(rho * phi.get_value(q), q);
+            phi.integrate (true,false);
+            phi.distribute_local_to_global(*dst[b]);
+          }
+      }
+  }
@@ -0,0 +1,490 @@
+#pragma once
+
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/thread_management.h>
+
+#include <mf_elasticity.h>
+#include <cell_coefficients.h>
+
+#include <functional>
+#include <iomanip>
+#include <random>
+
+namespace Cook_Membrane
+{
+  using namespace dealii;
+
+// @sect3{The <code>MonteCarlo</code> class}
+
+// Monte-Carlo estimation of the statistics of the vertical tip displacement of
+// the Cook membrane with random fields of the shear modulus and the Poisson's
+// ratio. The fields are constant on each cell and enter the matrix-free
+// operator as relative shear and bulk moduli per cell batch.
+//
+// The mesh, the constraints, the external force and the matrix-free data of
+// the reference configuration are set up once and shared by all samples.
+// Each thread solves its share of the samples in its own SampleState, whose
+// matrix-free data of the current configuration only has its index data set
+// up for the first sample. Every sample is loaded in a single step starting
+// from the solution of the mean material, which itself is loaded
+// incrementally. The residual is evaluated matrix-free as well, so that no
+// matrix is assembled at all.
+  template <int dim,typename NumberType>
+  class MonteCarlo
+  {
+  public:
+    static constexpr int degree = 1;
+    static constexpr int n_q_points_1d = 2;
+
+    MonteCarlo(const Parameters::AllParameters &parameters);
+
+    virtual
+    ~MonteCarlo();
+
+    void
+    run();
+
+    // The mean and the standard deviation of the vertical tip displacement
+    // over the converged samples of the last run:
+    std::pair<double,double>
+    get_tip_displacement_statistics() const;
+
+  private:
+
+    // Everything that changes from one sample to the next:
+    struct SampleState
+    {
+      Vector<double>                                        displacement;
+      std::shared_ptr<CellCoefficients<dim,double>>         fields;
+      std::shared_ptr<MappingQEulerian<dim,Vector<double>>> eulerian_mapping;
+      std::shared_ptr<MatrixFree<dim,double>>               mf_data_current;
+      NeoHookOperator<dim,degree,n_q_points_1d,double>      mf_nh_operator;
+    };
+
+    void
+    make_grid();
+
+    // Set up the constraints, the external force and the matrix-free data
+    // of the reference configuration:
+    void
+    system_setup();
+
+    // Find the neighbours of each cell and their weights for the correlation
+    // of the random fields:
+    void
+    setup_correlation();
+
+    void
+    initialize_sample_state(SampleState &state) const;
+
+    // Draw the relative shear and bulk moduli per active cell for the
+    // sample with the given number. The random numbers only depend on the
+    // sample number and the seed, not on the thread that solves the sample:
+    void
+    sample_fields(const unsigned int sample,
+                  Vector<double>    &mu_scaling,
+                  Vector<double>    &kappa_scaling) const;
+
+    // Newton's method for the given load factor starting from the
+    // displacement of @p state. Returns whether it converged:
+    bool
+    solve_equilibrium(SampleState &state,
+                      const double load_factor) const;
+
+    void
+    update_current_configuration(SampleState &state) const;
+
+    unsigned int
+    solve_linear_system(const SampleState    &state,
+                        const Vector<double> &rhs,
+                        Vector<double>       &update) const;
+
+    const Parameters::AllParameters &parameters;
+
+    Triangulation<dim>               triangulation;
+    const FESystem<dim>              fe;
+    DoFHandler<dim>                  dof_handler;
+    ConstraintMatrix                 constraints;
+
+    // The external force for a unit load factor and the DoF of the vertical
+    // displacement at the tip:
+    Vector<double>                   external_force;
+    types::global_dof_index          tip_dof;
+
+    // The statistics of the tip displacement of the last run:
+    double                           tip_displacement_mean;
+    double                           tip_displacement_deviation;
+
+    std::shared_ptr<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>> material_vec;
+    std::shared_ptr<MatrixFree<dim,double>> mf_data_reference;
+
+    std::vector<std::vector<std::pair<unsigned int,double>>> correlation;
+  };
+
+// @sect3{Implementation of the <code>MonteCarlo</code> class}
+
+  template <int dim,typename NumberType>
+  MonteCarlo<dim,NumberType>::MonteCarlo(const Parameters::AllParameters &parameters)
+    :
+    parameters(parameters),
+    fe(FE_Q<dim>(degree), dim),
+    dof_handler(triangulation),
+    tip_dof(numbers::invalid_dof_index),
+    tip_displacement_mean(0.0),
+    tip_displacement_deviation(0.0),
+    material_vec(std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>>(
+      parameters.mu,parameters.nu))
+  {
+    AssertThrow(parameters.material_model == "Neo-Hooke" &&
+                parameters.volumetric_formulation == "Standard" &&
+                parameters.obstacle == "None" &&
+                parameters.thermal_coupling == false,
+                ExcNotImplemented());
+  }
+
+  template <int dim,typename NumberType>
+  MonteCarlo<dim,NumberType>::~MonteCarlo()
+  {
+    mf_data_reference.reset();
+    dof_handler.clear();
+  }
+
+// @sect4{MonteCarlo::run}
+  template <int dim,typename NumberType>
+  void MonteCarlo<dim,NumberType>::run()
+  {
+    make_grid();
+    system_setup();
+    setup_correlation();
+
+    // The mean material is loaded incrementally:
+    SampleState mean_state;
+    initialize_sample_state(mean_state);
+
+    Time time(parameters.end_time, parameters.delta_t, parameters.load_ramp_time);
+    time.increment();
+    while (time.current() <= time.end())
+      {
+        AssertThrow(solve_equilibrium(mean_state, time.load_factor()),
+                    ExcMessage("No convergence for the mean material!"));
+        time.increment();
+      }
+
+    std::cout << "Vertical tip displacement of the mean material: "
+              << mean_state.displacement(tip_dof) << std::endl;
+
+    // The samples are distributed round-robin to the threads. Samples
+    // whose Newton scheme does not converge are excluded from the
+    // statistics:
+    const unsigned int n_samples = parameters.monte_carlo_samples;
+    const unsigned int n_workers = std::min(n_samples,
+                                            parameters.sampling_threads > 0 ?
+                                            parameters.sampling_threads :
+                                            MultithreadInfo::n_threads());
+
+    std::vector<double> tip_displacement(n_samples, 0.0);
+    std::vector<bool>   converged(n_samples, false);
+
+    Threads::TaskGroup<void> tasks;
+    for (unsigned int worker = 0; worker < n_workers; ++worker)
+      tasks += Threads::new_task(std::function<void ()>([this, worker, n_workers, n_samples,
+                                                         &mean_state, &tip_displacement, &converged]()
+      {
+        SampleState state;
+        initialize_sample_state(state);
+
+        Vector<double> mu_scaling(triangulation.n_active_cells());
+        Vector<double> kappa_scaling(triangulation.n_active_cells());
+        for (unsigned int sample = worker; sample < n_samples; sample += n_workers)
+          {
+            sample_fields(sample, mu_scaling, kappa_scaling);
+            state.fields->set(0, mu_scaling);
+            state.fields->set(1, kappa_scaling);
+
+            state.displacement = mean_state.displacement;
+            converged[sample] = solve_equilibrium(state, 1.0);
+            tip_displacement[sample] = state.displacement(tip_dof);
+          }
+      }));
+    tasks.join_all();
+
+    unsigned int n_converged = 0;
+    double sum = 0.0, minimum = std::numeric_limits<double>::max(), maximum = -minimum;
+    for (unsigned int sample = 0; sample < n_samples; ++sample)
+      if (converged[sample])
+        {
+          ++n_converged;
+          sum += tip_displacement[sample];
+          minimum = std::min(minimum, tip_displacement[sample]);
+          maximum = std::max(maximum, tip_displacement[sample]);
+        }
+    AssertThrow(n_converged > 1, ExcMessage("Too few samples converged!"));
+
+    const double mean = sum / n_converged;
+    double variance = 0.0;
+    for (unsigned int sample = 0; sample < n_samples; ++sample)
+      if (converged[sample])
+        variance += (tip_displacement[sample] - mean) * (tip_displacement[sample] - mean);
+    variance /= (n_converged - 1);
+
+    tip_displacement_mean = mean;
+    tip_displacement_deviation = std::sqrt(variance);
+
+    std::cout << "Monte-Carlo samples: " << n_samples
+              << " on " << n_workers << " threads, "
+              << n_samples - n_converged << " not converged" << std::endl
+              << "Vertical tip displacement:"
+              << "\n\t Mean: " << mean
+              << "\n\t Standard deviation: " << std::sqrt(variance)
+              << "\n\t Standard error of the mean: " << std::sqrt(variance / n_converged)
+              << "\n\t Minimum: " << minimum
+              << "\n\t Maximum: " << maximum
+              << std::endl;
+  }
+
+  template <int dim,typename NumberType>
+  std::pair<double,double>
+  MonteCarlo<dim,NumberType>::get_tip_displacement_statistics() const
+  {
+    return std::make_pair(tip_displacement_mean, tip_displacement_deviation);
+  }
+
+// @sect4{MonteCarlo::make_grid}
+  template <int dim,typename NumberType>
+  void MonteCarlo<dim,NumberType>::make_grid()
+  {
+    make_cook_membrane_grid(triangulation, parameters.elements_per_edge, parameters.scale);
+  }
+
+// @sect4{MonteCarlo::system_setup}
+
+// The beam is clamped on the left and loaded by a unit vertical force on the
+// right as in Solid, see make_cook_membrane_constraints() and
+// assemble_cook_membrane_traction().
+  template <int dim,typename NumberType>
+  void MonteCarlo<dim,NumberType>::system_setup()
+  {
+    dof_handler.distribute_dofs(fe);
+    DoFRenumbering::Cuthill_McKee(dof_handler);
+
+    std::cout << "Triangulation:"
+              << "\n\t Number of active cells: " << triangulation.n_active_cells()
+              << "\n\t Number of degrees of freedom: " << dof_handler.n_dofs()
+              << std::endl;
+
+    constraints.clear();
+    make_cook_membrane_constraints(dof_handler, constraints);
+    constraints.close();
+
+    assemble_cook_membrane_traction(dof_handler, constraints, QGauss<dim-1>(n_q_points_1d),
+                                    parameters.scale, external_force);
+
+    tip_dof = get_cook_membrane_tip_dof(dof_handler, parameters.scale);
+
+    const QGauss<1> quad (n_q_points_1d);
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+
+    mf_data_reference = std::make_shared<MatrixFree<dim,double>>();
+    mf_data_reference->reinit(dof_handler, constraints, quad, data);
+  }
+
+// @sect4{MonteCarlo::setup_correlation}
+
+// The correlated standard normal field $\xi_e = \sum_f w_{ef} z_f$ is white
+// noise $z_f$ smoothed with the Gaussian kernel $w_{ef} \propto
+// \exp(-|\mathbf{x}_e - \mathbf{x}_f|^2 / \ell^2)$, which is cut off at three
+// correlation lengths $\ell$ and normalized to $\sum_f w_{ef}^2 = 1$ for unit
+// variance. As for the filter of the topology optimization, the neighbours
+// are found once by find_cells_within_radius().
+  template <int dim,typename NumberType>
+  void MonteCarlo<dim,NumberType>::setup_correlation()
+  {
+    const double length = parameters.correlation_length * parameters.scale;
+
+    if (length == 0.0)
+      {
+        correlation.clear();
+        correlation.resize(triangulation.n_active_cells());
+        for (unsigned int e = 0; e < correlation.size(); ++e)
+          correlation[e].push_back(std::make_pair(e, 1.0));
+        return;
+      }
+
+    correlation = find_cells_within_radius(triangulation, 3.0 * length);
+    for (auto &neighbors : correlation)
+      {
+        double norm = 0.0;
+        for (auto &neighbor : neighbors)
+          {
+            const double distance = neighbor.second;
+            neighbor.second = std::exp(-distance * distance / (length * length));
+            norm += neighbor.second * neighbor.second;
+          }
+
+        for (auto &neighbor : neighbors)
+          neighbor.second /= std::sqrt(norm);
+      }
+  }
+
+// @sect4{MonteCarlo::initialize_sample_state}
+  template <int dim,typename NumberType>
+  void MonteCarlo<dim,NumberType>::initialize_sample_state(SampleState &state) const
+  {
+    state.displacement.reinit(dof_handler.n_dofs());
+
+    // the mean material has unit scaling
+    state.fields = std::make_shared<CellCoefficients<dim,double>>();
+    state.fields->reinit(*mf_data_reference, 2);
+
+    state.mf_nh_operator.set_material(material_vec);
+    state.mf_nh_operator.set_material_fields(state.fields);
+  }
+
+// @sect4{MonteCarlo::sample_fields}
+
+// The shear modulus $\mu_e = \mu \exp(\sigma \xi_e - \sigma^2/2)$ is lognormal
+// with mean $\mu$ and the coefficient of variation $c_\mu$ for $\sigma^2 =
+// \ln(1 + c_\mu^2)$. The Poisson's ratio $\nu_e = \nu (1 + c_\nu \xi_e)$ is
+// restricted to $[0, 0.49]$. The operator needs both moduli relative to
+// those of the mean material, where the bulk modulus is $\kappa \propto \mu
+// (1 + \nu) / (1 - 2 \nu)$.
+  template <int dim,typename NumberType>
+  void MonteCarlo<dim,NumberType>::sample_fields(const unsigned int sample,
+                                                 Vector<double>    &mu_scaling,
+                                                 Vector<double>    &kappa_scaling) const
+  {
+    const unsigned int n_cells = triangulation.n_active_cells();
+
+    // Seeding with both numbers keeps the streams of different seeds and
+    // samples apart, which the linear combination of the two does not.
+    std::seed_seq seed {parameters.random_seed, sample};
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> normal;
+
+    Vector<double> noise_mu(n_cells), noise_nu(n_cells);
+    for (unsigned int f = 0; f < n_cells; ++f)
+      {
+        noise_mu(f) = normal(generator);
+        noise_nu(f) = normal(generator);
+      }
+
+    const double sigma_2 = std::log(1.0 + parameters.shear_modulus_variation
+                                    * parameters.shear_modulus_variation);
+    const double kappa_factor = (1.0 + parameters.nu) / (1.0 - 2.0 * parameters.nu);
+
+    for (unsigned int e = 0; e < n_cells; ++e)
+      {
+        double xi_mu = 0.0, xi_nu = 0.0;
+        for (const auto &neighbor : correlation[e])
+          {
+            xi_mu += neighbor.second * noise_mu(neighbor.first);
+            xi_nu += neighbor.second * noise_nu(neighbor.first);
+          }
+
+        const double nu = std::min(std::max(parameters.nu * (1.0 + parameters.poissons_ratio_variation * xi_nu),
+                                            0.0),
+                                   0.49);
+
+        mu_scaling(e) = std::exp(std::sqrt(sigma_2) * xi_mu - 0.5 * sigma_2);
+        kappa_scaling(e) = mu_scaling(e) * (1.0 + nu) / (1.0 - 2.0 * nu) / kappa_factor;
+      }
+  }
+
+// @sect4{MonteCarlo::solve_equilibrium}
+
+// The force residual is measured relative to the external force. A failure
+// of the linear solver or a distorted configuration ends the Newton scheme
+// without convergence.
+  template <int dim,typename NumberType>
+  bool MonteCarlo<dim,NumberType>::solve_equilibrium(SampleState &state,
+                                                     const double load_factor) const
+  {
+    Vector<double> residual(dof_handler.n_dofs());
+    Vector<double> update(dof_handler.n_dofs());
+
+    const double tolerance = parameters.tol_f * load_factor * external_force.l2_norm();
+
+    for (unsigned int newton_iteration = 0;
+         newton_iteration < parameters.max_iterations_NR;
+         ++newton_iteration)
+      {
+        update_current_configuration(state);
+
+        residual = 0.0;
+        state.mf_nh_operator.add_internal_forces(residual);
+        residual.sadd(-1.0, load_factor, external_force);
+
+        const double residual_norm = residual.l2_norm();
+        if (!numbers::is_finite(residual_norm))
+          return false;
+        if (residual_norm <= tolerance)
+          return true;
+
+        update = 0.0;
+        try
+          {
+            solve_linear_system(state, residual, update);
+          }
+        catch (const SolverControl::NoConvergence &)
+          {
+            return false;
+          }
+
+        state.displacement += update;
+      }
+
+    return false;
+  }
+
+// @sect4{MonteCarlo::update_current_configuration}
+  template <int dim,typename NumberType>
+  void MonteCarlo<dim,NumberType>::update_current_configuration(SampleState &state) const
+  {
+    const QGauss<1> quad (n_q_points_1d);
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+
+    if (!state.mf_data_current)
+      {
+        state.eulerian_mapping = std::make_shared<MappingQEulerian<dim,Vector<double>>>(/*mapping degree*/1,dof_handler,state.displacement);
+        state.mf_data_current = std::make_shared<MatrixFree<dim,double>>();
+        state.mf_data_current->reinit(*state.eulerian_mapping, dof_handler, constraints, quad, data);
+        state.mf_nh_operator.initialize(state.mf_data_current,mf_data_reference,state.displacement);
+      }
+    else
+      {
+        // only the mapping changes with the displacement
+        data.initialize_indices = false;
+        state.mf_data_current->reinit(*state.eulerian_mapping, dof_handler, constraints, quad, data);
+      }
+
+    state.mf_nh_operator.compute_diagonal();
+  }
+
+// @sect4{MonteCarlo::solve_linear_system}
+  template <int dim,typename NumberType>
+  unsigned int
+  MonteCarlo<dim,NumberType>::solve_linear_system(const SampleState    &state,
+                                                  const Vector<double> &rhs,
+                                                  Vector<double>       &update) const
+  {
+    const int solver_its = dof_handler.n_dofs()
+                           * parameters.max_iterations_lin;
+    const double tol_sol = parameters.tol_lin
+                           * rhs.l2_norm();
+
+    SolverControl solver_control(solver_its, tol_sol);
+    SolverCG<Vector<double> > solver_CG(solver_control);
+
+    PreconditionJacobi<NeoHookOperator<dim,degree,n_q_points_1d,double>> preconditioner;
+    preconditioner.initialize (state.mf_nh_operator,parameters.preconditioner_relaxation);
+
+    solver_CG.solve(state.mf_nh_operator, update, rhs, preconditioner);
+
+    constraints.distribute(update);
+
+    return solver_control.last_step();
+  }
+
+}
@@ -12,6 +12,10 @@
 #include <deal.II/matrix_free/fe_evaluation.h>
 
 #include <material.h>
+#include <material_history.h>
+#include <fiber_directions.h>
+#include <cell_coefficients.h>
+#include <mf_contact.h>
 
 using namespace dealii;
 
@@ -19,6 +23,10 @@ using namespace dealii;
    * Large strain Neo-Hook tangent operator.
    *
    * Follow https://github.com/dealii/dealii/blob/master/tests/matrix_free/step-37.cc
+   *
+   * General constraints, e.g. hanging nodes or periodicity, are resolved
+   * when the source vector is gathered and the result is scattered, so the
+   * operator acts on the condensed space. Constrained DoFs get identity rows.
    */
   template <int dim, int fe_degree, int n_q_points_1d, typename number>
   class NeoHookOperator : public Subscriptor
@@ -34,16 +42,146 @@ using namespace dealii;
                     std::shared_ptr<const MatrixFree<dim,number>> data_reference,
                     Vector<number> &displacement);
 
+    /**
+     * Like above, but without tables for the current configuration. The
+     * spatial gradients $\nabla_x \mathbf{v} = \nabla_0 \mathbf{v}
+     * \mathbf{F}^{-1}$ are computed within the kernel from the deformation
+     * gradient, which is evaluated anyway, and the tangent is integrated over
+     * the reference configuration. This saves the memory and the setup of
+     * the MatrixFree object of the current configuration and its Jacobians
+     * in every application, for a few more operations per quadrature point.
+     */
+    void initialize(std::shared_ptr<const MatrixFree<dim,number>> data_reference,
+                    Vector<number> &displacement);
+
     void set_material(std::shared_ptr<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<number>>> material);
 
+    /**
+     * Use the elastoplastic material instead of the neo-Hookean one. The
+     * tangent is evaluated by the return mapping from the old values in
+     * @p history at every application of the operator.
+     */
+    void set_material(std::shared_ptr<Material_J2_Plasticity<dim,VectorizedArray<number>>> plastic_material,
+                      std::shared_ptr<const MaterialHistory<dim,number>>                   history);
+
+    /**
+     * Add the viscous stress of the current time step, stored as the first
+     * history variables of @p history, to the neo-Hookean stress. The
+     * isochoric scaling of the viscoelastic material is part of the
+     * neo-Hookean material itself.
+     */
+    void set_viscous_history(std::shared_ptr<const MaterialHistory<dim,number>> history);
+
+    /**
+     * Add the anisotropic response of fiber families with the directions
+     * @p fibers to the neo-Hookean ground matrix.
+     */
+    void set_fibers(std::shared_ptr<Material_HGO_Fibers<dim,VectorizedArray<number>>> fiber_material,
+                    std::shared_ptr<const FiberDirections<dim,number>>                fibers);
+
+    /**
+     * Use the mean dilatation (F-bar) formulation against volumetric locking:
+     * the volumetric response of the neo-Hookean material is evaluated with
+     * the ratio of current and reference volume of each cell.
+     */
+    void set_mean_dilatation(const bool mean_dilatation);
+
+    /**
+     * Add the tangent of the penalty contact on the active boundary faces.
+     */
+    void set_contact(std::shared_ptr<const PenaltyContact<dim,fe_degree,n_q_points_1d,number>> contact);
+
+    /**
+     * Evaluate the neo-Hookean material with the mechanical part of the
+     * deformation gradient for the thermal expansion @p thermal_expansion.
+     * The @p temperature is the field with index @p temperature_dof_index of
+     * the MatrixFree object of the reference configuration and is read in
+     * the same cell loop as the displacement.
+     */
+    void set_thermal_expansion(std::shared_ptr<const Thermal_Expansion<dim,VectorizedArray<number>>> thermal_expansion,
+                               const Vector<number> &temperature,
+                               const unsigned int    temperature_dof_index);
+
+    /**
+     * Degrade the tensile energy of the neo-Hookean material with the
+     * phase-field @p damage, which is the field with index
+     * @p damage_dof_index of the MatrixFree object of the reference
+     * configuration and is read in the same cell loop as the displacement.
+     */
+    void set_phase_field(std::shared_ptr<const Phase_Field_Degradation<dim,VectorizedArray<number>>> degradation,
+                         const Vector<number> &damage,
+                         const unsigned int    damage_dof_index);
+
+    /**
+     * Scale the hyperelastic response, i.e. the neo-Hookean matrix and the
+     * fibers, on each cell by the first coefficient of @p scaling, e.g. the
+     * interpolated stiffness of a density based topology optimization. The
+     * coefficients are read once per cell batch.
+     */
+    void set_material_scaling(std::shared_ptr<const CellCoefficients<dim,number>> scaling);
+
+    /**
+     * Use shear and bulk moduli of the neo-Hookean material that vary from
+     * cell to cell, e.g. samples of random fields. They are given relative
+     * to those of the material as the components 0 and 1 of @p fields.
+     */
+    void set_material_fields(std::shared_ptr<const CellCoefficients<dim,number>> fields);
+
+    /**
+     * Cache the reference volume and the mean dilatation of each cell batch
+     * for the current displacement. This has to be called whenever the
+     * displacement changes before the operator is applied.
+     */
+    void compute_cell_dilatation();
+
     void compute_diagonal();
 
+    /**
+     * Global quantities of the current displacement that are integrated
+     * along with the internal forces.
+     */
+    struct GlobalQuantities
+    {
+      GlobalQuantities ();
+
+      number               current_volume;
+      number               strain_energy;
+      Tensor<1,dim,number> reaction_force;
+    };
+
+    /**
+     * Mark the DoFs whose internal forces add up to the reaction force, e.g.
+     * those of a clamped boundary, by ones in @p indicator.
+     */
+    void set_reaction_dofs(const Vector<number> &indicator);
+
+    /**
+     * Fused version of compute_diagonal() and add_internal_forces(), which
+     * reads and evaluates the displacement, the temperature and the damage
+     * only once per cell batch for both. Along the way, the current volume,
+     * the strain energy of the neo-Hookean matrix and the reaction force on
+     * the DoFs set by set_reaction_dofs() are integrated. The mapping of the
+     * current configuration has to be up to date.
+     */
+    GlobalQuantities compute_diagonal_and_internal_forces (Vector<double> &dst);
+
     unsigned int m () const;
     unsigned int n () const;
 
     void vmult (Vector<double> &dst,
                 const Vector<double> &src) const;
 
+    /**
+     * Apply the operator to a block of vectors at once. The gradient of the
+     * displacement and the temperature or damage field are evaluated only
+     * once per cell for all vectors, and the cell data is loaded once, which
+     * makes this cheaper than repeated calls to vmult(), e.g. within block
+     * eigensolvers. The stress and the action of the tangent are still
+     * computed at every quadrature point for each vector.
+     */
+    void vmult (std::vector<Vector<double>> &dst,
+                const std::vector<Vector<double>> &src) const;
+
     void Tvmult (Vector<double> &dst,
                  const Vector<double> &src) const;
     void vmult_add (Vector<double> &dst,
@@ -51,6 +189,36 @@ using namespace dealii;
     void Tvmult_add (Vector<double> &dst,
                      const Vector<double> &src) const;
 
+    /**
+     * Like vmult_add(), but @p src is read without resolving the
+     * constraints, so that it may violate them, e.g. an affine displacement
+     * on a periodic domain. The result is condensed as usual and the
+     * constrained rows of @p dst are not touched.
+     */
+    void vmult_add_unconstrained (Vector<double> &dst,
+                                  const Vector<double> &src) const;
+
+    /**
+     * Add the internal forces $\int_{\Omega_0} \mathbf{P} : \nabla_0 \delta
+     * \mathbf{v} \, dV$ of the current displacement to @p dst and return
+     * the integral $\int_{\Omega_0} \mathbf{P} \, dV$ of the first
+     * Piola-Kirchhoff stress. Only the hyperelastic materials without the
+     * mean dilatation are supported.
+     */
+    Tensor<2,dim,number> add_internal_forces (Vector<double> &dst) const;
+
+    /**
+     * Integral $\int_{\Omega_0} \mathsf{A} : \nabla_0 \mathbf{d} \, dV$ of
+     * the linearization of the first Piola-Kirchhoff stress in the direction
+     * @p direction, which is read without resolving the constraints. As the
+     * finite element interpolates linear functions exactly, the cell
+     * contributions $\mathbf{f}_k$ of the tangent applied to @p direction
+     * give the integral as $\sum_k \mathbf{f}_k \otimes \mathbf{X}_k$ with
+     * the nodal positions @p reference_coordinates.
+     */
+    Tensor<2,dim,number> integrate_stress_derivative (const Vector<double> &direction,
+                                                      const Vector<double> &reference_coordinates) const;
+
     number el (const unsigned int row,
                const unsigned int col) const;
 
@@ -58,6 +226,29 @@ using namespace dealii;
                              const Vector<number> &src,
                              const number omega) const;
 
+    /**
+     * Integrate the derivatives of the internal forces with respect to the
+     * material parameters $\mu$ and $\nu$ against the @p adjoint solution,
+     * $-\int_{\Omega_e} \nabla_x \boldsymbol{\lambda} :
+     * \partial \boldsymbol{\tau} / \partial p \, dV$, and store the results
+     * per cell (indexed by the active cell index). Only the reference
+     * configuration is used.
+     */
+    void compute_parameter_sensitivities(const Vector<number> &adjoint,
+                                         Vector<double>       &cell_sensitivity_mu,
+                                         Vector<double>       &cell_sensitivity_nu) const;
+
+    /**
+     * Integrate the derivatives of the internal forces with respect to the
+     * material scaling against the @p adjoint solution, $-\int_{\Omega_e}
+     * \nabla_x \boldsymbol{\lambda} : \boldsymbol{\tau}_0 \, dV$ with the
+     * unscaled Kirchhoff stress $\boldsymbol{\tau}_0$, and store the results
+     * per cell (indexed by the active cell index). All lanes of a cell batch
+     * are integrated at once.
+     */
+    void compute_scaling_sensitivities(const Vector<number> &adjoint,
+                                       Vector<double>       &cell_sensitivity) const;
+
   private:
 
     /**
@@ -66,7 +257,16 @@ using namespace dealii;
     void local_apply_cell (const MatrixFree<dim,number>    &data,
                            Vector<double>                      &dst,
                            const Vector<double>                &src,
-                           const std::pair<unsigned int,unsigned int> &cell_range) const;
+                           const std::pair<unsigned int,unsigned int> &cell_range,
+                           const bool                           resolve_constraints = true) const;
+
+    /**
+     * Apply operator on a range of cells for a block of vectors.
+     */
+    void local_apply_cell_block (const MatrixFree<dim,number>         &data,
+                                 std::vector<Vector<double>>          &dst,
+                                 const std::vector<Vector<double>>    &src,
+                                 const std::pair<unsigned int,unsigned int> &cell_range) const;
 
     /**
      * Apply diagonal part of the operator on a cell range.
@@ -76,14 +276,76 @@ using namespace dealii;
                               const unsigned int &,
                               const std::pair<unsigned int,unsigned int>       &cell_range) const;
 
+    /**
+     * Diagonal of the operator on the cell batch @p cell, which is left in
+     * the DoF values of @p phi_current. The arguments are those of
+     * do_operation_on_cell().
+     */
+    void compute_local_diagonal(FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current,
+                                FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current_s,
+                                FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_reference,
+                                const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+                                const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
+                                const unsigned int cell) const;
+
+    /**
+     * Reset the diagonal before the cell contributions are added, and
+     * complete it with the contact, the constrained DoFs and the inverse
+     * afterwards.
+     */
+    Vector<number> &reinit_diagonal();
+    void finalize_diagonal();
+
+    /**
+     * Read and evaluate the scalar @p field with index @p dof_index, i.e. the
+     * temperature or the damage, on the cell batch @p cell and return the
+     * evaluator, or nullptr if the field is not used.
+     */
+    const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *
+    evaluate_scalar_field(std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> &phi,
+                          const Vector<number> *field,
+                          const unsigned int    dof_index,
+                          const unsigned int    cell) const;
+
+    /**
+     * Kirchhoff stress of the hyperelastic materials at the quadrature point
+     * @p q of the cell batch @p cell. The material scaling, if any, is only
+     * applied if @p scale is true.
+     */
+    SymmetricTensor<2,dim,VectorizedArray<number>>
+    get_tau(const Tensor<2,dim,VectorizedArray<number>>            &F,
+            const Tensor<1,dim,VectorizedArray<number>>            *a_0,
+            const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+            const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
+            const unsigned int                                       cell,
+            const unsigned int                                       q,
+            const bool                                               scale = true) const;
+
+    /**
+     * Energy of the neo-Hookean matrix at the quadrature point @p q of the
+     * cell batch @p cell with the same scalings as in get_tau().
+     */
+    VectorizedArray<number>
+    get_strain_energy(const Tensor<2,dim,VectorizedArray<number>>            &F,
+                      const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+                      const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
+                      const unsigned int                                       cell,
+                      const unsigned int                                       q) const;
 
    /**
     * Perform operation on a cell. @p phi_current and @phi_current_s correspond to the deformed configuration
     * where @p phi_reference is for the current configuration.
+    *
+    * The gradients of the displacement in @p phi_reference and the values of
+    * the temperature in @p phi_temperature and of the damage in
+    * @p phi_damage, if any, have to be evaluated beforehand, so that they can
+    * be reused for several source vectors.
     */
    void do_operation_on_cell(FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current,
                              FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current_s,
                              FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_reference,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
                              const unsigned int cell) const;
 
     std::shared_ptr<const MatrixFree<dim,number>> data_current;
@@ -91,8 +353,41 @@ using namespace dealii;
 
     Vector<number> *displacement;
 
+    // whether data_current is data_reference and the current geometry is
+    // computed on the fly
+    bool geometry_on_the_fly;
+
     std::shared_ptr<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<number>>> material;
 
+    std::shared_ptr<Material_J2_Plasticity<dim,VectorizedArray<number>>> plastic_material;
+    std::shared_ptr<const MaterialHistory<dim,number>>                   history;
+
+    std::shared_ptr<const MaterialHistory<dim,number>> viscous_history;
+
+    std::shared_ptr<Material_HGO_Fibers<dim,VectorizedArray<number>>> fiber_material;
+    std::shared_ptr<const FiberDirections<dim,number>>                fibers;
+
+    bool mean_dilatation;
+
+    std::shared_ptr<const PenaltyContact<dim,fe_degree,n_q_points_1d,number>> contact;
+
+    std::shared_ptr<const Thermal_Expansion<dim,VectorizedArray<number>>> thermal_expansion;
+    const Vector<number> *temperature;
+    unsigned int          temperature_dof_index;
+
+    std::shared_ptr<const Phase_Field_Degradation<dim,VectorizedArray<number>>> degradation;
+    const Vector<number> *damage;
+    unsigned int          damage_dof_index;
+
+    std::shared_ptr<const CellCoefficients<dim,number>> material_scaling;
+    std::shared_ptr<const CellCoefficients<dim,number>> material_fields;
+
+    const Vector<number> *reaction_dofs;
+
+    // reference volume and mean dilatation of each cell batch
+    AlignedVector<VectorizedArray<number>> cell_volume;
+    AlignedVector<VectorizedArray<number>> cell_dilatation;
+
     std::shared_ptr<DiagonalMatrix<Vector<number>>>  inverse_diagonal_entries;
     std::shared_ptr<DiagonalMatrix<Vector<number>>>  diagonal_entries;
 
@@ -105,11 +400,28 @@ using namespace dealii;
   NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::NeoHookOperator ()
     :
     Subscriptor(),
+    displacement(nullptr),
+    geometry_on_the_fly(false),
+    mean_dilatation(false),
+    temperature(nullptr),
+    temperature_dof_index(numbers::invalid_unsigned_int),
+    damage(nullptr),
+    damage_dof_index(numbers::invalid_unsigned_int),
+    reaction_dofs(nullptr),
     diagonal_is_available(false)
   {}
 
 
 
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::GlobalQuantities::GlobalQuantities ()
+    :
+    current_volume(0.),
+    strain_energy(0.)
+  {}
+
+
+
   template <int dim, int fe_degree, int n_q_points_1d, typename number>
   void
   NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::precondition_Jacobi(Vector<number> &dst,
@@ -151,6 +463,8 @@ using namespace dealii;
     diagonal_is_available = false;
     diagonal_entries.reset();
     inverse_diagonal_entries.reset();
+    cell_volume.clear();
+    cell_dilatation.clear();
   }
 
 
@@ -165,6 +479,21 @@ using namespace dealii;
     data_current = data_current_;
     data_reference = data_reference_;
     displacement = &displacement_;
+    geometry_on_the_fly = false;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::initialize(
+                    std::shared_ptr<const MatrixFree<dim,number>> data_reference_,
+                    Vector<number> &displacement_)
+  {
+    data_current = data_reference_;
+    data_reference = data_reference_;
+    displacement = &displacement_;
+    geometry_on_the_fly = true;
   }
 
 
@@ -178,6 +507,185 @@ using namespace dealii;
 
 
 
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_material(
+                    std::shared_ptr<Material_J2_Plasticity<dim,VectorizedArray<number>>> plastic_material_,
+                    std::shared_ptr<const MaterialHistory<dim,number>>                   history_)
+  {
+    plastic_material = plastic_material_;
+    history = history_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_viscous_history(
+                    std::shared_ptr<const MaterialHistory<dim,number>> history_)
+  {
+    viscous_history = history_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_fibers(
+                    std::shared_ptr<Material_HGO_Fibers<dim,VectorizedArray<number>>> fiber_material_,
+                    std::shared_ptr<const FiberDirections<dim,number>>                fibers_)
+  {
+    fiber_material = fiber_material_;
+    fibers = fibers_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_mean_dilatation(const bool mean_dilatation_)
+  {
+    mean_dilatation = mean_dilatation_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_contact(
+                    std::shared_ptr<const PenaltyContact<dim,fe_degree,n_q_points_1d,number>> contact_)
+  {
+    contact = contact_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_thermal_expansion(
+                    std::shared_ptr<const Thermal_Expansion<dim,VectorizedArray<number>>> thermal_expansion_,
+                    const Vector<number> &temperature_,
+                    const unsigned int    temperature_dof_index_)
+  {
+    Assert (!plastic_material && !mean_dilatation, ExcNotImplemented());
+    thermal_expansion = thermal_expansion_;
+    temperature = &temperature_;
+    temperature_dof_index = temperature_dof_index_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_material_scaling(
+                    std::shared_ptr<const CellCoefficients<dim,number>> scaling_)
+  {
+    Assert (!plastic_material, ExcNotImplemented());
+    material_scaling = scaling_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_material_fields(
+                    std::shared_ptr<const CellCoefficients<dim,number>> fields_)
+  {
+    Assert (!plastic_material && !mean_dilatation && !degradation, ExcNotImplemented());
+    Assert (fields_->n_components() == 2, ExcDimensionMismatch(fields_->n_components(), 2));
+    material_fields = fields_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_phase_field(
+                    std::shared_ptr<const Phase_Field_Degradation<dim,VectorizedArray<number>>> degradation_,
+                    const Vector<number> &damage_,
+                    const unsigned int    damage_dof_index_)
+  {
+    Assert (!plastic_material && !mean_dilatation && !material_fields, ExcNotImplemented());
+    degradation = degradation_;
+    damage = &damage_;
+    damage_dof_index = damage_dof_index_;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::set_reaction_dofs(const Vector<number> &indicator)
+  {
+    reaction_dofs = &indicator;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::evaluate_scalar_field(
+                    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> &phi,
+                    const Vector<number> *field,
+                    const unsigned int    dof_index,
+                    const unsigned int    cell) const
+  {
+    if (field == nullptr)
+      return nullptr;
+
+    if (!phi)
+      phi.reset(new FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>(*data_reference, dof_index));
+
+    phi->reinit(cell);
+    phi->read_dof_values_plain(*field);
+    phi->evaluate (true,false,false);
+    return phi.get();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::compute_cell_dilatation()
+  {
+    if (!mean_dilatation)
+      return;
+
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+
+    const unsigned int n_cells = data_reference->n_macro_cells();
+    cell_volume.resize(n_cells);
+    cell_dilatation.resize(n_cells);
+
+    for (unsigned int cell=0; cell<n_cells; ++cell)
+      {
+        phi_reference.reinit(cell);
+        phi_reference.read_dof_values_plain(*displacement);
+        phi_reference.evaluate (false,true,false);
+
+        VectorizedArray<number> volume = make_vectorized_array<number>(0.);
+        VectorizedArray<number> current_volume = make_vectorized_array<number>(0.);
+        for (unsigned int q=0; q<phi_reference.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<number>> F = Physics::Elasticity::Kinematics::F(phi_reference.get_gradient(q));
+            volume += phi_reference.JxW(q);
+            current_volume += determinant(F) * phi_reference.JxW(q);
+          }
+
+        // unfilled lanes have zero volume
+        for (unsigned int v=data_reference->n_components_filled(cell); v<VectorizedArray<number>::n_array_elements; ++v)
+          {
+            volume[v] = 1.;
+            current_volume[v] = 1.;
+          }
+
+        cell_volume[cell] = volume;
+        cell_dilatation[cell] = current_volume / volume;
+      }
+  }
+
+
+
   template <int dim, int fe_degree, int n_q_points_1d, typename number>
   void
   NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::vmult (Vector<double>       &dst,
@@ -233,6 +741,9 @@ using namespace dealii;
     local_apply_cell(*data_current, dst, src,
                      std::make_pair<unsigned int,unsigned int>(0,data_current->n_macro_cells()));
 
+    if (contact)
+      contact->vmult_add(dst, src);
+
     // 3. communicate results with MPI
     // dst.compress(VectorOperation::add);
 
@@ -245,19 +756,150 @@ using namespace dealii;
 
 
 
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::vmult_add_unconstrained (Vector<double>       &dst,
+                                                                  const Vector<double> &src) const
+  {
+    Assert (data_current->n_macro_cells() == data_reference->n_macro_cells(), ExcInternalError());
+
+    local_apply_cell(*data_current, dst, src,
+                     std::make_pair<unsigned int,unsigned int>(0,data_current->n_macro_cells()),
+                     false);
+
+    if (contact)
+      contact->vmult_add(dst, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  Tensor<2,dim,number>
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::add_internal_forces (Vector<double> &dst) const
+  {
+    AssertThrow (!plastic_material && !mean_dilatation && !contact, ExcNotImplemented());
+
+    typedef Material_HGO_Fibers<dim,VectorizedArray<number>> FiberMaterial;
+
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_temperature;
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_damage;
+
+    Tensor<2,dim,number> stress_integral;
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_reference.reinit(cell);
+        phi_reference.read_dof_values_plain(*displacement);
+        phi_reference.evaluate (false,true,false);
+        const auto phi_temperature_cell = evaluate_scalar_field(phi_temperature,temperature,temperature_dof_index,cell);
+        const auto phi_damage_cell      = evaluate_scalar_field(phi_damage,damage,damage_dof_index,cell);
+
+        Tensor<1,dim,VectorizedArray<number>> a_0[FiberMaterial::max_fiber_families];
+        if (fiber_material)
+          for (unsigned int f = 0; f < fibers->n_fiber_families(); ++f)
+            a_0[f] = fibers->get(cell,f);
+
+        Tensor<2,dim,VectorizedArray<number>> cell_stress_integral;
+        for (unsigned int q=0; q<phi_reference.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<number>> F =
+              Physics::Elasticity::Kinematics::F(phi_reference.get_gradient(q));
+            const Tensor<2,dim,VectorizedArray<number>> P =
+              Tensor<2,dim,VectorizedArray<number>>(get_tau(F,a_0,phi_temperature_cell,phi_damage_cell,cell,q)) *
+              transpose(invert(F));
+
+            cell_stress_integral += P * phi_reference.JxW(q);
+            phi_reference.submit_gradient(P,q);
+          }
+
+        phi_reference.integrate (false,true);
+        phi_reference.distribute_local_to_global(dst);
+
+        for (unsigned int v=0; v<data_reference->n_components_filled(cell); ++v)
+          for (unsigned int i=0; i<dim; ++i)
+            for (unsigned int j=0; j<dim; ++j)
+              stress_integral[i][j] += cell_stress_integral[i][j][v];
+      }
+
+    return stress_integral;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  Tensor<2,dim,number>
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::integrate_stress_derivative (
+                           const Vector<double> &direction,
+                           const Vector<double> &reference_coordinates) const
+  {
+    AssertThrow (!contact, ExcNotImplemented());
+
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current  (*data_current);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current_s(*data_current);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_position (*data_reference);
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_temperature;
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_damage;
+
+    const unsigned int dofs_per_component = phi_current.dofs_per_component;
+
+    Tensor<2,dim,number> stress_derivative;
+    for (unsigned int cell=0; cell<data_current->n_macro_cells(); ++cell)
+      {
+        phi_current.reinit(cell);
+        phi_current_s.reinit(cell);
+        phi_reference.reinit(cell);
+        phi_position.reinit(cell);
+
+        phi_reference.read_dof_values_plain(*displacement);
+        phi_reference.evaluate (false,true,false);
+        phi_current.  read_dof_values_plain(direction);
+        phi_current_s.read_dof_values_plain(direction);
+        phi_position. read_dof_values_plain(reference_coordinates);
+
+        do_operation_on_cell(phi_current,phi_current_s,phi_reference,
+                             evaluate_scalar_field(phi_temperature,temperature,temperature_dof_index,cell),
+                             evaluate_scalar_field(phi_damage,damage,damage_dof_index,cell),cell);
+
+        Tensor<2,dim,VectorizedArray<number>> cell_stress_derivative;
+        for (unsigned int i=0; i<dim; ++i)
+          for (unsigned int j=0; j<dim; ++j)
+            for (unsigned int k=0; k<dofs_per_component; ++k)
+              cell_stress_derivative[i][j] += (phi_current.  begin_dof_values()[i*dofs_per_component+k] +
+                                               phi_current_s.begin_dof_values()[i*dofs_per_component+k]) *
+                                              phi_position.begin_dof_values()[j*dofs_per_component+k];
+
+        for (unsigned int v=0; v<data_current->n_components_filled(cell); ++v)
+          for (unsigned int i=0; i<dim; ++i)
+            for (unsigned int j=0; j<dim; ++j)
+              stress_derivative[i][j] += cell_stress_derivative[i][j][v];
+      }
+
+    return stress_derivative;
+  }
+
+
+
   template <int dim, int fe_degree, int n_q_points_1d, typename number>
   void
   NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::local_apply_cell (
                            const MatrixFree<dim,number>    &/*data*/,
                            Vector<double>                      &dst,
                            const Vector<double>                &src,
-                           const std::pair<unsigned int,unsigned int> &cell_range) const
+                           const std::pair<unsigned int,unsigned int> &cell_range,
+                           const bool                           resolve_constraints) const
   {
-    // FIXME: I don't use data input, can this be bad?
+    // The cell range refers to data_current, whose cell batches are those
+    // of data_reference as both are set up on the same DoFHandler with the
+    // same settings. The evaluators are therefore bound to the two objects
+    // explicitly instead of to the one the loop passes in.
+    Assert (data_current->n_macro_cells() == data_reference->n_macro_cells(), ExcInternalError());
 
     FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current  (*data_current);
     FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current_s(*data_current);
     FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_temperature;
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_damage;
 
     Assert (phi_current.n_q_points == phi_reference.n_q_points, ExcInternalError());
 
@@ -270,13 +912,98 @@ using namespace dealii;
 
         // read-in total displacement and src vector and evaluate gradients
         phi_reference.read_dof_values_plain(*displacement);
-        phi_current.  read_dof_values(src);
-        phi_current_s.read_dof_values(src);
-
-        do_operation_on_cell(phi_current,phi_current_s,phi_reference,cell);
+        phi_reference.evaluate (false,true,false);
+        if (resolve_constraints)
+          {
+            phi_current.  read_dof_values(src);
+            if (!geometry_on_the_fly)
+              phi_current_s.read_dof_values(src);
+          }
+        else
+          {
+            phi_current.  read_dof_values_plain(src);
+            if (!geometry_on_the_fly)
+              phi_current_s.read_dof_values_plain(src);
+          }
+
+        do_operation_on_cell(phi_current,phi_current_s,phi_reference,
+                             evaluate_scalar_field(phi_temperature,temperature,temperature_dof_index,cell),
+                             evaluate_scalar_field(phi_damage,damage,damage_dof_index,cell),cell);
 
         phi_current.distribute_local_to_global(dst);
-        phi_current_s.distribute_local_to_global(dst);
+        if (!geometry_on_the_fly)
+          phi_current_s.distribute_local_to_global(dst);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::vmult (std::vector<Vector<double>>       &dst,
+                                                              const std::vector<Vector<double>> &src) const
+  {
+    Assert (dst.size() == src.size(), ExcDimensionMismatch(dst.size(), src.size()));
+    Assert (data_current->n_macro_cells() == data_reference->n_macro_cells(), ExcInternalError());
+
+    for (unsigned int b=0; b<dst.size(); ++b)
+      dst[b] = 0;
+
+    local_apply_cell_block(*data_current, dst, src,
+                           std::make_pair<unsigned int,unsigned int>(0,data_current->n_macro_cells()));
+
+    if (contact)
+      for (unsigned int b=0; b<dst.size(); ++b)
+        contact->vmult_add(dst[b], src[b]);
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data_current->get_constrained_dofs();
+    for (unsigned int b=0; b<dst.size(); ++b)
+      for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+        dst[b](constrained_dofs[i]) += src[b](constrained_dofs[i]);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::local_apply_cell_block (
+                           const MatrixFree<dim,number>               &/*data*/,
+                           std::vector<Vector<double>>                &dst,
+                           const std::vector<Vector<double>>          &src,
+                           const std::pair<unsigned int,unsigned int> &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current  (*data_current);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current_s(*data_current);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_temperature;
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_damage;
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi_current.reinit(cell);
+        phi_current_s.reinit(cell);
+        phi_reference.reinit(cell);
+
+        // the total displacement and the temperature are read and evaluated
+        // once for all vectors
+        phi_reference.read_dof_values_plain(*displacement);
+        phi_reference.evaluate (false,true,false);
+        const auto phi_temperature_cell = evaluate_scalar_field(phi_temperature,temperature,temperature_dof_index,cell);
+        const auto phi_damage_cell      = evaluate_scalar_field(phi_damage,damage,damage_dof_index,cell);
+
+        for (unsigned int b=0; b<src.size(); ++b)
+          {
+            phi_current.  read_dof_values(src[b]);
+            if (!geometry_on_the_fly)
+              phi_current_s.read_dof_values(src[b]);
+
+            do_operation_on_cell(phi_current,phi_current_s,phi_reference,phi_temperature_cell,phi_damage_cell,cell);
+
+            phi_current.distribute_local_to_global(dst[b]);
+            if (!geometry_on_the_fly)
+              phi_current_s.distribute_local_to_global(dst[b]);
+          }
       }
   }
 
@@ -289,11 +1016,17 @@ using namespace dealii;
                               const unsigned int &,
                               const std::pair<unsigned int,unsigned int>       &cell_range) const
   {
-    // FIXME: I don't use data input, can this be bad?
+    // The cell range refers to data_current, whose cell batches are those
+    // of data_reference as both are set up on the same DoFHandler with the
+    // same settings. The evaluators are therefore bound to the two objects
+    // explicitly instead of to the one the loop passes in.
+    Assert (data_current->n_macro_cells() == data_reference->n_macro_cells(), ExcInternalError());
 
     FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current  (*data_current);
     FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current_s(*data_current);
     FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_temperature;
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_damage;
 
     for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
       {
@@ -302,53 +1035,13 @@ using namespace dealii;
         phi_current_s.reinit(cell);
         phi_reference.reinit(cell);
 
-        // read-in total displacement.
+        // read-in total displacement and temperature.
         phi_reference.read_dof_values_plain(*displacement);
+        phi_reference.evaluate (false,true,false);
+        const auto phi_temperature_cell = evaluate_scalar_field(phi_temperature,temperature,temperature_dof_index,cell);
+        const auto phi_damage_cell      = evaluate_scalar_field(phi_damage,damage,damage_dof_index,cell);
 
-        // FIXME: although we override DoFs manually later, somehow
-        // we still need to read some dummy here
-        phi_current.read_dof_values(*displacement);
-        phi_current_s.read_dof_values(*displacement);
-
-        AlignedVector<VectorizedArray<number>> local_diagonal_vector(phi_current.dofs_per_component*phi_current.n_components);
-
-        // Loop over all DoFs and set dof values to zero everywhere but i-th DoF.
-        // With this input (instead of read_dof_values()) we do the action and store the
-        // result in a diagonal vector
-        for (unsigned int i=0; i<phi_current.dofs_per_component; ++i)
-          for (unsigned int ic=0; ic<phi_current.n_components; ++ic)
-            {
-              for (unsigned int j=0; j<phi_current.dofs_per_component; ++j)
-                for (unsigned int jc=0; jc<phi_current.n_components; ++jc)
-                  {
-                    const auto ind_j = j+jc*phi_current.dofs_per_component;
-                    phi_current.begin_dof_values()  [ind_j] = VectorizedArray<number>();
-                    phi_current_s.begin_dof_values()[ind_j] = VectorizedArray<number>();
-                  }
-
-              const auto ind_i = i+ic*phi_current.dofs_per_component;
-
-              phi_current.begin_dof_values()  [ind_i] = 1.;
-              phi_current_s.begin_dof_values()[ind_i] = 1.;
-
-              do_operation_on_cell(phi_current,phi_current_s,phi_reference,cell);
-
-              local_diagonal_vector[ind_i] = phi_current.begin_dof_values()[ind_i] +
-                                             phi_current_s.begin_dof_values()[ind_i];
-            }
-
-        // Finally, in order to distribute diagonal, write it again into one of
-        // FEEvaluations and do the standard distribute_local_to_global.
-        // Note that here non-diagonal matrix elements are ignored and so the result is
-        // not equivalent to matrix-based case when hanging nodes are present.
-        // see Section 5.3 in Korman 2016, A time-space adaptive method for the Schrodinger equation, doi: 10.4208/cicp.101214.021015a
-        // for a discussion.
-        for (unsigned int i=0; i<phi_current.dofs_per_component; ++i)
-          for (unsigned int ic=0; ic<phi_current.n_components; ++ic)
-            {
-              const auto ind_i = i+ic*phi_current.dofs_per_component;
-              phi_current.begin_dof_values()[ind_i] = local_diagonal_vector[ind_i];
-            }
+        compute_local_diagonal(phi_current,phi_current_s,phi_reference,phi_temperature_cell,phi_damage_cell,cell);
 
         phi_current.distribute_local_to_global (dst);
       } // end of cell loop
@@ -356,36 +1049,315 @@ using namespace dealii;
 
 
 
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::compute_local_diagonal(
+                             FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current,
+                             FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current_s,
+                             FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_reference,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
+                             const unsigned int cell) const
+  {
+    // FIXME: although we override DoFs manually later, somehow
+    // we still need to read some dummy here
+    phi_current.read_dof_values(*displacement);
+    phi_current_s.read_dof_values(*displacement);
+
+    AlignedVector<VectorizedArray<number>> local_diagonal_vector(phi_current.dofs_per_component*phi_current.n_components);
+
+    // Loop over all DoFs and set dof values to zero everywhere but i-th DoF.
+    // With this input (instead of read_dof_values()) we do the action and store the
+    // result in a diagonal vector
+    for (unsigned int i=0; i<phi_current.dofs_per_component; ++i)
+      for (unsigned int ic=0; ic<phi_current.n_components; ++ic)
+        {
+          for (unsigned int j=0; j<phi_current.dofs_per_component; ++j)
+            for (unsigned int jc=0; jc<phi_current.n_components; ++jc)
+              {
+                const auto ind_j = j+jc*phi_current.dofs_per_component;
+                phi_current.begin_dof_values()  [ind_j] = VectorizedArray<number>();
+                phi_current_s.begin_dof_values()[ind_j] = VectorizedArray<number>();
+              }
+
+          const auto ind_i = i+ic*phi_current.dofs_per_component;
+
+          phi_current.begin_dof_values()  [ind_i] = 1.;
+          phi_current_s.begin_dof_values()[ind_i] = 1.;
+
+          do_operation_on_cell(phi_current,phi_current_s,phi_reference,phi_temperature,phi_damage,cell);
+
+          local_diagonal_vector[ind_i] = phi_current.begin_dof_values()[ind_i] +
+                                         phi_current_s.begin_dof_values()[ind_i];
+        }
+
+    // Finally, in order to distribute diagonal, write it again into one of
+    // FEEvaluations and do the standard distribute_local_to_global.
+    // Note that here non-diagonal matrix elements are ignored and so the result is
+    // not equivalent to matrix-based case when hanging nodes are present.
+    // see Section 5.3 in Korman 2016, A time-space adaptive method for the Schrodinger equation, doi: 10.4208/cicp.101214.021015a
+    // for a discussion.
+    for (unsigned int i=0; i<phi_current.dofs_per_component; ++i)
+      for (unsigned int ic=0; ic<phi_current.n_components; ++ic)
+        {
+          const auto ind_i = i+ic*phi_current.dofs_per_component;
+          phi_current.begin_dof_values()[ind_i] = local_diagonal_vector[ind_i];
+        }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  SymmetricTensor<2,dim,VectorizedArray<number>>
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::get_tau(
+                             const Tensor<2,dim,VectorizedArray<number>>            &F,
+                             const Tensor<1,dim,VectorizedArray<number>>            *a_0,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
+                             const unsigned int                                       cell,
+                             const unsigned int                                       q,
+                             const bool                                               scale) const
+  {
+    Assert (!plastic_material && !mean_dilatation, ExcNotImplemented());
+
+    VectorizedArray<number>                              det_F  = determinant(F);
+    const Tensor<2,dim,VectorizedArray<number>>          F_bar  = F_iso(F);
+    const SymmetricTensor<2,dim,VectorizedArray<number>> b_bar  = Physics::Elasticity::Kinematics::b(F_bar);
+
+    if (thermal_expansion)
+      det_F = thermal_expansion->get_det_F_mechanical(det_F,phi_temperature->get_value(q));
+
+    SymmetricTensor<2,dim,VectorizedArray<number>> tau;
+    if (material_fields)
+      material->get_tau(tau,det_F,b_bar,material_fields->get(cell,0),material_fields->get(cell,1));
+    else if (degradation)
+      {
+        VectorizedArray<number> mu_scaling = make_vectorized_array<number>(1.);
+        VectorizedArray<number> kappa_scaling = make_vectorized_array<number>(1.);
+        degradation->degrade(det_F,phi_damage->get_value(q),mu_scaling,kappa_scaling);
+        material->get_tau(tau,det_F,b_bar,mu_scaling,kappa_scaling);
+      }
+    else
+      material->get_tau(tau,det_F,b_bar);
+
+    if (fiber_material)
+      {
+        typename Material_HGO_Fibers<dim,VectorizedArray<number>>::State fiber_state;
+        fiber_material->evaluate(fiber_state,F_bar,a_0,fibers->n_fiber_families());
+        tau += fiber_state.tau;
+      }
+
+    if (material_scaling && scale)
+      tau *= material_scaling->get(cell,0);
+
+    if (viscous_history)
+      {
+        std::array<VectorizedArray<number>,Viscoelastic_Prony_Series<dim,VectorizedArray<number>>::n_stress_components> H;
+        viscous_history->read_old(cell,q,H);
+        tau += Viscoelastic_Prony_Series<dim,VectorizedArray<number>>::get_tau_viscous(F,H.data());
+      }
+
+    return tau;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  VectorizedArray<number>
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::get_strain_energy(
+                             const Tensor<2,dim,VectorizedArray<number>>            &F,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
+                             const unsigned int                                       cell,
+                             const unsigned int                                       q) const
+  {
+    VectorizedArray<number>                              det_F  = determinant(F);
+    const SymmetricTensor<2,dim,VectorizedArray<number>> b_bar  =
+      Physics::Elasticity::Kinematics::b(F_iso(F));
+
+    if (thermal_expansion)
+      det_F = thermal_expansion->get_det_F_mechanical(det_F,phi_temperature->get_value(q));
+
+    VectorizedArray<number> mu_scaling = make_vectorized_array<number>(1.);
+    VectorizedArray<number> kappa_scaling = make_vectorized_array<number>(1.);
+    if (material_fields)
+      {
+        mu_scaling = material_fields->get(cell,0);
+        kappa_scaling = material_fields->get(cell,1);
+      }
+    else if (degradation)
+      degradation->degrade(det_F,phi_damage->get_value(q),mu_scaling,kappa_scaling);
+
+    VectorizedArray<number> energy = material->get_Psi(det_F,b_bar,mu_scaling,kappa_scaling);
+    if (material_scaling)
+      energy *= material_scaling->get(cell,0);
+
+    return energy;
+  }
+
+
+
   template <int dim, int fe_degree, int n_q_points_1d, typename number>
   void
   NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::do_operation_on_cell(
                              FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current,
                              FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_current_s,
                              FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> &phi_reference,
-                             const unsigned int /*cell*/) const
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_temperature,
+                             const FEEvaluation<dim,fe_degree,n_q_points_1d,1,number> *phi_damage,
+                             const unsigned int cell) const
   {
-    phi_reference.evaluate (false,true,false);
-    phi_current.  evaluate (false,true,false);
-    phi_current_s.evaluate (false,true,false);
+    // On the fly, phi_current holds the reference gradients and the whole
+    // tangent is integrated with it:
+    phi_current.evaluate (false,true,false);
+    if (!geometry_on_the_fly)
+      phi_current_s.evaluate (false,true,false);
+
+    typedef Material_J2_Plasticity<dim,VectorizedArray<number>> PlasticMaterial;
+    typedef Material_HGO_Fibers<dim,VectorizedArray<number>>    FiberMaterial;
+
+    // the fiber directions are constant on the cell batch
+    Tensor<1,dim,VectorizedArray<number>> a_0[FiberMaterial::max_fiber_families];
+    const unsigned int n_fiber_families = fiber_material ? fibers->n_fiber_families() : 0;
+    for (unsigned int f = 0; f < n_fiber_families; ++f)
+      a_0[f] = fibers->get(cell,f);
+
+    // and so are the scaling of the material and the moduli of the fields
+    const VectorizedArray<number> scaling = material_scaling ?
+                                            material_scaling->get(cell,0) :
+                                            make_vectorized_array<number>(1.);
+    const VectorizedArray<number> mu_scaling = material_fields ?
+                                               material_fields->get(cell,0) :
+                                               make_vectorized_array<number>(1.);
+    const VectorizedArray<number> kappa_scaling = material_fields ?
+                                                  material_fields->get(cell,1) :
+                                                  make_vectorized_array<number>(1.);
+
+    // For the mean dilatation formulation the change of the cell volume
+    // $\int_{\Omega^e} \nabla \cdot \mathbf{v} \, dv$ couples the
+    // quadrature points through the pressure:
+    VectorizedArray<number> theta = make_vectorized_array<number>(1.);
+    VectorizedArray<number> pressure_coupling = make_vectorized_array<number>(0.);
+    if (mean_dilatation)
+      {
+        Assert (cell_dilatation.size() == data_reference->n_macro_cells(), ExcNotInitialized());
+        theta = cell_dilatation[cell];
+
+        VectorizedArray<number> volume_change = make_vectorized_array<number>(0.);
+        for (unsigned int q=0; q<phi_current.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<number>> F = Physics::Elasticity::Kinematics::F(phi_reference.get_gradient(q));
+            const VectorizedArray<number> div_v = geometry_on_the_fly ?
+                                                  trace(phi_current.get_gradient(q) * invert(F)) :
+                                                  trace(phi_current.get_symmetric_gradient(q));
+            volume_change += div_v * determinant(F) * phi_reference.JxW(q);
+          }
+
+        pressure_coupling = material->get_d2Psi_vol_dJ2(theta) * volume_change / cell_volume[cell];
+      }
 
     for (unsigned int q=0; q<phi_current.n_q_points; ++q)
       {
         // reference configuration:
         const Tensor<2,dim,VectorizedArray<number>>         &grad_u = phi_reference.get_gradient(q);
         const Tensor<2,dim,VectorizedArray<number>>          F      = Physics::Elasticity::Kinematics::F(grad_u);
-        const VectorizedArray<number>                        det_F  = determinant(F);
-        const Tensor<2,dim,VectorizedArray<number>>          F_bar  = Physics::Elasticity::Kinematics::F_iso(F);
-        const SymmetricTensor<2,dim,VectorizedArray<number>> b_bar  = Physics::Elasticity::Kinematics::b(F_bar);
 
         // current configuration
-        const Tensor<2,dim,VectorizedArray<number>>          &grad_Nx_v      = phi_current.get_gradient(q);
-        const SymmetricTensor<2,dim,VectorizedArray<number>> &symm_grad_Nx_v = phi_current.get_symmetric_gradient(q);
+        Tensor<2,dim,VectorizedArray<number>> F_inv;
+        Tensor<2,dim,VectorizedArray<number>> grad_Nx_v = phi_current.get_gradient(q);
+        if (geometry_on_the_fly)
+          {
+            F_inv = invert(F);
+            grad_Nx_v = grad_Nx_v * F_inv;
+          }
+        const SymmetricTensor<2,dim,VectorizedArray<number>> symm_grad_Nx_v = symmetrize(grad_Nx_v);
 
         SymmetricTensor<2,dim,VectorizedArray<number>> tau;
-        material->get_tau(tau,det_F,b_bar);
+        SymmetricTensor<2,dim,VectorizedArray<number>> jc_part;
+        if (plastic_material)
+          {
+            // The return mapping starts from the history of the last
+            // converged step, the updated history is not needed here:
+            typename PlasticMaterial::History history_old, history_trial;
+            typename PlasticMaterial::State   state;
+            history->read_old(cell,q,history_old);
+            plastic_material->return_mapping(state,history_trial,F,history_old);
+
+            tau = state.tau;
+            jc_part = plastic_material->act_Jc(state,symm_grad_Nx_v);
+          }
+        else
+          {
+            VectorizedArray<number>                              det_F  = determinant(F);
+            const Tensor<2,dim,VectorizedArray<number>>          F_bar  = F_iso(F);
+            const SymmetricTensor<2,dim,VectorizedArray<number>> b_bar  = Physics::Elasticity::Kinematics::b(F_bar);
+
+            // the volumetric response only sees the mechanical volume change
+            if (thermal_expansion)
+              det_F = thermal_expansion->get_det_F_mechanical(det_F,phi_temperature->get_value(q));
+
+            if (mean_dilatation)
+              {
+                material->get_tau_mean_dilatation(tau,det_F,b_bar,theta);
+                jc_part = material->act_Jc_mean_dilatation(det_F,b_bar,theta,symm_grad_Nx_v);
+                for (unsigned int d = 0; d < dim; ++d)
+                  jc_part[d][d] += pressure_coupling * det_F;
+              }
+            else if (material_fields)
+              {
+                material->get_tau(tau,det_F,b_bar,mu_scaling,kappa_scaling);
+                jc_part = material->act_Jc(det_F,b_bar,symm_grad_Nx_v,mu_scaling,kappa_scaling);
+              }
+            else if (degradation)
+              {
+                // the damage only degrades the tensile part of the energy
+                VectorizedArray<number> mu_degraded = make_vectorized_array<number>(1.);
+                VectorizedArray<number> kappa_degraded = make_vectorized_array<number>(1.);
+                degradation->degrade(det_F,phi_damage->get_value(q),mu_degraded,kappa_degraded);
+                material->get_tau(tau,det_F,b_bar,mu_degraded,kappa_degraded);
+                jc_part = material->act_Jc(det_F,b_bar,symm_grad_Nx_v,mu_degraded,kappa_degraded);
+              }
+            else
+              {
+                material->get_tau(tau,det_F,b_bar);
+                jc_part = material->act_Jc(det_F,b_bar,symm_grad_Nx_v);
+              }
+
+            if (fiber_material)
+              {
+                typename FiberMaterial::State fiber_state;
+                fiber_material->evaluate(fiber_state,F_bar,a_0,n_fiber_families);
+                tau += fiber_state.tau;
+                jc_part += fiber_material->act_Jc(fiber_state,symm_grad_Nx_v);
+              }
+
+            if (material_scaling)
+              {
+                tau *= scaling;
+                jc_part *= scaling;
+              }
+
+            // the viscous stress is fixed within a time step and only enters
+            // the geometric term
+            if (viscous_history)
+              {
+                std::array<VectorizedArray<number>,Viscoelastic_Prony_Series<dim,VectorizedArray<number>>::n_stress_components> H;
+                viscous_history->read_old(cell,q,H);
+                tau += Viscoelastic_Prony_Series<dim,VectorizedArray<number>>::get_tau_viscous(F,H.data());
+              }
+          }
         const Tensor<2,dim,VectorizedArray<number>> tau_ns (tau);
 
-        const SymmetricTensor<2,dim,VectorizedArray<number>> jc_part = material->act_Jc(det_F,b_bar,symm_grad_Nx_v);
+        // With $\nabla_x \mathbf{w} : \mathbf{A} = \nabla_0 \mathbf{w} :
+        // \mathbf{A} \mathbf{F}^{-T}$ both contributions are integrated over
+        // the reference configuration at once:
+        if (geometry_on_the_fly)
+          {
+            phi_current.submit_gradient((Tensor<2,dim,VectorizedArray<number>>(jc_part) +
+                                         egeo_grad(grad_Nx_v,tau_ns)) * transpose(F_inv),
+                                        q);
+            continue;
+          }
 
         const VectorizedArray<number> & JxW_current = phi_current.JxW(q);
         VectorizedArray<number> JxW_scale = phi_reference.JxW(q);
@@ -414,7 +1386,128 @@ using namespace dealii;
 
     // actually do the contraction
     phi_current.integrate (false,true);
-    phi_current_s.integrate (false,true);
+    if (!geometry_on_the_fly)
+      phi_current_s.integrate (false,true);
+    else
+      for (unsigned int i=0; i<phi_current_s.dofs_per_component*phi_current_s.n_components; ++i)
+        phi_current_s.begin_dof_values()[i] = VectorizedArray<number>();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::compute_parameter_sensitivities(
+                             const Vector<number> &adjoint,
+                             Vector<double>       &cell_sensitivity_mu,
+                             Vector<double>       &cell_sensitivity_nu) const
+  {
+    AssertThrow (!plastic_material && !viscous_history && !fiber_material && !mean_dilatation &&
+                 !thermal_expansion && !material_scaling && !material_fields && !degradation,
+                 ExcNotImplemented());
+
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_adjoint  (*data_reference);
+
+    cell_sensitivity_mu = 0.;
+    cell_sensitivity_nu = 0.;
+
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_reference.reinit(cell);
+        phi_adjoint.reinit(cell);
+
+        phi_reference.read_dof_values_plain(*displacement);
+        phi_adjoint.read_dof_values_plain(adjoint);
+        phi_reference.evaluate (false,true,false);
+        phi_adjoint.  evaluate (false,true,false);
+
+        VectorizedArray<number> sensitivity_mu = make_vectorized_array<number>(0.);
+        VectorizedArray<number> sensitivity_nu = make_vectorized_array<number>(0.);
+        for (unsigned int q=0; q<phi_reference.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<number>>         &grad_u = phi_reference.get_gradient(q);
+            const Tensor<2,dim,VectorizedArray<number>>          F      = Physics::Elasticity::Kinematics::F(grad_u);
+            const VectorizedArray<number>                        det_F  = determinant(F);
+            const Tensor<2,dim,VectorizedArray<number>>          F_bar  = F_iso(F);
+            const SymmetricTensor<2,dim,VectorizedArray<number>> b_bar  = Physics::Elasticity::Kinematics::b(F_bar);
+
+            // push the adjoint gradient forward: $\nabla_x \lambda = \textrm{Grad} \lambda F^{-1}$
+            const SymmetricTensor<2,dim,VectorizedArray<number>> symm_grad_x_adjoint =
+              symmetrize(phi_adjoint.get_gradient(q) * invert(F));
+
+            SymmetricTensor<2,dim,VectorizedArray<number>> dtau_dmu, dtau_dnu;
+            material->get_dtau_dparameters(dtau_dmu,dtau_dnu,det_F,b_bar);
+
+            sensitivity_mu -= (symm_grad_x_adjoint * dtau_dmu) * phi_reference.JxW(q);
+            sensitivity_nu -= (symm_grad_x_adjoint * dtau_dnu) * phi_reference.JxW(q);
+          }
+
+        for (unsigned int v=0; v<data_reference->n_components_filled(cell); ++v)
+          {
+            const unsigned int index = data_reference->get_cell_iterator(cell,v)->active_cell_index();
+            cell_sensitivity_mu(index) = sensitivity_mu[v];
+            cell_sensitivity_nu(index) = sensitivity_nu[v];
+          }
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::compute_scaling_sensitivities(
+                             const Vector<number> &adjoint,
+                             Vector<double>       &cell_sensitivity) const
+  {
+    AssertThrow (material_scaling && !plastic_material && !viscous_history && !mean_dilatation,
+                 ExcNotImplemented());
+
+    typedef Material_HGO_Fibers<dim,VectorizedArray<number>> FiberMaterial;
+
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_adjoint  (*data_reference);
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_temperature;
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_damage;
+
+    cell_sensitivity = 0.;
+
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_reference.reinit(cell);
+        phi_adjoint.reinit(cell);
+
+        phi_reference.read_dof_values_plain(*displacement);
+        phi_adjoint.read_dof_values_plain(adjoint);
+        phi_reference.evaluate (false,true,false);
+        phi_adjoint.  evaluate (false,true,false);
+        const auto phi_temperature_cell = evaluate_scalar_field(phi_temperature,temperature,temperature_dof_index,cell);
+        const auto phi_damage_cell      = evaluate_scalar_field(phi_damage,damage,damage_dof_index,cell);
+
+        Tensor<1,dim,VectorizedArray<number>> a_0[FiberMaterial::max_fiber_families];
+        if (fiber_material)
+          for (unsigned int f = 0; f < fibers->n_fiber_families(); ++f)
+            a_0[f] = fibers->get(cell,f);
+
+        VectorizedArray<number> sensitivity = make_vectorized_array<number>(0.);
+        for (unsigned int q=0; q<phi_reference.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<number>> F =
+              Physics::Elasticity::Kinematics::F(phi_reference.get_gradient(q));
+
+            // the internal forces are linear in the scaling
+            const SymmetricTensor<2,dim,VectorizedArray<number>> tau =
+              get_tau(F,a_0,phi_temperature_cell,phi_damage_cell,cell,q,false);
+
+            const SymmetricTensor<2,dim,VectorizedArray<number>> symm_grad_x_adjoint =
+              symmetrize(phi_adjoint.get_gradient(q) * invert(F));
+
+            sensitivity -= (symm_grad_x_adjoint * tau) * phi_reference.JxW(q);
+          }
+
+        for (unsigned int v=0; v<data_reference->n_components_filled(cell); ++v)
+          cell_sensitivity(data_reference->get_cell_iterator(cell,v)->active_cell_index()) = sensitivity[v];
+      }
   }
 
 
@@ -423,6 +1516,116 @@ using namespace dealii;
   void
   NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::
   compute_diagonal()
+  {
+    Vector<number> &diagonal_vector = reinit_diagonal();
+
+    unsigned int dummy = 0;
+    local_diagonal_cell(*data_current, diagonal_vector, dummy,
+                     std::make_pair<unsigned int,unsigned int>(0,data_current->n_macro_cells()));
+
+    // data_current->cell_loop (&NeoHookOperator::local_diagonal_cell,
+    //                          this, diagonal_vector, dummy);
+
+    finalize_diagonal();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  typename NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::GlobalQuantities
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::
+  compute_diagonal_and_internal_forces(Vector<double> &dst)
+  {
+    AssertThrow (!plastic_material && !mean_dilatation && !contact, ExcNotImplemented());
+    Assert (data_current->n_macro_cells() == data_reference->n_macro_cells(), ExcInternalError());
+
+    typedef Material_HGO_Fibers<dim,VectorizedArray<number>> FiberMaterial;
+
+    Vector<number> &diagonal_vector = reinit_diagonal();
+
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current  (*data_current);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_current_s(*data_current);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reference(*data_reference);
+    FEEvaluation<dim,fe_degree,n_q_points_1d,dim,number> phi_reaction (*data_reference);
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_temperature;
+    std::unique_ptr<FEEvaluation<dim,fe_degree,n_q_points_1d,1,number>> phi_damage;
+
+    GlobalQuantities global_quantities;
+    for (unsigned int cell=0; cell<data_reference->n_macro_cells(); ++cell)
+      {
+        phi_current.reinit(cell);
+        phi_current_s.reinit(cell);
+        phi_reference.reinit(cell);
+
+        phi_reference.read_dof_values_plain(*displacement);
+        phi_reference.evaluate (false,true,false);
+        const auto phi_temperature_cell = evaluate_scalar_field(phi_temperature,temperature,temperature_dof_index,cell);
+        const auto phi_damage_cell      = evaluate_scalar_field(phi_damage,damage,damage_dof_index,cell);
+
+        // The diagonal only reads the deformation in phi_reference...
+        compute_local_diagonal(phi_current,phi_current_s,phi_reference,phi_temperature_cell,phi_damage_cell,cell);
+        phi_current.distribute_local_to_global (diagonal_vector);
+
+        // ...so that its gradients can be replaced by the stresses
+        // afterwards:
+        Tensor<1,dim,VectorizedArray<number>> a_0[FiberMaterial::max_fiber_families];
+        if (fiber_material)
+          for (unsigned int f = 0; f < fibers->n_fiber_families(); ++f)
+            a_0[f] = fibers->get(cell,f);
+
+        VectorizedArray<number> current_volume = make_vectorized_array<number>(0.);
+        VectorizedArray<number> strain_energy = make_vectorized_array<number>(0.);
+        for (unsigned int q=0; q<phi_reference.n_q_points; ++q)
+          {
+            const Tensor<2,dim,VectorizedArray<number>> F =
+              Physics::Elasticity::Kinematics::F(phi_reference.get_gradient(q));
+            const Tensor<2,dim,VectorizedArray<number>> P =
+              Tensor<2,dim,VectorizedArray<number>>(get_tau(F,a_0,phi_temperature_cell,phi_damage_cell,cell,q)) *
+              transpose(invert(F));
+
+            current_volume += determinant(F) * phi_reference.JxW(q);
+            strain_energy += get_strain_energy(F,phi_temperature_cell,phi_damage_cell,cell,q) * phi_reference.JxW(q);
+            phi_reference.submit_gradient(P,q);
+          }
+
+        phi_reference.integrate (false,true);
+        phi_reference.distribute_local_to_global(dst);
+
+        // The reaction force sums up the cell forces on the marked DoFs
+        // before the constraints are applied:
+        Tensor<1,dim,VectorizedArray<number>> reaction_force;
+        if (reaction_dofs)
+          {
+            phi_reaction.reinit(cell);
+            phi_reaction.read_dof_values_plain(*reaction_dofs);
+            for (unsigned int ic=0; ic<dim; ++ic)
+              for (unsigned int i=0; i<phi_reference.dofs_per_component; ++i)
+                {
+                  const auto ind_i = i+ic*phi_reference.dofs_per_component;
+                  reaction_force[ic] += phi_reference.begin_dof_values()[ind_i] *
+                                        phi_reaction.begin_dof_values()[ind_i];
+                }
+          }
+
+        for (unsigned int v=0; v<data_reference->n_components_filled(cell); ++v)
+          {
+            global_quantities.current_volume += current_volume[v];
+            global_quantities.strain_energy += strain_energy[v];
+            for (unsigned int d=0; d<dim; ++d)
+              global_quantities.reaction_force[d] += reaction_force[d][v];
+          }
+      }
+
+    finalize_diagonal();
+
+    return global_quantities;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  Vector<number> &
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::reinit_diagonal()
   {
     typedef Vector<number> VectorType;
 
@@ -434,12 +1637,23 @@ using namespace dealii;
     data_current->initialize_dof_vector(inverse_diagonal_vector);
     data_current->initialize_dof_vector(diagonal_vector);
 
-    unsigned int dummy = 0;
-    local_diagonal_cell(*data_current, diagonal_vector, dummy,
-                     std::make_pair<unsigned int,unsigned int>(0,data_current->n_macro_cells()));
+    diagonal_is_available = false;
+    return diagonal_vector;
+  }
 
-    // data_current->cell_loop (&NeoHookOperator::local_diagonal_cell,
-    //                          this, diagonal_vector, dummy);
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, typename number>
+  void
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number>::finalize_diagonal()
+  {
+    typedef Vector<number> VectorType;
+
+    VectorType &inverse_diagonal_vector = inverse_diagonal_entries->get_vector();
+    VectorType &diagonal_vector         = diagonal_entries->get_vector();
+
+    if (contact)
+      contact->add_diagonal(diagonal_vector);
 
     // set_constrained_entries_to_one
     {
@@ -0,0 +1,464 @@
+#pragma once
+
+#include <mf_elasticity.h>
+
+#include <iomanip>
+
+namespace Cook_Membrane
+{
+  using namespace dealii;
+
+// @sect3{Affine displacement}
+
+// The displacement $\mathbf{H} \mathbf{X}$ of a homogeneous deformation with
+// the displacement gradient $\mathbf{H}$:
+  template <int dim>
+  class AffineDisplacement : public Function<dim>
+  {
+  public:
+    AffineDisplacement(const Tensor<2,dim> &H)
+      :
+      Function<dim>(dim),
+      H(H)
+    {}
+
+    double value (const Point<dim> &p,
+                  const unsigned int component) const
+    {
+      double u = 0.;
+      for (unsigned int j = 0; j < dim; ++j)
+        u += H[component][j] * p[j];
+      return u;
+    }
+
+  private:
+    const Tensor<2,dim> H;
+  };
+
+// @sect3{The <code>RVE</code> class}
+
+// Computational homogenization on a periodic representative volume element.
+// The displacement is split into the affine part $(\overline{\mathbf{F}} -
+// \mathbf{I}) \mathbf{X}$ prescribed by the macroscopic deformation gradient
+// and a periodic fluctuation. The periodicity is a set of constraints which
+// the matrix-free operator resolves when it gathers the source vector and
+// scatters the result. One interior node is fixed against rigid translations.
+//
+// For each macroscopic state we compute the homogenized first Piola-Kirchhoff
+// stress $\overline{\mathbf{P}} = \frac{1}{|\Omega_0|} \int_{\Omega_0}
+// \mathbf{P} \, dV$ and the consistent tangent $\overline{\mathsf{A}} =
+// \partial \overline{\mathbf{P}} / \partial \overline{\mathbf{F}}$. The
+// latter takes one linear solve for the fluctuation of each of the $dim^2$
+// unit macroscopic displacement gradients, with the operator that is already
+// set up around the converged state. The index data of the matrix-free
+// operator is only set up once, and the fluctuation of the last state is the
+// initial guess for the next one.
+  template <int dim,typename NumberType>
+  class RVE
+  {
+  public:
+    static constexpr int degree = 1;
+    static constexpr int n_q_points_1d = 2;
+
+    RVE(const Parameters::AllParameters &parameters);
+
+    virtual
+    ~RVE();
+
+    void
+    run();
+
+  private:
+
+    // The unit cube with the boundary ids $2d$ and $2d+1$ on the faces normal
+    // to direction $d$:
+    void
+    make_grid();
+
+    // Set up the periodic constraints and the matrix-free data of the
+    // reference configuration:
+    void
+    system_setup();
+
+    // Update the matrix-free data of the current configuration:
+    void
+    setup_matrix_free(const bool first_setup);
+
+    // Newton's method for the fluctuation under the macroscopic deformation
+    // gradient @p F_macro. Returns the homogenized stress:
+    Tensor<2,dim>
+    solve_macroscopic_state(const Tensor<2,dim> &F_macro);
+
+    // The homogenized tangent around the converged state:
+    Tensor<4,dim>
+    compute_homogenized_tangent();
+
+    unsigned int
+    solve_linear_system(const Vector<double> &rhs,
+                        Vector<double>       &update);
+
+    Tensor<1,dim>
+    get_fiber_direction(const typename DoFHandler<dim>::cell_iterator &cell,
+                        const unsigned int                             family) const;
+
+    const Parameters::AllParameters &parameters;
+
+    Triangulation<dim>               triangulation;
+    const FESystem<dim>              fe;
+    DoFHandler<dim>                  dof_handler;
+    ConstraintMatrix                 constraints;
+    double                           volume;
+
+    std::shared_ptr<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>> material_vec;
+    std::shared_ptr<Material_HGO_Fibers<dim,VectorizedArray<NumberType>>> fiber_material_vec;
+    std::shared_ptr<FiberDirections<dim,double>> fiber_directions;
+
+    // The total displacement, its periodic fluctuation and the nodal
+    // positions of the reference configuration:
+    Vector<double>                   displacement;
+    Vector<double>                   fluctuation;
+    Vector<double>                   reference_coordinates;
+
+    std::shared_ptr<MappingQEulerian<dim,Vector<double>>> eulerian_mapping;
+    std::shared_ptr<MatrixFree<dim,double>> mf_data_current;
+    std::shared_ptr<MatrixFree<dim,double>> mf_data_reference;
+
+    NeoHookOperator<dim,degree,n_q_points_1d,double> mf_nh_operator;
+  };
+
+// @sect3{Implementation of the <code>RVE</code> class}
+
+  template <int dim,typename NumberType>
+  RVE<dim,NumberType>::RVE(const Parameters::AllParameters &parameters)
+    :
+    parameters(parameters),
+    fe(FE_Q<dim>(degree), dim),
+    dof_handler(triangulation),
+    volume(0.0),
+    material_vec(std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<NumberType>>>(
+      parameters.mu,parameters.nu))
+  {
+    AssertThrow(parameters.material_model == "Neo-Hooke" ||
+                parameters.material_model == "HGO",
+                ExcNotImplemented());
+    AssertThrow(parameters.volumetric_formulation == "Standard" &&
+                parameters.obstacle == "None" &&
+                parameters.thermal_coupling == false,
+                ExcNotImplemented());
+
+    mf_nh_operator.set_material(material_vec);
+
+    if (parameters.material_model == "HGO")
+      {
+        fiber_material_vec = std::make_shared<Material_HGO_Fibers<dim,VectorizedArray<NumberType>>>(
+          parameters.fiber_stiffness,parameters.fiber_exponent);
+        fiber_directions = std::make_shared<FiberDirections<dim,double>>();
+      }
+  }
+
+  template <int dim,typename NumberType>
+  RVE<dim,NumberType>::~RVE()
+  {
+    mf_nh_operator.clear();
+
+    mf_data_current.reset();
+    mf_data_reference.reset();
+    eulerian_mapping.reset();
+
+    dof_handler.clear();
+  }
+
+// @sect4{RVE::run}
+
+// The macroscopic states are processed in the given order, so that
+// neighbouring states give good initial guesses for each other.
+  template <int dim,typename NumberType>
+  void RVE<dim,NumberType>::run()
+  {
+    make_grid();
+    system_setup();
+
+    for (unsigned int s = 0; s < parameters.macroscopic_deformations.size(); ++s)
+      {
+        const std::vector<double> &entries = parameters.macroscopic_deformations[s];
+        AssertThrow(entries.size() == dim*dim,
+                    ExcMessage("A macroscopic deformation gradient needs dim*dim entries"));
+
+        Tensor<2,dim> F_macro;
+        for (unsigned int i = 0; i < dim; ++i)
+          for (unsigned int j = 0; j < dim; ++j)
+            F_macro[i][j] = entries[i*dim+j];
+        AssertThrow(determinant(F_macro) > 0,
+                    ExcMessage("The macroscopic deformation gradient must have a positive determinant"));
+
+        std::cout << std::endl << "Macroscopic state " << s << ": F = " << F_macro << std::endl;
+
+        const Tensor<2,dim> P_macro = solve_macroscopic_state(F_macro);
+        const Tensor<4,dim> A_macro = compute_homogenized_tangent();
+
+        std::cout << std::scientific << std::setprecision(6)
+                  << "  Homogenized stress P:" << std::endl;
+        for (unsigned int i = 0; i < dim; ++i)
+          {
+            std::cout << "   ";
+            for (unsigned int j = 0; j < dim; ++j)
+              std::cout << std::setw(15) << P_macro[i][j];
+            std::cout << std::endl;
+          }
+
+        // The tangent is printed as a $dim^2 \times dim^2$ matrix with the
+        // rows $ij$ and the columns $kl$:
+        std::cout << "  Homogenized tangent A:" << std::endl;
+        for (unsigned int i = 0; i < dim; ++i)
+          for (unsigned int j = 0; j < dim; ++j)
+            {
+              std::cout << "   ";
+              for (unsigned int k = 0; k < dim; ++k)
+                for (unsigned int l = 0; l < dim; ++l)
+                  std::cout << std::setw(15) << A_macro[i][j][k][l];
+              std::cout << std::endl;
+            }
+        std::cout.unsetf(std::ios_base::floatfield);
+      }
+  }
+
+// @sect4{RVE::make_grid}
+  template <int dim,typename NumberType>
+  void RVE<dim,NumberType>::make_grid()
+  {
+    AssertThrow(parameters.rve_refinements >= 1,
+                ExcMessage("The RVE needs an interior node"));
+
+    GridGenerator::hyper_cube(triangulation, 0.0, 1.0, /*colorize*/ true);
+    triangulation.refine_global(parameters.rve_refinements);
+
+    volume = GridTools::volume(triangulation);
+  }
+
+// @sect4{RVE::system_setup}
+  template <int dim,typename NumberType>
+  void RVE<dim,NumberType>::system_setup()
+  {
+    dof_handler.distribute_dofs(fe);
+    DoFRenumbering::Cuthill_McKee(dof_handler);
+
+    std::cout << "RVE:"
+              << "\n\t Number of active cells: " << triangulation.n_active_cells()
+              << "\n\t Number of degrees of freedom: " << dof_handler.n_dofs()
+              << std::endl;
+
+    // The fluctuation is periodic in each direction and vanishes at the
+    // center of the cube:
+    constraints.clear();
+    for (unsigned int d = 0; d < dim; ++d)
+      DoFTools::make_periodicity_constraints(dof_handler, 2*d, 2*d+1, d, constraints);
+
+    Point<dim> center;
+    for (unsigned int d = 0; d < dim; ++d)
+      center[d] = 0.5;
+
+    bool found_center = false;
+    for (const auto &cell: dof_handler.active_cell_iterators())
+      for (unsigned int v = 0; v < GeometryInfo<dim>::vertices_per_cell && !found_center; ++v)
+        if (cell->vertex(v).distance(center) < 1e-10)
+          {
+            for (unsigned int c = 0; c < dim; ++c)
+              constraints.add_line(cell->vertex_dof_index(v,c));
+            found_center = true;
+          }
+    AssertThrow(found_center, ExcMessage("Found no vertex at the center of the RVE!"));
+    constraints.close();
+
+    displacement.reinit(dof_handler.n_dofs());
+    fluctuation.reinit(dof_handler.n_dofs());
+    reference_coordinates.reinit(dof_handler.n_dofs());
+    VectorTools::interpolate(dof_handler,
+                             AffineDisplacement<dim>(Tensor<2,dim>(Physics::Elasticity::StandardTensors<dim>::I)),
+                             reference_coordinates);
+
+    // The index data of the reference configuration is set up once for all
+    // macroscopic states:
+    const QGauss<1> quad (n_q_points_1d);
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+
+    mf_data_reference = std::make_shared<MatrixFree<dim,double>>();
+    mf_data_reference->reinit(dof_handler, constraints, quad, data);
+
+    if (fiber_directions)
+      {
+        fiber_directions->reinit(*mf_data_reference, parameters.n_fiber_families,
+                                 [this](const typename DoFHandler<dim>::cell_iterator &cell,
+                                        const unsigned int                             family)
+        {
+          return get_fiber_direction(cell,family);
+        });
+        mf_nh_operator.set_fibers(fiber_material_vec, fiber_directions);
+      }
+
+    setup_matrix_free(true);
+  }
+
+// @sect4{RVE::setup_matrix_free}
+  template <int dim,typename NumberType>
+  void RVE<dim,NumberType>::setup_matrix_free(const bool first_setup)
+  {
+    const QGauss<1> quad (n_q_points_1d);
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+
+    if (first_setup)
+      {
+        eulerian_mapping = std::make_shared<MappingQEulerian<dim,Vector<double>>>(/*mapping degree*/1,dof_handler,displacement);
+        mf_data_current = std::make_shared<MatrixFree<dim,double>>();
+        mf_nh_operator.initialize(mf_data_current,mf_data_reference,displacement);
+      }
+    else
+      // only the mapping changes with the displacement
+      data.initialize_indices = false;
+
+    mf_data_current->reinit(*eulerian_mapping, dof_handler, constraints, quad, data);
+    mf_nh_operator.compute_diagonal();
+  }
+
+// @sect4{RVE::solve_macroscopic_state}
+
+// The residual of the first iteration vanishes for a homogeneous RVE, so the
+// force tolerance is bounded from below by the shear modulus, which is the
+// force scale on the unit cube.
+  template <int dim,typename NumberType>
+  Tensor<2,dim>
+  RVE<dim,NumberType>::solve_macroscopic_state(const Tensor<2,dim> &F_macro)
+  {
+    VectorTools::interpolate(dof_handler,
+                             AffineDisplacement<dim>(F_macro - Tensor<2,dim>(Physics::Elasticity::StandardTensors<dim>::I)),
+                             displacement);
+    displacement += fluctuation;
+
+    Vector<double> residual(dof_handler.n_dofs());
+    Vector<double> update(dof_handler.n_dofs());
+
+    Tensor<2,dim> stress_integral;
+    double residual_norm_0 = 0.0;
+    unsigned int newton_iteration = 0;
+    for (; newton_iteration < parameters.max_iterations_NR; ++newton_iteration)
+      {
+        setup_matrix_free(false);
+
+        residual = 0.0;
+        stress_integral = mf_nh_operator.add_internal_forces(residual);
+        residual *= -1.0;
+
+        const double residual_norm = residual.l2_norm();
+        if (newton_iteration == 0)
+          residual_norm_0 = std::max(residual_norm, parameters.mu);
+
+        std::cout << "  " << newton_iteration << "  residual: " << residual_norm << std::flush;
+        if (residual_norm <= parameters.tol_f * residual_norm_0)
+          {
+            std::cout << "  converged" << std::endl;
+            break;
+          }
+
+        update = 0.0;
+        const unsigned int lin_it = solve_linear_system(residual, update);
+        std::cout << "  CG iterations: " << lin_it << std::endl;
+
+        displacement += update;
+        fluctuation += update;
+      }
+
+    AssertThrow (newton_iteration < parameters.max_iterations_NR,
+                 ExcMessage("No convergence in nonlinear solver!"));
+
+    return stress_integral / volume;
+  }
+
+// @sect4{RVE::compute_homogenized_tangent}
+
+// The fluctuation $\delta \mathbf{w}$ for the unit macroscopic displacement
+// gradient $\mathbf{E}_{kl}$ solves $\mathbf{K} \delta \mathbf{w} = -
+// \mathbf{K} (\mathbf{E}_{kl} \mathbf{X})$, where the affine part is not
+// periodic and therefore applied without resolving the constraints. The
+// column $kl$ of the tangent is the volume average of the linearized stress
+// for the sum of both.
+  template <int dim,typename NumberType>
+  Tensor<4,dim>
+  RVE<dim,NumberType>::compute_homogenized_tangent()
+  {
+    Vector<double> direction(dof_handler.n_dofs());
+    Vector<double> rhs(dof_handler.n_dofs());
+    Vector<double> update(dof_handler.n_dofs());
+
+    Tensor<4,dim> tangent;
+    for (unsigned int k = 0; k < dim; ++k)
+      for (unsigned int l = 0; l < dim; ++l)
+        {
+          Tensor<2,dim> E;
+          E[k][l] = 1.0;
+          VectorTools::interpolate(dof_handler, AffineDisplacement<dim>(E), direction);
+
+          rhs = 0.0;
+          mf_nh_operator.vmult_add_unconstrained(rhs, direction);
+          rhs *= -1.0;
+
+          update = 0.0;
+          solve_linear_system(rhs, update);
+          direction += update;
+
+          const Tensor<2,dim> stress_derivative =
+            mf_nh_operator.integrate_stress_derivative(direction, reference_coordinates) / volume;
+          for (unsigned int i = 0; i < dim; ++i)
+            for (unsigned int j = 0; j < dim; ++j)
+              tangent[i][j][k][l] = stress_derivative[i][j];
+        }
+
+    return tangent;
+  }
+
+// @sect4{RVE::solve_linear_system}
+  template <int dim,typename NumberType>
+  unsigned int
+  RVE<dim,NumberType>::solve_linear_system(const Vector<double> &rhs,
+                                           Vector<double>       &update)
+  {
+    const int solver_its = dof_handler.n_dofs()
+                           * parameters.max_iterations_lin;
+    const double tol_sol = parameters.tol_lin
+                           * rhs.l2_norm();
+
+    SolverControl solver_control(solver_its, tol_sol);
+    SolverCG<Vector<double> > solver_CG(solver_control);
+
+    PreconditionJacobi<NeoHookOperator<dim,degree,n_q_points_1d,double>> preconditioner;
+    preconditioner.initialize (mf_nh_operator,parameters.preconditioner_relaxation);
+
+    solver_CG.solve(mf_nh_operator, update, rhs, preconditioner);
+
+    // the slave DoFs of the periodic constraints follow their masters
+    constraints.distribute(update);
+
+    return solver_control.last_step();
+  }
+
+// @sect4{RVE::get_fiber_direction}
+
+// The RVE is a cross-ply laminate: the fibers of the lower half are at plus
+// and minus the fiber angle to the x-axis, those of the upper half to the
+// y-axis.
+  template <int dim,typename NumberType>
+  Tensor<1,dim>
+  RVE<dim,NumberType>::get_fiber_direction(const typename DoFHandler<dim>::cell_iterator &cell,
+                                           const unsigned int                             family) const
+  {
+    const double layer_angle = (cell->center()[1] < 0.5 ? 0.0 : 0.5 * numbers::PI);
+    const double angle = layer_angle + (family == 0 ? 1.0 : -1.0) *
+                         parameters.fiber_angle * numbers::PI / 180.0;
+
+    Tensor<1,dim> a;
+    a[0] = std::cos(angle);
+    a[1] = std::sin(angle);
+    return a;
+  }
+
+}
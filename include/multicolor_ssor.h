@@ -0,0 +1,230 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/smartpointer.h>
+
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <vector>
+
+using namespace dealii;
+
+  /**
+   * SSOR preconditioner $\mathbf{M} = \frac{1}{\omega (2-\omega)}
+   * (\mathbf{D} + \omega \mathbf{L}) \mathbf{D}^{-1} (\mathbf{D} + \omega
+   * \mathbf{U})$ with the rows ordered by the colors of the matrix graph.
+   *
+   * Rows of the same color are not coupled, so that each color of the
+   * forward and the backward sweep is processed in parallel. $\mathbf{L}$
+   * and $\mathbf{U}$ are the couplings to rows of lower and higher colors,
+   * respectively. The iteration counts are thus those of SSOR for the
+   * multicolor ordering, which are usually close to those of the natural
+   * ordering for the low order elements used here.
+   *
+   * The coloring depends only on the sparsity pattern and is computed once
+   * by color(), the matrix is attached by initialize() whenever it changes.
+   */
+  template <typename number>
+  class MulticolorSSOR : public Subscriptor
+  {
+  public:
+    MulticolorSSOR ();
+
+    /**
+     * Greedy coloring of the graph of the symmetric @p sparsity, where each
+     * row gets the lowest color that none of its neighbors has.
+     */
+    void color (const SparsityPattern &sparsity);
+
+    void initialize (const SparseMatrix<number> &matrix,
+                     const double                relaxation = 1.);
+
+    void vmult (Vector<number>       &dst,
+                const Vector<number> &src) const;
+
+    void Tvmult (Vector<number>       &dst,
+                 const Vector<number> &src) const;
+
+    unsigned int n_colors () const;
+
+    /**
+     * Color of @p row in the coloring computed by color().
+     */
+    unsigned int get_color (const types::global_dof_index row) const;
+
+    void clear ();
+
+  private:
+    // the rows of each color and the color of each row
+    std::vector<std::vector<types::global_dof_index>> color_rows;
+    std::vector<unsigned int>                         row_color;
+
+    SmartPointer<const SparseMatrix<number>, MulticolorSSOR<number>> matrix;
+    double relaxation;
+
+    // rows of a color in a parallel task at least
+    static const unsigned int grain_size = 256;
+  };
+
+
+
+  template <typename number>
+  MulticolorSSOR<number>::MulticolorSSOR ()
+    :
+    relaxation(1.)
+  {}
+
+
+
+  template <typename number>
+  void
+  MulticolorSSOR<number>::clear ()
+  {
+    color_rows.clear();
+    row_color.clear();
+    matrix = nullptr;
+  }
+
+
+
+  template <typename number>
+  unsigned int
+  MulticolorSSOR<number>::n_colors () const
+  {
+    return color_rows.size();
+  }
+
+
+
+  template <typename number>
+  unsigned int
+  MulticolorSSOR<number>::get_color (const types::global_dof_index row) const
+  {
+    AssertIndexRange (row, row_color.size());
+    return row_color[row];
+  }
+
+
+
+  template <typename number>
+  void
+  MulticolorSSOR<number>::color (const SparsityPattern &sparsity)
+  {
+    Assert (sparsity.n_rows() == sparsity.n_cols(), ExcNotQuadratic());
+
+    const types::global_dof_index n_rows = sparsity.n_rows();
+    const unsigned int unassigned = numbers::invalid_unsigned_int;
+    row_color.assign(n_rows, unassigned);
+    color_rows.clear();
+
+    // the colors taken by the neighbors of the current row are marked by the
+    // row index, so that the marks need not be reset
+    std::vector<types::global_dof_index> taken_by;
+    for (types::global_dof_index row = 0; row < n_rows; ++row)
+      {
+        for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+          {
+            const unsigned int c = row_color[p->column()];
+            if (c != unassigned)
+              taken_by[c] = row;
+          }
+
+        unsigned int c = 0;
+        while (c < taken_by.size() && taken_by[c] == row)
+          ++c;
+        if (c == taken_by.size())
+          {
+            taken_by.push_back(numbers::invalid_dof_index);
+            color_rows.emplace_back();
+          }
+
+        row_color[row] = c;
+        color_rows[c].push_back(row);
+      }
+  }
+
+
+
+  template <typename number>
+  void
+  MulticolorSSOR<number>::initialize (const SparseMatrix<number> &matrix_,
+                                      const double                relaxation_)
+  {
+    Assert (row_color.size() == matrix_.m(),
+            ExcMessage("The sparsity pattern has to be colored first"));
+    Assert (relaxation_ > 0 && relaxation_ < 2, ExcMessage("The relaxation has to be in (0,2)"));
+    matrix = &matrix_;
+    relaxation = relaxation_;
+  }
+
+
+
+  template <typename number>
+  void
+  MulticolorSSOR<number>::vmult (Vector<number>       &dst,
+                                 const Vector<number> &src) const
+  {
+    Assert (matrix != nullptr, ExcNotInitialized());
+    AssertDimension (dst.size(), matrix->m());
+    AssertDimension (src.size(), matrix->m());
+
+    const SparseMatrix<number> &A = *matrix;
+    const double omega = relaxation;
+
+    // forward sweep $(\mathbf{D} + \omega \mathbf{L}) \mathbf{y} = \omega
+    // (2-\omega) \mathbf{r}$ over the colors in ascending order
+    for (unsigned int c = 0; c < color_rows.size(); ++c)
+      {
+        const std::vector<types::global_dof_index> &rows = color_rows[c];
+        parallel::apply_to_subranges(0u, static_cast<unsigned int>(rows.size()),
+                                     [&](const unsigned int begin, const unsigned int end)
+        {
+          for (unsigned int r = begin; r < end; ++r)
+            {
+              const types::global_dof_index row = rows[r];
+              number sum = 0;
+              for (typename SparseMatrix<number>::const_iterator p = A.begin(row); p != A.end(row); ++p)
+                if (row_color[p->column()] < c)
+                  sum += p->value() * dst(p->column());
+              dst(row) = (omega * (2. - omega) * src(row) - omega * sum) / A.diag_element(row);
+            }
+        },
+        grain_size);
+      }
+
+    // backward sweep $(\mathbf{D} + \omega \mathbf{U}) \mathbf{x} =
+    // \mathbf{D} \mathbf{y}$ over the colors in descending order
+    for (unsigned int c = color_rows.size(); c-- > 0; )
+      {
+        const std::vector<types::global_dof_index> &rows = color_rows[c];
+        parallel::apply_to_subranges(0u, static_cast<unsigned int>(rows.size()),
+                                     [&](const unsigned int begin, const unsigned int end)
+        {
+          for (unsigned int r = begin; r < end; ++r)
+            {
+              const types::global_dof_index row = rows[r];
+              number sum = 0;
+              for (typename SparseMatrix<number>::const_iterator p = A.begin(row); p != A.end(row); ++p)
+                if (row_color[p->column()] > c)
+                  sum += p->value() * dst(p->column());
+              dst(row) -= omega * sum / A.diag_element(row);
+            }
+        },
+        grain_size);
+      }
+  }
+
+
+
+  template <typename number>
+  void
+  MulticolorSSOR<number>::Tvmult (Vector<number>       &dst,
+                                  const Vector<number> &src) const
+  {
+    // the preconditioner is symmetric for a symmetric matrix
+    vmult(dst, src);
+  }
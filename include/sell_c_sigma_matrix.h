@@ -0,0 +1,263 @@
+#pragma once
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace dealii;
+
+  /**
+   * Copy of a SparseMatrix in the SELL-C-$\sigma$ format for a vectorized
+   * product. The rows are sorted by their length within windows of
+   * $\sigma$ rows and grouped into chunks of C rows, with C the width of
+   * VectorizedArray. The entries of a chunk are stored column by column, each
+   * column padded with zeros to the longest row of the chunk. The product then
+   * processes C rows at once with one vector load of the entries and a gather
+   * of the source vector per column, independently of the row lengths, and
+   * the sorting keeps the padding small where the row lengths vary, e.g. at
+   * the boundary.
+   *
+   * The layout only depends on the sparsity pattern and is set up by
+   * reinit(), the entries are copied by copy_from() after every assembly.
+   */
+  template <typename number>
+  class SellCSigmaMatrix : public Subscriptor
+  {
+  public:
+    typedef number                  value_type;
+    typedef types::global_dof_index size_type;
+
+    static const unsigned int chunk_size = VectorizedArray<number>::n_array_elements;
+
+    SellCSigmaMatrix ();
+
+    /**
+     * Set up the layout for matrices on @p sparsity, sorting the rows within
+     * windows of @p sigma rows.
+     */
+    void reinit (const SparsityPattern &sparsity,
+                 const unsigned int     sigma = 256);
+
+    /**
+     * Copy the entries of @p matrix, which has to be built on the sparsity
+     * pattern given to reinit().
+     */
+    void copy_from (const SparseMatrix<number> &matrix);
+
+    void clear ();
+
+    size_type m () const;
+    size_type n () const;
+
+    /**
+     * Number of stored entries including the padding.
+     */
+    std::size_t n_nonzero_elements () const;
+
+    std::size_t memory_consumption () const;
+
+    void vmult (Vector<number>       &dst,
+                const Vector<number> &src) const;
+
+  private:
+    // chunks per parallel task at least
+    static const unsigned int grain_size = 64;
+
+    size_type n_rows;
+    unsigned int n_chunks;
+
+    // the start of each chunk in values and the row of each lane, which is
+    // numbers::invalid_unsigned_int for the lanes after the last row
+    std::vector<unsigned int> chunk_start;
+    std::vector<unsigned int> chunk_row;
+
+    // the entries and columns of each chunk column by column, with zero
+    // entries in the first column for the padding
+    AlignedVector<VectorizedArray<number>> values;
+    std::vector<unsigned int>              columns;
+  };
+
+
+
+  template <typename number>
+  SellCSigmaMatrix<number>::SellCSigmaMatrix ()
+    :
+    n_rows(0),
+    n_chunks(0)
+  {}
+
+
+
+  template <typename number>
+  void
+  SellCSigmaMatrix<number>::clear ()
+  {
+    n_rows = 0;
+    n_chunks = 0;
+    chunk_start.clear();
+    chunk_row.clear();
+    values.clear();
+    columns.clear();
+  }
+
+
+
+  template <typename number>
+  void
+  SellCSigmaMatrix<number>::reinit (const SparsityPattern &sparsity,
+                                    const unsigned int     sigma)
+  {
+    Assert (sigma > 0, ExcMessage("The sorting window must not be empty"));
+    n_rows = sparsity.n_rows();
+    n_chunks = (n_rows + chunk_size - 1) / chunk_size;
+
+    // sort by descending row length within the windows
+    std::vector<unsigned int> rows(n_rows);
+    std::iota(rows.begin(), rows.end(), 0u);
+    for (size_type begin = 0; begin < n_rows; begin += sigma)
+      std::stable_sort(rows.begin() + begin,
+                       rows.begin() + std::min<size_type>(begin + sigma, n_rows),
+                       [&](const unsigned int a, const unsigned int b)
+      {
+        return sparsity.row_length(a) > sparsity.row_length(b);
+      });
+
+    chunk_row.assign(n_chunks * chunk_size, numbers::invalid_unsigned_int);
+    std::copy(rows.begin(), rows.end(), chunk_row.begin());
+
+    chunk_start.resize(n_chunks + 1);
+    chunk_start[0] = 0;
+    for (unsigned int k = 0; k < n_chunks; ++k)
+      {
+        unsigned int length = 0;
+        for (unsigned int l = 0; l < chunk_size; ++l)
+          if (chunk_row[k * chunk_size + l] != numbers::invalid_unsigned_int)
+            length = std::max(length, sparsity.row_length(chunk_row[k * chunk_size + l]));
+        chunk_start[k + 1] = chunk_start[k] + length;
+      }
+
+    columns.assign(static_cast<std::size_t>(chunk_start[n_chunks]) * chunk_size, 0);
+    for (unsigned int k = 0; k < n_chunks; ++k)
+      for (unsigned int l = 0; l < chunk_size; ++l)
+        {
+          const unsigned int row = chunk_row[k * chunk_size + l];
+          if (row == numbers::invalid_unsigned_int)
+            continue;
+          unsigned int j = 0;
+          for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p, ++j)
+            columns[(static_cast<std::size_t>(chunk_start[k]) + j) * chunk_size + l] = p->column();
+        }
+
+    values.resize_fast(chunk_start[n_chunks]);
+    values.fill(VectorizedArray<number>());
+  }
+
+
+
+  template <typename number>
+  void
+  SellCSigmaMatrix<number>::copy_from (const SparseMatrix<number> &matrix)
+  {
+    AssertDimension (matrix.m(), n_rows);
+
+    parallel::apply_to_subranges(0u, n_chunks,
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      for (unsigned int k = begin; k < end; ++k)
+        for (unsigned int l = 0; l < chunk_size; ++l)
+          {
+            const unsigned int row = chunk_row[k * chunk_size + l];
+            if (row == numbers::invalid_unsigned_int)
+              continue;
+            unsigned int j = chunk_start[k];
+            for (typename SparseMatrix<number>::const_iterator p = matrix.begin(row); p != matrix.end(row); ++p, ++j)
+              values[j][l] = p->value();
+            Assert (j <= chunk_start[k + 1],
+                    ExcMessage("The matrix is not on the sparsity pattern of the layout"));
+          }
+    },
+    grain_size);
+  }
+
+
+
+  template <typename number>
+  typename SellCSigmaMatrix<number>::size_type
+  SellCSigmaMatrix<number>::m () const
+  {
+    return n_rows;
+  }
+
+
+
+  template <typename number>
+  typename SellCSigmaMatrix<number>::size_type
+  SellCSigmaMatrix<number>::n () const
+  {
+    return n_rows;
+  }
+
+
+
+  template <typename number>
+  std::size_t
+  SellCSigmaMatrix<number>::n_nonzero_elements () const
+  {
+    return values.size() * chunk_size;
+  }
+
+
+
+  template <typename number>
+  std::size_t
+  SellCSigmaMatrix<number>::memory_consumption () const
+  {
+    return MemoryConsumption::memory_consumption(chunk_start) +
+           MemoryConsumption::memory_consumption(chunk_row) +
+           values.memory_consumption() +
+           MemoryConsumption::memory_consumption(columns);
+  }
+
+
+
+  template <typename number>
+  void
+  SellCSigmaMatrix<number>::vmult (Vector<number>       &dst,
+                                   const Vector<number> &src) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+    Assert (&src != &dst, ExcMessage("The vectors have to be different"));
+
+    parallel::apply_to_subranges(0u, n_chunks,
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      for (unsigned int k = begin; k < end; ++k)
+        {
+          VectorizedArray<number> sum = VectorizedArray<number>();
+          const unsigned int *chunk_columns = &columns[static_cast<std::size_t>(chunk_start[k]) * chunk_size];
+          for (unsigned int j = chunk_start[k]; j < chunk_start[k + 1]; ++j, chunk_columns += chunk_size)
+            {
+              VectorizedArray<number> x;
+              x.gather(src.begin(), chunk_columns);
+              sum += values[j] * x;
+            }
+
+          for (unsigned int l = 0; l < chunk_size; ++l)
+            if (chunk_row[k * chunk_size + l] != numbers::invalid_unsigned_int)
+              dst(chunk_row[k * chunk_size + l]) = sum[l];
+        }
+    },
+    grain_size);
+  }
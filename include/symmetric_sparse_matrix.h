@@ -0,0 +1,563 @@
+#pragma once
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+// ConstraintMatrix::distribute_local_to_global() is only instantiated for the
+// matrices of the library:
+#include <deal.II/lac/constraint_matrix.templates.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace dealii;
+
+  /**
+   * Symmetric sparse matrix that stores the diagonal and the upper triangle
+   * in the CSR format, i.e. about half of the entries and column indices of
+   * SparseMatrix. Entries below the diagonal that are added are dropped, so
+   * that the full symmetric matrix can be assembled as usual.
+   *
+   * The product $\mathbf{A} \mathbf{x} = \mathbf{U} \mathbf{x} +
+   * \mathbf{U}^T \mathbf{x} - \mathbf{D} \mathbf{x}$ reads each entry once.
+   * The transposed part scatters into rows after the current one, so the rows
+   * are split into chunks that accumulate into buffers of their own, which
+   * reach as far as the largest column of the chunk. They are short for the
+   * bandwidth reducing Cuthill-McKee numbering, and summed up by the rows
+   * in a second parallel pass. The buffers make vmult() not thread-safe for
+   * concurrent calls on the same matrix.
+   *
+   * The interface is the one of BSRMatrix, i.e. the subset of SparseMatrix
+   * used by the solver.
+   */
+  template <typename number>
+  class SymmetricSparseMatrix : public Subscriptor
+  {
+  public:
+    typedef number                  value_type;
+    typedef types::global_dof_index size_type;
+
+    SymmetricSparseMatrix ();
+
+    /**
+     * Set up the upper triangle of the symmetric @p sparsity and zero the
+     * entries.
+     */
+    void reinit (const SparsityPattern &sparsity);
+
+    void clear ();
+
+    /**
+     * Only zero can be assigned, as for SparseMatrix.
+     */
+    SymmetricSparseMatrix &operator = (const double d);
+
+    size_type m () const;
+    size_type n () const;
+
+    /**
+     * Number of stored entries, i.e. of the diagonal and the upper triangle.
+     */
+    std::size_t n_nonzero_elements () const;
+
+    std::size_t memory_consumption () const;
+
+    void add (const size_type i,
+              const size_type j,
+              const number    value);
+
+    template <typename number2>
+    void add (const size_type  row,
+              const size_type  n_cols,
+              const size_type *col_indices,
+              const number2   *values,
+              const bool       elide_zero_values = true,
+              const bool       col_indices_are_sorted = false);
+
+    number el (const size_type i,
+               const size_type j) const;
+
+    number diag_element (const size_type i) const;
+
+    void vmult (Vector<number>       &dst,
+                const Vector<number> &src) const;
+
+    void Tvmult (Vector<number>       &dst,
+                 const Vector<number> &src) const;
+
+    void precondition_Jacobi (Vector<number>       &dst,
+                              const Vector<number> &src,
+                              const number          omega = 1.) const;
+
+    void precondition_SOR (Vector<number>       &dst,
+                           const Vector<number> &src,
+                           const number          omega = 1.) const;
+
+    /**
+     * Point SSOR in the same form as SparseMatrix::precondition_SSOR(). The
+     * forward sweep runs over the columns of the upper triangle. The last
+     * argument is only there for the interface of PreconditionSSOR and
+     * ignored.
+     */
+    void precondition_SSOR (Vector<number>                 &dst,
+                            const Vector<number>           &src,
+                            const number                    omega = 1.,
+                            const std::vector<std::size_t> &pos_right_of_diagonal = std::vector<std::size_t>()) const;
+
+    /**
+     * Copy into a full scalar matrix, whose pattern is set up in @p sparsity.
+     */
+    void copy_to (SparsityPattern      &sparsity,
+                  SparseMatrix<number> &matrix) const;
+
+  private:
+    /**
+     * Position of the entry (@p row, @p col) with @p col >= @p row, or
+     * numbers::invalid_size_type.
+     */
+    std::size_t index (const size_type row,
+                       const size_type col) const;
+
+    /**
+     * Forward sweep $(\mathbf{D} + \omega \mathbf{U}^T) \mathbf{y} =
+     * \mathbf{D} \mathbf{y}_0$ of SOR and SSOR in place on @p dst, where
+     * @p divide_diagonal_first selects the variant of
+     * SparseMatrix::precondition_SOR().
+     */
+    void forward_sweep (Vector<number> &dst,
+                        const number    omega,
+                        const bool      divide_diagonal_first) const;
+
+    // rows per chunk of the product at least
+    static const unsigned int min_chunk_size = 1024;
+
+    size_type n_rows;
+
+    // the diagonal is the first entry of each row, the others are sorted
+    std::vector<std::size_t> row_start;
+    std::vector<unsigned int> column;
+    AlignedVector<number>    values;
+
+    // the chunks of rows of vmult(), with the end of their buffer, the
+    // first chunk whose buffer reaches into them and the start of their
+    // buffer in scratch
+    std::vector<size_type>   chunk_start;
+    std::vector<size_type>   chunk_buffer_end;
+    std::vector<unsigned int> first_contributing_chunk;
+    std::vector<std::size_t> buffer_start;
+    mutable AlignedVector<number> scratch;
+  };
+
+
+
+  template <typename number>
+  SymmetricSparseMatrix<number>::SymmetricSparseMatrix ()
+    :
+    n_rows(0)
+  {}
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::clear ()
+  {
+    n_rows = 0;
+    row_start.clear();
+    column.clear();
+    values.clear();
+    chunk_start.clear();
+    chunk_buffer_end.clear();
+    first_contributing_chunk.clear();
+    buffer_start.clear();
+    scratch.clear();
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::reinit (const SparsityPattern &sparsity)
+  {
+    Assert (sparsity.n_rows() == sparsity.n_cols(), ExcNotQuadratic());
+    n_rows = sparsity.n_rows();
+
+    row_start.resize(n_rows + 1);
+    row_start[0] = 0;
+    for (size_type row = 0; row < n_rows; ++row)
+      {
+        std::size_t n_upper = 1;
+        for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+          if (p->column() > row)
+            ++n_upper;
+        row_start[row + 1] = row_start[row] + n_upper;
+      }
+
+    column.resize(row_start[n_rows]);
+    for (size_type row = 0; row < n_rows; ++row)
+      {
+        std::size_t k = row_start[row];
+        column[k++] = row;
+        for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+          if (p->column() > row)
+            column[k++] = p->column();
+        std::sort(column.begin() + row_start[row] + 1, column.begin() + row_start[row + 1]);
+      }
+
+    values.resize_fast(column.size());
+    *this = 0.;
+
+    // chunks of about equal numbers of entries, a few per thread
+    const unsigned int n_chunks =
+      std::max<size_type>(1, std::min<size_type>(4 * MultithreadInfo::n_threads(),
+                                                 n_rows / min_chunk_size));
+    chunk_start.resize(n_chunks + 1);
+    chunk_start[0] = 0;
+    for (unsigned int c = 1; c < n_chunks; ++c)
+      chunk_start[c] = std::upper_bound(row_start.begin(), row_start.end() - 1,
+                                        c * (row_start[n_rows] / n_chunks)) - row_start.begin() - 1;
+    chunk_start[n_chunks] = n_rows;
+
+    chunk_buffer_end.resize(n_chunks);
+    buffer_start.resize(n_chunks + 1);
+    buffer_start[0] = 0;
+    for (unsigned int c = 0; c < n_chunks; ++c)
+      {
+        size_type end = chunk_start[c + 1];
+        for (size_type row = chunk_start[c]; row < chunk_start[c + 1]; ++row)
+          if (row_start[row + 1] > row_start[row])
+            end = std::max<size_type>(end, column[row_start[row + 1] - 1] + 1);
+        chunk_buffer_end[c] = end;
+        buffer_start[c + 1] = buffer_start[c] + (end - chunk_start[c]);
+      }
+
+    first_contributing_chunk.resize(n_chunks);
+    for (unsigned int d = 0; d < n_chunks; ++d)
+      {
+        unsigned int c = d;
+        for (unsigned int c2 = 0; c2 < d; ++c2)
+          if (chunk_buffer_end[c2] > chunk_start[d])
+            {
+              c = c2;
+              break;
+            }
+        first_contributing_chunk[d] = c;
+      }
+
+    scratch.resize_fast(buffer_start[n_chunks]);
+  }
+
+
+
+  template <typename number>
+  SymmetricSparseMatrix<number> &
+  SymmetricSparseMatrix<number>::operator = (const double d)
+  {
+    Assert (d == 0, ExcMessage("Only zero can be assigned to the matrix"));
+    (void)d;
+    values.fill(number());
+    return *this;
+  }
+
+
+
+  template <typename number>
+  typename SymmetricSparseMatrix<number>::size_type
+  SymmetricSparseMatrix<number>::m () const
+  {
+    return n_rows;
+  }
+
+
+
+  template <typename number>
+  typename SymmetricSparseMatrix<number>::size_type
+  SymmetricSparseMatrix<number>::n () const
+  {
+    return n_rows;
+  }
+
+
+
+  template <typename number>
+  std::size_t
+  SymmetricSparseMatrix<number>::n_nonzero_elements () const
+  {
+    return values.size();
+  }
+
+
+
+  template <typename number>
+  std::size_t
+  SymmetricSparseMatrix<number>::memory_consumption () const
+  {
+    return MemoryConsumption::memory_consumption(row_start) +
+           MemoryConsumption::memory_consumption(column) +
+           values.memory_consumption() +
+           MemoryConsumption::memory_consumption(chunk_start) +
+           MemoryConsumption::memory_consumption(chunk_buffer_end) +
+           MemoryConsumption::memory_consumption(first_contributing_chunk) +
+           MemoryConsumption::memory_consumption(buffer_start) +
+           scratch.memory_consumption();
+  }
+
+
+
+  template <typename number>
+  std::size_t
+  SymmetricSparseMatrix<number>::index (const size_type row,
+                                        const size_type col) const
+  {
+    if (col == row)
+      return row_start[row];
+    const std::vector<unsigned int>::const_iterator
+    begin = column.begin() + row_start[row] + 1,
+    end = column.begin() + row_start[row + 1],
+    p = std::lower_bound(begin, end, static_cast<unsigned int>(col));
+    if (p == end || *p != col)
+      return numbers::invalid_size_type;
+    return p - column.begin();
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::add (const size_type i,
+                                      const size_type j,
+                                      const number    value)
+  {
+    if (j < i)
+      return;
+    const std::size_t k = index(i, j);
+    Assert (k != numbers::invalid_size_type,
+            ExcMessage("The entry is not in the sparsity pattern"));
+    values[k] += value;
+  }
+
+
+
+  template <typename number>
+  template <typename number2>
+  void
+  SymmetricSparseMatrix<number>::add (const size_type  row,
+                                      const size_type  n_cols,
+                                      const size_type *col_indices,
+                                      const number2   *col_values,
+                                      const bool       elide_zero_values,
+                                      const bool       /*col_indices_are_sorted*/)
+  {
+    for (size_type c = 0; c < n_cols; ++c)
+      if (col_indices[c] >= row &&
+          !(elide_zero_values && col_values[c] == number2()))
+        {
+          const std::size_t k = index(row, col_indices[c]);
+          Assert (k != numbers::invalid_size_type,
+                  ExcMessage("The entry is not in the sparsity pattern"));
+          values[k] += col_values[c];
+        }
+  }
+
+
+
+  template <typename number>
+  number
+  SymmetricSparseMatrix<number>::el (const size_type i,
+                                     const size_type j) const
+  {
+    const std::size_t k = (j < i ? index(j, i) : index(i, j));
+    if (k == numbers::invalid_size_type)
+      return number();
+    return values[k];
+  }
+
+
+
+  template <typename number>
+  number
+  SymmetricSparseMatrix<number>::diag_element (const size_type i) const
+  {
+    return values[row_start[i]];
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::vmult (Vector<number>       &dst,
+                                        const Vector<number> &src) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+    Assert (&src != &dst, ExcMessage("The vectors have to be different"));
+
+    const unsigned int n_chunks = chunk_start.size() - 1;
+
+    // each chunk computes its rows and the transposed contributions of its
+    // rows into its buffer
+    parallel::apply_to_subranges(0u, n_chunks,
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      for (unsigned int c = begin; c < end; ++c)
+        {
+          number *buffer = scratch.begin() + buffer_start[c];
+          const size_type offset = chunk_start[c];
+          std::fill(scratch.begin() + buffer_start[c], scratch.begin() + buffer_start[c + 1], number());
+
+          for (size_type row = chunk_start[c]; row < chunk_start[c + 1]; ++row)
+            {
+              const number x = src(row);
+              number sum = values[row_start[row]] * x;
+              for (std::size_t k = row_start[row] + 1; k < row_start[row + 1]; ++k)
+                {
+                  sum += values[k] * src(column[k]);
+                  buffer[column[k] - offset] += values[k] * x;
+                }
+              buffer[row - offset] += sum;
+            }
+        }
+    },
+    1);
+
+    // sum the buffers reaching into each chunk
+    parallel::apply_to_subranges(0u, n_chunks,
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      for (unsigned int d = begin; d < end; ++d)
+        {
+          for (size_type row = chunk_start[d]; row < chunk_start[d + 1]; ++row)
+            dst(row) = scratch[buffer_start[d] + row - chunk_start[d]];
+          for (unsigned int c = first_contributing_chunk[d]; c < d; ++c)
+            for (size_type row = chunk_start[d]; row < std::min(chunk_start[d + 1], chunk_buffer_end[c]); ++row)
+              dst(row) += scratch[buffer_start[c] + row - chunk_start[c]];
+        }
+    },
+    1);
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::Tvmult (Vector<number>       &dst,
+                                         const Vector<number> &src) const
+  {
+    vmult(dst, src);
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::precondition_Jacobi (Vector<number>       &dst,
+                                                      const Vector<number> &src,
+                                                      const number          omega) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+
+    for (size_type i = 0; i < n_rows; ++i)
+      dst(i) = omega * src(i) / values[row_start[i]];
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::forward_sweep (Vector<number> &dst,
+                                                const number    omega,
+                                                const bool      divide_diagonal_first) const
+  {
+    // the entries of row i left of the diagonal are those of column i of the
+    // upper triangle, so they are subtracted from the later rows as soon as
+    // dst(i) is known
+    for (size_type row = 0; row < n_rows; ++row)
+      {
+        if (divide_diagonal_first)
+          dst(row) *= omega / values[row_start[row]];
+        else
+          dst(row) /= values[row_start[row]];
+
+        const number scaled = (divide_diagonal_first ? dst(row) : omega * dst(row));
+        for (std::size_t k = row_start[row] + 1; k < row_start[row + 1]; ++k)
+          dst(column[k]) -= values[k] * scaled;
+      }
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::precondition_SOR (Vector<number>       &dst,
+                                                   const Vector<number> &src,
+                                                   const number          omega) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+
+    dst = src;
+    forward_sweep(dst, omega, true);
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::precondition_SSOR (Vector<number>                 &dst,
+                                                    const Vector<number>           &src,
+                                                    const number                    omega,
+                                                    const std::vector<std::size_t> &) const
+  {
+    AssertDimension (dst.size(), m());
+    AssertDimension (src.size(), n());
+
+    dst = src;
+    forward_sweep(dst, omega, false);
+
+    for (size_type row = 0; row < n_rows; ++row)
+      dst(row) *= omega * (2. - omega) * values[row_start[row]];
+
+    for (size_type row = n_rows; row-- > 0; )
+      {
+        number s = 0;
+        for (std::size_t k = row_start[row] + 1; k < row_start[row + 1]; ++k)
+          s += values[k] * dst(column[k]);
+        dst(row) -= s * omega;
+        dst(row) /= values[row_start[row]];
+      }
+  }
+
+
+
+  template <typename number>
+  void
+  SymmetricSparseMatrix<number>::copy_to (SparsityPattern      &sparsity,
+                                          SparseMatrix<number> &matrix) const
+  {
+    DynamicSparsityPattern dsp(n_rows, n_rows);
+    for (size_type row = 0; row < n_rows; ++row)
+      for (std::size_t k = row_start[row]; k < row_start[row + 1]; ++k)
+        {
+          dsp.add(row, column[k]);
+          dsp.add(column[k], row);
+        }
+    sparsity.copy_from(dsp);
+    matrix.reinit(sparsity);
+
+    for (size_type row = 0; row < n_rows; ++row)
+      for (std::size_t k = row_start[row]; k < row_start[row + 1]; ++k)
+        {
+          matrix.set(row, column[k], values[k]);
+          matrix.set(column[k], row, values[k]);
+        }
+  }
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/vectorization.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace dealii;
+
+/**
+ * Transcendental functions for the quadrature point kernels of the materials.
+ *
+ * For a VectorizedArray, the overloads of std::exp, std::log and std::pow in
+ * deal.II call the scalar functions lane by lane. The functions here instead
+ * evaluate a polynomial on all lanes at once. Only the range reduction, i.e.
+ * splitting off or applying the binary exponent, is done lane by lane with
+ * integer operations that the compiler vectorizes. For scalar arguments, as
+ * in the matrix-based assembly, the functions forward to the standard
+ * library.
+ *
+ * The accuracy is chosen by a template argument. With Accuracy::full the
+ * relative error is a few ulp of the number type, which is needed wherever
+ * energies are compared, e.g. in a line search. Accuracy::reduced gives about
+ * half the digits for fewer operations, which is sufficient for the
+ * linearization in the tangent operator.
+ *
+ * The arguments are assumed to be normalized finite numbers. In particular,
+ * log and pow require positive arguments, which is checked in debug mode,
+ * and the argument of exp is clamped to the range of the number type.
+ */
+namespace VectorizedMath
+{
+  enum class Accuracy
+  {
+    full,
+    reduced
+  };
+
+
+  namespace internal
+  {
+    // Layout of the IEEE number types and the number of terms of the
+    // polynomials:
+    template <typename Number>
+    struct NumberTraits;
+
+    template <>
+    struct NumberTraits<double>
+    {
+      typedef std::int64_t  int_type;
+      typedef std::uint64_t uint_type;
+
+      static constexpr unsigned int mantissa_bits = 52;
+      static constexpr int          exponent_bias = 1023;
+
+      // Cody-Waite splitting of ln(2), the high part has trailing zeros
+      static constexpr double ln2_hi = 6.93147180369123816490e-01;
+      static constexpr double ln2_lo = 1.90821492927058770002e-10;
+
+      static constexpr double max_exp_argument = 709.;
+      static constexpr double min_exp_argument = -708.;
+
+      static constexpr unsigned int
+      exp_degree(const Accuracy accuracy)
+      {
+        return accuracy == Accuracy::full ? 13 : 7;
+      }
+
+      static constexpr unsigned int
+      log_terms(const Accuracy accuracy)
+      {
+        return accuracy == Accuracy::full ? 11 : 5;
+      }
+    };
+
+    template <>
+    struct NumberTraits<float>
+    {
+      typedef std::int32_t  int_type;
+      typedef std::uint32_t uint_type;
+
+      static constexpr unsigned int mantissa_bits = 23;
+      static constexpr int          exponent_bias = 127;
+
+      static constexpr float ln2_hi = 6.9314575195e-01f;
+      static constexpr float ln2_lo = 1.4286067653e-06f;
+
+      static constexpr float max_exp_argument = 88.f;
+      static constexpr float min_exp_argument = -87.f;
+
+      static constexpr unsigned int
+      exp_degree(const Accuracy accuracy)
+      {
+        return accuracy == Accuracy::full ? 7 : 5;
+      }
+
+      static constexpr unsigned int
+      log_terms(const Accuracy accuracy)
+      {
+        return accuracy == Accuracy::full ? 5 : 3;
+      }
+    };
+
+
+
+    // $2^n$ for an integer $n$ within the range of normalized numbers
+    template <typename Number>
+    inline
+    Number
+    power_of_two(const int n)
+    {
+      typedef NumberTraits<Number> Traits;
+      const typename Traits::uint_type bits =
+        static_cast<typename Traits::uint_type>(n + Traits::exponent_bias) << Traits::mantissa_bits;
+      Number result;
+      std::memcpy(&result, &bits, sizeof(Number));
+      return result;
+    }
+
+
+
+    // Split $x = m 2^e$ with $m \in [\sqrt{1/2},\sqrt{2})$
+    template <typename Number>
+    inline
+    void
+    split_exponent(const Number x,
+                   Number      &m,
+                   Number      &e)
+    {
+      typedef NumberTraits<Number> Traits;
+      typedef typename Traits::uint_type uint_type;
+
+      const uint_type exponent_mask = (uint_type(1) << (8*sizeof(Number) - 1 - Traits::mantissa_bits)) - 1;
+
+      uint_type bits;
+      std::memcpy(&bits, &x, sizeof(Number));
+      int exponent = static_cast<int>((bits >> Traits::mantissa_bits) & exponent_mask) - Traits::exponent_bias;
+
+      // replace the exponent by the bias, which gives $m \in [1,2)$
+      bits = (bits & ~(exponent_mask << Traits::mantissa_bits)) |
+             (static_cast<uint_type>(Traits::exponent_bias) << Traits::mantissa_bits);
+      std::memcpy(&m, &bits, sizeof(Number));
+
+      if (m > Number(1.41421356237309504880))
+        {
+          m *= Number(0.5);
+          ++exponent;
+        }
+      e = static_cast<Number>(exponent);
+    }
+
+
+
+    // Inverse factorials $1/k!$ for the Taylor polynomial of exp
+    constexpr double inverse_factorials[] =
+    {
+      1., 1., 1./2., 1./6., 1./24., 1./120., 1./720., 1./5040., 1./40320.,
+      1./362880., 1./3628800., 1./39916800., 1./479001600., 1./6227020800.
+    };
+  }
+
+
+
+  /**
+   * Exponential function. The argument is reduced to $x = n \ln 2 + r$ with
+   * $|r| \leq \ln(2)/2$ and $e^r$ is evaluated by its Taylor polynomial.
+   */
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  Number
+  exp(const Number &x)
+  {
+    return std::exp(x);
+  }
+
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  VectorizedArray<Number>
+  exp(const VectorizedArray<Number> &x)
+  {
+    typedef internal::NumberTraits<Number> Traits;
+    constexpr unsigned int n_lanes = VectorizedArray<Number>::n_array_elements;
+    constexpr unsigned int degree = Traits::exp_degree(accuracy);
+    static_assert(degree < sizeof(internal::inverse_factorials)/sizeof(double),
+                  "Not enough coefficients");
+
+    // range reduction, lane by lane
+    const Number ln2_hi = Traits::ln2_hi;
+    const Number ln2_lo = Traits::ln2_lo;
+    VectorizedArray<Number> x_clamped, n;
+    int                     n_int[n_lanes];
+    for (unsigned int v = 0; v < n_lanes; ++v)
+      {
+        x_clamped[v] = std::min(std::max(x[v], Number(Traits::min_exp_argument)),
+                                Number(Traits::max_exp_argument));
+        n_int[v] = static_cast<int>(std::floor(x_clamped[v] * Number(1.44269504088896340736) + Number(0.5)));
+        n[v] = static_cast<Number>(n_int[v]);
+      }
+    const VectorizedArray<Number> r = (x_clamped - n * ln2_hi) - n * ln2_lo;
+
+    // Horner scheme on all lanes
+    VectorizedArray<Number> p = make_vectorized_array(Number(internal::inverse_factorials[degree]));
+    for (int k = degree - 1; k >= 0; --k)
+      p = p * r + Number(internal::inverse_factorials[k]);
+
+    VectorizedArray<Number> scaling;
+    for (unsigned int v = 0; v < n_lanes; ++v)
+      scaling[v] = internal::power_of_two<Number>(n_int[v]);
+
+    return p * scaling;
+  }
+
+
+
+  /**
+   * Natural logarithm of a positive argument. With $x = m 2^e$ and $s =
+   * (m-1)/(m+1)$, $\ln x = e \ln 2 + 2 \operatorname{artanh} s$, where the
+   * series of the area hyperbolic tangent converges fast for $|s| \leq
+   * 0.172$.
+   */
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  Number
+  log(const Number &x)
+  {
+    return std::log(x);
+  }
+
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  VectorizedArray<Number>
+  log(const VectorizedArray<Number> &x)
+  {
+    typedef internal::NumberTraits<Number> Traits;
+    constexpr unsigned int n_lanes = VectorizedArray<Number>::n_array_elements;
+    constexpr unsigned int n_terms = Traits::log_terms(accuracy);
+
+    VectorizedArray<Number> m, e;
+    for (unsigned int v = 0; v < n_lanes; ++v)
+      {
+        Assert(x[v] > 0 && std::isnormal(x[v]),
+               ExcMessage("The logarithm requires positive normalized arguments"));
+        internal::split_exponent(x[v], m[v], e[v]);
+      }
+
+    const VectorizedArray<Number> s = (m - Number(1.)) / (m + Number(1.));
+    const VectorizedArray<Number> z = s * s;
+
+    // $\sum_k z^k / (2k+1)$
+    VectorizedArray<Number> p = make_vectorized_array(Number(1.) / Number(2*n_terms - 1));
+    for (int k = n_terms - 2; k >= 0; --k)
+      p = p * z + Number(1.) / Number(2*k + 1);
+
+    const Number ln2_hi = Traits::ln2_hi;
+    const Number ln2_lo = Traits::ln2_lo;
+    return (e * ln2_lo + Number(2.) * s * p) + e * ln2_hi;
+  }
+
+
+
+  /**
+   * Power $x^y = e^{y \ln x}$ of a positive base. The logarithm is evaluated
+   * with full accuracy, since its error is amplified by the exponent. Still,
+   * the relative error grows proportionally to $|y \ln x|$.
+   */
+  template <Accuracy accuracy = Accuracy::full, typename Number, typename Exponent>
+  inline
+  Number
+  pow(const Number   &x,
+      const Exponent &y)
+  {
+    return std::pow(x, y);
+  }
+
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  VectorizedArray<Number>
+  pow(const VectorizedArray<Number> &x,
+      const Number                   y)
+  {
+    return exp<accuracy>(log<Accuracy::full>(x) * y);
+  }
+
+  template <Accuracy accuracy = Accuracy::full, typename Number>
+  inline
+  VectorizedArray<Number>
+  pow(const VectorizedArray<Number> &x,
+      const VectorizedArray<Number> &y)
+  {
+    return exp<accuracy>(log<Accuracy::full>(x) * y);
+  }
+
+
+
+  /**
+   * Square root. deal.II already maps it to the vector instruction of the
+   * hardware, it is only added to have the complete set in one place.
+   */
+  template <typename Number>
+  inline
+  Number
+  sqrt(const Number &x)
+  {
+    return std::sqrt(x);
+  }
+}
@@ -21,6 +21,9 @@
 
 // own headers
 #include <mf_elasticity.h>
+#include <mf_rve.h>
+#include <mf_monte_carlo.h>
+#include <mf_full_approximation_scheme.h>
 
 // @sect3{Main function}
 // Lastly we provide the main driver function which appears
@@ -46,8 +49,26 @@ int main (int argc, char *argv[])
                                                             dealii::numbers::invalid_unsigned_int);
 
         typedef double NumberType;
-        Solid<dim,NumberType> solid_3d(parameters);
-        solid_3d.run();
+        if (parameters.rve_homogenization)
+          {
+            RVE<dim,NumberType> rve(parameters);
+            rve.run();
+          }
+        else if (parameters.monte_carlo_samples > 0)
+          {
+            MonteCarlo<dim,NumberType> monte_carlo(parameters);
+            monte_carlo.run();
+          }
+        else if (parameters.type_nonlin == "FAS")
+          {
+            FullApproximationScheme<dim,NumberType> fas(parameters);
+            fas.run();
+          }
+        else
+          {
+            Solid<dim,NumberType> solid_3d(parameters);
+            solid_3d.run();
+          }
       }
     }
   catch (std::exception &exc)
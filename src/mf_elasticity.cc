@@ -1,4 +1,10 @@
 #include <mf_elasticity.h>
+#include <mf_rve.h>
+#include <mf_monte_carlo.h>
+#include <mf_full_approximation_scheme.h>
 
 // explicit instantiations
-template class Cook_Membrane::Solid<2,double>;
\ No newline at end of file
+template class Cook_Membrane::Solid<2,double>;
+template class Cook_Membrane::RVE<2,double>;
+template class Cook_Membrane::MonteCarlo<2,double>;
+template class Cook_Membrane::FullApproximationScheme<2,double>;
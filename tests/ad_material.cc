@@ -0,0 +1,100 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/base/vectorization.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <material.h>
+
+using namespace dealii;
+
+// Check that the Kirchhoff stress and the action of the tangent derived by
+// automatic differentiation from the neo-Hookean strain energy agree with the
+// hand-coded neo-Hookean material, lane by lane for vectorized arguments.
+
+template <int dim, typename NumberType>
+double relative_error (const SymmetricTensor<2,dim,NumberType> &a,
+                       const SymmetricTensor<2,dim,NumberType> &b,
+                       const unsigned int                       lane)
+{
+  double error = 0., norm = 0.;
+  for (unsigned int i = 0; i < dim; ++i)
+    for (unsigned int j = 0; j < dim; ++j)
+      {
+        error += std::pow(a[i][j][lane] - b[i][j][lane], 2);
+        norm  += std::pow(b[i][j][lane], 2);
+      }
+  return std::sqrt(error / norm);
+}
+
+
+
+template <int dim>
+void test ()
+{
+  typedef VectorizedArray<double> NumberType;
+  const unsigned int n_lanes = NumberType::n_array_elements;
+
+  const double mu = 0.4225e6;
+  const double nu = 0.3;
+  Material_Compressible_Neo_Hook_One_Field<dim,NumberType> material(mu,nu);
+  Material_Hyperelastic_AD<dim,NumberType,Compressible_Neo_Hook_Energy<dim>>
+  material_ad(Compressible_Neo_Hook_Energy<dim>(mu,nu));
+
+  // a different stretch, shear and compression in each lane
+  Tensor<2,dim,NumberType> F;
+  SymmetricTensor<2,dim,NumberType> src;
+  for (unsigned int v = 0; v < n_lanes; ++v)
+    for (unsigned int i = 0; i < dim; ++i)
+      for (unsigned int j = 0; j < dim; ++j)
+        {
+          F[i][j][v] = (i == j ? 0.8 + 0.15 * (v + i) : 0.1 * (j + 1) - 0.05 * (i + v));
+          if (j >= i)
+            src[i][j][v] = 1. + 0.3 * i - 0.7 * j + 0.2 * v;
+        }
+
+  const NumberType det_F = determinant(F);
+  const SymmetricTensor<2,dim,NumberType> b_bar = Physics::Elasticity::Kinematics::b(F_iso(F));
+
+  SymmetricTensor<2,dim,NumberType> tau, tau_ad;
+  material.get_tau(tau, det_F, b_bar);
+  material_ad.get_tau(tau_ad, F);
+
+  const SymmetricTensor<2,dim,NumberType> jc    = material.act_Jc(det_F, b_bar, src);
+  const SymmetricTensor<2,dim,NumberType> jc_ad = material_ad.act_Jc(F, src);
+
+  const NumberType psi    = material.get_Psi(det_F, b_bar);
+  const NumberType psi_ad = material_ad.get_Psi(F);
+
+  for (unsigned int v = 0; v < n_lanes; ++v)
+    {
+      AssertThrow(relative_error(tau_ad, tau, v) < 1e-12, ExcMessage("tau"));
+      AssertThrow(relative_error(jc_ad, jc, v) < 1e-12, ExcMessage("Jc"));
+      AssertThrow(std::abs(psi_ad[v] - psi[v]) < 1e-12 * std::abs(psi[v]), ExcMessage("Psi"));
+    }
+
+  deallog.push(Utilities::int_to_string(dim) + "d");
+  deallog << "Ok" << std::endl;
+  deallog.pop();
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test<2>();
+  test<3>();
+  deallog.pop();
+}
@@ -0,0 +1,112 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the adjoint sensitivities of the vertical tip displacement of the
+// Cook membrane with respect to the shear modulus and Poisson's ratio
+// against central differences of forward solves with perturbed parameters.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.5
+end
+subsection Sensitivity
+  set Adjoint sensitivities = true
+end
+)";
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  {
+    std::ofstream file("adjoint_sensitivities.prm");
+    file << cook_parameters;
+  }
+  const Parameters::AllParameters parameters("adjoint_sensitivities.prm");
+
+  Solid<2,double> solid(parameters);
+  solid.run();
+  const std::pair<double,double> sensitivities = solid.get_parameter_sensitivities();
+
+  // the forward solves do not need the adjoint
+  Parameters::AllParameters parameters_perturbed(parameters);
+  parameters_perturbed.adjoint_sensitivities = false;
+
+  const double delta_mu = 1e-3 * parameters.mu;
+  parameters_perturbed.mu = parameters.mu + delta_mu;
+  const double tip_mu_plus = tip_displacement(parameters_perturbed);
+  parameters_perturbed.mu = parameters.mu - delta_mu;
+  const double tip_mu_minus = tip_displacement(parameters_perturbed);
+  parameters_perturbed.mu = parameters.mu;
+  const double difference_mu = (tip_mu_plus - tip_mu_minus) / (2. * delta_mu);
+
+  const double delta_nu = 1e-3 * parameters.nu;
+  parameters_perturbed.nu = parameters.nu + delta_nu;
+  const double tip_nu_plus = tip_displacement(parameters_perturbed);
+  parameters_perturbed.nu = parameters.nu - delta_nu;
+  const double tip_nu_minus = tip_displacement(parameters_perturbed);
+  const double difference_nu = (tip_nu_plus - tip_nu_minus) / (2. * delta_nu);
+
+  AssertThrow(std::abs(sensitivities.first - difference_mu) < 1e-3 * std::abs(difference_mu),
+              ExcMessage("d(tip)/d(mu): " + std::to_string(sensitivities.first) +
+                         " != " + std::to_string(difference_mu)));
+  AssertThrow(std::abs(sensitivities.second - difference_nu) < 1e-3 * std::abs(difference_nu),
+              ExcMessage("d(tip)/d(nu): " + std::to_string(sensitivities.second) +
+                         " != " + std::to_string(difference_nu)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
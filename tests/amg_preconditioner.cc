@@ -0,0 +1,112 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the AMG preconditioner of the assembled tangent on the Cook
+// membrane: Set up again in every Newton iteration or reused while the CG
+// iterations stay low, the solution agrees with the one preconditioned by
+// the Jacobi method. Without Trilinos, there is nothing to check.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("amg_preconditioner.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("amg_preconditioner.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+#ifdef DEAL_II_WITH_TRILINOS
+  const std::string assembled = "subsection Linear solver\n"
+                                "  set Solver type   = CG\n"
+                                "  set Matrix format = CSR\n"
+                                "end\n";
+
+  const double tip_jacobi =
+    tip_displacement(make_parameters(assembled +
+                                     "subsection Linear solver\n"
+                                     "  set Preconditioner type = jacobi\n"
+                                     "end\n"));
+
+  for (const std::string ratio : {"1.0", "1.5"})
+    {
+      const double tip_amg =
+        tip_displacement(make_parameters(assembled +
+                                         "subsection Linear solver\n"
+                                         "  set Preconditioner type = amg\n"
+                                         "  set AMG rebuild ratio   = " + ratio + "\n"
+                                         "end\n"));
+      AssertThrow(std::abs(tip_amg - tip_jacobi) < 1e-7 * std::abs(tip_jacobi),
+                  ExcMessage("AMG with ratio " + ratio + ": " + std::to_string(tip_amg) +
+                             " != " + std::to_string(tip_jacobi)));
+    }
+#endif
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
@@ -0,0 +1,62 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/vector.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <anderson_acceleration.h>
+
+using namespace dealii;
+
+// Check that the Anderson acceleration of the linear fixed-point iteration
+// x = M x + b finds the fixed point after n+1 iterations for a history at
+// least as deep as the dimension n, where the plain iteration converges
+// slowly, and that its history stays within the depth.
+
+void test_linear_fixed_point ()
+{
+  const unsigned int n = 4;
+  const double diagonal[n] = {0.9, 0.8, -0.5, 0.95};
+
+  Vector<double> fixed_point(n);
+  for (unsigned int i=0; i<n; ++i)
+    fixed_point(i) = 1. / (1. - diagonal[i]);
+
+  AndersonAcceleration<Vector<double>> anderson(n);
+  AssertThrow(anderson.max_n_vectors() == 2*n+2, ExcInternalError());
+
+  Vector<double> x(n), update(n);
+  for (unsigned int k=0; k<=n+1; ++k)
+    {
+      for (unsigned int i=0; i<n; ++i)
+        update(i) = diagonal[i] * x(i) + 1. - x(i);
+
+      anderson.apply(x, update);
+      x += update;
+    }
+
+  x -= fixed_point;
+  AssertThrow(x.l2_norm() < 1e-8 * fixed_point.l2_norm(), ExcMessage("fixed point"));
+  AssertThrow(anderson.memory_consumption() <= anderson.max_n_vectors() * Vector<double>(n).memory_consumption(),
+              ExcMessage("memory"));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test_linear_fixed_point();
+  deallog.pop();
+}
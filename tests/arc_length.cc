@@ -0,0 +1,108 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check that the arc-length continuation of the Cook membrane ends on the
+// equilibrium path of the load control: As the neo-Hookean stress is
+// proportional to the shear modulus for a fixed Poisson's ratio, the state
+// at the final load factor $\lambda \geq 1$ is the one at the full load for
+// the shear modulus divided by $\lambda$.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("arc_length.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("arc_length.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const Parameters::AllParameters parameters =
+    make_parameters("subsection Continuation\n"
+                    "  set Continuation type = Arc-length\n"
+                    "  set Final load factor = 1\n"
+                    "end\n");
+
+  Solid<2,double> solid(parameters);
+  solid.run();
+  const double load_factor = solid.get_load_factor();
+  const double tip_arc_length = solid.get_vertical_tip_displacement();
+  AssertThrow(load_factor >= 1.0, ExcMessage("final load factor"));
+
+  Parameters::AllParameters parameters_load(parameters);
+  parameters_load.type_continuation = "Load";
+  parameters_load.mu /= load_factor;
+  const double tip_load = tip_displacement(parameters_load);
+
+  AssertThrow(std::abs(tip_arc_length - tip_load) < 1e-6 * std::abs(tip_load),
+              ExcMessage("tip displacement: " + std::to_string(tip_arc_length) +
+                         " != " + std::to_string(tip_load)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
@@ -0,0 +1,111 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <bsr_matrix.h>
+
+using namespace dealii;
+
+// Check that the block CSR matrix gives the same product and relaxation
+// methods as SparseMatrix for a symmetric matrix with nodal blocks, where
+// the scalar pattern does not fill all blocks, and that the copy for the
+// direct solver gives the same matrix.
+
+template <int block_size>
+void test ()
+{
+  const unsigned int n_nodes = 50;
+  const unsigned int n = n_nodes * block_size;
+
+  // couple each node with a few others, without some of the entries in the
+  // off-diagonal blocks
+  DynamicSparsityPattern dsp(n, n);
+  for (unsigned int I = 0; I < n_nodes; ++I)
+    for (const unsigned int J : {I, (I + 1) % n_nodes, (I + 7) % n_nodes})
+      for (unsigned int r = 0; r < block_size; ++r)
+        for (unsigned int c = 0; c < block_size; ++c)
+          if (I == J || (r + c) % 2 == 0)
+            {
+              dsp.add(I * block_size + r, J * block_size + c);
+              dsp.add(J * block_size + c, I * block_size + r);
+            }
+  SparsityPattern sparsity;
+  sparsity.copy_from(dsp);
+
+  SparseMatrix<double> matrix(sparsity);
+  BSRMatrix<block_size,double> matrix_bsr;
+  matrix_bsr.reinit(sparsity);
+  for (unsigned int row = 0; row < n; ++row)
+    for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+      if (p->column() >= row)
+        {
+          const double value = (p->column() == row ? 10. :
+                                -1. + 0.01 * ((row * 13 + p->column() * 7) % 50));
+          matrix.set(row, p->column(), value);
+          matrix.set(p->column(), row, value);
+          matrix_bsr.add(row, p->column(), value);
+          if (p->column() != row)
+            matrix_bsr.add(p->column(), row, value);
+        }
+
+  Vector<double> src(n), dst(n), dst_bsr(n);
+  for (unsigned int i = 0; i < n; ++i)
+    src(i) = std::sin(1. + i);
+
+  matrix.vmult(dst, src);
+  matrix_bsr.vmult(dst_bsr, src);
+  dst_bsr -= dst;
+  AssertThrow(dst_bsr.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("vmult"));
+
+  matrix.precondition_Jacobi(dst, src, 0.8);
+  matrix_bsr.precondition_Jacobi(dst_bsr, src, 0.8);
+  dst_bsr -= dst;
+  AssertThrow(dst_bsr.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("Jacobi"));
+
+  matrix.precondition_SOR(dst, src, 1.2);
+  matrix_bsr.precondition_SOR(dst_bsr, src, 1.2);
+  dst_bsr -= dst;
+  AssertThrow(dst_bsr.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("SOR"));
+
+  matrix.precondition_SSOR(dst, src, 1.2);
+  matrix_bsr.precondition_SSOR(dst_bsr, src, 1.2);
+  dst_bsr -= dst;
+  AssertThrow(dst_bsr.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("SSOR"));
+
+  SparsityPattern sparsity_copy;
+  SparseMatrix<double> matrix_copy;
+  matrix_bsr.copy_to(sparsity_copy, matrix_copy);
+  AssertThrow(matrix_copy.n_nonzero_elements() == matrix_bsr.n_nonzero_elements(),
+              ExcMessage("copy pattern"));
+  matrix.vmult(dst, src);
+  matrix_copy.vmult(dst_bsr, src);
+  dst_bsr -= dst;
+  AssertThrow(dst_bsr.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("copy"));
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  deallog.push("2d");
+  test<2>();
+  test<3>();
+  deallog << "Ok" << std::endl;
+  deallog.pop();
+  deallog.pop();
+}
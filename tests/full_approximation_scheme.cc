@@ -0,0 +1,102 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_full_approximation_scheme.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the full approximation scheme on the Cook membrane: Converged to a
+// tight force tolerance on two levels, it finds the same tip displacement as
+// Newton's method on the finest level.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("full_approximation_scheme.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("full_approximation_scheme.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const double tip_newton = tip_displacement(make_parameters(""));
+
+  FullApproximationScheme<2,double> fas(
+    make_parameters("subsection Nonlinear solver\n"
+                    "  set Solver type     = FAS\n"
+                    "  set Tolerance force = 1.0e-8\n"
+                    "end\n"
+                    "subsection Nonlinear multigrid\n"
+                    "  set Levels     = 2\n"
+                    "  set Max cycles = 100\n"
+                    "end\n"));
+  fas.run();
+  const double tip_fas = fas.get_vertical_tip_displacement();
+  AssertThrow(std::abs(tip_fas - tip_newton) < 1e-4 * std::abs(tip_newton),
+              ExcMessage("FAS: " + std::to_string(tip_fas) +
+                         " != " + std::to_string(tip_newton)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
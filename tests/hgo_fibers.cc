@@ -0,0 +1,119 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the fiber reinforced material on the Cook membrane: The matrix-free
+// operator and the assembled tangent give the same tip displacement, the
+// fibers stiffen the membrane, and without fiber stiffness the material is
+// the neo-Hookean ground matrix.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("hgo_fibers.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("hgo_fibers.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const double tip_neo_hooke = tip_displacement(make_parameters(""));
+
+  const std::string hgo = "subsection Material properties\n"
+                          "  set Material model  = HGO\n"
+                          "  set Fiber stiffness = 1.0e5\n"
+                          "  set Fiber exponent  = 1.0\n"
+                          "  set Fiber angle     = 30\n"
+                          "  set Fiber families  = 2\n"
+                          "end\n";
+
+  const double tip_matrix_free = tip_displacement(make_parameters(hgo));
+  const double tip_assembled =
+    tip_displacement(make_parameters(hgo +
+                                     "subsection Linear solver\n"
+                                     "  set Solver type = CG\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_matrix_free - tip_assembled) < 1e-7 * std::abs(tip_assembled),
+              ExcMessage("matrix-free: " + std::to_string(tip_matrix_free) +
+                         " != " + std::to_string(tip_assembled)));
+
+  AssertThrow(tip_matrix_free < (1. - 1e-3) * tip_neo_hooke,
+              ExcMessage("stiffening: " + std::to_string(tip_matrix_free) +
+                         " >= " + std::to_string(tip_neo_hooke)));
+
+  const double tip_no_fibers =
+    tip_displacement(make_parameters(hgo +
+                                     "subsection Material properties\n"
+                                     "  set Fiber stiffness = 0\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_no_fibers - tip_neo_hooke) < 1e-7 * std::abs(tip_neo_hooke),
+              ExcMessage("ground matrix: " + std::to_string(tip_no_fibers) +
+                         " != " + std::to_string(tip_neo_hooke)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
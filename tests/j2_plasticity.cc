@@ -0,0 +1,187 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/physics/elasticity/kinematics.h>
+#include <deal.II/physics/elasticity/standard_tensors.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <material.h>
+
+using namespace dealii;
+
+// Check the return mapping and the tangent of the J2 plasticity model:
+// 1) below the yield stress it coincides with the neo-Hookean material,
+// 2) after a plastic step the yield condition is satisfied,
+// 3) the tangent matches a finite difference of the Kirchhoff stress along
+//    $\delta \mathbf{F} = \mathbf{l} \mathbf{F}$, i.e.
+//    $\delta \boldsymbol{\tau} = J \mathfrak{c} : \textrm{sym}(\mathbf{l}) +
+//    \mathbf{l} \boldsymbol{\tau} + \boldsymbol{\tau} \mathbf{l}^T$,
+// 4) the vectorized evaluation with elastic and plastic lanes matches the
+//    scalar one lane by lane.
+template <int dim>
+void test_plasticity ()
+{
+  typedef double number;
+  typedef Material_J2_Plasticity<dim,number>                  Material;
+  typedef Material_J2_Plasticity<dim,VectorizedArray<number>> MaterialVectorized;
+
+  const double nu = 0.3;
+  const double mu = 0.4225e6;
+  const double yield_stress = 2.0e4;
+  const double K = 1.0e5;
+
+  Material           material(mu,nu,yield_stress,K,0.0);
+  MaterialVectorized material_vectorized(mu,nu,yield_stress,K,0.0);
+  Material_Compressible_Neo_Hook_One_Field<dim,number> neo_hook(mu,nu);
+
+  typename Material::History history_0;
+  {
+    const std::vector<double> initial = Material::initial_history();
+    std::copy(initial.begin(), initial.end(), history_0.begin());
+  }
+
+  Tensor<2,dim,number> grad_u_small, grad_u_large, l;
+  for (unsigned int i = 0; i < dim; ++i)
+    for (unsigned int j = 0; j < dim; ++j)
+      {
+        grad_u_small[i][j] = 1e-4 * (1. + i + 2.*j);
+        grad_u_large[i][j] = 0.05 * (1. + (i+j)%2) * (i<j ? 1. : -0.5);
+        l[i][j] = std::sin(1. + i + 3.*j);
+      }
+  const SymmetricTensor<2,dim,number> symm_l = symmetrize(l);
+
+  // 1) elastic step
+  {
+    const Tensor<2,dim,number> F = Physics::Elasticity::Kinematics::F(grad_u_small);
+    const number det_F = determinant(F);
+    const SymmetricTensor<2,dim,number> b_bar =
+      Physics::Elasticity::Kinematics::b(Physics::Elasticity::Kinematics::F_iso(F));
+
+    typename Material::State   state;
+    typename Material::History history;
+    material.return_mapping(state,history,F,history_0);
+    AssertThrow(history[Material::alpha_index] == 0., ExcMessage("elastic alpha"));
+
+    SymmetricTensor<2,dim,number> tau;
+    neo_hook.get_tau(tau,det_F,b_bar);
+    AssertThrow((tau - state.tau).norm() < 1e-10 * tau.norm(), ExcMessage("elastic tau"));
+
+    const SymmetricTensor<2,dim,number> jc = neo_hook.act_Jc(det_F,b_bar,symm_l);
+    AssertThrow((jc - material.act_Jc(state,symm_l)).norm() < 1e-10 * jc.norm(),
+                ExcMessage("elastic tangent"));
+  }
+
+  // 2) plastic step, starting from a previous plastic state
+  const Tensor<2,dim,number> F_n = Physics::Elasticity::Kinematics::F(0.8 * grad_u_large);
+  const Tensor<2,dim,number> F   = Physics::Elasticity::Kinematics::F(grad_u_large);
+  typename Material::History history_n, history;
+  typename Material::State   state;
+  material.return_mapping(state,history_n,F_n,history_0);
+  material.return_mapping(state,history,F,history_n);
+
+  const number alpha = history[Material::alpha_index];
+  AssertThrow(alpha > history_n[Material::alpha_index], ExcMessage("no plastic flow"));
+  {
+    const SymmetricTensor<2,dim,number> s = deviator(state.tau);
+    const number f = s.norm() - std::sqrt(2./3.) * (yield_stress + K * alpha);
+    AssertThrow(std::abs(f) < 1e-10 * yield_stress, ExcMessage("yield condition"));
+  }
+
+  // 3) finite difference check of the tangent
+  {
+    const double h = 1e-7;
+    typename Material::State   state_p, state_m;
+    typename Material::History history_p, history_m;
+    material.return_mapping(state_p,history_p,F + h * l * F,history_n);
+    material.return_mapping(state_m,history_m,F - h * l * F,history_n);
+
+    const Tensor<2,dim,number> tau_ns(state.tau);
+    const Tensor<2,dim,number> dtau_fd = (Tensor<2,dim,number>(state_p.tau) -
+                                          Tensor<2,dim,number>(state_m.tau)) / (2. * h);
+    const Tensor<2,dim,number> dtau = Tensor<2,dim,number>(material.act_Jc(state,symm_l))
+                                      + l * tau_ns + tau_ns * transpose(l);
+
+    AssertThrow((dtau - dtau_fd).norm() < 1e-6 * dtau_fd.norm(), ExcMessage("tangent"));
+  }
+
+  // 4) vectorized evaluation, every other lane stays elastic
+  {
+    const unsigned int n_lanes = VectorizedArray<number>::n_array_elements;
+    Tensor<2,dim,VectorizedArray<number>> F_v;
+    typename MaterialVectorized::History history_n_v, history_v;
+    for (unsigned int v = 0; v < n_lanes; ++v)
+      {
+        const Tensor<2,dim,number> grad_u = (v%2 == 0 ? grad_u_large : grad_u_small) * (1. + 0.1*v);
+        const Tensor<2,dim,number> F_lane = Physics::Elasticity::Kinematics::F(grad_u);
+        for (unsigned int i = 0; i < dim; ++i)
+          for (unsigned int j = 0; j < dim; ++j)
+            F_v[i][j][v] = F_lane[i][j];
+        for (unsigned int c = 0; c < Material::n_history_variables; ++c)
+          history_n_v[c][v] = history_n[c];
+      }
+
+    SymmetricTensor<2,dim,VectorizedArray<number>> symm_l_v;
+    for (unsigned int i = 0; i < dim; ++i)
+      for (unsigned int j = i; j < dim; ++j)
+        symm_l_v[i][j] = make_vectorized_array<number>(symm_l[i][j]);
+
+    typename MaterialVectorized::State state_v;
+    material_vectorized.return_mapping(state_v,history_v,F_v,history_n_v);
+    const SymmetricTensor<2,dim,VectorizedArray<number>> jc_v = material_vectorized.act_Jc(state_v,symm_l_v);
+
+    for (unsigned int v = 0; v < n_lanes; ++v)
+      {
+        Tensor<2,dim,number> F_lane;
+        for (unsigned int i = 0; i < dim; ++i)
+          for (unsigned int j = 0; j < dim; ++j)
+            F_lane[i][j] = F_v[i][j][v];
+
+        typename Material::State   state_lane;
+        typename Material::History history_lane;
+        material.return_mapping(state_lane,history_lane,F_lane,history_n);
+        const SymmetricTensor<2,dim,number> jc = material.act_Jc(state_lane,symm_l);
+
+        for (unsigned int i = 0; i < dim; ++i)
+          for (unsigned int j = i; j < dim; ++j)
+            {
+              AssertThrow(std::abs(state_v.tau[i][j][v] - state_lane.tau[i][j]) < 1e-10 * state_lane.tau.norm(),
+                          ExcMessage("vectorized tau"));
+              AssertThrow(std::abs(jc_v[i][j][v] - jc[i][j]) < 1e-10 * jc.norm(),
+                          ExcMessage("vectorized tangent"));
+            }
+        for (unsigned int c = 0; c < Material::n_history_variables; ++c)
+          AssertThrow(std::abs(history_v[c][v] - history_lane[c]) < 1e-12 * (1. + std::abs(history_lane[c])),
+                      ExcMessage("vectorized history"));
+      }
+  }
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  deallog.push("2d");
+  test_plasticity<2>();
+  deallog.pop();
+  deallog.push("3d");
+  test_plasticity<3>();
+  deallog.pop();
+  deallog.pop();
+}
@@ -0,0 +1,110 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the Chebyshev iteration on the linear elastic operator as the
+// preconditioner of the matrix-free solver on the Cook membrane: With the
+// default and with an explicit smoothing range and eigenvalue estimate, the
+// solution agrees with the one preconditioned by the Jacobi method.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("linear_elastic_preconditioner.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("linear_elastic_preconditioner.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const double tip_jacobi =
+    tip_displacement(make_parameters("subsection Linear solver\n"
+                                     "  set Preconditioner type = jacobi\n"
+                                     "end\n"));
+
+  const double tip_default =
+    tip_displacement(make_parameters("subsection Linear solver\n"
+                                     "  set Preconditioner type = linear_elastic\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_default - tip_jacobi) < 1e-7 * std::abs(tip_jacobi),
+              ExcMessage("default: " + std::to_string(tip_default) +
+                         " != " + std::to_string(tip_jacobi)));
+
+  const double tip_explicit =
+    tip_displacement(make_parameters("subsection Linear solver\n"
+                                     "  set Preconditioner type                  = linear_elastic\n"
+                                     "  set Preconditioner degree                = 3\n"
+                                     "  set Preconditioner smoothing range       = 20\n"
+                                     "  set Preconditioner eigenvalue iterations = 30\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_explicit - tip_jacobi) < 1e-7 * std::abs(tip_jacobi),
+              ExcMessage("explicit: " + std::to_string(tip_explicit) +
+                         " != " + std::to_string(tip_jacobi)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
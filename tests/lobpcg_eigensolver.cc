@@ -0,0 +1,137 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/identity_matrix.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_eigensolver.h>
+
+using namespace dealii;
+
+// Check that LOBPCG finds the lowest eigenvalues of the linear finite
+// element discretization of -u'' = lambda u on (0,1) with homogeneous
+// Dirichlet conditions, which are $\lambda_k = \frac{6}{h^2} \frac{1 -
+// \cos\theta_k}{2 + \cos\theta_k}$ with $\theta_k = k \pi h$ for the
+// consistent mass matrix and $\lambda_k = \frac{2}{h} (1 - \cos\theta_k)$
+// for the identity, and that the eigenvectors are B-orthonormal.
+
+// the eigensolver applies the operators to blocks of vectors
+class BlockSparseMatrix
+{
+public:
+  BlockSparseMatrix(const SparseMatrix<double> &matrix)
+    :
+    matrix(matrix)
+  {}
+
+  void vmult(std::vector<Vector<double>>       &dst,
+             const std::vector<Vector<double>> &src) const
+  {
+    for (unsigned int j=0; j<src.size(); ++j)
+      matrix.vmult(dst[j], src[j]);
+  }
+
+private:
+  const SparseMatrix<double> &matrix;
+};
+
+
+template <typename MassMatrixType>
+void check (const SparseMatrix<double>  &stiffness,
+            const MassMatrixType        &mass,
+            const SparseMatrix<double>  &mass_matrix,
+            const std::vector<double>   &exact_eigenvalues)
+{
+  const unsigned int n = stiffness.m();
+  const unsigned int n_eigenvalues = exact_eigenvalues.size();
+
+  PreconditionJacobi<SparseMatrix<double>> preconditioner;
+  preconditioner.initialize(stiffness);
+  ConstraintMatrix constraints;
+  constraints.close();
+
+  LOBPCGEigensolver::AdditionalData data(500, 1e-8);
+  LOBPCGEigensolver eigensolver(data);
+  std::vector<double> eigenvalues;
+  std::vector<Vector<double>> eigenvectors(n_eigenvalues, Vector<double>(n));
+  std::vector<double> residuals;
+  const unsigned int n_iterations =
+    eigensolver.solve(BlockSparseMatrix(stiffness), mass, preconditioner, constraints,
+                      eigenvalues, eigenvectors, residuals);
+  AssertThrow(n_iterations < data.max_iterations, ExcMessage("convergence"));
+
+  for (unsigned int k=0; k<n_eigenvalues; ++k)
+    AssertThrow(std::abs(eigenvalues[k] - exact_eigenvalues[k]) < 1e-6 * exact_eigenvalues[k],
+                ExcMessage("eigenvalue " + Utilities::int_to_string(k)));
+
+  Vector<double> tmp(n);
+  for (unsigned int i=0; i<n_eigenvalues; ++i)
+    {
+      mass_matrix.vmult(tmp, eigenvectors[i]);
+      for (unsigned int j=0; j<n_eigenvalues; ++j)
+        AssertThrow(std::abs(eigenvectors[j] * tmp - (i == j ? 1. : 0.)) < 1e-10,
+                    ExcMessage("B-orthonormality"));
+    }
+}
+
+
+void test ()
+{
+  const unsigned int n = 50;
+  const unsigned int n_eigenvalues = 4;
+  const double h = 1. / (n + 1);
+
+  DynamicSparsityPattern dsp(n, n);
+  for (unsigned int i=0; i<n; ++i)
+    for (unsigned int j=(i > 0 ? i-1 : 0); j<std::min(i+2, n); ++j)
+      dsp.add(i, j);
+  SparsityPattern sparsity;
+  sparsity.copy_from(dsp);
+
+  SparseMatrix<double> stiffness(sparsity), mass(sparsity), identity(sparsity);
+  for (unsigned int i=0; i<n; ++i)
+    for (SparsityPattern::iterator p = sparsity.begin(i); p != sparsity.end(i); ++p)
+      {
+        const bool diagonal = (p->column() == i);
+        stiffness.set(i, p->column(), (diagonal ? 2. : -1.) / h);
+        mass.set(i, p->column(), (diagonal ? 4. : 1.) * h / 6.);
+        identity.set(i, p->column(), diagonal ? 1. : 0.);
+      }
+
+  std::vector<double> exact_mass(n_eigenvalues), exact_identity(n_eigenvalues);
+  for (unsigned int k=0; k<n_eigenvalues; ++k)
+    {
+      const double theta = (k + 1) * numbers::PI * h;
+      exact_mass[k] = 6. / (h * h) * (1. - std::cos(theta)) / (2. + std::cos(theta));
+      exact_identity[k] = 2. / h * (1. - std::cos(theta));
+    }
+
+  check(stiffness, BlockSparseMatrix(mass), mass, exact_mass);
+  check(stiffness, IdentityMatrix(n), identity, exact_identity);
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
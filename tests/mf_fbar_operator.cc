@@ -0,0 +1,191 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/function.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_system.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/fe/mapping_q_eulerian.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <deal.II/physics/elasticity/kinematics.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_nh_operator.h>
+
+using namespace dealii;
+
+// Check the matrix-free operator of the mean dilatation (F-bar) formulation
+// for a nearly incompressible material with nu = 0.4999: it has to match a
+// finite difference of the internal forces and be symmetric.
+
+template <int dim>
+class Displacement : public Function<dim>
+{
+public:
+  Displacement() :
+    Function<dim>(dim)
+  {}
+
+  double value (const Point<dim> &p,
+                const unsigned int component) const
+  {
+    if (component==0)
+      return 0.1*p[0]*p[1];
+    else if (component==1)
+      return -0.05*p[0]*p[0] + 0.02*p[1];
+    else
+      return 0.;
+  }
+};
+
+
+// Internal forces $\int_{\Omega_0} \boldsymbol{\tau} : \nabla_x \delta
+// \mathbf{v} \, dV$ with the pressure from the mean dilatation of each cell:
+template <int dim>
+void compute_internal_forces(const DoFHandler<dim>                                 &dof,
+                             const Quadrature<dim>                                 &quad,
+                             Material_Compressible_Neo_Hook_One_Field<dim,double> &material,
+                             const Vector<double>                                  &displacement,
+                             Vector<double>                                        &forces)
+{
+  const FiniteElement<dim> &fe = dof.get_fe();
+  FEValues<dim> fe_values(fe, quad, update_gradients | update_JxW_values);
+  const FEValuesExtractors::Vector u_fe(0);
+
+  std::vector<Tensor<2,dim>>           grads_u(quad.size());
+  std::vector<types::global_dof_index> local_dof_indices(fe.dofs_per_cell);
+
+  forces = 0.;
+  for (const auto &cell: dof.active_cell_iterators())
+    {
+      fe_values.reinit(cell);
+      fe_values[u_fe].get_function_gradients(displacement, grads_u);
+      cell->get_dof_indices(local_dof_indices);
+
+      double volume = 0., theta = 0.;
+      for (unsigned int q=0; q<quad.size(); ++q)
+        {
+          volume += fe_values.JxW(q);
+          theta += determinant(Physics::Elasticity::Kinematics::F(grads_u[q])) * fe_values.JxW(q);
+        }
+      theta /= volume;
+
+      for (unsigned int q=0; q<quad.size(); ++q)
+        {
+          const Tensor<2,dim> F = Physics::Elasticity::Kinematics::F(grads_u[q]);
+          const SymmetricTensor<2,dim> b_bar =
+            Physics::Elasticity::Kinematics::b(Physics::Elasticity::Kinematics::F_iso(F));
+          const Tensor<2,dim> F_inv = invert(F);
+
+          SymmetricTensor<2,dim> tau;
+          material.get_tau_mean_dilatation(tau,determinant(F),b_bar,theta);
+
+          for (unsigned int i=0; i<fe.dofs_per_cell; ++i)
+            forces(local_dof_indices[i]) += (symmetrize(fe_values[u_fe].gradient(i,q) * F_inv) * tau)
+                                            * fe_values.JxW(q);
+        }
+    }
+}
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void test_fbar ()
+{
+  typedef double number;
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global (2);
+
+  FESystem<dim> fe(FE_Q<dim>(fe_degree),dim);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+
+  ConstraintMatrix constraints;
+  constraints.close();
+
+  Vector<number> displacement(dof.n_dofs());
+  VectorTools::interpolate(dof, Displacement<dim>(), displacement);
+
+  MappingQEulerian<dim,Vector<number>> mapping(/*degree*/1,dof,displacement);
+
+  auto mf_data_current   = std::make_shared<MatrixFree<dim,number>>();
+  auto mf_data_reference = std::make_shared<MatrixFree<dim,number>>();
+
+  const QGauss<1> quad (n_q_points_1d);
+  typename MatrixFree<dim,number>::AdditionalData data;
+  data.tasks_parallel_scheme = MatrixFree<dim,number>::AdditionalData::none;
+
+  mf_data_reference->reinit (        dof, constraints, quad, data);
+  mf_data_current->reinit   (mapping,dof, constraints, quad, data);
+
+  const double nu = 0.4999;
+  const double mu = 0.4225e6;
+  auto material = std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<number>>>(mu,nu);
+  Material_Compressible_Neo_Hook_One_Field<dim,number> material_standard(mu,nu);
+
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number> op;
+  op.initialize(mf_data_current,mf_data_reference,displacement);
+  op.set_material(material);
+  op.set_mean_dilatation(true);
+  op.compute_cell_dilatation();
+
+  Vector<number> src(dof.n_dofs()), src2(dof.n_dofs()), dst(dof.n_dofs()), dst2(dof.n_dofs());
+  for (unsigned int i=0; i<src.size(); ++i)
+    {
+      src(i)  = ((double)std::rand())/RAND_MAX;
+      src2(i) = ((double)std::rand())/RAND_MAX;
+    }
+
+  op.vmult(dst,src);
+  op.vmult(dst2,src2);
+
+  // finite difference of the internal forces
+  const double h = 1e-7;
+  const QGauss<dim> quad_cell (n_q_points_1d);
+  Vector<number> u(dof.n_dofs()), forces_p(dof.n_dofs()), forces_m(dof.n_dofs());
+  u = displacement;
+  u.add(h,src);
+  compute_internal_forces(dof,quad_cell,material_standard,u,forces_p);
+  u = displacement;
+  u.add(-h,src);
+  compute_internal_forces(dof,quad_cell,material_standard,u,forces_m);
+
+  Vector<number> diff(forces_p);
+  diff -= forces_m;
+  diff *= 1./(2.*h);
+  diff -= dst;
+  AssertThrow(diff.l2_norm() < 1e-6 * dst.l2_norm(), ExcMessage("tangent"));
+
+  // symmetry
+  const double a12 = src2 * dst;
+  const double a21 = src * dst2;
+  AssertThrow(std::abs(a12 - a21) < 1e-10 * std::abs(a12), ExcMessage("symmetry"));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  deallog.push("2d");
+  test_fbar<2,1,2>();
+  deallog.pop();
+  deallog.pop();
+}
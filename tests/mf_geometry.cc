@@ -0,0 +1,97 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the matrix-free operator on the Cook membrane: Computing the
+// Jacobians of the current configuration in the cell kernel gives the same
+// tip displacement as tabulating them.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("mf_geometry.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("mf_geometry.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const double tip_tabulated =
+    tip_displacement(make_parameters("subsection Linear solver\n"
+                                     "  set Current configuration geometry = Tabulated\n"
+                                     "end\n"));
+  const double tip_on_the_fly =
+    tip_displacement(make_parameters("subsection Linear solver\n"
+                                     "  set Current configuration geometry = On the fly\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_on_the_fly - tip_tabulated) < 1e-7 * std::abs(tip_tabulated),
+              ExcMessage("on the fly: " + std::to_string(tip_on_the_fly) +
+                         " != " + std::to_string(tip_tabulated)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
@@ -0,0 +1,156 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/function.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_system.h>
+#include <deal.II/fe/mapping_q_eulerian.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <deal.II/physics/elasticity/kinematics.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_nh_operator.h>
+
+using namespace dealii;
+
+// Check the homogenization kernels of the matrix-free operator on a periodic
+// unit cube under a homogeneous deformation: the condensed internal forces
+// vanish, the volume average of the stress is the one of the material and
+// the averaged linearized stress matches a finite difference of it.
+
+template <int dim>
+class AffineDisplacement : public Function<dim>
+{
+public:
+  AffineDisplacement(const Tensor<2,dim> &H) :
+    Function<dim>(dim),
+    H(H)
+  {}
+
+  double value (const Point<dim> &p,
+                const unsigned int component) const
+  {
+    double u = 0.;
+    for (unsigned int j=0; j<dim; ++j)
+      u += H[component][j] * p[j];
+    return u;
+  }
+
+private:
+  const Tensor<2,dim> H;
+};
+
+
+template <int dim>
+Tensor<2,dim> first_piola_kirchhoff_stress(Material_Compressible_Neo_Hook_One_Field<dim,double> &material,
+                                           const Tensor<2,dim>                                  &F)
+{
+  const SymmetricTensor<2,dim> b_bar =
+    Physics::Elasticity::Kinematics::b(Physics::Elasticity::Kinematics::F_iso(F));
+  SymmetricTensor<2,dim> tau;
+  material.get_tau(tau,determinant(F),b_bar);
+  return Tensor<2,dim>(tau) * transpose(invert(F));
+}
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void test_rve ()
+{
+  typedef double number;
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria, 0., 1., true);
+  tria.refine_global (2);
+
+  FESystem<dim> fe(FE_Q<dim>(fe_degree),dim);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+
+  ConstraintMatrix constraints;
+  for (unsigned int d=0; d<dim; ++d)
+    DoFTools::make_periodicity_constraints(dof, 2*d, 2*d+1, d, constraints);
+  constraints.close();
+
+  Tensor<2,dim> F;
+  F[0][0] = 1.1;
+  F[0][1] = 0.2;
+  F[1][0] = -0.05;
+  F[1][1] = 0.95;
+
+  const Tensor<2,dim> I(unit_symmetric_tensor<dim>());
+
+  Vector<number> displacement(dof.n_dofs()), coordinates(dof.n_dofs()), direction(dof.n_dofs());
+  VectorTools::interpolate(dof, AffineDisplacement<dim>(F - I), displacement);
+  VectorTools::interpolate(dof, AffineDisplacement<dim>(I), coordinates);
+
+  MappingQEulerian<dim,Vector<number>> mapping(/*degree*/1,dof,displacement);
+
+  auto mf_data_current   = std::make_shared<MatrixFree<dim,number>>();
+  auto mf_data_reference = std::make_shared<MatrixFree<dim,number>>();
+
+  const QGauss<1> quad (n_q_points_1d);
+  typename MatrixFree<dim,number>::AdditionalData data;
+  data.tasks_parallel_scheme = MatrixFree<dim,number>::AdditionalData::none;
+
+  mf_data_reference->reinit (        dof, constraints, quad, data);
+  mf_data_current->reinit   (mapping,dof, constraints, quad, data);
+
+  const double nu = 0.3;
+  const double mu = 0.4225e6;
+  auto material = std::make_shared<Material_Compressible_Neo_Hook_One_Field<dim,VectorizedArray<number>>>(mu,nu);
+  Material_Compressible_Neo_Hook_One_Field<dim,number> material_standard(mu,nu);
+
+  NeoHookOperator<dim,fe_degree,n_q_points_1d,number> op;
+  op.initialize(mf_data_current,mf_data_reference,displacement);
+  op.set_material(material);
+
+  // stress and forces
+  Vector<number> forces(dof.n_dofs());
+  const Tensor<2,dim> P = op.add_internal_forces(forces);
+  const Tensor<2,dim> P_ref = first_piola_kirchhoff_stress(material_standard,F);
+  AssertThrow((P - P_ref).norm() < 1e-10 * P_ref.norm(), ExcMessage("stress"));
+  AssertThrow(forces.l2_norm() < 1e-10 * P_ref.norm(), ExcMessage("forces"));
+
+  // linearized stress
+  const double h = 1e-6;
+  for (unsigned int k=0; k<dim; ++k)
+    for (unsigned int l=0; l<dim; ++l)
+      {
+        Tensor<2,dim> E;
+        E[k][l] = 1.;
+        VectorTools::interpolate(dof, AffineDisplacement<dim>(E), direction);
+
+        const Tensor<2,dim> dP = op.integrate_stress_derivative(direction,coordinates);
+        const Tensor<2,dim> dP_ref = (first_piola_kirchhoff_stress(material_standard,Tensor<2,dim>(F + h*E)) -
+                                      first_piola_kirchhoff_stress(material_standard,Tensor<2,dim>(F - h*E))) / (2.*h);
+        AssertThrow((dP - dP_ref).norm() < 1e-6 * dP_ref.norm(), ExcMessage("tangent"));
+      }
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  deallog.push("2d");
+  test_rve<2,1,2>();
+  deallog.pop();
+  deallog.pop();
+}
@@ -0,0 +1,137 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+#include <mf_monte_carlo.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the Monte-Carlo driver on the Cook membrane: Without variation of
+// the material all samples have the tip displacement of the deterministic
+// analysis. With random fields, the statistics must not depend on the
+// number of threads that solve the samples.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("monte_carlo.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("monte_carlo.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+std::pair<double,double>
+statistics (const Parameters::AllParameters &parameters)
+{
+  MonteCarlo<2,double> monte_carlo(parameters);
+  monte_carlo.run();
+  return monte_carlo.get_tip_displacement_statistics();
+}
+
+
+void test ()
+{
+  const double tip_deterministic = tip_displacement(make_parameters(""));
+
+  const std::string samples = "subsection Uncertainty quantification\n"
+                              "  set Monte-Carlo samples = 4\n"
+                              "  set Correlation length  = 8.0\n"
+                              "  set Random seed         = 1\n"
+                              "end\n";
+
+  const std::pair<double,double> constant =
+    statistics(make_parameters(samples +
+                               "subsection Uncertainty quantification\n"
+                               "  set Shear modulus variation   = 0\n"
+                               "  set Poisson's ratio variation = 0\n"
+                               "end\n"));
+  AssertThrow(std::abs(constant.first - tip_deterministic) < 1e-6 * std::abs(tip_deterministic),
+              ExcMessage("mean: " + std::to_string(constant.first) +
+                         " != " + std::to_string(tip_deterministic)));
+  AssertThrow(constant.second < 1e-8 * std::abs(tip_deterministic),
+              ExcMessage("deviation: " + std::to_string(constant.second)));
+
+  const std::string random = samples +
+                             "subsection Uncertainty quantification\n"
+                             "  set Shear modulus variation   = 0.1\n"
+                             "  set Poisson's ratio variation = 0.05\n"
+                             "end\n";
+  const std::pair<double,double> serial =
+    statistics(make_parameters(random +
+                               "subsection Uncertainty quantification\n"
+                               "  set Sampling threads = 1\n"
+                               "end\n"));
+  const std::pair<double,double> threaded =
+    statistics(make_parameters(random +
+                               "subsection Uncertainty quantification\n"
+                               "  set Sampling threads = 2\n"
+                               "end\n"));
+  AssertThrow(serial.second > 1e-6 * std::abs(serial.first),
+              ExcMessage("deviation: " + std::to_string(serial.second)));
+  AssertThrow(std::abs(serial.first - threaded.first) < 1e-12 * std::abs(serial.first) &&
+              std::abs(serial.second - threaded.second) < 1e-12 * std::abs(serial.second),
+              ExcMessage("threads"));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
@@ -0,0 +1,130 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <multicolor_ssor.h>
+
+using namespace dealii;
+
+// Check on the five-point Laplacian that the greedy coloring gives no two
+// coupled rows the same color, which is the red-black coloring for the
+// natural ordering, that vmult() inverts the SSOR matrix of the colored
+// ordering, and that CG needs fewer iterations with it than with Jacobi.
+
+void test ()
+{
+  const unsigned int n_1d = 24;
+  const unsigned int n = n_1d * n_1d;
+  const double omega = 1.;
+
+  DynamicSparsityPattern dsp(n, n);
+  for (unsigned int i = 0; i < n_1d; ++i)
+    for (unsigned int j = 0; j < n_1d; ++j)
+      {
+        const unsigned int row = i * n_1d + j;
+        dsp.add(row, row);
+        if (i > 0)
+          dsp.add(row, row - n_1d);
+        if (i + 1 < n_1d)
+          dsp.add(row, row + n_1d);
+        if (j > 0)
+          dsp.add(row, row - 1);
+        if (j + 1 < n_1d)
+          dsp.add(row, row + 1);
+      }
+  SparsityPattern sparsity;
+  sparsity.copy_from(dsp);
+
+  SparseMatrix<double> matrix(sparsity);
+  for (unsigned int row = 0; row < n; ++row)
+    for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+      matrix.set(row, p->column(), p->column() == row ? 4. : -1.);
+
+  MulticolorSSOR<double> ssor;
+  ssor.color(sparsity);
+  AssertThrow(ssor.n_colors() == 2, ExcMessage("n_colors"));
+  for (unsigned int row = 0; row < n; ++row)
+    for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+      AssertThrow(p->column() == row || ssor.get_color(p->column()) != ssor.get_color(row),
+                  ExcMessage("coloring"));
+  ssor.initialize(matrix, omega);
+
+  Vector<double> src(n), dst(n);
+  for (unsigned int i = 0; i < n; ++i)
+    src(i) = std::sin(1. + i);
+  ssor.vmult(dst, src);
+
+  // multiply by $\mathbf{M} = \frac{1}{\omega (2-\omega)} (\mathbf{D} +
+  // \omega \mathbf{L}) \mathbf{D}^{-1} (\mathbf{D} + \omega \mathbf{U})$,
+  // with $\mathbf{L}$ and $\mathbf{U}$ the couplings to lower and higher
+  // colors, which has to give back the source vector
+  Vector<double> tmp(n), result(n);
+  for (unsigned int row = 0; row < n; ++row)
+    {
+      double sum = 0;
+      for (SparseMatrix<double>::const_iterator p = matrix.begin(row); p != matrix.end(row); ++p)
+        if (p->column() == row)
+          sum += p->value() * dst(p->column());
+        else if (ssor.get_color(p->column()) > ssor.get_color(row))
+          sum += omega * p->value() * dst(p->column());
+      tmp(row) = sum / matrix.diag_element(row);
+    }
+  for (unsigned int row = 0; row < n; ++row)
+    {
+      double sum = 0;
+      for (SparseMatrix<double>::const_iterator p = matrix.begin(row); p != matrix.end(row); ++p)
+        if (p->column() == row)
+          sum += p->value() * tmp(p->column());
+        else if (ssor.get_color(p->column()) < ssor.get_color(row))
+          sum += omega * p->value() * tmp(p->column());
+      result(row) = sum / (omega * (2. - omega));
+    }
+  result -= src;
+  AssertThrow(result.l2_norm() < 1e-12 * src.l2_norm(), ExcMessage("vmult"));
+
+  // solve with both preconditioners, without logging the iterations
+  Vector<double> rhs(n), solution(n);
+  rhs = 1.;
+
+  SolverControl control_jacobi(1000, 1e-10 * rhs.l2_norm(), false, false);
+  SolverCG<Vector<double>> solver_jacobi(control_jacobi);
+  PreconditionJacobi<SparseMatrix<double>> jacobi;
+  jacobi.initialize(matrix);
+  solver_jacobi.solve(matrix, solution, rhs, jacobi);
+
+  solution = 0.;
+  SolverControl control_ssor(1000, 1e-10 * rhs.l2_norm(), false, false);
+  SolverCG<Vector<double>> solver_ssor(control_ssor);
+  solver_ssor.solve(matrix, solution, rhs, ssor);
+
+  AssertThrow(control_ssor.last_step() < control_jacobi.last_step(),
+              ExcMessage("iterations"));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
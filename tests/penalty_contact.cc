@@ -0,0 +1,113 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the penalty contact on the Cook membrane: An obstacle that the body
+// does not reach leaves the solution unchanged. A plane 5 mm above the tip
+// stops the tip there, up to the small penetration of the penalty method.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("penalty_contact.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("penalty_contact.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const double tip_free = tip_displacement(make_parameters(""));
+  AssertThrow(tip_free > 0.006, ExcMessage("free tip displacement"));
+
+  const std::string plane = "subsection Contact\n"
+                            "  set Obstacle            = Plane\n"
+                            "  set Contact boundary id = 0\n"
+                            "  set Obstacle normal     = 0.0, -1.0, 0.0\n"
+                            "  set Penalty parameter   = 1.0e10\n"
+                            "end\n";
+
+  const double tip_far =
+    tip_displacement(make_parameters(plane +
+                                     "subsection Contact\n"
+                                     "  set Obstacle point = 0.0, 1.0, 0.0\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_far - tip_free) < 1e-7 * std::abs(tip_free),
+              ExcMessage("far obstacle: " + std::to_string(tip_far) +
+                         " != " + std::to_string(tip_free)));
+
+  // the tip is at y = 60 mm in the reference configuration
+  const double tip_contact =
+    tip_displacement(make_parameters(plane +
+                                     "subsection Contact\n"
+                                     "  set Obstacle point = 0.0, 0.065, 0.0\n"
+                                     "end\n"));
+  AssertThrow(tip_contact < 0.005 + 1e-4,
+              ExcMessage("penetration: " + std::to_string(tip_contact)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
@@ -0,0 +1,113 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the phase-field fracture on the Cook membrane: For a very large
+// fracture toughness the body stays intact and has the tip displacement of
+// the neo-Hookean material. For a lower one, the damage near the clamped
+// corners softens the membrane.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("phase_field.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("phase_field.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const double tip_intact = tip_displacement(make_parameters(""));
+
+  const std::string phase_field = "subsection Phase field\n"
+                                  "  set Phase-field fracture = true\n"
+                                  "  set Length scale         = 1.0\n"
+                                  "  set Residual stiffness   = 1.0e-6\n"
+                                  "  set Staggered iterations = 1\n"
+                                  "end\n";
+
+  const double tip_tough =
+    tip_displacement(make_parameters(phase_field +
+                                     "subsection Phase field\n"
+                                     "  set Fracture toughness = 1.0e12\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_tough - tip_intact) < 1e-6 * std::abs(tip_intact),
+              ExcMessage("tough: " + std::to_string(tip_tough) +
+                         " != " + std::to_string(tip_intact)));
+
+  const double tip_damaged =
+    tip_displacement(make_parameters(phase_field +
+                                     "subsection Phase field\n"
+                                     "  set Fracture toughness = 50.0\n"
+                                     "end\n"));
+  AssertThrow(tip_damaged > (1. + 1e-4) * tip_intact,
+              ExcMessage("damaged: " + std::to_string(tip_damaged) +
+                         " <= " + std::to_string(tip_intact)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
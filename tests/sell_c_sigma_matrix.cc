@@ -0,0 +1,86 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <sell_c_sigma_matrix.h>
+
+using namespace dealii;
+
+// Check that the SELL-C-sigma matrix gives the same product as SparseMatrix
+// for rows of very different lengths, a number of rows that is not a
+// multiple of the chunk size, and sorting windows both longer than a chunk
+// and longer than the matrix.
+
+void test (const unsigned int sigma)
+{
+  const unsigned int n = 1001;
+
+  // row i has between 1 and 16 entries
+  DynamicSparsityPattern dsp(n, n);
+  for (unsigned int row = 0; row < n; ++row)
+    {
+      dsp.add(row, row);
+      for (unsigned int k = 1; k < (row * 7) % 16 + 1; ++k)
+        dsp.add(row, (row + k * k * 3) % n);
+    }
+  SparsityPattern sparsity;
+  sparsity.copy_from(dsp);
+
+  SparseMatrix<double> matrix(sparsity);
+  for (unsigned int row = 0; row < n; ++row)
+    for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+      matrix.set(row, p->column(),
+                 p->column() == row ? 10. : -1. + 0.01 * ((row * 13 + p->column() * 7) % 50));
+
+  SellCSigmaMatrix<double> matrix_sell;
+  matrix_sell.reinit(sparsity, sigma);
+  matrix_sell.copy_from(matrix);
+  AssertThrow(matrix_sell.m() == n && matrix_sell.n() == n, ExcMessage("size"));
+  AssertThrow(matrix_sell.n_nonzero_elements() >= matrix.n_nonzero_elements(),
+              ExcMessage("n_nonzero_elements"));
+
+  Vector<double> src(n), dst(n), dst_sell(n);
+  for (unsigned int i = 0; i < n; ++i)
+    src(i) = std::sin(1. + i);
+
+  matrix.vmult(dst, src);
+  dst_sell = 1.;
+  matrix_sell.vmult(dst_sell, src);
+  dst_sell -= dst;
+  AssertThrow(dst_sell.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("vmult"));
+
+  // new entries on the same pattern
+  matrix *= 2.;
+  matrix_sell.copy_from(matrix);
+  matrix.vmult(dst, src);
+  matrix_sell.vmult(dst_sell, src);
+  dst_sell -= dst;
+  AssertThrow(dst_sell.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("copy_from"));
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test(1);
+  test(3 * SellCSigmaMatrix<double>::chunk_size + 1);
+  test(256);
+  test(2000);
+  deallog << "Ok" << std::endl;
+  deallog.pop();
+}
@@ -0,0 +1,106 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <symmetric_sparse_matrix.h>
+
+using namespace dealii;
+
+// Check that the storage of the upper triangle gives the same product and
+// relaxation methods as SparseMatrix for a symmetric matrix that is large
+// enough to be split into several chunks for the product, and that the copy
+// for the direct solver gives the same matrix.
+
+void test ()
+{
+  const unsigned int n = 20000;
+
+  // a band with some longer couplings
+  DynamicSparsityPattern dsp(n, n);
+  for (unsigned int i = 0; i < n; ++i)
+    for (const unsigned int j : {i, i + 1, i + 3, i + 50, i + (i % 97)})
+      if (j < n)
+        {
+          dsp.add(i, j);
+          dsp.add(j, i);
+        }
+  SparsityPattern sparsity;
+  sparsity.copy_from(dsp);
+
+  SparseMatrix<double> matrix(sparsity);
+  SymmetricSparseMatrix<double> matrix_symmetric;
+  matrix_symmetric.reinit(sparsity);
+  for (unsigned int row = 0; row < n; ++row)
+    for (SparsityPattern::iterator p = sparsity.begin(row); p != sparsity.end(row); ++p)
+      if (p->column() >= row)
+        {
+          const double value = (p->column() == row ? 10. :
+                                -1. + 0.01 * ((row * 13 + p->column() * 7) % 50));
+          matrix.set(row, p->column(), value);
+          matrix.set(p->column(), row, value);
+          matrix_symmetric.add(row, p->column(), value);
+          if (p->column() != row)
+            matrix_symmetric.add(p->column(), row, value);
+        }
+
+  Vector<double> src(n), dst(n), dst_symmetric(n);
+  for (unsigned int i = 0; i < n; ++i)
+    src(i) = std::sin(1. + i);
+
+  matrix.vmult(dst, src);
+  matrix_symmetric.vmult(dst_symmetric, src);
+  dst_symmetric -= dst;
+  AssertThrow(dst_symmetric.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("vmult"));
+
+  matrix.precondition_Jacobi(dst, src, 0.8);
+  matrix_symmetric.precondition_Jacobi(dst_symmetric, src, 0.8);
+  dst_symmetric -= dst;
+  AssertThrow(dst_symmetric.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("Jacobi"));
+
+  matrix.precondition_SOR(dst, src, 1.2);
+  matrix_symmetric.precondition_SOR(dst_symmetric, src, 1.2);
+  dst_symmetric -= dst;
+  AssertThrow(dst_symmetric.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("SOR"));
+
+  matrix.precondition_SSOR(dst, src, 1.2);
+  matrix_symmetric.precondition_SSOR(dst_symmetric, src, 1.2);
+  dst_symmetric -= dst;
+  AssertThrow(dst_symmetric.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("SSOR"));
+
+  SparsityPattern sparsity_copy;
+  SparseMatrix<double> matrix_copy;
+  matrix_symmetric.copy_to(sparsity_copy, matrix_copy);
+  AssertThrow(matrix_copy.n_nonzero_elements() == matrix.n_nonzero_elements() &&
+              2 * matrix_symmetric.n_nonzero_elements() == matrix.n_nonzero_elements() + n,
+              ExcMessage("copy pattern"));
+  matrix.vmult(dst, src);
+  matrix_copy.vmult(dst_symmetric, src);
+  dst_symmetric -= dst;
+  AssertThrow(dst_symmetric.l2_norm() < 1e-12 * dst.l2_norm(), ExcMessage("copy"));
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, numbers::invalid_unsigned_int);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  deallog.push("2d");
+  test();
+  deallog << "Ok" << std::endl;
+  deallog.pop();
+  deallog.pop();
+}
@@ -0,0 +1,114 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the staggered thermo-elastic coupling on the Cook membrane: Without
+// thermal expansion the heat equation does not change the tip displacement,
+// whereas heating the body through the clamped boundary with a conductivity
+// large enough to heat the whole beam within the load steps does.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("thermal_coupling.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("thermal_coupling.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const double tip_isothermal = tip_displacement(make_parameters(""));
+
+  const std::string thermal = "subsection Thermal\n"
+                              "  set Thermal coupling      = true\n"
+                              "  set Reference temperature = 293.0\n"
+                              "  set Boundary temperature  = 393.0\n"
+                              "  set Heat capacity         = 3.6e6\n"
+                              "  set Thermal conductivity  = 5.0e4\n"
+                              "end\n";
+
+  const double tip_no_expansion =
+    tip_displacement(make_parameters(thermal +
+                                     "subsection Thermal\n"
+                                     "  set Thermal expansion coefficient = 0\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_no_expansion - tip_isothermal) < 1e-7 * std::abs(tip_isothermal),
+              ExcMessage("no expansion: " + std::to_string(tip_no_expansion) +
+                         " != " + std::to_string(tip_isothermal)));
+
+  const double tip_heated =
+    tip_displacement(make_parameters(thermal +
+                                     "subsection Thermal\n"
+                                     "  set Thermal expansion coefficient = 1.0e-4\n"
+                                     "end\n"));
+  AssertThrow(std::abs(tip_heated - tip_isothermal) > 1e-3 * std::abs(tip_isothermal),
+              ExcMessage("heated: " + std::to_string(tip_heated) +
+                         " == " + std::to_string(tip_isothermal)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
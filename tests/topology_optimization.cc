@@ -0,0 +1,124 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check that the optimality criteria updates of the topology optimization
+// lower the compliance of the Cook membrane below the one of the uniform
+// initial design at the same volume. The material is a hundred times stiffer
+// than usual so that the soft intermediate densities do not deform the
+// membrane excessively.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("topology_optimization.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("topology_optimization.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+double
+compliance (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_compliance();
+}
+
+
+void test ()
+{
+  const std::string topology = "subsection Material properties\n"
+                               "  set Shear modulus = 0.4225e8\n"
+                               "end\n"
+                               "subsection Topology optimization\n"
+                               "  set Topology optimization = true\n"
+                               "  set Volume fraction       = 0.5\n"
+                               "  set Filter radius         = 1.5\n"
+                               "  set Move limit            = 0.2\n"
+                               "  set Design tolerance      = 0\n"
+                               "end\n";
+
+  // The compliance is that of the design before the last update, i.e. of
+  // the uniform density after one iteration:
+  const double compliance_uniform =
+    compliance(make_parameters(topology +
+                               "subsection Topology optimization\n"
+                               "  set Optimization iterations = 1\n"
+                               "end\n"));
+  const double compliance_optimized =
+    compliance(make_parameters(topology +
+                               "subsection Topology optimization\n"
+                               "  set Optimization iterations = 6\n"
+                               "end\n"));
+  AssertThrow(compliance_uniform > 0., ExcMessage("compliance"));
+  AssertThrow(compliance_optimized < 0.9 * compliance_uniform,
+              ExcMessage("optimized: " + std::to_string(compliance_optimized) +
+                         " >= " + std::to_string(compliance_uniform)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}
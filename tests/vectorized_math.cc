@@ -0,0 +1,103 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/vectorization.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <vectorized_math.h>
+#include <material.h>
+
+using namespace dealii;
+
+// Check the vectorized exp, log and pow against the scalar functions of the
+// standard library over the range of stretches and energies that occur in
+// the material kernels, for both accuracies, and that the isochoric part of
+// the deformation gradient has unit determinant.
+
+template <typename Number, VectorizedMath::Accuracy accuracy>
+void test_functions (const double tolerance)
+{
+  constexpr unsigned int n_lanes = VectorizedArray<Number>::n_array_elements;
+
+  double error_log = 0., error_exp = 0., error_pow = 0.;
+  for (double x = 1e-8; x < 1e8; x *= 1.01)
+    {
+      VectorizedArray<Number> a;
+      for (unsigned int v = 0; v < n_lanes; ++v)
+        a[v] = x * (1. + 0.1 * v);
+
+      const VectorizedArray<Number> log_a = VectorizedMath::log<accuracy>(a);
+      const VectorizedArray<Number> pow_a = VectorizedMath::pow<accuracy>(a, Number(-2./3.));
+      for (unsigned int v = 0; v < n_lanes; ++v)
+        {
+          const double log_ref = std::log(static_cast<double>(a[v]));
+          const double pow_ref = std::pow(static_cast<double>(a[v]), -2./3.);
+          error_log = std::max(error_log, std::abs(log_a[v] - log_ref) / std::max(1., std::abs(log_ref)));
+          error_pow = std::max(error_pow, std::abs(pow_a[v] - pow_ref) / pow_ref);
+        }
+    }
+
+  for (double x = -50.; x < 50.; x += 0.01)
+    {
+      VectorizedArray<Number> a;
+      for (unsigned int v = 0; v < n_lanes; ++v)
+        a[v] = x + 0.001 * v;
+
+      const VectorizedArray<Number> exp_a = VectorizedMath::exp<accuracy>(a);
+      for (unsigned int v = 0; v < n_lanes; ++v)
+        {
+          const double exp_ref = std::exp(static_cast<double>(a[v]));
+          error_exp = std::max(error_exp, std::abs(exp_a[v] - exp_ref) / exp_ref);
+        }
+    }
+
+  AssertThrow(error_log < tolerance, ExcMessage("log: " + std::to_string(error_log)));
+  AssertThrow(error_exp < tolerance, ExcMessage("exp: " + std::to_string(error_exp)));
+  AssertThrow(error_pow < 20 * tolerance, ExcMessage("pow: " + std::to_string(error_pow)));
+}
+
+
+
+template <int dim>
+void test_F_iso ()
+{
+  Tensor<2,dim,VectorizedArray<double>> F;
+  for (unsigned int v = 0; v < VectorizedArray<double>::n_array_elements; ++v)
+    for (unsigned int i = 0; i < dim; ++i)
+      for (unsigned int j = 0; j < dim; ++j)
+        F[i][j][v] = (i == j ? 1.5 + 0.1 * v : 0.2 * (i + 1) - 0.1 * j);
+
+  const VectorizedArray<double> det_F_bar = determinant(F_iso(F));
+  for (unsigned int v = 0; v < VectorizedArray<double>::n_array_elements; ++v)
+    AssertThrow(std::abs(det_F_bar[v] - 1.) < 1e-14, ExcMessage("F_iso"));
+
+  deallog.push(Utilities::int_to_string(dim) + "d");
+  deallog << "Ok" << std::endl;
+  deallog.pop();
+}
+
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test_functions<double,VectorizedMath::Accuracy::full>(1e-15);
+  test_functions<double,VectorizedMath::Accuracy::reduced>(1e-8);
+  test_functions<float, VectorizedMath::Accuracy::full>(5e-7);
+  test_functions<float, VectorizedMath::Accuracy::reduced>(1e-5);
+  deallog << "Ok" << std::endl;
+  test_F_iso<2>();
+  test_F_iso<3>();
+  deallog.pop();
+}
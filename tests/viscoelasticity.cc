@@ -0,0 +1,128 @@
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/logstream.h>
+
+#include <iostream>
+#include <fstream>
+
+#include <mf_elasticity.h>
+
+using namespace dealii;
+using namespace Cook_Membrane;
+
+// Check the limits of the Prony series on the Cook membrane: If the load is
+// held for many relaxation times, the viscous stresses relax and the tip
+// displacement is the one of the neo-Hookean material. If the relaxation
+// times are long compared to the loading, the response is that of the
+// instantaneous shear modulus $\mu (1 + \sum_\alpha \beta_\alpha)$ at the
+// unchanged bulk modulus.
+
+const std::string cook_parameters = R"(
+subsection Finite element system
+  set Polynomial degree = 1
+  set Quadrature order  = 2
+end
+subsection Geometry
+  set Elements per edge = 8
+  set Grid scale        = 1e-3
+end
+subsection Linear solver
+  set Max iteration multiplier = 10
+  set Residual                 = 1e-10
+  set Solver type              = MF_CG
+end
+subsection Nonlinear solver
+  set Max iterations Newton-Raphson = 20
+  set Tolerance displacement        = 1.0e-8
+  set Tolerance force               = 1.0e-10
+end
+subsection Time
+  set End time       = 1
+  set Time step size = 0.25
+end
+)";
+
+
+// The coarse Cook membrane above with the given additional entries:
+Parameters::AllParameters
+make_parameters (const std::string &entries)
+{
+  {
+    std::ofstream file("viscoelasticity.prm");
+    file << cook_parameters << entries;
+  }
+  return Parameters::AllParameters("viscoelasticity.prm");
+}
+
+
+double
+tip_displacement (const Parameters::AllParameters &parameters)
+{
+  Solid<2,double> solid(parameters);
+  solid.run();
+  return solid.get_vertical_tip_displacement();
+}
+
+
+void test ()
+{
+  const Parameters::AllParameters parameters = make_parameters("");
+  const double tip_elastic = tip_displacement(parameters);
+
+  // the load is ramped up in two steps and held for 18 more, each of which
+  // relaxes the viscous stresses by $e^{-\varDelta t / \tau} = e^{-5}$
+  const Parameters::AllParameters parameters_relaxed =
+    make_parameters("subsection Material properties\n"
+                    "  set Material model                 = Viscoelastic\n"
+                    "  set Prony series stiffnesses       = 0.5\n"
+                    "  set Prony series relaxation times  = 0.01\n"
+                    "end\n"
+                    "subsection Time\n"
+                    "  set Time step size = 0.05\n"
+                    "  set Load ramp time = 0.1\n"
+                    "end\n");
+  const double tip_relaxed = tip_displacement(parameters_relaxed);
+  AssertThrow(std::abs(tip_relaxed - tip_elastic) < 1e-6 * std::abs(tip_elastic),
+              ExcMessage("relaxed: " + std::to_string(tip_relaxed) +
+                         " != " + std::to_string(tip_elastic)));
+
+  const Parameters::AllParameters parameters_instantaneous =
+    make_parameters("subsection Material properties\n"
+                    "  set Material model                 = Viscoelastic\n"
+                    "  set Prony series stiffnesses       = 0.5\n"
+                    "  set Prony series relaxation times  = 1e6\n"
+                    "end\n");
+  const double tip_instantaneous = tip_displacement(parameters_instantaneous);
+
+  // the neo-Hookean material with the instantaneous shear modulus and the
+  // Poisson's ratio that keeps the bulk modulus
+  Parameters::AllParameters parameters_stiff(parameters);
+  const double kappa = 2. * parameters.mu * (1. + parameters.nu) / (3. * (1. - 2. * parameters.nu));
+  parameters_stiff.mu = 1.5 * parameters.mu;
+  const double ratio = 3. * kappa / (2. * parameters_stiff.mu);
+  parameters_stiff.nu = (ratio - 1.) / (1. + 2. * ratio);
+  const double tip_stiff = tip_displacement(parameters_stiff);
+  AssertThrow(std::abs(tip_instantaneous - tip_stiff) < 1e-5 * std::abs(tip_stiff),
+              ExcMessage("instantaneous: " + std::to_string(tip_instantaneous) +
+                         " != " + std::to_string(tip_stiff)));
+
+  deallog << "Ok" << std::endl;
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv);
+
+  const std::string deallogname = "output";
+  std::ofstream deallogfile;
+  deallogfile.open(deallogname.c_str());
+  deallog.attach(deallogfile);
+  deallog.depth_console(0);
+  // the linear solvers of the simulation log one level deeper
+  deallog.depth_file(2);
+  deallog << std::setprecision(4);
+
+  deallog.push("0");
+  test();
+  deallog.pop();
+}